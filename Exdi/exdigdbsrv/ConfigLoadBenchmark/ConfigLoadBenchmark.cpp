@@ -0,0 +1,221 @@
+//----------------------------------------------------------------------------
+//
+// ConfigLoadBenchmark.cpp
+//
+// Measures the load of a large multi-target Exdi-GdbServer configuration file.
+// The benchmark writes a configuration file with many ExdiTarget sections, selects
+// the last one and reports the time and the number of heap allocations that
+// the configuration helper needs to load it. It also times the lookups of the
+// memoized target settings after the load.
+//
+// Usage: ConfigLoadBenchmark [numberOfTargets] [registersPerTarget]
+//
+// Copyright (c) Microsoft. All rights reserved.
+//----------------------------------------------------------------------------
+
+#include <windows.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <new>
+#include <string>
+#include "cfgExdiGdbSrvHelper.h"
+
+using namespace std;
+
+//=============================================================================
+// Allocation counter
+//=============================================================================
+
+static atomic<size_t> g_allocationCount(0);
+
+void * operator new(size_t size)
+{
+    g_allocationCount.fetch_add(1, memory_order_relaxed);
+    void * pMemory = malloc(size != 0 ? size : 1);
+    if (pMemory == nullptr)
+    {
+        throw bad_alloc();
+    }
+    return pMemory;
+}
+
+void * operator new(size_t size, const nothrow_t &) noexcept
+{
+    g_allocationCount.fetch_add(1, memory_order_relaxed);
+    return malloc(size != 0 ? size : 1);
+}
+
+void * operator new[](size_t size)
+{
+    return operator new(size);
+}
+
+void * operator new[](size_t size, const nothrow_t & tag) noexcept
+{
+    return operator new(size, tag);
+}
+
+void operator delete(void * pMemory) noexcept
+{
+    free(pMemory);
+}
+
+void operator delete(void * pMemory, size_t) noexcept
+{
+    free(pMemory);
+}
+
+void operator delete[](void * pMemory) noexcept
+{
+    free(pMemory);
+}
+
+void operator delete[](void * pMemory, size_t) noexcept
+{
+    free(pMemory);
+}
+
+//=============================================================================
+// Configuration file generator
+//=============================================================================
+
+//  Writes an ExdiTarget section with the same shape as the targets of exdiConfigData.xml.
+static void WriteTarget(_Inout_ ofstream & file, _In_ unsigned targetIndex, _In_ unsigned numberOfRegisters)
+{
+    file << "  <ExdiTarget Name = \"Target" << targetIndex << "\">\n";
+    file << "    <ExdiGdbServerConfigData agentNamePacket = \"\" uuid = \"72d4aeda-9723-4972-b89a-679ac79810ef\""
+            " displayCommPackets = \"no\" debuggerSessionByCore = \"no\" enableThrowExceptionOnMemoryErrors = \"yes\""
+            " qSupportedPacket=\"qSupported:xmlRegisters=i386;qRelocInsn+\" enableMemoryWriteCoalescing = \"yes\">\n";
+    file << "      <ExdiGdbServerTargetData targetArchitecture = \"X64\" targetFamily = \"ProcessorFamilyX64\""
+            " numberOfCores = \"1\" EnableSseContext = \"no\" heuristicScanSize = \"0xfffe\" targetDescriptionFile = \"target.xml\"/>\n";
+    file << "      <GdbServerConnectionParameters MultiCoreGdbServerSessions = \"no\" MaximumGdbServerPacketLength = \"4096\""
+            " MaximumConnectAttempts = \"3\" SendPacketTimeout = \"100\" ReceivePacketTimeout = \"3000\">\n";
+    file << "        <Value HostNameAndPort=\"LocalHost:" << (50000 + targetIndex) << "\" />\n";
+    file << "      </GdbServerConnectionParameters>\n";
+    file << "      <ExdiGdbServerMemoryCommands GdbSpecialMemoryCommand = \"no\" PhysicalMemory = \"yes\" SupervisorMemory = \"no\""
+            " HypervisorMemory = \"no\" SpecialMemoryRegister = \"no\" SystemRegistersGdbMonitor = \"no\" SystemRegisterDecoding = \"no\">\n";
+    file << "      </ExdiGdbServerMemoryCommands>\n";
+    file << "      <ExdiGdbServerRegisters Architecture = \"X64\" FeatureNameSupported = \"sys\" SystemRegistersStart = \"\" SystemRegistersEnd = \"\">\n";
+    for (unsigned i = 0; i < numberOfRegisters; ++i)
+    {
+        file << "          <Entry Name =\"r" << i << "\" Order = \"" << hex << i << dec << "\" Size = \"8\" />\n";
+    }
+    file << "      </ExdiGdbServerRegisters>\n";
+    file << "    </ExdiGdbServerConfigData>\n";
+    file << "  </ExdiTarget>\n";
+}
+
+//  Writes the configuration file and selects the last target, so the whole file is read.
+static bool WriteConfigFile(_In_ const wstring & fileName, _In_ unsigned numberOfTargets, _In_ unsigned numberOfRegisters)
+{
+    ofstream file(fileName.c_str(), ios::out | ios::trunc);
+    if (!file)
+    {
+        return false;
+    }
+    file << "<ExdiTargets CurrentTarget = \"Target" << (numberOfTargets - 1) << "\">\n";
+    for (unsigned i = 0; i < numberOfTargets; ++i)
+    {
+        WriteTarget(file, i, numberOfRegisters);
+    }
+    file << "</ExdiTargets>\n";
+    return static_cast<bool>(file);
+}
+
+//=============================================================================
+// Benchmark
+//=============================================================================
+
+int wmain(int argc, wchar_t * argv[])
+{
+    unsigned numberOfTargets = (argc > 1) ? static_cast<unsigned>(_wtoi(argv[1])) : 512;
+    unsigned numberOfRegisters = (argc > 2) ? static_cast<unsigned>(_wtoi(argv[2])) : 64;
+    if (numberOfTargets == 0)
+    {
+        wprintf(L"The number of targets must be greater than zero\n");
+        return 1;
+    }
+
+    WCHAR tempPath[MAX_PATH + 1] = {};
+    DWORD tempPathLength = GetTempPathW(_countof(tempPath), tempPath);
+    if (tempPathLength == 0 || tempPathLength > MAX_PATH)
+    {
+        wprintf(L"Unable to get the temporary directory\n");
+        return 1;
+    }
+    wstring fileName = wstring(tempPath) + L"ConfigLoadBenchmark.xml";
+    if (!WriteConfigFile(fileName, numberOfTargets, numberOfRegisters))
+    {
+        wprintf(L"Unable to write %ls\n", fileName.c_str());
+        return 1;
+    }
+
+    HRESULT hr = CoInitializeEx(nullptr, COINIT_MULTITHREADED);
+    if (FAILED(hr))
+    {
+        wprintf(L"CoInitializeEx failed (0x%08x)\n", hr);
+        return 1;
+    }
+
+    int exitCode = 0;
+    try
+    {
+        //  Load
+        size_t allocationsBefore = g_allocationCount.load();
+        auto loadStart = chrono::steady_clock::now();
+        ConfigExdiGdbServerHelper & cfgData = ConfigExdiGdbServerHelper::GetInstanceCfgExdiGdbServer(fileName.c_str());
+        auto loadEnd = chrono::steady_clock::now();
+        size_t loadAllocations = g_allocationCount.load() - allocationsBefore;
+
+        wstring targetName;
+        cfgData.GetGdbServerTargetName(targetName);
+        wstring expectedTargetName = L"Target" + to_wstring(numberOfTargets - 1);
+        if (targetName != expectedTargetName || cfgData.GetNumberOfCores() != 1 ||
+            cfgData.GetMaxServerPacketLength() != 4096 || !cfgData.IsMemoryWriteCoalescingEnabled())
+        {
+            wprintf(L"FAILED: the selected target '%ls' was not loaded\n", expectedTargetName.c_str());
+            exitCode = 1;
+        }
+
+        wprintf(L"Loaded %u targets with %u registers each\n", numberOfTargets, numberOfRegisters);
+        wprintf(L"  load time:   %.3f ms\n",
+                chrono::duration<double, milli>(loadEnd - loadStart).count());
+        wprintf(L"  allocations: %zu\n", loadAllocations);
+
+        //  Memoized lookups
+        const size_t lookupCount = 10000000;
+        size_t enabledCount = 0;
+        allocationsBefore = g_allocationCount.load();
+        auto lookupStart = chrono::steady_clock::now();
+        for (size_t i = 0; i < lookupCount; ++i)
+        {
+            ConfigExdiGdbServerHelper & cfgLookup = ConfigExdiGdbServerHelper::GetInstanceCfgExdiGdbServer(nullptr);
+            if (cfgLookup.IsMemoryWriteCoalescingEnabled() && cfgLookup.GetTargetSettings().maxServerPacketLength != 0)
+            {
+                ++enabledCount;
+            }
+        }
+        auto lookupEnd = chrono::steady_clock::now();
+        size_t lookupAllocations = g_allocationCount.load() - allocationsBefore;
+
+        wprintf(L"  lookups:     %.2f ns per lookup, %zu allocations\n",
+                chrono::duration<double, nano>(lookupEnd - lookupStart).count() / lookupCount,
+                lookupAllocations);
+        if (enabledCount != lookupCount)
+        {
+            exitCode = 1;
+        }
+    }
+    catch (...)
+    {
+        wprintf(L"FAILED: an exception was thrown while loading %ls\n", fileName.c_str());
+        exitCode = 1;
+    }
+
+    CoUninitialize();
+    DeleteFileW(fileName.c_str());
+    return exitCode;
+}
@@ -16,6 +16,7 @@
 #include "ComHelpers.h"
 #include "AsynchronousGdbSrvController.h"
 #include "CommandLogger.h"
+#include "asyncCommandLogger.h"
 #include "ArgumentHelpers.h"
 #include "ExceptionHelpers.h"
 #include "GdbSrvRspClient.h"
@@ -531,6 +532,13 @@ HRESULT STDMETHODCALLTYPE CLiveExdiGdbSrvServer::ReadVirtualMemory(
         {
             return E_POINTER;
         }
+        //  The addresses are translated here if the target can only access memory by PA.
+        if (pController->IsHostPageTableWalkEnabled())
+        {
+            SimpleCharBuffer buffer = pController->ReadVirtualMemoryByPA(Address, dwBytesToRead);
+            return SafeArrayFromByteArray(buffer.GetInternalBuffer(), buffer.GetLength(), pbReadBuffer);
+        }
+
         memoryAccessType memType = {0};
         pController->GetMemoryPacketType(m_lastPSRvalue, &memType);
 
@@ -567,10 +575,17 @@ HRESULT STDMETHODCALLTYPE CLiveExdiGdbSrvServer::WriteVirtualMemory(
         ULONG bufferSize = pBuffer->rgsabound[0].cElements;
         PVOID pRawBuffer = pBuffer->pvData;
 
-        memoryAccessType memType = {0};
-        pController->GetMemoryPacketType(m_lastPSRvalue, &memType);
-
-        bool isWriteDone = pController->WriteMemory(Address, bufferSize, pRawBuffer, pdwBytesWritten, memType);
+        bool isWriteDone = false;
+        if (pController->IsHostPageTableWalkEnabled())
+        {
+            isWriteDone = pController->WriteVirtualMemoryByPA(Address, bufferSize, pRawBuffer, pdwBytesWritten);
+        }
+        else
+        {
+            memoryAccessType memType = {0};
+            pController->GetMemoryPacketType(m_lastPSRvalue, &memType);
+            isWriteDone = pController->WriteMemory(Address, bufferSize, pRawBuffer, pdwBytesWritten, memType);
+        }
         if (isWriteDone)
         {
             return S_OK;
@@ -703,8 +718,10 @@ HRESULT STDMETHODCALLTYPE CLiveExdiGdbSrvServer::Ioctl(
                     }
                     else if (pAdditionalInfo->request.RequireMemoryAccessByPA)
                     {
-                        size_t bytesToCopy = min(dwBuffOutSize, sizeof(m_RequireMemoryAccessByPA));
-                        hr = SafeArrayFromByteArray(reinterpret_cast<const char*>(&m_RequireMemoryAccessByPA), bytesToCopy, pOutputBuffer);
+                        //  The engine does not need to translate the virtual addresses if the host page table walker does it.
+                        bool requireMemoryAccessByPA = m_RequireMemoryAccessByPA && !pController->IsHostPageTableWalkEnabled();
+                        size_t bytesToCopy = min(dwBuffOutSize, sizeof(requireMemoryAccessByPA));
+                        hr = SafeArrayFromByteArray(reinterpret_cast<const char*>(&requireMemoryAccessByPA), bytesToCopy, pOutputBuffer);
                     }
                     else
                     {
@@ -1057,7 +1074,7 @@ HRESULT STDMETHODCALLTYPE CLiveExdiGdbSrvServer::GetContextEx(_In_ DWORD process
         pController->StopTargetAtRun();
         memset(pContext, 0, sizeof(CONTEXT_ARM4));
 
-        std::map<std::string, std::string> registers = pController->QueryAllRegisters(processorNumber);
+        std::map<std::string, std::string> registers = pController->QueryAllRegistersFromSnapshot(processorNumber);
         pContext->R0 = GdbSrvController::ParseRegisterValue32(registers["r0"]);
         pContext->R1 = GdbSrvController::ParseRegisterValue32(registers["r1"]);
         pContext->R2 = GdbSrvController::ParseRegisterValue32(registers["r2"]);
@@ -1190,7 +1207,7 @@ HRESULT STDMETHODCALLTYPE CLiveExdiGdbSrvServer::GetContextEx(_In_ DWORD process
         pContext->DescriptorEs.SegFlags = static_cast<DWORD>(-1);
         pContext->DescriptorDs.SegFlags = static_cast<DWORD>(-1);
 
-        std::map<std::string, std::string> registers = pController->QueryAllRegisters(processorNumber);
+        std::map<std::string, std::string> registers = pController->QueryAllRegistersFromSnapshot(processorNumber);
         pContext->Rax = GdbSrvController::ParseRegisterValue(registers["rax"]);
         pContext->Rbx = GdbSrvController::ParseRegisterValue(registers["rbx"]);
         pContext->Rcx = GdbSrvController::ParseRegisterValue(registers["rcx"]);
@@ -1432,7 +1449,7 @@ HRESULT STDMETHODCALLTYPE CLiveExdiGdbSrvServer::GetContextEx(_In_ DWORD process
         pContext->DescriptorEs.Flags = static_cast<DWORD>(X86_DESC_FLAGS);
         pContext->DescriptorDs.Flags = static_cast<DWORD>(X86_DESC_FLAGS);
 
-        std::map<std::string, std::string> registers = pController->QueryAllRegisters(processorNumber);
+        std::map<std::string, std::string> registers = pController->QueryAllRegistersFromSnapshot(processorNumber);
         //  Get core integer registers
         GetX86CoreRegisters(registers, pContext);
         //  Get the 80387 Copreocessor registers
@@ -1495,7 +1512,7 @@ HRESULT STDMETHODCALLTYPE CLiveExdiGdbSrvServer::GetContextEx(_In_ DWORD process
         pController->StopTargetAtRun();
         memset(pContext, 0, sizeof(CONTEXT_ARMV8ARCH64));
 
-        std::map<std::string, std::string> registers = pController->QueryAllRegisters(processorNumber);
+        std::map<std::string, std::string> registers = pController->QueryAllRegistersFromSnapshot(processorNumber);
 
         for (int i = 0; i < ARMV8ARCH64_MAX_INTERGER_REGISTERS; ++i)
         {
@@ -1684,13 +1701,14 @@ HRESULT CLiveExdiGdbSrvServer::SetGdbServerParameters()
         }
 
         ConfigExdiGdbServerHelper & cfgData = ConfigExdiGdbServerHelper::GetInstanceCfgExdiGdbServer(configXmlFile);
-        m_targetProcessorArch = cfgData.GetTargetArchitecture();
-        m_detectedProcessorFamily = cfgData.GetTargetFamily();
-        m_fDisplayCommData = cfgData.GetDisplayCommPacketsCharacters();
-        m_fEnableSSEContext = cfgData.GetIntelSseContext();
-        m_heuristicChunkSize = cfgData.GetHeuristicScanMemorySize();
-        m_RequireMemoryAccessByPA = cfgData.GetServerRequirePAMemoryAccess();
-        unsigned numberOfCores = cfgData.GetNumberOfCores();
+        const ConfigExdiTargetSettings & targetSettings = cfgData.GetTargetSettings();
+        m_targetProcessorArch = targetSettings.targetArchitecture;
+        m_detectedProcessorFamily = targetSettings.targetFamily;
+        m_fDisplayCommData = targetSettings.fDisplayCommPackets;
+        m_fEnableSSEContext = targetSettings.fEnabledIntelFpSseContext;
+        m_heuristicChunkSize = targetSettings.heuristicChunkSize;
+        m_RequireMemoryAccessByPA = targetSettings.fPAMemoryAccess;
+        unsigned numberOfCores = targetSettings.numberOfCores;
         std::vector<std::wstring> coreConnections;
         cfgData.GetGdbServerConnectionParameters(coreConnections);
         if (coreConnections.size() != numberOfCores)
@@ -1705,7 +1723,20 @@ HRESULT CLiveExdiGdbSrvServer::SetGdbServerParameters()
         m_pGdbSrvController->SetTargetProcessorFamilyByTargetArch(m_targetProcessorArch);
         if (m_fDisplayCommData)
         {
-            m_pGdbSrvController->SetTextHandler(new CommandLogger(true));
+            //  The text is written by the logger background thread, so the RSP packet loop
+            //  does not wait for the console/file output.
+            WCHAR logFile[MAX_PATH + 1];
+            fileNameLength = GetEnvironmentVariable(_T("EXDI_GDBSRV_LOG_FILE"), logFile, _countof(logFile));
+            IGdbSrvTextHandler * pTextHandler = nullptr;
+            if (fileNameLength != 0 && fileNameLength < _countof(logFile))
+            {
+                pTextHandler = new RotatingFileLogger(logFile);
+            }
+            else
+            {
+                pTextHandler = new CommandLogger(true);
+            }
+            m_pGdbSrvController->SetTextHandler(new AsyncCommandLogger(pTextHandler));
         }
 
         WCHAR systemRegMapXmlFile[MAX_PATH + 1];
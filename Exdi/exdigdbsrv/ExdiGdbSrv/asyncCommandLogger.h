@@ -0,0 +1,417 @@
+//----------------------------------------------------------------------------
+//
+// asyncCommandLogger.h
+//
+// Helper classes that log the commands being executed without blocking
+// the RSP packet loop. The text records are queued in a bounded lock-free
+// ring buffer and a background thread writes them to the console or to a
+// rotating log file.
+//
+// Copyright (c) Microsoft. All rights reserved.
+//----------------------------------------------------------------------------
+
+#pragma once
+#include <windows.h>
+#include <stdio.h>
+#include <assert.h>
+#include <atomic>
+#include <memory>
+#include <string>
+#include <map>
+#include "GdbSrvControllerLib.h"
+
+//  Maximum length of the text stored in one ring buffer slot,
+//  longer texts are split in several consecutive slots.
+const size_t C_MAX_LOG_RECORD_TEXT_LENGTH = 480;
+
+//  Number of ring buffer slots (it has to be a power of two)
+const size_t C_LOG_RING_BUFFER_SLOTS = 2048;
+
+//  Maximum time that the logging thread waits for new records before checking the drop counters
+const DWORD C_LOG_THREAD_WAIT_TIMEOUT = 250;
+
+//  Default size limit of each log file, and the number of rotated files kept
+const ULONGLONG C_MAX_LOG_FILE_SIZE = 16 * 1024 * 1024;
+const unsigned C_MAX_ROTATED_LOG_FILES = 4;
+
+//
+//  RotatingFileLogger  Text handler that writes the records to a log file.
+//                      Once the file reaches its size limit, it's renamed to <name>.1 (the former <name>.1
+//                      becomes <name>.2 and so on), and a new file is started.
+//
+class RotatingFileLogger : public GdbSrvControllerLib::IGdbSrvTextHandler
+{
+public:
+    RotatingFileLogger(_In_z_ PCWSTR pFileName, _In_ ULONGLONG maxFileSize = C_MAX_LOG_FILE_SIZE,
+                       _In_ unsigned maxRotatedFiles = C_MAX_ROTATED_LOG_FILES) :
+        m_fileName(pFileName),
+        m_maxFileSize(maxFileSize),
+        m_maxRotatedFiles(maxRotatedFiles),
+        m_logFile(INVALID_HANDLE_VALUE),
+        m_currentFileSize(0)
+    {
+        assert(pFileName != nullptr);
+        OpenLogFile();
+    }
+
+    ~RotatingFileLogger()
+    {
+        CloseLogFile();
+    }
+
+public:
+    void HandleText(_In_ GdbSrvControllerLib::GdbSrvTextType textType, _In_reads_bytes_(readSize) const char * pText,
+                    _In_ size_t readSize)
+    {
+        assert(pText != nullptr);
+
+        const char * pPrefix = "!! ";
+        if (textType == GdbSrvControllerLib::GdbSrvTextType::Command)
+        {
+            pPrefix = ">> ";
+        }
+        else if (textType == GdbSrvControllerLib::GdbSrvTextType::CommandOutput)
+        {
+            pPrefix = "<< ";
+        }
+
+        const size_t prefixLength = strlen(pPrefix);
+        if (m_currentFileSize + prefixLength + readSize + 2 > m_maxFileSize)
+        {
+            RotateLogFiles();
+        }
+
+        if (m_logFile == INVALID_HANDLE_VALUE)
+        {
+            return;
+        }
+
+        WriteLogData(pPrefix, prefixLength);
+        WriteLogData(pText, readSize);
+        WriteLogData("\r\n", 2);
+    }
+
+private:
+    void OpenLogFile()
+    {
+        m_logFile = CreateFileW(m_fileName.c_str(), FILE_APPEND_DATA, FILE_SHARE_READ, nullptr,
+                                OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+        m_currentFileSize = 0;
+        LARGE_INTEGER fileSize;
+        if (m_logFile != INVALID_HANDLE_VALUE && GetFileSizeEx(m_logFile, &fileSize))
+        {
+            m_currentFileSize = static_cast<ULONGLONG>(fileSize.QuadPart);
+        }
+    }
+
+    void CloseLogFile()
+    {
+        if (m_logFile != INVALID_HANDLE_VALUE)
+        {
+            CloseHandle(m_logFile);
+            m_logFile = INVALID_HANDLE_VALUE;
+        }
+    }
+
+    std::wstring GetRotatedFileName(_In_ unsigned index) const
+    {
+        return m_fileName + L"." + std::to_wstring(index);
+    }
+
+    void RotateLogFiles()
+    {
+        CloseLogFile();
+        if (m_maxRotatedFiles != 0)
+        {
+            DeleteFileW(GetRotatedFileName(m_maxRotatedFiles).c_str());
+            for (unsigned index = m_maxRotatedFiles - 1; index > 0; --index)
+            {
+                MoveFileExW(GetRotatedFileName(index).c_str(), GetRotatedFileName(index + 1).c_str(),
+                            MOVEFILE_REPLACE_EXISTING);
+            }
+            MoveFileExW(m_fileName.c_str(), GetRotatedFileName(1).c_str(), MOVEFILE_REPLACE_EXISTING);
+        }
+        else
+        {
+            DeleteFileW(m_fileName.c_str());
+        }
+        OpenLogFile();
+    }
+
+    void WriteLogData(_In_reads_bytes_(length) const char * pData, _In_ size_t length)
+    {
+        DWORD done = 0;
+        if (WriteFile(m_logFile, pData, static_cast<DWORD>(length), &done, nullptr))
+        {
+            m_currentFileSize += done;
+        }
+    }
+
+    std::wstring m_fileName;
+    ULONGLONG m_maxFileSize;
+    unsigned m_maxRotatedFiles;
+    HANDLE m_logFile;
+    ULONGLONG m_currentFileSize;
+
+    RotatingFileLogger(_In_ const RotatingFileLogger &);
+    void operator=(_In_ const RotatingFileLogger &);
+};
+
+//
+//  AsyncCommandLogger  Text handler that moves the text output off the caller thread.
+//
+//  The caller thread (i.e. the RSP packet loop) copies the text into a bounded lock-free
+//  ring buffer (multiple producers, single consumer) and returns. A background thread
+//  drains the ring buffer and forwards the records to the wrapped text handler
+//  (i.e. CommandLogger for the console, or RotatingFileLogger).
+//  If the ring buffer is full, then the record is dropped and counted, the background
+//  thread reports the number of dropped records through the wrapped handler.
+//
+class AsyncCommandLogger : public GdbSrvControllerLib::IGdbSrvTextHandler
+{
+public:
+    //  The logger owns the passed in text handler.
+    AsyncCommandLogger(_In_ GdbSrvControllerLib::IGdbSrvTextHandler * pTextHandler) :
+        m_pTextHandler(pTextHandler),
+        m_spRingBuffer(new LogRecordSlot[C_LOG_RING_BUFFER_SLOTS]),
+        m_enqueuePosition(0),
+        m_dequeuePosition(0),
+        m_isConsumerWaiting(false),
+        m_isStopping(false),
+        m_droppedRecords(0),
+        m_reportedDroppedRecords(0),
+        m_loggingThread(nullptr)
+    {
+        static_assert((C_LOG_RING_BUFFER_SLOTS & (C_LOG_RING_BUFFER_SLOTS - 1)) == 0,
+                      "The number of ring buffer slots has to be a power of two");
+        assert(pTextHandler != nullptr);
+
+        for (size_t index = 0; index < C_LOG_RING_BUFFER_SLOTS; ++index)
+        {
+            m_spRingBuffer[index].sequence.store(index, std::memory_order_relaxed);
+        }
+
+        m_dataAvailableEvent = CreateEvent(nullptr, FALSE, FALSE, nullptr);
+        if (m_dataAvailableEvent != nullptr)
+        {
+            m_loggingThread = CreateThread(nullptr, 0, LoggingThreadBody, this, 0, nullptr);
+        }
+    }
+
+    ~AsyncCommandLogger()
+    {
+        if (m_loggingThread != nullptr)
+        {
+            //  The logging thread flushes any pending record before exiting
+            m_isStopping.store(true, std::memory_order_release);
+            SetEvent(m_dataAvailableEvent);
+            WaitForSingleObject(m_loggingThread, INFINITE);
+            CloseHandle(m_loggingThread);
+        }
+        if (m_dataAvailableEvent != nullptr)
+        {
+            CloseHandle(m_dataAvailableEvent);
+        }
+    }
+
+    //  Number of records dropped since the logger was created.
+    ULONGLONG GetDroppedRecords() const
+    {
+        return m_droppedRecords.load(std::memory_order_relaxed);
+    }
+
+public:
+    void HandleText(_In_ GdbSrvControllerLib::GdbSrvTextType textType, _In_reads_bytes_(readSize) const char * pText,
+                    _In_ size_t readSize)
+    {
+        assert(pText != nullptr);
+
+        if (m_loggingThread == nullptr)
+        {
+            //  The background thread could not be started, so write the text synchronously.
+            m_pTextHandler->HandleText(textType, pText, readSize);
+            return;
+        }
+
+        const DWORD producerId = GetCurrentThreadId();
+        size_t offset = 0;
+        do
+        {
+            const size_t chunkLength = min(readSize - offset, C_MAX_LOG_RECORD_TEXT_LENGTH);
+            const bool isFirstChunk = (offset == 0);
+            const bool isLastChunk = (offset + chunkLength == readSize);
+            if (!TryPushRecord(textType, producerId, &pText[offset], chunkLength, isFirstChunk, isLastChunk))
+            {
+                //  The remaining chunks are dropped too, the consumer discards the partial record.
+                m_droppedRecords.fetch_add(1, std::memory_order_relaxed);
+                break;
+            }
+            offset += chunkLength;
+        }
+        while (offset < readSize);
+
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (m_isConsumerWaiting.exchange(false))
+        {
+            SetEvent(m_dataAvailableEvent);
+        }
+    }
+
+private:
+    //  Ring buffer slot, the sequence field implements the slot ownership
+    //  between producers and the consumer (bounded MPMC queue algorithm).
+    struct LogRecordSlot
+    {
+        std::atomic<size_t> sequence;
+        GdbSrvControllerLib::GdbSrvTextType textType;
+        DWORD producerId;
+        bool isFirstChunk;
+        bool isLastChunk;
+        size_t length;
+        char text[C_MAX_LOG_RECORD_TEXT_LENGTH];
+    };
+
+    //  Record being reassembled by the consumer for a particular producer thread.
+    struct PendingRecord
+    {
+        GdbSrvControllerLib::GdbSrvTextType textType;
+        std::string text;
+    };
+
+    bool TryPushRecord(_In_ GdbSrvControllerLib::GdbSrvTextType textType, _In_ DWORD producerId,
+                       _In_reads_bytes_(length) const char * pText, _In_ size_t length,
+                       _In_ bool isFirstChunk, _In_ bool isLastChunk)
+    {
+        LogRecordSlot * pSlot = nullptr;
+        size_t position = m_enqueuePosition.load(std::memory_order_relaxed);
+        for (;;)
+        {
+            pSlot = &m_spRingBuffer[position & (C_LOG_RING_BUFFER_SLOTS - 1)];
+            const size_t sequence = pSlot->sequence.load(std::memory_order_acquire);
+            const intptr_t difference = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(position);
+            if (difference == 0)
+            {
+                if (m_enqueuePosition.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+                {
+                    break;
+                }
+            }
+            else if (difference < 0)
+            {
+                //  The ring buffer is full
+                return false;
+            }
+            else
+            {
+                position = m_enqueuePosition.load(std::memory_order_relaxed);
+            }
+        }
+
+        pSlot->textType = textType;
+        pSlot->producerId = producerId;
+        pSlot->isFirstChunk = isFirstChunk;
+        pSlot->isLastChunk = isLastChunk;
+        pSlot->length = length;
+        memcpy(pSlot->text, pText, length);
+        pSlot->sequence.store(position + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool IsRecordAvailable() const
+    {
+        const LogRecordSlot & slot = m_spRingBuffer[m_dequeuePosition & (C_LOG_RING_BUFFER_SLOTS - 1)];
+        return slot.sequence.load(std::memory_order_acquire) == m_dequeuePosition + 1;
+    }
+
+    //  Consumes all the available records, it's called only by the logging thread.
+    void DrainRecords()
+    {
+        while (IsRecordAvailable())
+        {
+            LogRecordSlot & slot = m_spRingBuffer[m_dequeuePosition & (C_LOG_RING_BUFFER_SLOTS - 1)];
+            if (slot.isFirstChunk && slot.isLastChunk)
+            {
+                m_pTextHandler->HandleText(slot.textType, slot.text, slot.length);
+            }
+            else
+            {
+                PendingRecord & pending = m_pendingRecords[slot.producerId];
+                if (slot.isFirstChunk)
+                {
+                    //  Any partial record left by this producer had its last chunks dropped.
+                    pending.textType = slot.textType;
+                    pending.text.clear();
+                }
+                pending.text.append(slot.text, slot.length);
+                if (slot.isLastChunk)
+                {
+                    m_pTextHandler->HandleText(pending.textType, pending.text.c_str(), pending.text.length());
+                    pending.text.clear();
+                }
+            }
+            slot.sequence.store(m_dequeuePosition + C_LOG_RING_BUFFER_SLOTS, std::memory_order_release);
+            ++m_dequeuePosition;
+        }
+    }
+
+    void ReportDroppedRecords()
+    {
+        const ULONGLONG droppedRecords = m_droppedRecords.load(std::memory_order_relaxed);
+        if (droppedRecords != m_reportedDroppedRecords)
+        {
+            char message[128];
+            int length = sprintf_s(message, _countof(message), "ExdiGdbSrv logger: %I64u records dropped (total %I64u)",
+                                   droppedRecords - m_reportedDroppedRecords, droppedRecords);
+            if (length > 0)
+            {
+                m_pTextHandler->HandleText(GdbSrvControllerLib::GdbSrvTextType::CommandError, message, length);
+            }
+            m_reportedDroppedRecords = droppedRecords;
+        }
+    }
+
+    static DWORD CALLBACK LoggingThreadBody(LPVOID p)
+    {
+        AsyncCommandLogger * pLogger = reinterpret_cast<AsyncCommandLogger *>(p);
+        assert(pLogger != nullptr);
+
+        for (;;)
+        {
+            pLogger->DrainRecords();
+            pLogger->ReportDroppedRecords();
+            if (pLogger->m_isStopping.load(std::memory_order_acquire))
+            {
+                //  Flush the records pushed after the last drain
+                pLogger->DrainRecords();
+                pLogger->ReportDroppedRecords();
+                break;
+            }
+
+            //  Tell the producers to signal the event, then check again for records
+            //  pushed before the flag was visible, so no wake up is lost.
+            pLogger->m_isConsumerWaiting.store(true);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            if (!pLogger->IsRecordAvailable())
+            {
+                WaitForSingleObject(pLogger->m_dataAvailableEvent, C_LOG_THREAD_WAIT_TIMEOUT);
+            }
+            pLogger->m_isConsumerWaiting.store(false, std::memory_order_release);
+        }
+        return 0;
+    }
+
+    std::unique_ptr<GdbSrvControllerLib::IGdbSrvTextHandler> m_pTextHandler;
+    std::unique_ptr<LogRecordSlot[]> m_spRingBuffer;
+    std::atomic<size_t> m_enqueuePosition;
+    size_t m_dequeuePosition;
+    std::atomic<bool> m_isConsumerWaiting;
+    std::atomic<bool> m_isStopping;
+    std::atomic<ULONGLONG> m_droppedRecords;
+    ULONGLONG m_reportedDroppedRecords;
+    std::map<DWORD, PendingRecord> m_pendingRecords;
+    HANDLE m_dataAvailableEvent;
+    HANDLE m_loggingThread;
+
+    AsyncCommandLogger(_In_ const AsyncCommandLogger &);
+    void operator=(_In_ const AsyncCommandLogger &);
+};
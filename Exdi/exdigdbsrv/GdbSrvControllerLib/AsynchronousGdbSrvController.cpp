@@ -181,6 +181,13 @@ AsynchronousGdbSrvController::~AsynchronousGdbSrvController()
 //
 unsigned AsynchronousGdbSrvController::CreateCodeBreakpoint(_In_ AddressType address)
 {
+    //  The GdbServer can save the original instruction when it inserts the breakpoint.
+    AddressType faultAddress = 0;
+    if (!FlushPendingMemoryWrites(&faultAddress))
+    {
+        ThrowFailedMemoryWrite(faultAddress, "inserting a breakpoint");
+    }
+
     unsigned slot = static_cast<unsigned>(-1);
     for(unsigned i = 0; i < m_breakpointSlots.size(); ++i)
     {
@@ -258,6 +265,13 @@ unsigned AsynchronousGdbSrvController::CreateCodeBreakpoint(_In_ AddressType add
 //
 void AsynchronousGdbSrvController::DeleteCodeBreakpoint(_In_ unsigned breakpointNumber, _In_ AddressType address)
 {
+    //  The GdbServer restores the saved instruction, so the deferred writes have to be sent first.
+    AddressType faultAddress = 0;
+    if (!FlushPendingMemoryWrites(&faultAddress))
+    {
+        ThrowFailedMemoryWrite(faultAddress, "removing a breakpoint");
+    }
+
     if (breakpointNumber >= m_breakpointSlots.size() || !m_breakpointSlots[breakpointNumber])
     {
         throw std::exception("Trying to delete nonexisting breakpoint");
@@ -486,6 +500,15 @@ void AsynchronousGdbSrvController::StartAsynchronousCommand(_In_ LPCSTR pCommand
         throw std::exception("Cannot execute a command while an asynchronous command is in progress (e.g. target is running).");
     }
 
+    //  The deferred memory writes have to reach the target before it resumes.
+    AddressType faultAddress = 0;
+    if (!FlushPendingMemoryWrites(&faultAddress))
+    {
+        ThrowFailedMemoryWrite(faultAddress, "resuming the target");
+    }
+    FlushAddressTranslations();
+    DiscardAllProcessorsRegisters();
+
     if (m_asynchronousCommandThread != nullptr)
     {
         CloseHandle(m_asynchronousCommandThread);
@@ -788,3 +811,15 @@ void AsynchronousGdbSrvController::SetInterruptEvent()
     GdbSrvController::SetInterruptEvent();
 }
 
+//  Reports a deferred memory write that failed, the operation that needed the write is not done
+//  (i.e. the target is not resumed with stale memory).
+void AsynchronousGdbSrvController::ThrowFailedMemoryWrite(_In_ AddressType faultAddress, _In_ LPCSTR pOperation)
+{
+    assert(pOperation != nullptr);
+    char message[256];
+    sprintf_s(message, _countof(message), "Failed writing the deferred memory write at address 0x%I64x before %s.",
+              faultAddress, pOperation);
+    DisplayLogEntry(message, strlen(message));
+    throw std::exception(message);
+}
+
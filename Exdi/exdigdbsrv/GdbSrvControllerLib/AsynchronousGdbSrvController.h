@@ -75,6 +75,7 @@ namespace GdbSrvControllerLib
 
         static DWORD CALLBACK AsynchronousCommandThreadBody(LPVOID p);
         int GetBreakPointSize();
+        void ThrowFailedMemoryWrite(_In_ AddressType faultAddress, _In_ LPCSTR pOperation);
 
         std::vector<bool> m_breakpointSlots;
         std::vector<bool> m_dataBreakpointSlots;
@@ -21,6 +21,8 @@
 #include <codecvt>
 #include "TargetArchitectureHelpers.h"
 #include "TargetGdbServerHelpers.h"
+#include "TargetDescriptionCache.h"
+#include "PageTableWalker.h"
 
 using namespace GdbSrvControllerLib;
 
@@ -39,9 +41,13 @@ const DWORD C_MAX_REGISTER_NAME_ARRAY_ELEM = 32;
 const PCWSTR exdiComponentFunctionList[] =
 {
     L"connect",
-    L"close"
+    L"close",
+    L"stressregisters"
 };
 
+//  Number of iterations of the registers stress function (see StressProcessorsRegisters).
+const unsigned C_STRESS_REGISTERS_ITERATIONS = 100;
+
 // 
 //  Request to read feature target file from the GDB server 
 //  It's use to request reading xml registers target file.
@@ -86,6 +92,42 @@ PCSTR const g_headerRegisterVerbose[] =
     "Access code"
 };
 
+//  Invalid index in the system register vector
+const size_t c_InvalidRegisterIndex = static_cast<size_t>(-1);
+
+//  Entry of the flat system register decoding table (the table is sorted by access code).
+typedef struct
+{
+    AddressType accessCode;     //  System register access code (encoded system register index).
+    size_t registerIndex;       //  Index in the system register vector (c_InvalidRegisterIndex if the server does not report it).
+    const char * pName;         //  System register name (it points to the access code map entry).
+} SystemRegisterDecodeEntry;
+
+//  Maximum number of bytes kept in the memory write-back buffer before it's flushed.
+const size_t C_MAX_PENDING_MEMORY_WRITE_BYTES = 64 * 1024;
+
+//  Memory write deferred by the write-back buffer (it's kept for error attribution).
+typedef struct
+{
+    AddressType address;                //  Start address of the original write.
+    std::vector<unsigned char> data;    //  Data of the original write.
+} PendingMemoryWrite;
+
+//  Set of deferred memory writes for one memory access type.
+typedef struct
+{
+    memoryAccessType memType;                                           //  Memory class accessed by the writes.
+    std::map<AddressType, std::vector<unsigned char>> coalescedRanges;  //  Merged overlapping/adjacent writes keyed by start address.
+    std::vector<PendingMemoryWrite> writes;                             //  Original writes in issue order.
+} PendingMemoryWriteSet;
+
+//  Deferred memory write that failed when the write-back buffer was flushed.
+typedef struct
+{
+    memoryAccessType memType;           //  Memory class accessed by the write.
+    PendingMemoryWrite write;           //  Address and data of the original write.
+} FailedMemoryWrite;
+
 //=============================================================================
 // Private function definitions
 //=============================================================================
@@ -105,7 +147,10 @@ public:
         m_pRspClient(std::unique_ptr <GdbSrvRspClient<TcpConnectorStream>>
             (new (std::nothrow) GdbSrvRspClient<TcpConnectorStream>(coreNumberConnectionParameters))),
         m_IsForcedPAMemoryMode(false),
-        m_ConfigPAMemMode(false)
+        m_ConfigPAMemMode(false),
+        m_pendingMemoryWriteBytes(0),
+        m_isPagingRegistersProbed(false),
+        m_isPagingRegistersAvailable(false)
     {
         m_cachedKPCRStartAddress.clear();
         m_targetProcessorIds.clear();
@@ -114,8 +159,20 @@ public:
             this, std::placeholders::_1, std::placeholders::_2));
         SetExdiFunctions(exdiComponentFunctionList[0], std::bind(&GdbSrvControllerImpl::CloseGdbSrvCore,
             this, std::placeholders::_1, std::placeholders::_2));
+        SetExdiFunctions(exdiComponentFunctionList[2], std::bind(&GdbSrvControllerImpl::StressProcessorsRegisters,
+            this, std::placeholders::_1, std::placeholders::_2));
         ConfigExdiGdbServerHelper& cfgData = ConfigExdiGdbServerHelper::GetInstanceCfgExdiGdbServer(nullptr);
         m_IsThrowExceptionEnabled = cfgData.IsExceptionThrowEnabled();
+        m_IsMemoryWriteCoalescingEnabled = cfgData.IsMemoryWriteCoalescingEnabled();
+        if (cfgData.GetServerRequirePAMemoryAccess() && cfgData.IsHostPageTableWalkEnabled())
+        {
+            m_spPageTableWalker = unique_ptr<PageTableWalker>(new (std::nothrow) PageTableWalker(
+                std::bind(&GdbSrvControllerImpl::ReadPageTableEntry, this, std::placeholders::_1)));
+            if (m_spPageTableWalker == nullptr)
+            {
+                throw _com_error(E_OUTOFMEMORY);
+            }
+        }
         InitializeSystemRegistersFunctions();
         InitializeInternalGdbClientFunctionMap();
         cfgData.GetGdbServerRegisters(&m_spRegisterVector);
@@ -123,6 +180,8 @@ public:
 
     GdbSrvControllerImpl::~GdbSrvControllerImpl()
     {
+        //  The deferred memory writes (i.e. restored breakpoint instructions) have to reach the target.
+        FlushPendingMemoryWritesOnClose();
         ShutdownGdbSrv();
 
         delete m_pTextHandler;
@@ -427,6 +486,9 @@ public:
     {
         assert(m_pRspClient != nullptr);
 
+        //  A new session does not keep the thread selected by the previous one.
+        m_selectedThreadCommands.clear();
+
         pSetDisplayCommData pFunction = nullptr;
         ConfigExdiGdbServerHelper & cfgData = ConfigExdiGdbServerHelper::GetInstanceCfgExdiGdbServer(nullptr);
         if (fDisplayCommData)
@@ -464,6 +526,7 @@ public:
     {
         bool isDone = false;
 
+        DiscardAllProcessorsRegisters();
         //  Send the restart packet. It's only supported in extended mode.
         const char cmdRestartTarget[] = "R";
         std::string reply = ExecuteCommandEx(cmdRestartTarget, false, 0);
@@ -552,6 +615,7 @@ public:
                 //  Get the actual system register vector from the table.
                 cfgData.GetGdbServerSystemRegisters(&m_spSystemRegisterVector);
             }
+            BuildSystemRegisterDecodeTable();
 
             //  Enable extended features that are no advertised by the qSupported GDB server response,
             //  it's needed to read system registers/ARM64 CP15 registers in such GDB servers w/o
@@ -722,6 +786,10 @@ public:
     //      $OK#9a
     //      +
     //
+    //  Note.
+    //  The command is not sent if the thread is already selected for the operation, the selection
+    //  is forgotten when the target resumes (the GdbServer selects the thread that stops).
+    //
     bool GdbSrvControllerImpl::SetThreadCommand(_In_ unsigned processorNumber, _In_ const char * pOperation)
     {
         assert(pOperation != nullptr);
@@ -746,6 +814,13 @@ public:
         {
             _snprintf_s(setThreadCommand, _TRUNCATE, "%s%s%s", setThreadCommand, pOperation, m_targetProcessorIds[processorNumber].c_str());
         }
+        std::string & selectedThreadCommand = m_selectedThreadCommands[pOperation];
+        if (selectedThreadCommand == setThreadCommand)
+        {
+            m_lastKnownActiveCpu = processorNumber;
+            return true;
+        }
+
         bool isSet = false;
         int retryCounter = 0;
         RSP_Response_Packet replyType = RSP_ERROR;
@@ -761,6 +836,7 @@ public:
             if (replyType == RSP_OK)
             {
                 m_lastKnownActiveCpu = processorNumber;
+                m_selectedThreadCommands[pOperation] = setThreadCommand;
                 isSet = true;
                 break;
             }
@@ -776,12 +852,20 @@ public:
 
     //
     //  SetTextHandler  Stores the pointer to the trace/logging class (this module will own the pointer now).
+    //                  The handler calls are serialized, since the packets of different channels are
+    //                  exchanged concurrently (see QueryAllProcessorsRegisters).
     //
     void GdbSrvControllerImpl::SetTextHandler(_In_ IGdbSrvTextHandler * pHandler)
     {
         assert(pHandler != m_pTextHandler && pHandler != nullptr);
+        SerializedTextHandler * pSerializedHandler = new (std::nothrow) SerializedTextHandler(pHandler);
+        if (pSerializedHandler == nullptr)
+        {
+            delete pHandler;
+            throw _com_error(E_OUTOFMEMORY);
+        }
         delete m_pTextHandler;
-        m_pTextHandler = pHandler;
+        m_pTextHandler = pSerializedHandler;
     }
 
     //
@@ -814,6 +898,10 @@ public:
     //  Return:
     //  The command response.
     //
+    //  Note.
+    //  The channel lock is held across the request and its response, so a concurrent exchange on
+    //  the same channel cannot take the response.
+    //
     std::string GdbSrvControllerImpl::ExecuteCommandOnProcessor(_In_ LPCSTR pCommand, _In_ bool isRspWaitNeeded, _In_ size_t stringSize,
                                                                 _In_ unsigned processor)
     {
@@ -833,32 +921,73 @@ public:
             result.reserve(stringSize);
         }
 
+        //  An explicit thread selection replaces the one done by SetThreadCommand.
+        if (pCommand[0] == 'H')
+        {
+            m_selectedThreadCommands.clear();
+        }
+
+        scoped_lock exchangeGuard(m_pRspClient->GetChannelLock(processor));
+        SendCommandOnProcessor(pCommand, processor);
+        ReceiveResponseOnProcessor(result, isRspWaitNeeded, true, processor);
+        return result;
+    }
+
+    //
+    //  SendCommandOnProcessor  Sends a GdbServer command on a particular processor core without
+    //                          waiting for the command response.
+    //
+    //  Parameters:
+    //  pCommand                Pointer to the command to be sent.
+    //  processor               Processor core to send the command.
+    //
+    //  Return:
+    //  Nothing, it throws if the packet could not be sent.
+    //
+    void GdbSrvControllerImpl::SendCommandOnProcessor(_In_ LPCSTR pCommand, _In_ unsigned processor)
+    {
+        assert(pCommand != nullptr);
+
         if (m_pTextHandler != nullptr && m_displayCommands)
         {
             m_pTextHandler->HandleText(GdbSrvTextType::Command, pCommand, strlen(pCommand));
         }
 
         std::string command(pCommand);
-        bool isDone = m_pRspClient->SendRspPacket(command, processor);
-        if (isDone)
+        if (!m_pRspClient->SendRspPacket(command, processor))
         {
-            isDone = m_pRspClient->ReceiveRspPacket(result, processor, isRspWaitNeeded);
-            if (!isDone)
-            {
-                //  Did the user interrupt?
-                if (!m_pRspClient->GetInterruptFlag())
-                {
-                    //  No, then this is a fatal error or a communication error ocurred
-                    m_pRspClient->HandleRspErrors(GdbSrvTextType::CommandError);
-                    throw _com_error(HRESULT_FROM_WIN32(m_pRspClient->GetRspLastError()));
-                }
-            }
+            //  A fatal error or a communication error ocurred
+            m_pRspClient->HandleRspErrors(GdbSrvTextType::CommandError, processor);
+            throw _com_error(HRESULT_FROM_WIN32(m_pRspClient->GetRspLastError(processor)));
         }
-        else
+    }
+
+    //
+    //  ReceiveResponseOnProcessor  Receives the response of a command previously sent on a particular processor core.
+    //
+    //  Parameters:
+    //  result                      Reference to the string receiving the command response.
+    //  isRspWaitNeeded             Flag tells if we need to wait forever for the response.
+    //  fResetBuffer                Flag indicates if any pending data in the cached receive buffer has to be discarded,
+    //                              it has to be false when collecting the responses of pipelined commands.
+    //  processor                   Processor core where the command was sent.
+    //
+    //  Return:
+    //  Nothing, it throws if a communication error occurred.
+    //
+    void GdbSrvControllerImpl::ReceiveResponseOnProcessor(_Out_ std::string & result, _In_ bool isRspWaitNeeded,
+                                                          _In_ bool fResetBuffer, _In_ unsigned processor)
+    {
+        bool isPollingMode = false;
+        if (!m_pRspClient->ReceiveRspPacketEx(result, processor, isRspWaitNeeded, isPollingMode, fResetBuffer))
         {
-            //  A fatal error or a communication error ocurred
-            m_pRspClient->HandleRspErrors(GdbSrvTextType::CommandError);
-            throw _com_error(HRESULT_FROM_WIN32(m_pRspClient->GetRspLastError()));
+            //  Did the user interrupt?
+            if (!m_pRspClient->GetInterruptFlag())
+            {
+                //  No, then this is a fatal error or a communication error ocurred
+                m_pRspClient->HandleRspErrors(GdbSrvTextType::CommandError, processor);
+                throw _com_error(HRESULT_FROM_WIN32(m_pRspClient->GetRspLastError(processor)));
+            }
         }
 
         if (m_pTextHandler != nullptr && m_displayCommands)
@@ -866,7 +995,6 @@ public:
             const char * pResult = result.c_str(); 
             m_pTextHandler->HandleText(GdbSrvTextType::CommandOutput, pResult, strlen(pResult));
         }
-        return result;
     }
 
     //
@@ -898,8 +1026,8 @@ public:
         if (!isDone)
         {
             //  A fatal error or a communication error ocurred
-            m_pRspClient->HandleRspErrors(GdbSrvTextType::CommandError);
-            throw _com_error(HRESULT_FROM_WIN32(m_pRspClient->GetRspLastError()));
+            m_pRspClient->HandleRspErrors(GdbSrvTextType::CommandError, processor);
+            throw _com_error(HRESULT_FROM_WIN32(m_pRspClient->GetRspLastError(processor)));
         }
 
         if (m_pTextHandler != nullptr && m_displayCommands)
@@ -953,7 +1081,8 @@ public:
         bool isDone = false;
         unsigned numberOfCoreConnections = static_cast<unsigned>(m_pRspClient->GetNumberOfStreamConnections());
 
-        for (unsigned core = 0; core < numberOfCoreConnections; ++core)
+        unsigned core = 0;
+        for (; core < numberOfCoreConnections; ++core)
         {
             isDone = m_pRspClient->SendRspPacket(command, core);
             if (!isDone)
@@ -967,7 +1096,7 @@ public:
             bool IsPollingChannelMode = true;
 
             //  Start checking response from the last known processor core.
-            unsigned core = GetLastKnownActiveCpu();
+            core = GetLastKnownActiveCpu();
             for (;;)
             {
                 isDone = m_pRspClient->ReceiveRspPacketEx(result, core, isRspWaitNeeded, IsPollingChannelMode, true);
@@ -985,8 +1114,8 @@ public:
         else
         {
             //  A fatal error or a communication error ocurred
-            m_pRspClient->HandleRspErrors(GdbSrvTextType::CommandError);
-            throw _com_error(HRESULT_FROM_WIN32(m_pRspClient->GetRspLastError()));
+            m_pRspClient->HandleRspErrors(GdbSrvTextType::CommandError, core);
+            throw _com_error(HRESULT_FROM_WIN32(m_pRspClient->GetRspLastError(core)));
         }
 
         if (m_pTextHandler != nullptr && m_displayCommands)
@@ -1091,8 +1220,22 @@ public:
         {
             throw _com_error(E_FAIL);
         }
+        return ParseAllRegistersReply(reply, groupType);
+    }
 
-        size_t numberOfElements = 0;
+    //
+    //  ParseAllRegistersReply  Parses the response of the read all registers request ('g').
+    //
+    //  Parameters:
+    //  reply                   Reference to the 'g' response.
+    //  groupType               Register group type.
+    //
+    //  Return:
+    //  A map containing the register name and its hex-decimal ascii value.
+    //
+    std::map<std::string, std::string> GdbSrvControllerImpl::ParseAllRegistersReply(_In_ const std::string & reply,
+                                                                                     _In_ RegisterGroupType groupType)
+    {
         std::map<std::string, std::string> result;
         size_t startIdx = 0;
         size_t endIdx = 0;
@@ -1141,6 +1284,227 @@ public:
         return QueryAllRegistersEx(processorNumber, CORE_REGS);
     }
 
+    //
+    //  QueryAllProcessorsRegisters Reads the core registers of all the processor cores.
+    //
+    //  Parameters:
+    //
+    //  Return:
+    //  A vector indexed by processor core containing the register maps (register name and its hex-decimal ascii value).
+    //
+    //  Note.
+    //  In multi-core GdbServer sessions each core has its own channel, so the 'g' requests are
+    //  sent concurrently (a worker thread per core), otherwise the cores are read one after the other.
+    //  The result is kept as the register snapshot of the halted target (see QueryAllRegistersFromSnapshot).
+    //
+    std::vector<std::map<std::string, std::string>> GdbSrvControllerImpl::QueryAllProcessorsRegisters()
+    {
+        ConfigExdiGdbServerHelper & cfgData = ConfigExdiGdbServerHelper::GetInstanceCfgExdiGdbServer(nullptr);
+        const unsigned numberOfProcessors = GetProcessorCount();
+        std::vector<std::map<std::string, std::string>> result(numberOfProcessors);
+        if (!cfgData.GetMultiCoreGdbServer() || m_pRspClient->GetNumberOfStreamConnections() < numberOfProcessors)
+        {
+            const unsigned lastKnownActiveCpu = GetLastKnownActiveCpu();
+            for (unsigned processorNumber = 0; processorNumber < numberOfProcessors; ++processorNumber)
+            {
+                result[processorNumber] = QueryAllRegistersEx(processorNumber, CORE_REGS);
+            }
+            //  Restore the active processor core.
+            SetThreadCommand(lastKnownActiveCpu, "g");
+        }
+        else
+        {
+            std::vector<ProcessorRegistersRequest> requests(numberOfProcessors);
+            std::vector<HANDLE> workerThreads;
+            workerThreads.reserve(numberOfProcessors);
+            HRESULT hr = S_OK;
+            for (unsigned processorNumber = 0; processorNumber < numberOfProcessors; ++processorNumber)
+            {
+                requests[processorNumber].pController = this;
+                requests[processorNumber].processorNumber = processorNumber;
+                requests[processorNumber].result = E_PENDING;
+                HANDLE workerThread = CreateThread(nullptr, 0, QueryProcessorRegistersThreadBody,
+                                                   reinterpret_cast<PVOID>(&requests[processorNumber]), 0, nullptr);
+                if (workerThread == nullptr)
+                {
+                    hr = HRESULT_FROM_WIN32(GetLastError());
+                    break;
+                }
+                workerThreads.push_back(workerThread);
+            }
+
+            //  Wait for all the started workers before touching the requests.
+            for (HANDLE workerThread : workerThreads)
+            {
+                WaitForSingleObject(workerThread, INFINITE);
+                CloseHandle(workerThread);
+            }
+            if (FAILED(hr))
+            {
+                throw _com_error(hr);
+            }
+
+            for (unsigned processorNumber = 0; processorNumber < numberOfProcessors; ++processorNumber)
+            {
+                if (FAILED(requests[processorNumber].result))
+                {
+                    throw _com_error(requests[processorNumber].result);
+                }
+                result[processorNumber].swap(requests[processorNumber].registers);
+            }
+        }
+
+        m_allProcessorsRegisters = result;
+        return result;
+    }
+
+    //
+    //  QueryAllRegistersFromSnapshot   Reads the core registers of a processor core by using the registers
+    //                                  snapshot of the halted target.
+    //
+    //  Parameters:
+    //  processorNumber                 Processor core number.
+    //
+    //  Return:
+    //  A map containing the register name and its hex-decimal ascii value.
+    //
+    //  Note.
+    //  In multi-core GdbServer sessions the first request after the target stops reads all the cores
+    //  concurrently, and the next requests are served from the snapshot until the target resumes
+    //  or a register is written. Otherwise it's the same as QueryAllRegisters.
+    //
+    std::map<std::string, std::string> GdbSrvControllerImpl::QueryAllRegistersFromSnapshot(_In_ unsigned processorNumber)
+    {
+        ConfigExdiGdbServerHelper & cfgData = ConfigExdiGdbServerHelper::GetInstanceCfgExdiGdbServer(nullptr);
+        if (!cfgData.GetMultiCoreGdbServer())
+        {
+            return QueryAllRegisters(processorNumber);
+        }
+
+        if (m_allProcessorsRegisters.empty())
+        {
+            QueryAllProcessorsRegisters();
+        }
+        if (processorNumber >= m_allProcessorsRegisters.size())
+        {
+            return QueryAllRegisters(processorNumber);
+        }
+
+        //  The next commands are sent to this processor core, as when the registers are read.
+        if (!SetThreadCommand(processorNumber, "g"))
+        {
+            throw _com_error(E_FAIL);
+        }
+        return m_allProcessorsRegisters[processorNumber];
+    }
+
+    //
+    //  DiscardAllProcessorsRegisters   Discards the registers snapshot of the halted target.
+    //                                  It's called when the target resumes, so the thread
+    //                                  selected by SetThreadCommand is forgotten too.
+    //
+    void GdbSrvControllerImpl::DiscardAllProcessorsRegisters()
+    {
+        m_allProcessorsRegisters.clear();
+        m_systemRegistersSnapshot.clear();
+        m_selectedThreadCommands.clear();
+    }
+
+    //
+    //  QueryAllRegistersOnChannel  Reads the core registers on the channel of a processor core.
+    //                              It does not change the last known active processor, so it
+    //                              can be called concurrently for different cores.
+    //
+    std::map<std::string, std::string> GdbSrvControllerImpl::QueryAllRegistersOnChannel(_In_ unsigned processorNumber)
+    {
+        std::string reply = ExecuteCommandOnProcessor("g", true, 0, processorNumber);
+        if (IsReplyError(reply))
+        {
+            throw _com_error(E_FAIL);
+        }
+        return ParseAllRegistersReply(reply, CORE_REGS);
+    }
+
+    //
+    //  StressProcessorsRegisters   Exdi component function ("stressregisters") that stresses the concurrent
+    //                              packet exchange against the connected GdbServer.
+    //
+    //  Parameters:
+    //  connectionStr               Connection string (not used).
+    //  core                        Processor core (not used, all the cores are read).
+    //
+    //  Return:
+    //  true                        if all the concurrent reads matched the serial reads.
+    //  false                       otherwise, the mismatches are reported in the command log.
+    //
+    //  Note.
+    //  The target has to be halted. The core registers are read one core after the other, and then
+    //  C_STRESS_REGISTERS_ITERATIONS times concurrently (a worker per channel in multi-core sessions)
+    //  and from the registers snapshot, every read has to return the same registers.
+    //
+    bool GdbSrvControllerImpl::StressProcessorsRegisters(_In_ const std::wstring & connectionStr, _In_ unsigned core)
+    {
+        UNREFERENCED_PARAMETER(connectionStr);
+        UNREFERENCED_PARAMETER(core);
+
+        const unsigned lastKnownActiveCpu = GetLastKnownActiveCpu();
+        const unsigned numberOfProcessors = GetProcessorCount();
+        std::vector<std::map<std::string, std::string>> expectedRegisters(numberOfProcessors);
+        for (unsigned processorNumber = 0; processorNumber < numberOfProcessors; ++processorNumber)
+        {
+            expectedRegisters[processorNumber] = QueryAllRegistersEx(processorNumber, CORE_REGS);
+        }
+
+        char message[256];
+        unsigned mismatches = 0;
+        for (unsigned iteration = 0; iteration < C_STRESS_REGISTERS_ITERATIONS; ++iteration)
+        {
+            DiscardAllProcessorsRegisters();
+            std::vector<std::map<std::string, std::string>> allRegisters = QueryAllProcessorsRegisters();
+            for (unsigned processorNumber = 0; processorNumber < numberOfProcessors; ++processorNumber)
+            {
+                if (allRegisters[processorNumber] != expectedRegisters[processorNumber] ||
+                    QueryAllRegistersFromSnapshot(processorNumber) != expectedRegisters[processorNumber])
+                {
+                    sprintf_s(message, _countof(message), "stressregisters: the registers of core %u do not match at iteration %u",
+                              processorNumber, iteration);
+                    DisplayLogEntry(message, strlen(message));
+                    ++mismatches;
+                }
+            }
+        }
+        DiscardAllProcessorsRegisters();
+        SetThreadCommand(lastKnownActiveCpu, "g");
+
+        sprintf_s(message, _countof(message), "stressregisters: %u iterations on %u cores, %u mismatches",
+                  C_STRESS_REGISTERS_ITERATIONS, numberOfProcessors, mismatches);
+        DisplayLogEntry(message, strlen(message));
+        return mismatches == 0;
+    }
+
+    //
+    //  QueryProcessorRegistersThreadBody   Worker thread reading the core registers of one processor core.
+    //
+    static DWORD WINAPI QueryProcessorRegistersThreadBody(_In_ LPVOID pParameter)
+    {
+        ProcessorRegistersRequest * pRequest = reinterpret_cast<ProcessorRegistersRequest *>(pParameter);
+        assert(pRequest != nullptr && pRequest->pController != nullptr);
+        try
+        {
+            pRequest->registers = pRequest->pController->QueryAllRegistersOnChannel(pRequest->processorNumber);
+            pRequest->result = S_OK;
+        }
+        catch (_com_error & error)
+        {
+            pRequest->result = error.Error();
+        }
+        catch (...)
+        {
+            pRequest->result = E_FAIL;
+        }
+        return 0;
+    }
+
     //
     //  SetRegistersEx      Sets all general registers.  
     //
@@ -1172,6 +1536,9 @@ public:
                                               _In_ bool isRegisterValuePtr,
                                               _In_ RegisterGroupType groupType = CORE_REGS)
     {
+        //  The register values can change the address translation.
+        m_pagingRegisters.clear();
+        DiscardAllProcessorsRegisters();
         if (processorNumber != -1)
         {
             //  Set the processor core before setting the register values.
@@ -1255,23 +1622,16 @@ public:
             }
         }
 
-        std::map<std::string, std::string> result;
+        std::vector<const RegistersStruct *> registersToQuery;
+        registersToQuery.reserve(numberOfElements);
         for (size_t index = 0; index < numberOfElements; ++index)
         {
-            std::string registerName(registerNames[index]); 
-            const_regIterator it = FindRegisterVectorEntryEx(registerName, groupType);
-
-            char command[512];
-            _snprintf_s(command, _TRUNCATE, "p%s", it->nameOrder.c_str());
-
-            std::string reply = ExecuteCommand(command);
-            if (IsReplyError(reply) || reply.empty())
-            {
-                throw _com_error(E_FAIL);
-            }
-            //  Process the register value returned by the GDBServer
-            result[registerName] = TargetArchitectureHelpers::ReverseRegValue(reply);
+            const_regIterator it = FindRegisterVectorEntryEx(registerNames[index], groupType);
+            registersToQuery.push_back(&(*it));
         }
+
+        std::map<std::string, std::string> result;
+        QueryRegisterValuesBatch(registersToQuery, result);
         return result;
     }
 
@@ -1326,83 +1686,206 @@ public:
         }
 
         maxRegisterNameLength = 0;
-        std::map<std::string, std::string> result;
+        std::vector<const RegistersStruct *> registersToQuery;
+        registersToQuery.reserve(RegistersGroupSize(groupType));
         for (const_regIterator it = RegistersBegin(groupType);
             it != RegistersEnd(groupType); ++it)
         {
-            const_regIterator itReg = FindRegisterVectorEntryEx(it->name, groupType);
-
-            char command[512];
-            _snprintf_s(command, _TRUNCATE, "p%s", itReg->nameOrder.c_str());
-
-            std::string reply = ExecuteCommand(command);
-            if (IsReplyError(reply) || reply.empty())
-            {
-                throw _com_error(E_FAIL);
-            }
-            maxRegisterNameLength = (maxRegisterNameLength < itReg->name.length()) ? 
-                static_cast<int>(itReg->name.length()) :
+            maxRegisterNameLength = (maxRegisterNameLength < it->name.length()) ? 
+                static_cast<int>(it->name.length()) :
                 maxRegisterNameLength;
-            //  Process the register value returned by the GDBServer
-            result[itReg->name] = TargetArchitectureHelpers::ReverseRegValue(reply);
+            registersToQuery.push_back(&(*it));
         }
+
+        std::map<std::string, std::string> result;
+        QueryRegisterValuesBatch(registersToQuery, result);
         return result;
     }
 
     //
-    //  ReadSystemRegistersFromGdbMonitor Obtains a register value from the GDB monitor command response.
+    //  QuerySystemRegistersByAccessCode    Request reading a set of system registers identified by their access codes.
     //
     //  Parameters:
-    //  systemRegIndex  Address pointing to the system register inndex encoded.
-    //  maxSize         Size of the expected system register value.
-    //  memType         The memory class that will be accessed by the read operation.
+    //  processorNumber                     Processor core number.
+    //  accessCodes                         Array of system register access codes (encoded system register index).
+    //  numberOfElements                    Number of elements in the access code array.
     //
     //  Return:
-    //  A simple buffer object containing the system register value.
+    //  A map containing the register access code and its hex-decimal ascii value.
     //
+    //  Note.
+    //  The access codes are decoded by the sorted system register table, and the registers
+    //  are read by the same batched "p n" requests used for reading a full register group.
     //
-    SimpleCharBuffer GdbSrvControllerImpl::ReadSystemRegistersFromGdbMonitor(
-        _In_ AddressType systemRegIndex,
-        _In_ size_t maxSize,
-        _In_ const memoryAccessType memType)
+    std::map<AddressType, std::string> GdbSrvControllerImpl::QuerySystemRegistersByAccessCode(
+        _In_ unsigned processorNumber,
+        _In_reads_(numberOfElements) const AddressType accessCodes[],
+        _In_ const size_t numberOfElements)
     {
-        // Decode the system register passed in index.
-        SystemRegister systemReg = {0};
-        if (TargetArchitectureHelpers::SetSystemRegister(m_targetProcessorArch, systemRegIndex, &systemReg) != S_OK)
+        if (accessCodes == nullptr || m_spSystemRegisterVector == nullptr)
         {
-            throw _com_error(E_NOTIMPL);
+            throw _com_error(E_INVALIDARG);
         }
 
-        PCSTR pFormat = GetReadMemoryCmd(memType);
-        if (pFormat == nullptr)
-        {
-            throw _com_error(E_UNEXPECTED);
-        }
-        unique_ptr<wchar_t> pWideFormat(new (nothrow) wchar_t[strlen(pFormat) + 1]);
-        if (pWideFormat == nullptr)
+        std::vector<const RegistersStruct *> registersToQuery;
+        registersToQuery.reserve(numberOfElements);
+        for (size_t index = 0; index < numberOfElements; ++index)
         {
-            throw _com_error(E_OUTOFMEMORY);
+            const SystemRegisterDecodeEntry * pEntry = FindSystemRegisterDecodeEntry(accessCodes[index]);
+            if (pEntry == nullptr || pEntry->registerIndex == c_InvalidRegisterIndex)
+            {
+                throw _com_error(E_INVALIDARG);
+            }
+            registersToQuery.push_back(&(*m_spSystemRegisterVector)[pEntry->registerIndex]);
         }
-        if (MultiByteToWideChar(CP_ACP, 0, pFormat, -1, pWideFormat.get(), static_cast<int>(strlen(pFormat) + 1)) == 0)
+
+        if (processorNumber != -1)
         {
-            throw _com_error(E_FAIL);
+            //  Set the processor core before setting the register values.
+            if (!SetThreadCommand(processorNumber, "g"))
+            {
+                throw _com_error(E_FAIL);
+            }
         }
 
-        wchar_t systemRegCmd[256] = {0};
-        swprintf_s(systemRegCmd, ARRAYSIZE(systemRegCmd), pWideFormat.get(),
-                   systemReg.Op0, systemReg.Op1, systemReg.CRn, systemReg.CRm, systemReg.Op2);
+        std::map<std::string, std::string> registerValues;
+        QueryRegisterValuesBatch(registersToQuery, registerValues);
 
-        SimpleCharBuffer monitorString = ExecuteExdiGdbSrvMonitor(GetLastKnownActiveCpu(), systemRegCmd);
-        std::string memoryValueStr(monitorString.GetInternalBuffer(), monitorString.GetEndOfData());
-        // Validate the response, since GDB can include additional spew in front of the register value
-        std::size_t pos = memoryValueStr.find("0x");
-        if (pos == string::npos || memoryValueStr.length() <= maxSize)
+        std::map<AddressType, std::string> result;
+        for (size_t index = 0; index < numberOfElements; ++index)
         {
-            throw _com_error(E_FAIL);
+            result[accessCodes[index]] = registerValues[registersToQuery[index]->name];
         }
+        return result;
+    }
 
-        ULONG64 regValue = 0;
-        if (sscanf_s(&memoryValueStr[pos], "%I64x", &regValue) != 1)
+    //
+    //  QueryRegisterValuesBatch    Reads a set of registers on the current processor core.
+    //
+    //  Parameters:
+    //  registersToQuery            Vector containing the register entries to read.
+    //  result                      Map receiving the register name and its hex-decimal ascii value.
+    //  isPartialResultAllowed      Flag if set then the registers that could not be read are left out
+    //                              of the result instead of failing the whole request.
+    //
+    //  Return:
+    //  Nothing, it throws if any register could not be read (unless isPartialResultAllowed is set).
+    //
+    //  Note.
+    //  If the no-ack mode is active then the "p n" requests are sent back to back, and their responses
+    //  are collected afterwards, so a batch costs a single round trip instead of one per register.
+    //  The total length of the requests in flight is bounded by the negotiated PacketSize, so
+    //  the server input buffer does not overflow. In ACK mode each request waits for its response.
+    //  The channel lock is held across the whole batch, so a concurrent exchange on the same
+    //  channel cannot interleave its packets with the requests in flight or take their responses.
+    //
+    void GdbSrvControllerImpl::QueryRegisterValuesBatch(_In_ const std::vector<const RegistersStruct *> & registersToQuery,
+                                                        _Inout_ std::map<std::string, std::string> & result,
+                                                        _In_ bool isPartialResultAllowed = false)
+    {
+        const unsigned processor = GetLastKnownActiveCpu();
+        const bool isPipelined = m_pRspClient->IsFeatureEnabled(PACKET_QSTART_NO_ACKMODE);
+
+        PacketConfig rspFeatures;
+        m_pRspClient->GetRspPacketFeatures(&rspFeatures, PACKET_SIZE);
+        const size_t maxBatchLength = static_cast<size_t>(rspFeatures.featureDefaultValue);
+        //  Each request contains the 'p' command plus the "$" & "#nn" packet markers
+        const size_t packetOverhead = 5;
+
+        scoped_lock exchangeGuard(m_pRspClient->GetChannelLock(processor));
+        size_t batchStart = 0;
+        while (batchStart < registersToQuery.size())
+        {
+            size_t batchEnd = batchStart;
+            size_t batchLength = 0;
+            do
+            {
+                char command[512];
+                _snprintf_s(command, _TRUNCATE, "p%s", registersToQuery[batchEnd]->nameOrder.c_str());
+                SendCommandOnProcessor(command, processor);
+                batchLength += registersToQuery[batchEnd]->nameOrder.length() + packetOverhead;
+                ++batchEnd;
+            }
+            while (isPipelined && batchEnd < registersToQuery.size() &&
+                   (batchLength + registersToQuery[batchEnd]->nameOrder.length() + packetOverhead) <= maxBatchLength);
+
+            //  Collect all the responses of the batch even if one of them failed,
+            //  so no stale response is left pending for the next command.
+            bool isReplyError = false;
+            for (size_t index = batchStart; index < batchEnd; ++index)
+            {
+                std::string reply;
+                ReceiveResponseOnProcessor(reply, true, (index == batchStart), processor);
+                if (IsReplyError(reply) || reply.empty())
+                {
+                    isReplyError = true;
+                    continue;
+                }
+                //  Process the register value returned by the GDBServer
+                result[registersToQuery[index]->name] = TargetArchitectureHelpers::ReverseRegValue(reply);
+            }
+            if (isReplyError && !isPartialResultAllowed)
+            {
+                throw _com_error(E_FAIL);
+            }
+            batchStart = batchEnd;
+        }
+    }
+
+    //
+    //  ReadSystemRegistersFromGdbMonitor Obtains a register value from the GDB monitor command response.
+    //
+    //  Parameters:
+    //  systemRegIndex  Address pointing to the system register inndex encoded.
+    //  maxSize         Size of the expected system register value.
+    //  memType         The memory class that will be accessed by the read operation.
+    //
+    //  Return:
+    //  A simple buffer object containing the system register value.
+    //
+    //
+    SimpleCharBuffer GdbSrvControllerImpl::ReadSystemRegistersFromGdbMonitor(
+        _In_ AddressType systemRegIndex,
+        _In_ size_t maxSize,
+        _In_ const memoryAccessType memType)
+    {
+        // Decode the system register passed in index.
+        SystemRegister systemReg = {0};
+        if (TargetArchitectureHelpers::SetSystemRegister(m_targetProcessorArch, systemRegIndex, &systemReg) != S_OK)
+        {
+            throw _com_error(E_NOTIMPL);
+        }
+
+        PCSTR pFormat = GetReadMemoryCmd(memType);
+        if (pFormat == nullptr)
+        {
+            throw _com_error(E_UNEXPECTED);
+        }
+        unique_ptr<wchar_t> pWideFormat(new (nothrow) wchar_t[strlen(pFormat) + 1]);
+        if (pWideFormat == nullptr)
+        {
+            throw _com_error(E_OUTOFMEMORY);
+        }
+        if (MultiByteToWideChar(CP_ACP, 0, pFormat, -1, pWideFormat.get(), static_cast<int>(strlen(pFormat) + 1)) == 0)
+        {
+            throw _com_error(E_FAIL);
+        }
+
+        wchar_t systemRegCmd[256] = {0};
+        swprintf_s(systemRegCmd, ARRAYSIZE(systemRegCmd), pWideFormat.get(),
+                   systemReg.Op0, systemReg.Op1, systemReg.CRn, systemReg.CRm, systemReg.Op2);
+
+        SimpleCharBuffer monitorString = ExecuteExdiGdbSrvMonitor(GetLastKnownActiveCpu(), systemRegCmd);
+        std::string memoryValueStr(monitorString.GetInternalBuffer(), monitorString.GetEndOfData());
+        // Validate the response, since GDB can include additional spew in front of the register value
+        std::size_t pos = memoryValueStr.find("0x");
+        if (pos == string::npos || memoryValueStr.length() <= maxSize)
+        {
+            throw _com_error(E_FAIL);
+        }
+
+        ULONG64 regValue = 0;
+        if (sscanf_s(&memoryValueStr[pos], "%I64x", &regValue) != 1)
         {
             throw _com_error(E_INVALIDARG);
         }
@@ -1439,6 +1922,12 @@ public:
     //
     //  Response:
     //
+    //  Note.
+    //  The debugger engine reads the system registers one at the time, so the first read after the target
+    //  stops fetches the whole system register group of the processor by a batched request
+    //  (see QueryRegisterValuesBatch) and the next reads are served from it until the target resumes
+    //  or a register is written. A register that the batch could not read is requested on its own.
+    //
     SimpleCharBuffer GdbSrvControllerImpl::ReadSysRegByQueryRegGdbCmd(
         _In_ AddressType address, 
         _In_ size_t maxSize, 
@@ -1449,9 +1938,25 @@ public:
         const char* arraySystemRegisterToQuery[] = { nullptr };
         arraySystemRegisterToQuery[0] = GetSystemRegNamebyAccessCode(address);
 
-        std::map<std::string, std::string> systemRegMapResult = QueryRegistersEx(GetLastKnownActiveCpu(),
-            arraySystemRegisterToQuery, ARRAYSIZE(arraySystemRegisterToQuery), SYSTEM_REGS);
-        ULONGLONG systemRegValue = ParseRegisterValue(systemRegMapResult[arraySystemRegisterToQuery[0]]);
+        const unsigned processorNumber = GetLastKnownActiveCpu();
+        auto itSnapshot = m_systemRegistersSnapshot.find(processorNumber);
+        if (itSnapshot == m_systemRegistersSnapshot.end())
+        {
+            itSnapshot = m_systemRegistersSnapshot.emplace(processorNumber, QuerySystemRegistersGroup(processorNumber)).first;
+        }
+
+        ULONGLONG systemRegValue = 0;
+        auto itRegister = itSnapshot->second.find(arraySystemRegisterToQuery[0]);
+        if (itRegister != itSnapshot->second.end())
+        {
+            systemRegValue = ParseRegisterValue(itRegister->second);
+        }
+        else
+        {
+            std::map<std::string, std::string> systemRegMapResult = QueryRegistersEx(processorNumber,
+                arraySystemRegisterToQuery, ARRAYSIZE(arraySystemRegisterToQuery), SYSTEM_REGS);
+            systemRegValue = ParseRegisterValue(systemRegMapResult[arraySystemRegisterToQuery[0]]);
+        }
 
         SimpleCharBuffer systemRegBuffer;
         if (!systemRegBuffer.TryEnsureCapacity(C_MAX_MONITOR_CMD_BUFFER))
@@ -1466,6 +1971,35 @@ public:
         return systemRegBuffer;
     }
 
+    //
+    //  QuerySystemRegistersGroup   Reads all the system registers of a processor core by batched requests.
+    //
+    //  Parameters:
+    //  processorNumber             Processor core number.
+    //
+    //  Return:
+    //  A map containing the register name and its hex-decimal ascii value, the registers that
+    //  the GDB server could not read are not in the map.
+    //
+    std::map<std::string, std::string> GdbSrvControllerImpl::QuerySystemRegistersGroup(_In_ unsigned processorNumber)
+    {
+        if (!SetThreadCommand(processorNumber, "g"))
+        {
+            throw _com_error(E_FAIL);
+        }
+
+        std::vector<const RegistersStruct *> registersToQuery;
+        registersToQuery.reserve(RegistersGroupSize(SYSTEM_REGS));
+        for (const_regIterator it = RegistersBegin(SYSTEM_REGS); it != RegistersEnd(SYSTEM_REGS); ++it)
+        {
+            registersToQuery.push_back(&(*it));
+        }
+
+        std::map<std::string, std::string> result;
+        QueryRegisterValuesBatch(registersToQuery, result, true);
+        return result;
+    }
+
     //
     //  ReadSystemRegisters Reads System registers
     //
@@ -1529,6 +2063,9 @@ public:
             throw _com_error(E_NOTIMPL);
         }
 
+        //  The written register can change the value of other system registers.
+        m_systemRegistersSnapshot.clear();
+
         return itFunction->second(address, size, pRawBuffer, pdwBytesWritten, memType, fReportWriteError);
     }
 
@@ -1583,6 +2120,17 @@ public:
     SimpleCharBuffer GdbSrvControllerImpl::ReadMemory(_In_ AddressType address, _In_ size_t maxSize, 
                                                       _In_ const memoryAccessType memType)
     {
+        //  The read has to observe the data of any deferred write to the same range,
+        //  and it fails only if a deferred write to this range failed.
+        if (IsPendingMemoryWriteOverlapped(address, maxSize, memType))
+        {
+            SendPendingMemoryWrites();
+        }
+        if (!ReportFailedMemoryWritesInRange(address, maxSize, memType))
+        {
+            throw _com_error(E_FAIL);
+        }
+
         SimpleCharBuffer result;
         //  The response is an Ascii hex string, so ensure some extra capacity
         //  in case that GdbServer replies with an unexpected stop reply packet.
@@ -1697,6 +2245,59 @@ public:
 
     //
     //  WriteMemory     Writes length bytes of memory starting at address XX
+    //                  If the write-back buffer is enabled (enableMemoryWriteCoalescing), then the write is
+    //                  merged with the pending writes to overlapping or adjacent ranges of the same memory type,
+    //                  and it's sent before the target resumes, or before reading an overlapping range.
+    //
+    //  Parameters:
+    //  address         Address location where we should write the data
+    //  size            Size of the memory write.
+    //  pRawBuffer      Pointer to the buffer that contains the data to write
+    //  pdwBytesWritten Pointer to the variable containing how many bytes have been written.
+    //  memType         The memory class that will be accessed by the write operation.
+    //  fReportWriteError Flag indicates if the function needs to report packet errors. 
+    //
+    //  Return:
+    //  true            if we succeeded (or the write has been buffered).
+    //  false           otherwise.
+    //
+    //  Note.
+    //  The result only reflects this write. A buffered write that fails when it's sent is kept
+    //  and reported at the next flush point (resume, breakpoint, close, or a read of its range).
+    //
+    bool GdbSrvControllerImpl::WriteMemory(_In_ AddressType address, _In_ size_t size, _In_ const void * pRawBuffer, 
+                                           _Out_ DWORD * pdwBytesWritten, _In_ const memoryAccessType memType, 
+                                           _In_ bool fReportWriteError)
+    {
+        assert(pRawBuffer != nullptr && pdwBytesWritten != nullptr);
+
+        //  A write to the page tables invalidates the cached address translations.
+        if (m_spPageTableWalker != nullptr && !memType.isSpecialRegs &&
+            m_spPageTableWalker->IsPageTableMemory(address, size))
+        {
+            FlushAddressTranslations();
+        }
+
+        //  Special register accesses are not memory, so they are never deferred.
+        if (m_IsMemoryWriteCoalescingEnabled && !memType.isSpecialRegs &&
+            size != 0 && size <= C_MAX_PENDING_MEMORY_WRITE_BYTES)
+        {
+            AddPendingMemoryWrite(address, size, pRawBuffer, memType);
+            *pdwBytesWritten = static_cast<DWORD>(size);
+            if (m_pendingMemoryWriteBytes >= C_MAX_PENDING_MEMORY_WRITE_BYTES)
+            {
+                SendPendingMemoryWrites();
+            }
+            return true;
+        }
+
+        //  Keep the writes order on the target.
+        SendPendingMemoryWrites();
+        return WriteMemoryPackets(address, size, pRawBuffer, pdwBytesWritten, memType, fReportWriteError);
+    }
+
+    //
+    //  WriteMemoryPackets  Writes length bytes of memory starting at address XX
     //                  The data is transmitted in ascii hexadecimal.
     //                  
     //  Parameters:
@@ -1729,9 +2330,9 @@ public:
     //      $OK#9a
     //      +
     //
-    bool GdbSrvControllerImpl::WriteMemory(_In_ AddressType address, _In_ size_t size, _In_ const void * pRawBuffer, 
-                                           _Out_ DWORD * pdwBytesWritten, _In_ const memoryAccessType memType, 
-                                           _In_ bool fReportWriteError)
+    bool GdbSrvControllerImpl::WriteMemoryPackets(_In_ AddressType address, _In_ size_t size, _In_ const void * pRawBuffer, 
+                                                  _Out_ DWORD * pdwBytesWritten, _In_ const memoryAccessType memType, 
+                                                  _In_ bool fReportWriteError)
     {
         assert(pRawBuffer != nullptr && pdwBytesWritten != nullptr && m_pRspClient != nullptr);
 
@@ -1766,38 +2367,637 @@ public:
             command += dataLength;
             if (isQ32GdbServerCmd)
             {
-                command += ",";
+                command += ",";
+            }
+            else
+            {
+                command += ":";
+            }
+            command += dataBuffer.c_str();
+
+            std::string reply = ExecuteCommand(command.c_str());
+
+            //  We should receive 'OK' or 'EE NN' response.
+            if (IsReplyError(reply))
+            {
+                isError = fReportWriteError;
+                break;
+            }
+            if (packetSize >= size)
+            {
+                break;
+            }
+            pRawDataBuffer += maxPacketSize;
+            size_t leftPacketSize = size - packetSize;
+            maxPacketSize = (leftPacketSize < maxPacketSize) ? leftPacketSize : maxPacketSize;        
+            packetSize += maxPacketSize;
+        }
+
+        if (packetSize == size && !isError)
+        {
+            *pdwBytesWritten = static_cast<DWORD>(size);
+            isDone = true;
+        }
+        return isDone;
+    }
+
+    //
+    //  FlushPendingMemoryWrites    Sends the deferred memory writes to the target and reports the ones that failed.
+    //                              It's called at the flush points (resume, breakpoint insert/remove and close).
+    //
+    //  Parameters:
+    //  pFaultAddress   Pointer to the variable receiving the address of the first failed write (optional).
+    //
+    //  Return:
+    //  true            if all the deferred writes succeeded (or there were not pending writes).
+    //  false           otherwise, this includes the failures of the writes sent before this flush point.
+    //
+    bool GdbSrvControllerImpl::FlushPendingMemoryWrites(_Out_opt_ AddressType * pFaultAddress = nullptr)
+    {
+        SendPendingMemoryWrites();
+        return ReportFailedMemoryWrites(pFaultAddress);
+    }
+
+    //
+    //  SendPendingMemoryWrites     Sends the deferred memory writes to the target without reporting the failures.
+    //
+    //  Parameters:
+    //  None.
+    //
+    //  Return:
+    //  Nothing.
+    //
+    //  Note.
+    //  Each merged range is sent by the fewest packets allowed by the packet size.
+    //  If a merged range fails, then the original writes contained in the range are replayed
+    //  one by one, so the error is kept for the write that actually failed (see ReportFailedMemoryWrites).
+    //  If sending throws (i.e. the connection is lost), then the ranges that were not sent are put back
+    //  in the write-back buffer before the exception is rethrown.
+    //
+    void GdbSrvControllerImpl::SendPendingMemoryWrites()
+    {
+        if (m_pendingMemoryWrites.empty())
+        {
+            return;
+        }
+
+        std::map<WORD, PendingMemoryWriteSet> pendingWrites;
+        pendingWrites.swap(m_pendingMemoryWrites);
+        m_pendingMemoryWriteBytes = 0;
+
+        try
+        {
+            for (auto & writeSetEntry : pendingWrites)
+            {
+                PendingMemoryWriteSet & writeSet = writeSetEntry.second;
+                while (!writeSet.coalescedRanges.empty())
+                {
+                    auto range = writeSet.coalescedRanges.begin();
+                    DWORD bytesWritten = 0;
+                    if (!WriteMemoryPackets(range->first, range->second.size(), range->second.data(), &bytesWritten,
+                                            writeSet.memType, true))
+                    {
+                        ReplayFailedMemoryWrites(writeSet, range->first, range->second.size());
+                    }
+                    writeSet.coalescedRanges.erase(range);
+                }
+            }
+        }
+        catch (...)
+        {
+            RestoreUnsentMemoryWrites(pendingWrites);
+            throw;
+        }
+    }
+
+    //
+    //  RestoreUnsentMemoryWrites   Puts back in the write-back buffer the ranges that were not sent.
+    //
+    //  Parameters:
+    //  unsentWrites    Reference to the write sets taken from the buffer, the sent ranges have been removed.
+    //
+    //  Return:
+    //  Nothing.
+    //
+    //  Note.
+    //  Only the original writes contained in the unsent ranges are kept, so a later replay
+    //  can't send again the data of a range that was already written.
+    //
+    void GdbSrvControllerImpl::RestoreUnsentMemoryWrites(_Inout_ std::map<WORD, PendingMemoryWriteSet> & unsentWrites)
+    {
+        for (auto & writeSetEntry : unsentWrites)
+        {
+            PendingMemoryWriteSet & writeSet = writeSetEntry.second;
+            if (writeSet.coalescedRanges.empty())
+            {
+                continue;
+            }
+
+            std::vector<PendingMemoryWrite> unsentOriginalWrites;
+            for (auto & write : writeSet.writes)
+            {
+                auto it = writeSet.coalescedRanges.upper_bound(write.address);
+                if (it == writeSet.coalescedRanges.begin())
+                {
+                    continue;
+                }
+                --it;
+                if (write.address + write.data.size() <= it->first + it->second.size())
+                {
+                    m_pendingMemoryWriteBytes += write.data.size();
+                    unsentOriginalWrites.push_back(std::move(write));
+                }
+            }
+            writeSet.writes.swap(unsentOriginalWrites);
+            m_pendingMemoryWrites[writeSetEntry.first] = std::move(writeSet);
+        }
+    }
+
+    //
+    //  ReportFailedMemoryWrites    Reports the deferred writes that failed to the caller.
+    //
+    //  Parameters:
+    //  pFaultAddress   Pointer to the variable receiving the address of the first failed write (optional).
+    //
+    //  Return:
+    //  true            if there are not failed writes.
+    //  false           otherwise, the failed writes are discarded once they have been reported.
+    //
+    bool GdbSrvControllerImpl::ReportFailedMemoryWrites(_Out_opt_ AddressType * pFaultAddress)
+    {
+        if (m_failedMemoryWrites.empty())
+        {
+            return true;
+        }
+
+        if (pFaultAddress != nullptr)
+        {
+            *pFaultAddress = m_failedMemoryWrites.front().write.address;
+        }
+        m_failedMemoryWrites.clear();
+        return false;
+    }
+
+    //
+    //  ReportFailedMemoryWritesInRange     Reports the deferred writes that failed and overlap a memory range.
+    //
+    //  Parameters:
+    //  address         Start address of the range.
+    //  size            Size of the range.
+    //  memType         The memory class of the range.
+    //
+    //  Return:
+    //  true            if there are not failed writes of the same memory type overlapping the range.
+    //  false           otherwise, the reported writes are discarded and the other failures are kept
+    //                  for the next flush point.
+    //
+    bool GdbSrvControllerImpl::ReportFailedMemoryWritesInRange(_In_ AddressType address, _In_ size_t size, 
+                                                               _In_ const memoryAccessType memType)
+    {
+        const WORD memTypeKey = GetMemoryAccessTypeKey(memType);
+        auto itReported = std::remove_if(m_failedMemoryWrites.begin(), m_failedMemoryWrites.end(),
+            [&](const FailedMemoryWrite & failedWrite)
+            {
+                return GetMemoryAccessTypeKey(failedWrite.memType) == memTypeKey &&
+                       failedWrite.write.address < address + size &&
+                       address < failedWrite.write.address + failedWrite.write.data.size();
+            });
+        bool isReported = (itReported != m_failedMemoryWrites.end());
+        m_failedMemoryWrites.erase(itReported, m_failedMemoryWrites.end());
+        return !isReported;
+    }
+
+    //
+    //  FlushPendingMemoryWritesOnClose     Sends the deferred memory writes when the session is closing.
+    //
+    bool GdbSrvControllerImpl::FlushPendingMemoryWritesOnClose()
+    {
+        try
+        {
+            return FlushPendingMemoryWrites();
+        }
+        CATCH_AND_RETURN_BOOLEAN
+    }
+
+    //
+    //  AddPendingMemoryWrite   Adds a write to the write-back buffer.
+    //
+    //  Parameters:
+    //  address         Address location where we should write the data
+    //  size            Size of the memory write.
+    //  pRawBuffer      Pointer to the buffer that contains the data to write
+    //  memType         The memory class that will be accessed by the write operation.
+    //
+    //  Return:
+    //  Nothing.
+    //
+    //  Note.
+    //  The write is merged with any pending range of the same memory type that overlaps
+    //  or is adjacent to it, the new data replaces the overlapped bytes.
+    //
+    void GdbSrvControllerImpl::AddPendingMemoryWrite(_In_ AddressType address, _In_ size_t size, 
+                                                     _In_ const void * pRawBuffer, _In_ const memoryAccessType memType)
+    {
+        const unsigned char * pData = reinterpret_cast<const unsigned char *>(pRawBuffer);
+        PendingMemoryWriteSet & writeSet = m_pendingMemoryWrites[GetMemoryAccessTypeKey(memType)];
+        writeSet.memType = memType;
+        writeSet.writes.push_back({address, std::vector<unsigned char>(pData, pData + size)});
+
+        //  Find the first range that overlaps or it's adjacent to the new write.
+        AddressType startAddress = address;
+        AddressType endAddress = address + size;
+        auto itFirst = writeSet.coalescedRanges.upper_bound(startAddress);
+        if (itFirst != writeSet.coalescedRanges.begin())
+        {
+            auto itPrevious = std::prev(itFirst);
+            if (itPrevious->first + itPrevious->second.size() >= startAddress)
+            {
+                itFirst = itPrevious;
+            }
+        }
+        auto itLast = itFirst;
+        for (; itLast != writeSet.coalescedRanges.end() && itLast->first <= endAddress; ++itLast)
+        {
+            startAddress = std::min<AddressType>(startAddress, itLast->first);
+            endAddress = std::max<AddressType>(endAddress, itLast->first + itLast->second.size());
+        }
+
+        std::vector<unsigned char> mergedData(static_cast<size_t>(endAddress - startAddress));
+        for (auto it = itFirst; it != itLast; ++it)
+        {
+            memcpy(&mergedData[static_cast<size_t>(it->first - startAddress)], it->second.data(), it->second.size());
+        }
+        memcpy(&mergedData[static_cast<size_t>(address - startAddress)], pData, size);
+
+        writeSet.coalescedRanges.erase(itFirst, itLast);
+        writeSet.coalescedRanges.emplace(startAddress, std::move(mergedData));
+        m_pendingMemoryWriteBytes += size;
+    }
+
+    //
+    //  IsPendingMemoryWriteOverlapped  Checks if a memory range could observe a deferred write.
+    //
+    //  Parameters:
+    //  address         Start address of the range.
+    //  size            Size of the range.
+    //  memType         The memory class of the range.
+    //
+    //  Return:
+    //  true            if a pending write of the same memory type overlaps the range, or if there are
+    //                  pending writes of other memory types (they can alias the range, i.e. physical vs virtual).
+    //  false           otherwise.
+    //
+    bool GdbSrvControllerImpl::IsPendingMemoryWriteOverlapped(_In_ AddressType address, _In_ size_t size, 
+                                                              _In_ const memoryAccessType memType) const
+    {
+        const WORD memTypeKey = GetMemoryAccessTypeKey(memType);
+        for (auto const & writeSetEntry : m_pendingMemoryWrites)
+        {
+            if (writeSetEntry.first != memTypeKey)
+            {
+                return true;
+            }
+
+            const std::map<AddressType, std::vector<unsigned char>> & ranges = writeSetEntry.second.coalescedRanges;
+            auto it = ranges.upper_bound(address);
+            if (it != ranges.begin())
+            {
+                auto itPrevious = std::prev(it);
+                if (itPrevious->first + itPrevious->second.size() > address)
+                {
+                    return true;
+                }
+            }
+            if (it != ranges.end() && it->first < address + size)
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    //
+    //  ReplayFailedMemoryWrites    Sends one by one the original writes contained in a merged range that failed.
+    //
+    //  Parameters:
+    //  writeSet        Reference to the deferred write set.
+    //  address         Start address of the failed range.
+    //  size            Size of the failed range.
+    //
+    //  Return:
+    //  Nothing.
+    //
+    //  Note.
+    //  The writes that fail again are kept in the failed write list with their data.
+    //  They are added once the whole range has been replayed, so a range that is put back
+    //  in the buffer after an exception is not reported as failed too.
+    //
+    void GdbSrvControllerImpl::ReplayFailedMemoryWrites(_In_ const PendingMemoryWriteSet & writeSet,
+                                                        _In_ AddressType address, _In_ size_t size)
+    {
+        std::vector<FailedMemoryWrite> failedWrites;
+        for (auto const & write : writeSet.writes)
+        {
+            if (write.address < address || write.address + write.data.size() > address + size)
+            {
+                continue;
+            }
+
+            DWORD bytesWritten = 0;
+            if (!WriteMemoryPackets(write.address, write.data.size(), write.data.data(), &bytesWritten, writeSet.memType, true))
+            {
+                char message[128];
+                sprintf_s(message, _countof(message), "Deferred memory write failed, address: 0x%I64x size: 0x%zx",
+                          write.address, write.data.size());
+                DisplayLogEntry(message, strlen(message));
+                failedWrites.push_back({writeSet.memType, write});
+            }
+        }
+        m_failedMemoryWrites.insert(m_failedMemoryWrites.end(), failedWrites.begin(), failedWrites.end());
+    }
+
+    //
+    //  ReadVirtualMemoryByPA   Reads virtual memory on targets that can only access memory by physical address.
+    //
+    //  Parameters:
+    //  address                 Virtual address of the memory to read.
+    //  maxSize                 Size of the memory to read.
+    //
+    //  Return:
+    //  The buffer containing the memory content, it may contain fewer bytes than requested
+    //  if the range is not fully mapped.
+    //
+    //  Note.
+    //  The virtual address is translated by walking the page tables of the last known active
+    //  processor on the host (see PageTableWalker), and each page is read by physical address.
+    //  The translations are cached until the target resumes, so repeated reads of the same
+    //  page cost a single physical memory read.
+    //
+    SimpleCharBuffer GdbSrvControllerImpl::ReadVirtualMemoryByPA(_In_ AddressType address, _In_ size_t maxSize)
+    {
+        assert(m_spPageTableWalker != nullptr);
+
+        PagingRegisters pagingRegisters = {};
+        if (!GetPagingRegisters(GetLastKnownActiveCpu(), &pagingRegisters))
+        {
+            throw _com_error(E_NOTIMPL);
+        }
+
+        SimpleCharBuffer result;
+        if (!result.TryEnsureCapacity(maxSize))
+        {
+            throw _com_error(E_OUTOFMEMORY);
+        }
+
+        memoryAccessType memType = GetPhysicalMemoryAccessType();
+        PAMemoryAccessModeScope paMemoryAccessMode(this, memType);
+        while (maxSize != 0)
+        {
+            AddressType physicalAddress = 0;
+            size_t bytesToPageEnd = 0;
+            if (!m_spPageTableWalker->TranslateVirtualAddress(pagingRegisters, address, &physicalAddress, &bytesToPageEnd))
+            {
+                if (result.GetLength() == 0 && GetThrowExceptionEnabled())
+                {
+                    throw _com_error(E_FAIL);
+                }
+                break;
+            }
+
+            size_t requestSize = min(bytesToPageEnd, maxSize);
+            SimpleCharBuffer pageData = ReadMemory(physicalAddress, requestSize, memType);
+            memcpy(result.GetEndOfData(), pageData.GetInternalBuffer(), pageData.GetLength());
+            result.SetLength(result.GetLength() + pageData.GetLength());
+            if (pageData.GetLength() != requestSize)
+            {
+                break;
+            }
+            address += requestSize;
+            maxSize -= requestSize;
+        }
+
+        return result;
+    }
+
+    //
+    //  WriteVirtualMemoryByPA  Writes virtual memory on targets that can only access memory by physical address.
+    //
+    //  Parameters:
+    //  address                 Virtual address where we should write the data
+    //  size                    Size of the memory write.
+    //  pRawBuffer              Pointer to the buffer that contains the data to write
+    //  pdwBytesWritten         Pointer to the variable containing how many bytes have been written.
+    //
+    //  Return:
+    //  true                    if we succeeded.
+    //  false                   otherwise.
+    //
+    //  Note.
+    //  The PA memory mode is set like for the reads, and the writes deferred by the write-back buffer
+    //  are sent before the mode is cleared.
+    //
+    bool GdbSrvControllerImpl::WriteVirtualMemoryByPA(_In_ AddressType address, _In_ size_t size, 
+                                                      _In_ const void * pRawBuffer, _Out_ DWORD * pdwBytesWritten)
+    {
+        assert(m_spPageTableWalker != nullptr && pRawBuffer != nullptr && pdwBytesWritten != nullptr);
+
+        *pdwBytesWritten = 0;
+        PagingRegisters pagingRegisters = {};
+        if (!GetPagingRegisters(GetLastKnownActiveCpu(), &pagingRegisters))
+        {
+            throw _com_error(E_NOTIMPL);
+        }
+
+        const unsigned char * pData = reinterpret_cast<const unsigned char *>(pRawBuffer);
+        memoryAccessType memType = GetPhysicalMemoryAccessType();
+        PAMemoryAccessModeScope paMemoryAccessMode(this, memType);
+        bool isDone = true;
+        while (size != 0)
+        {
+            AddressType physicalAddress = 0;
+            size_t bytesToPageEnd = 0;
+            if (!m_spPageTableWalker->TranslateVirtualAddress(pagingRegisters, address, &physicalAddress, &bytesToPageEnd))
+            {
+                isDone = false;
+                break;
+            }
+
+            size_t requestSize = min(bytesToPageEnd, size);
+            DWORD bytesWritten = 0;
+            if (!WriteMemory(physicalAddress, requestSize, pData, &bytesWritten, memType, true))
+            {
+                isDone = false;
+                break;
+            }
+            *pdwBytesWritten += bytesWritten;
+            address += requestSize;
+            pData += requestSize;
+            size -= requestSize;
+        }
+
+        //  The deferred writes would be sent after the PA memory mode is cleared,
+        //  their failures are reported at the next flush point.
+        if (paMemoryAccessMode.IsModeSet())
+        {
+            SendPendingMemoryWrites();
+        }
+        return isDone;
+    }
+
+    //
+    //  FlushAddressTranslations    Discards the cached address translations and paging registers.
+    //                              It has to be called when the target resumes.
+    //
+    void GdbSrvControllerImpl::FlushAddressTranslations()
+    {
+        m_pagingRegisters.clear();
+        if (m_spPageTableWalker != nullptr)
+        {
+            m_spPageTableWalker->FlushTranslations();
+        }
+    }
+
+    //
+    //  GetPagingRegisters  Gets the registers controlling the address translation of a processor.
+    //
+    //  Parameters:
+    //  processorNumber     Processor core number.
+    //  pPagingRegisters    Pointer to the returned paging registers.
+    //
+    //  Return:
+    //  true                if the registers are available for the target architecture.
+    //  false               otherwise.
+    //
+    //  Note.
+    //  The register values are cached by processor until the target resumes.
+    //
+    bool GdbSrvControllerImpl::GetPagingRegisters(_In_ unsigned processorNumber, _Out_ PagingRegisters * pPagingRegisters)
+    {
+        assert(pPagingRegisters != nullptr);
+
+        auto itCached = m_pagingRegisters.find(processorNumber);
+        if (itCached != m_pagingRegisters.end())
+        {
+            *pPagingRegisters = itCached->second;
+            return true;
+        }
+
+        PagingRegisters pagingRegisters = {};
+        pagingRegisters.arch = m_targetProcessorArch;
+        if (m_targetProcessorArch == AMD64_ARCH)
+        {
+            const char * pagingRegisterNames[] = {"cr0", "cr3", "cr4"};
+            std::map<std::string, std::string> registers = QueryRegisters(processorNumber, pagingRegisterNames,
+                                                                          ARRAYSIZE(pagingRegisterNames));
+            if (registers.find("cr0") == registers.end() || registers.find("cr3") == registers.end() ||
+                registers.find("cr4") == registers.end())
+            {
+                return false;
             }
-            else
+            pagingRegisters.systemControl = GdbSrvController::ParseRegisterValue(registers["cr0"]);
+            pagingRegisters.translationBase0 = GdbSrvController::ParseRegisterValue(registers["cr3"]);
+            pagingRegisters.translationControl = GdbSrvController::ParseRegisterValue(registers["cr4"]);
+        }
+        else if (m_targetProcessorArch == ARM64_ARCH)
+        {
+            const AddressType sctlrEl1 = TargetArchitectureHelpers::EncodeAccessCode(ARM64_ARCH, 3, 0, 1, 0, 0);
+            const AddressType ttbr0El1 = TargetArchitectureHelpers::EncodeAccessCode(ARM64_ARCH, 3, 0, 2, 0, 0);
+            const AddressType ttbr1El1 = TargetArchitectureHelpers::EncodeAccessCode(ARM64_ARCH, 3, 0, 2, 0, 1);
+            const AddressType tcrEl1 = TargetArchitectureHelpers::EncodeAccessCode(ARM64_ARCH, 3, 0, 2, 0, 2);
+            const AddressType accessCodes[] = {sctlrEl1, ttbr0El1, ttbr1El1, tcrEl1};
+            std::map<AddressType, std::string> registers = QuerySystemRegistersByAccessCode(processorNumber, accessCodes,
+                                                                                            ARRAYSIZE(accessCodes));
+            if (registers.size() != ARRAYSIZE(accessCodes))
             {
-                command += ":";
+                return false;
             }
-            command += dataBuffer.c_str();
+            pagingRegisters.systemControl = GdbSrvController::ParseRegisterValue(registers[sctlrEl1]);
+            pagingRegisters.translationBase0 = GdbSrvController::ParseRegisterValue(registers[ttbr0El1]);
+            pagingRegisters.translationBase1 = GdbSrvController::ParseRegisterValue(registers[ttbr1El1]);
+            pagingRegisters.translationControl = GdbSrvController::ParseRegisterValue(registers[tcrEl1]);
+        }
+        else
+        {
+            return false;
+        }
 
-            std::string reply = ExecuteCommand(command.c_str());
+        m_pagingRegisters[processorNumber] = pagingRegisters;
+        *pPagingRegisters = pagingRegisters;
+        return true;
+    }
 
-            //  We should receive 'OK' or 'EE NN' response.
-            if (IsReplyError(reply))
+    //
+    //  ReadPageTableEntry  Reads a 64 bits page table entry by physical address (used by the page table walker).
+    //
+    //  Parameters:
+    //  physicalAddress     Physical address of the entry.
+    //
+    //  Return:
+    //  The entry value, it throws an exception if the entry cannot be read.
+    //
+    ULONGLONG GdbSrvControllerImpl::ReadPageTableEntry(_In_ AddressType physicalAddress)
+    {
+        SimpleCharBuffer entryData = ReadMemory(physicalAddress, sizeof(ULONGLONG), GetPhysicalMemoryAccessType());
+        if (entryData.GetLength() != sizeof(ULONGLONG))
+        {
+            throw _com_error(E_FAIL);
+        }
+
+        ULONGLONG entry = 0;
+        memcpy(&entry, entryData.GetInternalBuffer(), sizeof(entry));
+        return entry;
+    }
+
+    //
+    //  GetPhysicalMemoryAccessType     Gets the memory type used for accessing memory by physical address.
+    //                                  If the PA memory mode is set by a monitor command, then the regular
+    //                                  memory packets access the physical memory.
+    //
+    memoryAccessType GdbSrvControllerImpl::GetPhysicalMemoryAccessType()
+    {
+        memoryAccessType memType = {0};
+        memType.isPhysical = GetPAMemoryMode() ? 0 : 1;
+        return memType;
+    }
+
+    //
+    //  IsHostPageTableWalkEnabled  Checks if the virtual addresses are translated by the host page table walker.
+    //
+    //  Return:
+    //  true                if the walker is enabled and the target reports the paging registers.
+    //  false               otherwise, the debugger engine translates the addresses.
+    //
+    //  Note.
+    //  The paging registers are probed once, since their availability depends on the registers
+    //  reported by the GdbServer and not on the target state. A probe that fails to communicate
+    //  with the GdbServer is not cached.
+    //
+    bool GdbSrvControllerImpl::IsHostPageTableWalkEnabled()
+    {
+        if (m_spPageTableWalker == nullptr)
+        {
+            return false;
+        }
+
+        if (!m_isPagingRegistersProbed)
+        {
+            PagingRegisters pagingRegisters = {};
+            try
             {
-                isError = fReportWriteError;
-                break;
+                m_isPagingRegistersAvailable = GetPagingRegisters(GetLastKnownActiveCpu(), &pagingRegisters);
             }
-            if (packetSize >= size)
+            catch (...)
             {
-                break;
+                return false;
+            }
+            m_isPagingRegistersProbed = true;
+            if (!m_isPagingRegistersAvailable)
+            {
+                const char message[] = "The target does not report the paging registers, the host page table walk is disabled.";
+                DisplayLogEntry(message, strlen(message));
             }
-            pRawDataBuffer += maxPacketSize;
-            size_t leftPacketSize = size - packetSize;
-            maxPacketSize = (leftPacketSize < maxPacketSize) ? leftPacketSize : maxPacketSize;        
-            packetSize += maxPacketSize;
-        }
-
-        if (packetSize == size && !isError)
-        {
-            *pdwBytesWritten = static_cast<DWORD>(size);
-            isDone = true;
         }
-        return isDone;
+        return m_isPagingRegistersAvailable;
     }
 
     //
@@ -2690,8 +3890,100 @@ public:
     unique_ptr<vector<RegistersStruct>> m_spRegisterVector;
     unique_ptr<vector<RegistersStruct>> m_spSystemRegisterVector;
     unique_ptr<SystemRegistersMapType> m_spSystemRegAccessCodeMap;
+    //  Flat system register decoding table sorted by access code, and the system register
+    //  indexes sorted by register order and by register name (see BuildSystemRegisterDecodeTable).
+    std::vector<SystemRegisterDecodeEntry> m_systemRegDecodeTable;
+    std::vector<std::pair<std::string, AddressType>> m_systemRegOrderIndex;
+    std::vector<std::pair<std::string, size_t>> m_systemRegNameIndex;
     bool m_IsForcedPAMemoryMode;
     bool m_ConfigPAMemMode;
+    //  Memory write-back buffer (enableMemoryWriteCoalescing), the deferred writes are keyed by memory type.
+    bool m_IsMemoryWriteCoalescingEnabled;
+    std::map<WORD, PendingMemoryWriteSet> m_pendingMemoryWrites;
+    size_t m_pendingMemoryWriteBytes;
+    //  Deferred writes that failed and have not been reported yet (see ReportFailedMemoryWrites).
+    std::vector<FailedMemoryWrite> m_failedMemoryWrites;
+    //  Core registers snapshot of all the processors (see QueryAllRegistersFromSnapshot).
+    std::vector<std::map<std::string, std::string>> m_allProcessorsRegisters;
+    //  System registers read by processor while the target is halted (see ReadSysRegByQueryRegGdbCmd).
+    std::map<unsigned, std::map<std::string, std::string>> m_systemRegistersSnapshot;
+    //  Last thread selection command sent by operation (see SetThreadCommand).
+    std::map<std::string, std::string> m_selectedThreadCommands;
+    //  Request processed by the worker threads reading the processor registers concurrently.
+    typedef struct
+    {
+        GdbSrvControllerImpl * pController;
+        unsigned processorNumber;
+        std::map<std::string, std::string> registers;
+        HRESULT result;
+    } ProcessorRegistersRequest;
+    //  Host page table walker (enableHostPageTableWalk) and the paging registers cached by processor.
+    unique_ptr<PageTableWalker> m_spPageTableWalker;
+    std::map<unsigned, PagingRegisters> m_pagingRegisters;
+    //  Result of probing the paging registers (see IsHostPageTableWalkEnabled).
+    bool m_isPagingRegistersProbed;
+    bool m_isPagingRegistersAvailable;
+
+    //
+    //  PAMemoryAccessModeScope     Sets the PA memory access mode of the GdbServer (see HandleConfigPAMemAccessMode)
+    //                              for the lifetime of the object, so the mode is cleared if the access throws.
+    //                              The mode is not cleared if it was already set when the object is created.
+    //
+    class PAMemoryAccessModeScope
+    {
+    public:
+        PAMemoryAccessModeScope(_In_ GdbSrvControllerImpl * pController, _In_ memoryAccessType memType) :
+            m_pController(pController),
+            m_memType(memType),
+            m_isModeSet(false)
+        {
+            assert(m_pController != nullptr);
+            if (!m_pController->GetConfigPAMemoryMode())
+            {
+                m_pController->HandleConfigPAMemAccessMode(m_memType, true);
+                m_isModeSet = m_pController->GetConfigPAMemoryMode();
+            }
+        }
+
+        ~PAMemoryAccessModeScope()
+        {
+            if (!m_isModeSet)
+            {
+                return;
+            }
+
+            try
+            {
+                m_pController->HandleConfigPAMemAccessMode(m_memType, false);
+            }
+            catch (...)
+            {
+                const char message[] = "Failed clearing the PA memory access mode.";
+                m_pController->DisplayLogEntry(message, strlen(message));
+            }
+        }
+
+        bool IsModeSet() const
+        {
+            return m_isModeSet;
+        }
+
+    private:
+        GdbSrvControllerImpl * m_pController;
+        memoryAccessType m_memType;
+        bool m_isModeSet;
+
+        PAMemoryAccessModeScope(_In_ const PAMemoryAccessModeScope &);
+        void operator=(_In_ const PAMemoryAccessModeScope &);
+    };
+
+    static WORD GetMemoryAccessTypeKey(_In_ const memoryAccessType memType)
+    {
+        static_assert(sizeof(memoryAccessType) == sizeof(WORD), "The memory access type has to fit in a WORD");
+        WORD memTypeKey = 0;
+        memcpy(&memTypeKey, &memType, sizeof(memTypeKey));
+        return memTypeKey;
+    }
 
     const_regIterator RegistersBegin(_In_ RegisterGroupType type = CORE_REGS) const {return (type == CORE_REGS) ? m_spRegisterVector->begin() : m_spSystemRegisterVector->begin();}
     const_regIterator RegistersEnd(_In_ RegisterGroupType type = CORE_REGS) const {return (type == CORE_REGS) ? m_spRegisterVector->end() : m_spSystemRegisterVector->end();}
@@ -2794,38 +4086,97 @@ public:
         return SetPhysicalReadMemoryModeEx(true);
     }
 
-    inline AddressType GetAccessCodeByRegisterNumber(_In_ const string & regOrder)
+    //
+    //  BuildSystemRegisterDecodeTable  Builds the flat system register decoding tables.
+    //
+    //  Parameters:
+    //
+    //  Return:
+    //  Nothing.
+    //
+    //  Note.
+    //  The decoding table is a vector sorted by access code, each entry links the access code
+    //  with the system register vector entry reported by the GDB server, so decoding a register
+    //  is a binary search instead of walking the access code map and the register vector.
+    //  It has to be rebuilt every time the system register vector or the access code map change.
+    //
+    void GdbSrvControllerImpl::BuildSystemRegisterDecodeTable()
     {
-        if (m_spSystemRegAccessCodeMap->empty())
+        m_systemRegDecodeTable.clear();
+        m_systemRegOrderIndex.clear();
+        m_systemRegNameIndex.clear();
+
+        if (m_spSystemRegisterVector != nullptr)
         {
-            throw _com_error(E_INVALIDARG);
+            m_systemRegNameIndex.reserve(m_spSystemRegisterVector->size());
+            for (size_t index = 0; index < m_spSystemRegisterVector->size(); ++index)
+            {
+                m_systemRegNameIndex.emplace_back((*m_spSystemRegisterVector)[index].name, index);
+            }
+            std::sort(m_systemRegNameIndex.begin(), m_systemRegNameIndex.end());
+        }
+
+        if (m_spSystemRegAccessCodeMap == nullptr)
+        {
+            return;
         }
 
-        for (auto it = m_spSystemRegAccessCodeMap->cbegin();
-            it != m_spSystemRegAccessCodeMap->cend();
-            ++it)
+        //  The access code map is ordered, so the decode table is built already sorted.
+        m_systemRegDecodeTable.reserve(m_spSystemRegAccessCodeMap->size());
+        m_systemRegOrderIndex.reserve(m_spSystemRegAccessCodeMap->size());
+        for (auto const & accessCodeEntry : *m_spSystemRegAccessCodeMap)
         {
-            if (it->second.first == regOrder)
+            SystemRegisterDecodeEntry decodeEntry = {accessCodeEntry.first, c_InvalidRegisterIndex,
+                                                     accessCodeEntry.second.second.c_str()};
+            auto itName = std::lower_bound(m_systemRegNameIndex.cbegin(), m_systemRegNameIndex.cend(),
+                accessCodeEntry.second.second,
+                [](const std::pair<std::string, size_t> & entry, const std::string & name) { return entry.first < name; });
+            if (itName != m_systemRegNameIndex.cend() && itName->first == accessCodeEntry.second.second)
             {
-                return it->first;
+                decodeEntry.registerIndex = itName->second;
             }
+            m_systemRegDecodeTable.push_back(decodeEntry);
+            m_systemRegOrderIndex.emplace_back(accessCodeEntry.second.first, accessCodeEntry.first);
         }
-        return c_InvalidAddress;
+        std::sort(m_systemRegOrderIndex.begin(), m_systemRegOrderIndex.end());
     }
 
-    inline const char * GetSystemRegNamebyAccessCode(_In_ AddressType regAccess)
+    inline const SystemRegisterDecodeEntry * FindSystemRegisterDecodeEntry(_In_ AddressType regAccess) const
+    {
+        auto it = std::lower_bound(m_systemRegDecodeTable.cbegin(), m_systemRegDecodeTable.cend(), regAccess,
+            [](const SystemRegisterDecodeEntry & entry, AddressType accessCode) { return entry.accessCode < accessCode; });
+        if (it != m_systemRegDecodeTable.cend() && it->accessCode == regAccess)
+        {
+            return &(*it);
+        }
+        return nullptr;
+    }
+
+    inline AddressType GetAccessCodeByRegisterNumber(_In_ const string & regOrder)
     {
-        if (m_spSystemRegAccessCodeMap->empty())
+        if (m_systemRegOrderIndex.empty())
         {
             throw _com_error(E_INVALIDARG);
         }
 
-        auto it = m_spSystemRegAccessCodeMap->find(regAccess);
-        if (it != m_spSystemRegAccessCodeMap->end())
+        auto it = std::lower_bound(m_systemRegOrderIndex.cbegin(), m_systemRegOrderIndex.cend(), regOrder,
+            [](const std::pair<std::string, AddressType> & entry, const std::string & order) { return entry.first < order; });
+        if (it != m_systemRegOrderIndex.cend() && it->first == regOrder)
+        {
+            return it->second;
+        }
+        return c_InvalidAddress;
+    }
+
+    inline const char * GetSystemRegNamebyAccessCode(_In_ AddressType regAccess)
+    {
+        if (m_systemRegDecodeTable.empty())
         {
-            return it->second.second.c_str();
+            throw _com_error(E_INVALIDARG);
         }
-        return "";
+
+        const SystemRegisterDecodeEntry * pEntry = FindSystemRegisterDecodeEntry(regAccess);
+        return (pEntry != nullptr) ? pEntry->pName : "";
     }
 
     SimpleCharBuffer GdbSrvControllerImpl::PrintSystemRegisters()
@@ -2956,6 +4307,17 @@ public:
     const_regIterator GdbSrvControllerImpl::FindRegisterVectorEntryEx(_In_ const std::string regName,
                                                                       _In_ RegisterGroupType regGroup)
     {
+        if (regGroup != CORE_REGS && !m_systemRegNameIndex.empty())
+        {
+            auto itName = std::lower_bound(m_systemRegNameIndex.cbegin(), m_systemRegNameIndex.cend(), regName,
+                [](const std::pair<std::string, size_t> & entry, const std::string & name) { return entry.first < name; });
+            if (itName == m_systemRegNameIndex.cend() || itName->first != regName)
+            {
+                throw _com_error(E_INVALIDARG);
+            }
+            return RegistersBegin(regGroup) + itName->second;
+        }
+
         const_regIterator it;
         for (it = RegistersBegin(regGroup); it != RegistersEnd(regGroup); ++it)
         {
@@ -3091,19 +4453,57 @@ public:
         return pFormat;
     }
 
-    void RequestXmlFileDescriptionFeature(_In_ ConfigExdiGdbServerHelper & cfgData,
-                                          _In_ wstring const & wTargetFileName, 
-                                          _In_ const char * requestCmd, 
-                                          _In_ const char * startOffset,
-                                          _In_ const char * lengthToRead)
+    //
+    //  GetXmlFileDescriptionChunkLength    Returns the length used for each qXfer:features:read request.
+    //                                      The largest packet size negotiated with the GDB server is used,
+    //                                      so the file can be transferred with the minimum number of packets.
+    //
+    //  Parameters:
+    //  minLengthToRead                     Minimum length that will be requested.
+    //
+    //  Return:
+    //  The length of the chunk to read.
+    //
+    size_t GetXmlFileDescriptionChunkLength(_In_ size_t minLengthToRead)
+    {
+        assert(m_pRspClient != nullptr);
+
+        PacketConfig rspFeatures;
+        m_pRspClient->GetRspPacketFeatures(&rspFeatures, PACKET_SIZE);
+        //  The reply packet contains the 'm'/'l' prefix plus the "$" & "#nn" packet markers
+        const size_t packetOverhead = 5;
+        size_t negotiatedLength = static_cast<size_t>(rspFeatures.featureDefaultValue);
+        negotiatedLength = (negotiatedLength > packetOverhead) ? (negotiatedLength - packetOverhead) : 0;
+        return (negotiatedLength > minLengthToRead) ? negotiatedLength : minLengthToRead;
+    }
+
+    //
+    //  FetchXmlFileDescription     Reads an xml target description file from the GDB server.
+    //
+    //  Parameters:
+    //  wTargetFileName             Name of the file to read.
+    //  requestCmd                  Request command.
+    //  minLengthToRead             Minimum length of each multi-part chunk.
+    //
+    //  Return:
+    //  The xml file content.
+    //
+    //  Request:
+    //      qXfer:features:read:<annex>:<offset>,<length>
+    //  Response:
+    //      m<data> (more data to read) or l<data> (last chunk)
+    //
+    std::string FetchXmlFileDescription(_In_ wstring const & wTargetFileName,
+                                        _In_ const char * requestCmd,
+                                        _In_ size_t minLengthToRead)
     {
-        //  Process the target description file
         using convert_type = std::codecvt_utf8<wchar_t>;
         std::wstring_convert<convert_type, wchar_t> converter;
         const std::string sfileName = converter.to_bytes(wTargetFileName);
 
+        size_t lengthToRead = GetXmlFileDescriptionChunkLength(minLengthToRead);
         char fileRegCmd[256] = { 0 };
-        sprintf_s(fileRegCmd, ARRAYSIZE(fileRegCmd), "%s%s:%s,%s", requestCmd, sfileName.c_str(), startOffset, lengthToRead);
+        sprintf_s(fileRegCmd, ARRAYSIZE(fileRegCmd), "%s%s:0,%zx", requestCmd, sfileName.c_str(), lengthToRead);
 
         bool isDone = false;
         std::string descriptionFile;
@@ -3131,7 +4531,7 @@ public:
                 else
                 {
                     fileOffset += (recvLength - 1);
-                    sprintf_s(fileRegCmd, ARRAYSIZE(fileRegCmd), "%s%s:%zx,%s", requestCmd, sfileName.c_str(), fileOffset, lengthToRead);
+                    sprintf_s(fileRegCmd, ARRAYSIZE(fileRegCmd), "%s%s:%zx,%zx", requestCmd, sfileName.c_str(), fileOffset, lengthToRead);
                 }
             }
             else if (reply.find("l") == 0 && recvLength == 1)
@@ -3149,7 +4549,11 @@ public:
         {
             throw _com_error(E_FAIL);
         }
+        return descriptionFile;
+    }
 
+    void ParseXmlFileDescription(_In_ ConfigExdiGdbServerHelper & cfgData, _In_ const std::string & descriptionFile)
+    {
         //  Parse the file target description
         std::wstring wTargetFileBuffer(descriptionFile.begin(), descriptionFile.end());
         //  @TODO: find a solution for xmlLite to handle "xi:include" tag, so for now
@@ -3158,21 +4562,37 @@ public:
         cfgData.SetXmlBufferToParse(wTargetFileBuffer.c_str());
     }
 
-    void ValidateTargetArchitecture(_Inout_ ConfigExdiGdbServerHelper& cfgData)
+    void ValidateTargetArchitecture(_Inout_ ConfigExdiGdbServerHelper& cfgData,
+                                    _In_opt_ const TargetDescriptionLayout * pCachedLayout = nullptr)
     {
         //  Validate that the group register included in the target file matches
         //  with the current GDbserver target architecture configuration.
-        if (cfgData.GetRegisterGroupArchitecture() != cfgData.GetTargetArchitecture())
+        const TargetArchitecture registerGroupArchitecture = (pCachedLayout != nullptr) ?
+                                                             pCachedLayout->registerGroupArchitecture :
+                                                             cfgData.GetRegisterGroupArchitecture();
+        if (registerGroupArchitecture != cfgData.GetTargetArchitecture())
         {
-            if (cfgData.GetRegisterGroupArchitecture() != UNKNOWN_ARCH)
+            if (registerGroupArchitecture != UNKNOWN_ARCH)
             {
                 //  Set the current saved target architecture
-                cfgData.SetTargetArchitecture(cfgData.GetRegisterGroupArchitecture());
-                SetTargetArchitecture(cfgData.GetRegisterGroupArchitecture());
-                SetTargetProcessorFamilyByTargetArch(cfgData.GetRegisterGroupArchitecture());
+                cfgData.SetTargetArchitecture(registerGroupArchitecture);
+                SetTargetArchitecture(registerGroupArchitecture);
+                SetTargetProcessorFamilyByTargetArch(registerGroupArchitecture);
                 //  Re-Read the core registers since the target GDB architecture changed 
-                //  by the GDB server target description file
-                cfgData.GetGdbServerRegisters(&m_spRegisterVector);
+                //  by the GDB server target description file (a cached layout keeps
+                //  the core registers that were read when it was compiled).
+                if (pCachedLayout != nullptr)
+                {
+                    m_spRegisterVector.reset(new (std::nothrow) vector<RegistersStruct>(pCachedLayout->coreRegisters));
+                    if (m_spRegisterVector == nullptr)
+                    {
+                        throw _com_error(E_OUTOFMEMORY);
+                    }
+                }
+                else
+                {
+                    cfgData.GetGdbServerRegisters(&m_spRegisterVector);
+                }
             }
             else
             {
@@ -3209,6 +4629,10 @@ public:
     //  _ Read the response into a buffer and then call to set the buffer to be parsed SetXmlBufferToParse("buffer response")
     //  _ Read the xml system registers, and then stores here the vector system registers from the config table.
     //
+    //  The register layout compiled from these files is stored in the TargetDescriptionCache keyed by
+    //  the target description file content hash, so later sessions receiving the same files
+    //  skip the xml parsing phase.
+    //
     void GdbSrvControllerImpl::HandleTargetDescriptionPacket(_In_ ConfigExdiGdbServerHelper & cfgData)
     {
         std::wstring wFileName;
@@ -3218,11 +4642,43 @@ public:
             return;
         }
 
+        //  Read the target description file, and check if the register layout 
+        //  for this file content has been already compiled.
+        const std::string targetDescription = FetchXmlFileDescription(wFileName, g_RequestGdbReadFeatureFile, 0xffb);
+        //  The layout also depends on the local configuration (target architecture and core register set),
+        //  so a configuration change compiles the layout again.
+        const ULONGLONG targetDescriptionHash = TargetDescriptionCache::ComputeLayoutKey(
+                                                    TargetDescriptionCache::ComputeContentHash(targetDescription),
+                                                    cfgData.GetTargetArchitecture(),
+                                                    m_spRegisterVector.get());
+        const ULONGLONG systemRegMapFileHash = TargetDescriptionCache::ComputeFileContentHash(m_spSystemRegXmlFile.get());
+
+        TargetDescriptionLayout layout = {};
+        std::string systemRegDescription;
+        if (TargetDescriptionCache::GetInstance().FindLayout(targetDescriptionHash, layout) &&
+            layout.systemRegMapFileHash == systemRegMapFileHash)
+        {
+            bool isLayoutValid = true;
+            if (!layout.systemRegFileName.empty())
+            {
+                //  The system register file is validated against its content hash
+                systemRegDescription = FetchXmlFileDescription(layout.systemRegFileName, g_RequestGdbReadFeatureFile, 0xffff);
+                isLayoutValid = (TargetDescriptionCache::ComputeContentHash(systemRegDescription) == layout.systemRegFileHash);
+            }
+            if (isLayoutValid)
+            {
+                ApplyTargetDescriptionLayout(cfgData, layout);
+                return;
+            }
+        }
+
         //  Process the target description file
-        RequestXmlFileDescriptionFeature(cfgData, wFileName, g_RequestGdbReadFeatureFile, "0","ffb");
+        ParseXmlFileDescription(cfgData, targetDescription);
 
         //  Validate that the group register included in the target file matches
         //  with the current GDbserver target architecture configuration.
+        layout.registerGroupArchitecture = cfgData.GetRegisterGroupArchitecture();
+        layout.fCoreRegistersFromTarget = (layout.registerGroupArchitecture != cfgData.GetTargetArchitecture());
         ValidateTargetArchitecture(cfgData);
 
         //
@@ -3230,17 +4686,23 @@ public:
         //  processes only the file with the system register group.
         //
         bool checkSystemRegFile = false;
+        std::wstring systemRegFileName;
         if (cfgData.IsRegisterGroupFileAvailable(SYSTEM_REGS))
         {
             //  Get the system register file
-            cfgData.GetRegisterGroupFile(SYSTEM_REGS, wFileName);
-            if (wFileName.empty())
+            cfgData.GetRegisterGroupFile(SYSTEM_REGS, systemRegFileName);
+            if (systemRegFileName.empty())
             {
                 throw _com_error(E_INVALIDARG);
             }
 
-            //  Process the system register description file
-            RequestXmlFileDescriptionFeature(cfgData, wFileName, g_RequestGdbReadFeatureFile, "0", "ffff");
+            //  Process the system register description file (it could have been read
+            //  already when validating a stale cached layout).
+            if (systemRegDescription.empty() || layout.systemRegFileName != systemRegFileName)
+            {
+                systemRegDescription = FetchXmlFileDescription(systemRegFileName, g_RequestGdbReadFeatureFile, 0xffff);
+            }
+            ParseXmlFileDescription(cfgData, systemRegDescription);
 
             checkSystemRegFile = true;
         }
@@ -3261,6 +4723,88 @@ public:
             //  Get the actual system register vector from the table.
             cfgData.GetGdbServerSystemRegisters(&m_spSystemRegisterVector);
         }
+
+        //  Store the compiled layout, so next sessions can skip parsing the same files.
+        layout.systemRegFileName = systemRegFileName;
+        layout.systemRegFileHash = systemRegFileName.empty() ? 0 : TargetDescriptionCache::ComputeContentHash(systemRegDescription);
+        layout.systemRegMapFileHash = systemRegMapFileHash;
+        StoreTargetDescriptionLayout(targetDescriptionHash, layout);
+    }
+
+    //
+    //  ApplyTargetDescriptionLayout    Sets the register layout from a previously compiled
+    //                                  target description layout.
+    //
+    //  Parameters:
+    //  cfgData                         Reference to the configuration data.
+    //  layout                          Reference to the cached layout.
+    //
+    //  Return:
+    //  Nothing.
+    //
+    void GdbSrvControllerImpl::ApplyTargetDescriptionLayout(_Inout_ ConfigExdiGdbServerHelper & cfgData,
+                                                            _In_ const TargetDescriptionLayout & layout)
+    {
+        //  The architecture is validated as if the target description file had been parsed.
+        ValidateTargetArchitecture(cfgData, &layout);
+
+        if (layout.fSystemRegistersAvailable)
+        {
+            m_spSystemRegisterVector.reset(new (std::nothrow) vector<RegistersStruct>(layout.systemRegisters));
+            if (m_spSystemRegisterVector == nullptr)
+            {
+                throw _com_error(E_OUTOFMEMORY);
+            }
+        }
+
+        if (layout.fSystemRegMapAvailable)
+        {
+            m_spSystemRegAccessCodeMap.reset(new (std::nothrow) SystemRegistersMapType(layout.systemRegAccessCodeMap));
+            if (m_spSystemRegAccessCodeMap == nullptr)
+            {
+                throw _com_error(E_OUTOFMEMORY);
+            }
+        }
+    }
+
+    //
+    //  StoreTargetDescriptionLayout    Stores the current register layout in the target description cache.
+    //
+    //  Parameters:
+    //  contentHash                     Hash of the target description file content.
+    //  layout                          Reference to the layout containing the target file data.
+    //
+    //  Return:
+    //  Nothing.
+    //
+    void GdbSrvControllerImpl::StoreTargetDescriptionLayout(_In_ ULONGLONG contentHash,
+                                                            _Inout_ TargetDescriptionLayout & layout)
+    {
+        layout.coreRegisters.clear();
+        if (layout.fCoreRegistersFromTarget)
+        {
+            if (m_spRegisterVector == nullptr)
+            {
+                return;
+            }
+            layout.coreRegisters = *m_spRegisterVector;
+        }
+
+        layout.fSystemRegistersAvailable = (m_spSystemRegisterVector != nullptr);
+        layout.systemRegisters.clear();
+        if (layout.fSystemRegistersAvailable)
+        {
+            layout.systemRegisters = *m_spSystemRegisterVector;
+        }
+
+        layout.fSystemRegMapAvailable = (m_spSystemRegAccessCodeMap != nullptr);
+        layout.systemRegAccessCodeMap.clear();
+        if (layout.fSystemRegMapAvailable)
+        {
+            layout.systemRegAccessCodeMap = *m_spSystemRegAccessCodeMap;
+        }
+
+        TargetDescriptionCache::GetInstance().StoreLayout(contentHash, layout);
     }
 };
 
@@ -3432,6 +4976,14 @@ std::map<std::string, std::string> GdbSrvController::QueryRegistersByGroup(_In_
     }
 }
 
+std::map<AddressType, std::string> GdbSrvController::QuerySystemRegistersByAccessCode(_In_ unsigned processorNumber,
+                                                                                      _In_reads_(numberOfElements) const AddressType accessCodes[],
+                                                                                      _In_ const size_t numberOfElements)
+{
+    assert(m_pGdbSrvControllerImpl != nullptr);
+    return m_pGdbSrvControllerImpl->QuerySystemRegistersByAccessCode(processorNumber, accessCodes, numberOfElements);
+}
+
 SimpleCharBuffer GdbSrvController::ReadMemory(_In_ AddressType address, _In_ size_t size, _In_ const memoryAccessType memType)
 {
     assert(m_pGdbSrvControllerImpl != nullptr);
@@ -3444,6 +4996,55 @@ SimpleCharBuffer GdbSrvController::ReadSystemRegisters(_In_ AddressType address,
     return m_pGdbSrvControllerImpl->ReadSystemRegisters(address, size, memType);
 }
 
+std::vector<std::map<std::string, std::string>> GdbSrvController::QueryAllProcessorsRegisters()
+{
+    assert(m_pGdbSrvControllerImpl != nullptr);
+    return m_pGdbSrvControllerImpl->QueryAllProcessorsRegisters();
+}
+
+std::map<std::string, std::string> GdbSrvController::QueryAllRegistersFromSnapshot(_In_ unsigned processorNumber)
+{
+    assert(m_pGdbSrvControllerImpl != nullptr);
+    return m_pGdbSrvControllerImpl->QueryAllRegistersFromSnapshot(processorNumber);
+}
+
+void GdbSrvController::DiscardAllProcessorsRegisters()
+{
+    assert(m_pGdbSrvControllerImpl != nullptr);
+    m_pGdbSrvControllerImpl->DiscardAllProcessorsRegisters();
+}
+
+bool GdbSrvController::IsHostPageTableWalkEnabled()
+{
+    assert(m_pGdbSrvControllerImpl != nullptr);
+    return m_pGdbSrvControllerImpl->IsHostPageTableWalkEnabled();
+}
+
+SimpleCharBuffer GdbSrvController::ReadVirtualMemoryByPA(_In_ AddressType address, _In_ size_t size)
+{
+    assert(m_pGdbSrvControllerImpl != nullptr);
+    return m_pGdbSrvControllerImpl->ReadVirtualMemoryByPA(address, size);
+}
+
+bool GdbSrvController::WriteVirtualMemoryByPA(_In_ AddressType address, _In_ size_t size, _In_ const void * pRawBuffer, 
+                                              _Out_ DWORD * pdwBytesWritten)
+{
+    assert(m_pGdbSrvControllerImpl != nullptr);
+    return m_pGdbSrvControllerImpl->WriteVirtualMemoryByPA(address, size, pRawBuffer, pdwBytesWritten);
+}
+
+void GdbSrvController::FlushAddressTranslations()
+{
+    assert(m_pGdbSrvControllerImpl != nullptr);
+    m_pGdbSrvControllerImpl->FlushAddressTranslations();
+}
+
+bool GdbSrvController::FlushPendingMemoryWrites(_Out_opt_ AddressType * pFaultAddress)
+{
+    assert(m_pGdbSrvControllerImpl != nullptr);
+    return m_pGdbSrvControllerImpl->FlushPendingMemoryWrites(pFaultAddress);
+}
+
 bool GdbSrvController::WriteMemory(_In_ AddressType address, _In_ size_t size, _In_ const void * pRawBuffer, 
                                    _Out_ DWORD * pdwBytesWritten, _In_ const memoryAccessType memType)
 {
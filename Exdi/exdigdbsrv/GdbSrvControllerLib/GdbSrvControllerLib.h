@@ -214,6 +214,15 @@ namespace GdbSrvControllerLib
         //  Request the current value for all target CPU registers.
         std::map<std::string, std::string> QueryAllRegisters(_In_ unsigned processorNumber);
 
+        //  Request the core registers of all the processor cores (concurrently in multi-core sessions).
+        std::vector<std::map<std::string, std::string>> QueryAllProcessorsRegisters();
+
+        //  Request the core registers by using the registers snapshot of the halted target.
+        std::map<std::string, std::string> QueryAllRegistersFromSnapshot(_In_ unsigned processorNumber);
+
+        //  Discard the registers snapshot of the halted target.
+        void DiscardAllProcessorsRegisters();
+
         //  Request the current set of register values for the specified register group type (core, fpu, system).
         std::map<std::string, std::string> QueryAllRegistersEx(_In_ unsigned processorNumber,
             _In_ RegisterGroupType groupType = CORE_REGS);
@@ -228,6 +237,11 @@ namespace GdbSrvControllerLib
                                                                  _In_ RegisterGroupType groupType,
                                                                 _Out_ int & maxRegisterNameLength);
 
+        //  Request reading a set of system registers identified by their access codes
+        std::map<AddressType, std::string> QuerySystemRegistersByAccessCode(_In_ unsigned processorNumber,
+                                                                            _In_reads_(numberOfElements) const AddressType accessCodes[],
+                                                                            _In_ const size_t numberOfElements);
+
         //  Utility function to get a 64 bit register value.
         static ULONGLONG ParseRegisterValue(_In_ const std::string &stringValue);
         
@@ -283,6 +297,20 @@ namespace GdbSrvControllerLib
         bool WriteMemory(_In_ AddressType address, _In_ size_t size, _In_ const void * pRawBuffer, 
                          _Out_ DWORD * pdwBytesWritten, _In_ const memoryAccessType memType);
 
+        //  Send the memory writes deferred by the write-back buffer, it fails if a deferred write failed.
+        bool FlushPendingMemoryWrites(_Out_opt_ AddressType * pFaultAddress = nullptr);
+
+        //  Check if the virtual addresses are translated by the host page table walker.
+        bool IsHostPageTableWalkEnabled();
+
+        //  Read/write the target virtual memory by translating the addresses to physical addresses.
+        SimpleCharBuffer ReadVirtualMemoryByPA(_In_ AddressType address, _In_ size_t size);
+        bool WriteVirtualMemoryByPA(_In_ AddressType address, _In_ size_t size, _In_ const void * pRawBuffer, 
+                                    _Out_ DWORD * pdwBytesWritten);
+
+        //  Discard the cached address translations.
+        void FlushAddressTranslations();
+
         //  Get the number of RSP GdbServer connections.
         unsigned GetNumberOfRspConnections();
 
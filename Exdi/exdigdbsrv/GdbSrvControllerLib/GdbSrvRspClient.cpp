@@ -318,6 +318,7 @@ int MakeRunLengthEncoding(_In_reads_(remaining) const char * pCommand, _In_ int
 //  Parameters:
 //  packetLength        Length of the expected packet.
 //  pStream             Pointer to the TcpIpStream object.
+//  receiveBuffer       Reference to the receive buffer of the stream channel.
 //  resetBuffer         Flag indicating if we need to flush the current buffer.
 //  pCurrentChar        Pointer to the current output character.
 //
@@ -330,41 +331,45 @@ int MakeRunLengthEncoding(_In_reads_(remaining) const char * pCommand, _In_ int
 //  and then it'll dispatch the received characters until the buffer is empty or the 
 //  caller requests reseting the input buffer.
 //
-int ReceiveInternal(_In_ int packetLength, _In_ TcpIpStream * const pStream,
+int ReceiveInternal(_In_ int packetLength, _In_ TcpIpStream * const pStream, _Inout_ RspReceiveBuffer & receiveBuffer,
                     _In_ bool resetBuffer, _Out_ char * pCurrentChar)
 {
     assert(pStream != nullptr && pCurrentChar != nullptr);
 
-    static unique_ptr<char> pReadInputStream = nullptr;
-    static int readInputStreamCharCounter = 0;
-    static char * pReadInputStreamBuffer = nullptr;
-    static int maximumPacketLength = 0;
-
-    if (resetBuffer || pReadInputStreamBuffer == nullptr)
+    if (resetBuffer || receiveBuffer.pReadInputStreamBuffer == nullptr)
     {
-        maximumPacketLength = static_cast<int>(CALC_RSP_PACKET_LENGTH(packetLength));
-        pReadInputStream = unique_ptr <char>(new (nothrow) char[maximumPacketLength]);
-        assert(pReadInputStream != nullptr);
-        readInputStreamCharCounter = 0;
+        int maximumPacketLength = static_cast<int>(CALC_RSP_PACKET_LENGTH(packetLength));
+        //  Keep the current buffer if it's large enough.
+        if (receiveBuffer.pReadInputStream == nullptr || receiveBuffer.maximumPacketLength != maximumPacketLength)
+        {
+            receiveBuffer.pReadInputStream = unique_ptr<char[]>(new (nothrow) char[maximumPacketLength]);
+            if (receiveBuffer.pReadInputStream == nullptr)
+            {
+                throw _com_error(E_OUTOFMEMORY);
+            }
+            receiveBuffer.maximumPacketLength = maximumPacketLength;
+        }
+        receiveBuffer.readInputStreamCharCounter = 0;
     }
 
-    if (readInputStreamCharCounter == 0)
+    if (receiveBuffer.readInputStreamCharCounter == 0)
     {
-        pReadInputStreamBuffer = pReadInputStream.get();
-        memset(pReadInputStreamBuffer, 0x00, maximumPacketLength);
-        readInputStreamCharCounter = pStream->Receive(pReadInputStreamBuffer, maximumPacketLength);
-        if (readInputStreamCharCounter == SOCKET_ERROR)
+        receiveBuffer.pReadInputStreamBuffer = receiveBuffer.pReadInputStream.get();
+        memset(receiveBuffer.pReadInputStreamBuffer, 0x00, receiveBuffer.maximumPacketLength);
+        receiveBuffer.readInputStreamCharCounter = pStream->Receive(receiveBuffer.pReadInputStreamBuffer,
+                                                                    receiveBuffer.maximumPacketLength);
+        if (receiveBuffer.readInputStreamCharCounter == SOCKET_ERROR)
         {
-            pReadInputStreamBuffer = nullptr;
+            receiveBuffer.pReadInputStreamBuffer = nullptr;
         }
     }
-    if (pReadInputStreamBuffer != nullptr)
+    if (receiveBuffer.pReadInputStreamBuffer != nullptr)
     {
-        readInputStreamCharCounter--;
-        *pCurrentChar = *pReadInputStreamBuffer;
-        pReadInputStreamBuffer++;
+        receiveBuffer.readInputStreamCharCounter--;
+        *pCurrentChar = *receiveBuffer.pReadInputStreamBuffer;
+        receiveBuffer.pReadInputStreamBuffer++;
     }
-    return readInputStreamCharCounter;
+    return receiveBuffer.readInputStreamCharCounter;
 }
 
 //
@@ -372,6 +377,7 @@ int ReceiveInternal(_In_ int packetLength, _In_ TcpIpStream * const pStream,
 //
 //  Parameters:
 //  pStream         Pointer to the TcpIpStream object.
+//  receiveBuffer   Reference to the receive buffer of the stream channel.
 //  outData         Reference to the built packet.
 //  checkSum        Reference to the checksum of the built packet data
 //
@@ -379,7 +385,8 @@ int ReceiveInternal(_In_ int packetLength, _In_ TcpIpStream * const pStream,
 //  If there is no any error then it returns the packet length  
 //  Otherwise the error.
 //
-int BuildRspPacket(_In_ TcpIpStream * const pStream, _Out_ string & outData, _Out_ unsigned int & checkSum)
+int BuildRspPacket(_In_ TcpIpStream * const pStream, _Inout_ RspReceiveBuffer & receiveBuffer,
+                   _Out_ string & outData, _Out_ unsigned int & checkSum)
 {
     assert(pStream != nullptr);
 
@@ -389,7 +396,7 @@ int BuildRspPacket(_In_ TcpIpStream * const pStream, _Out_ string & outData, _Ou
 
     for(;;)
     {
-        readStatus = ReceiveInternal(0, pStream, false, &currentChar);
+        readStatus = ReceiveInternal(0, pStream, receiveBuffer, false, &currentChar);
         if (readStatus == SOCKET_ERROR)
         {
             break;
@@ -411,6 +418,7 @@ int BuildRspPacket(_In_ TcpIpStream * const pStream, _Out_ string & outData, _Ou
 //
 //  Parameters:
 //  pStream             Pointer to the TcpIpStream object.
+//  receiveBuffer       Reference to the receive buffer of the stream channel.
 //  outData             The calculated checksum of the received packet
 //  isNoAckModeEnabled  Flag indicating if the ACK mode is not enabled
 //  inputRspData        Reference to the received data packet without the checksum.
@@ -420,8 +428,8 @@ int BuildRspPacket(_In_ TcpIpStream * const pStream, _Out_ string & outData, _Ou
 //  true                If both checksums match.
 //  false               Otherwise.
 //
-bool IsValidRspPacket(_In_ TcpIpStream * const pStream, _In_ unsigned int checkSum, _In_ bool isNoAckModeEnabled, 
-                      _In_ const string & inputRspData, _Out_ string & outRspData)
+bool IsValidRspPacket(_In_ TcpIpStream * const pStream, _Inout_ RspReceiveBuffer & receiveBuffer, _In_ unsigned int checkSum,
+                      _In_ bool isNoAckModeEnabled, _In_ const string & inputRspData, _Out_ string & outRspData)
 {
     assert(pStream != nullptr);
     bool isDone = false;
@@ -429,10 +437,10 @@ bool IsValidRspPacket(_In_ TcpIpStream * const pStream, _In_ unsigned int checkS
     unsigned char checkSumR = 0;
 
     //  Verify the checksum
-    int readStatus = ReceiveInternal(0, pStream, false, reinterpret_cast<char *>(&checkSumL));
+    int readStatus = ReceiveInternal(0, pStream, receiveBuffer, false, reinterpret_cast<char *>(&checkSumL));
     if (readStatus != SOCKET_ERROR)
     {
-        readStatus = ReceiveInternal(0, pStream, false, reinterpret_cast<char *>(&checkSumR));
+        readStatus = ReceiveInternal(0, pStream, receiveBuffer, false, reinterpret_cast<char *>(&checkSumR));
         if (readStatus != SOCKET_ERROR)
         {
             checkSumL = ((AciiHexToNumber(checkSumL) << 4) & 0xf0);
@@ -542,6 +550,7 @@ inline bool IsReceiveInterrupt(_In_ int readStatus, _In_ bool isRspWaitNeeded,
 //  Parameters:
 //  maxPacketLength         Expected packet length
 //  pStream                 Pointer to the TcpIpStream object.
+//  receiveBuffer           Reference to the receive buffer of the stream channel.
 //  isRspWaitNeeded         Flag true if we need to wait until the packet arrive (ignore timeout).
 //  IsPollingChannelMode    Flag set if the current mode requires polling all channels.
 //  fResetBuffer            Flag indicates if we need to reset any pending data in the local cached buffer.
@@ -550,8 +559,8 @@ inline bool IsReceiveInterrupt(_In_ int readStatus, _In_ bool isRspWaitNeeded,
 //  The number of received characters. 
 //
 int GdbSrvRspClient<TcpConnectorStream>::WaitForRspPacketStart(_In_ int maxPacketLength, _In_ TcpIpStream * const pStream, 
-                                                               _In_ bool isRspWaitNeeded, _Inout_ bool & IsPollingChannelMode,
-                                                               _In_ bool fResetBuffer)
+                                                               _Inout_ RspReceiveBuffer & receiveBuffer, _In_ bool isRspWaitNeeded,
+                                                               _Inout_ bool & IsPollingChannelMode, _In_ bool fResetBuffer)
 {
     assert(pStream != nullptr && maxPacketLength != 0);
     char currentChar;
@@ -563,7 +572,7 @@ int GdbSrvRspClient<TcpConnectorStream>::WaitForRspPacketStart(_In_ int maxPacke
     //  Wait for the packet start character to arrive.
     do
     {
-        readStatus = ReceiveInternal(maxPacketLength, pStream, reset, &currentChar);
+        readStatus = ReceiveInternal(maxPacketLength, pStream, receiveBuffer, reset, &currentChar);
         //  Do we need to exit the receiving sequence?
         if (IsReceiveInterrupt(readStatus, isRspWaitNeeded, m_interruptEvent.Get(),
             userInterrupFlag))
@@ -659,6 +668,27 @@ inline bool GdbSrvRspClient<TcpConnectorStream>::GetNoAckModeRequired(_In_ const
     return isNoAckMode;
 }
 
+//
+//  GetChannel      Gets the channel state used by the processor core.
+//
+//  Parameters:
+//  core            Processor core.
+//
+//  Returns:
+//  Reference to the channel state (a single channel is shared by all cores if 
+//  there is only one stream connection).
+//
+inline RspChannel & GdbSrvRspClient<TcpConnectorStream>::GetChannel(_In_ unsigned core)
+{
+    assert(m_pChannels != nullptr);
+    size_t channel = (m_numberOfChannels > 1) ? core : 0;
+    if (channel >= m_numberOfChannels)
+    {
+        throw _com_error(E_INVALIDARG);
+    }
+    return m_pChannels[channel];
+}
+
 //=============================================================================
 // Public function definitions
 //=============================================================================
@@ -688,7 +718,8 @@ bool GdbSrvRspClient<TcpConnectorStream>::SendRspPacket(_In_ const string & comm
 
     try
     {
-        scoped_lock packetGuard(m_gdbSrvRspLock);
+        RspChannel & channel = GetChannel(activeCore);
+        scoped_lock packetGuard(channel.channelLock);
         bool isDone = true;
 
         //  Create the packet to send
@@ -749,7 +780,11 @@ bool GdbSrvRspClient<TcpConnectorStream>::SendRspPacket(_In_ const string & comm
             //  the stop reason package that will continue this break before exiting from this function.
         }
         while (IS_SEND_PACKET_DONE(ackCharacter[0], m_interruptEvent.Get()));
-    
+
+        if (!isDone)
+        {
+            channel.lastError = GetChannelError();
+        }
         return isDone;
     }
     CATCH_AND_RETURN_BOOLEAN
@@ -784,7 +819,8 @@ bool GdbSrvRspClient<TcpConnectorStream>::ReceiveRspPacketEx(_Out_ string & resp
     {
         bool isDone = false;
 
-        scoped_lock packetGuard(m_gdbSrvRspLock);
+        RspChannel & channel = GetChannel(activeCore);
+        scoped_lock packetGuard(channel.channelLock);
         //  Verify if we have set the maximum response packet, if so then use
         //  this value as the maximum response
         int maxPacketLength = GET_FEATURE_VALUE(PACKET_SIZE);
@@ -792,16 +828,17 @@ bool GdbSrvRspClient<TcpConnectorStream>::ReceiveRspPacketEx(_Out_ string & resp
         TcpIpStream * pTcpStream = m_pConnector->GetLinkLayerStreamEntry(activeCore);
         assert(pTcpStream != nullptr);
         //  Wait for the first packet character '$' to arrive
-        if (WaitForRspPacketStart(maxPacketLength, pTcpStream, isRspWaitNeeded, IsPollingChannelMode, fResetBuffer) != SOCKET_ERROR)
+        if (WaitForRspPacketStart(maxPacketLength, pTcpStream, channel.receiveBuffer, isRspWaitNeeded,
+                                  IsPollingChannelMode, fResetBuffer) != SOCKET_ERROR)
         {
             string replyPacket;
             replyPacket.reserve(response.length());
             unsigned int checkSum = 0;
             //  Build the data packet
-            if (BuildRspPacket(pTcpStream, replyPacket, checkSum) != SOCKET_ERROR)   
+            if (BuildRspPacket(pTcpStream, channel.receiveBuffer, replyPacket, checkSum) != SOCKET_ERROR)   
             {
                 //  Verify if the RSP checksum is valid, if so, then output the response string
-                if (IsValidRspPacket(pTcpStream, checkSum, IS_FEATURE_ENABLED(PACKET_QSTART_NO_ACKMODE), 
+                if (IsValidRspPacket(pTcpStream, channel.receiveBuffer, checkSum, IS_FEATURE_ENABLED(PACKET_QSTART_NO_ACKMODE), 
                                      replyPacket, response))
                 {
                     isDone = true;
@@ -810,6 +847,10 @@ bool GdbSrvRspClient<TcpConnectorStream>::ReceiveRspPacketEx(_Out_ string & resp
                 }
             }
         }
+        if (!isDone)
+        {
+            channel.lastError = GetChannelError();
+        }
         return isDone;
     }
     CATCH_AND_RETURN_BOOLEAN
@@ -1130,6 +1171,11 @@ bool GdbSrvRspClient<TcpConnectorStream>::AttachRspToCore(_In_ const wstring &co
         return isAttached;
     }
 
+    //  The channel stream is replaced, so no packet can be in flight on this channel.
+    RspChannel & channel = GetChannel(core);
+    scoped_lock channelGuard(channel.channelLock);
+    channel.receiveBuffer.readInputStreamCharCounter = 0;
+    channel.receiveBuffer.pReadInputStreamBuffer = nullptr;
     isAttached = m_pConnector->TcpOpenStreamCore(connectionStr, core);
     if (isAttached)
     {
@@ -1189,6 +1235,7 @@ bool GdbSrvRspClient<TcpConnectorStream>::CloseRspCore(_In_ const wstring &close
         return isClosed;
     }
 
+    scoped_lock channelGuard(GetChannel(core).channelLock);
     return m_pConnector->TcpCloseCore(core);
 }
 
@@ -1204,6 +1251,51 @@ int GdbSrvRspClient<TcpConnectorStream>::GetRspLastError()
     return m_pConnector->GetLastError();
 }
 
+//
+//  GetRspLastError Retrieves the error of the last failed packet on a channel.
+//
+//  Parameters:
+//  core            Processor core using the channel.
+//
+//  Returns:
+//  The link layer error stored when the packet failed, it's not affected by
+//  the packets exchanged later on other channels.
+//
+int GdbSrvRspClient<TcpConnectorStream>::GetRspLastError(_In_ unsigned core)
+{
+    RspChannel & channel = GetChannel(core);
+    scoped_lock channelGuard(channel.channelLock);
+    return channel.lastError;
+}
+
+//
+//  GetChannelLock  Gets the lock serializing the packets of a channel.
+//
+//  Parameters:
+//  core            Processor core using the channel.
+//
+//  Returns:
+//  Reference to the channel lock, the lock is reentrant, so the holder can send and receive
+//  packets on the channel.
+//
+CRITICAL_SECTION & GdbSrvRspClient<TcpConnectorStream>::GetChannelLock(_In_ unsigned core)
+{
+    return GetChannel(core).channelLock;
+}
+
+//
+//  GetChannelError Gets the link layer error of the packet that just failed on the calling thread.
+//
+//  Returns:
+//  The socket error, or ERROR_INVALID_DATA if the packet failed without a socket error
+//  (i.e. a bad checksum), so the failure is never reported as a success.
+//
+int GdbSrvRspClient<TcpConnectorStream>::GetChannelError()
+{
+    int error = m_pConnector->GetLastError();
+    return (error != 0) ? error : ERROR_INVALID_DATA;
+}
+
 //
 //  ShutDownRsp     Shutdown the RSP protocol session by requesting closing the connection..
 //
@@ -1308,6 +1400,36 @@ void GdbSrvRspClient<TcpConnectorStream>::HandleRspErrors(_In_ GdbSrvTextType te
     }
 }
 
+//
+//  HandleRspErrors     Displays the error of the last failed packet on a channel.
+//
+//  Parameters:
+//  textType            Text type (command/output/error)
+//  core                Processor core using the channel.
+//
+//  Return:
+//  Nothing.
+//
+void GdbSrvRspClient<TcpConnectorStream>::HandleRspErrors(_In_ GdbSrvTextType textType, _In_ unsigned core)
+{
+    assert(m_pConnector != nullptr);
+    int errorCode = GetRspLastError(core);
+
+    TcpIpStream * pStream = m_pConnector->GetLinkLayerStreamEntry(core);
+    assert(pStream != nullptr);
+    const ConnectStreamErrorStruct * pEntry = FindErrorEntry(errorCode);
+    if (pEntry != nullptr)
+    {
+        pStream->CallDisplayFunction(pEntry->description, textType);
+    }
+    else
+    {
+        char errorString[128] = {0};
+        _snprintf_s(errorString, _TRUNCATE, "The socket error 0x%x ocurred", errorCode);        
+        pStream->CallDisplayFunction(errorString, textType);
+    }
+}
+
 //
 //  DiscardResponse    Discard any pending response.
 //  
@@ -1321,7 +1443,6 @@ void GdbSrvRspClient<TcpConnectorStream>::DiscardResponse(_In_ unsigned activeCo
 {
     assert(m_pConnector != nullptr);
 
-    scoped_lock packetGuard(m_gdbSrvRspLock);
     bool IsPollingChannelMode = true;
     size_t totalNumberOfProcessorCores = m_pConnector->GetNumberOfConnections();
     for (unsigned coreNumber = 0; coreNumber < totalNumberOfProcessorCores; ++coreNumber)
@@ -1331,6 +1452,7 @@ void GdbSrvRspClient<TcpConnectorStream>::DiscardResponse(_In_ unsigned activeCo
             TcpIpStream * pStream = m_pConnector->GetLinkLayerStreamEntry(coreNumber);
             assert(pStream != nullptr);
 
+            scoped_lock channelGuard(GetChannel(coreNumber).channelLock);
             string result;
             bool isRecvDone = ReceiveRspPacketEx(result, coreNumber, false, IsPollingChannelMode, true);
             if ((!isRecvDone && IsPollingChannelMode) || result.empty())
@@ -1393,7 +1515,7 @@ size_t GdbSrvRspClient<TcpConnectorStream>::GetNumberOfStreamConnections()
 {
     assert(m_pConnector != nullptr);
 
-    scoped_lock packetGuard(m_gdbSrvRspLock);
+    //  The number of stream connections does not change after the client is constructed.
     return m_pConnector->GetNumberOfConnections();
 }
 
@@ -1402,12 +1524,30 @@ GdbSrvRspClient<TcpConnectorStream>::GdbSrvRspClient(_In_ const vector<wstring>
                                      m_pConnector(unique_ptr<TConnectStream>(new (nothrow) TConnectStream(coreConnectionParameters)))
 {
     InitializeCriticalSection(&m_gdbSrvRspLock);
-     m_fInterruptFlag = false;
+    m_fInterruptFlag = false;
+
+    //  One channel per stream connection
+    m_numberOfChannels = (m_pConnector != nullptr && m_pConnector->GetNumberOfConnections() > 1) ?
+                         m_pConnector->GetNumberOfConnections() : 1;
+    m_pChannels = unique_ptr<RspChannel[]>(new (nothrow) RspChannel[m_numberOfChannels]());
+    if (m_pChannels == nullptr)
+    {
+        m_numberOfChannels = 0;
+        return;
+    }
+    for (size_t channel = 0; channel < m_numberOfChannels; ++channel)
+    {
+        InitializeCriticalSection(&m_pChannels[channel].channelLock);
+    }
 }
 
 GdbSrvRspClient<TcpConnectorStream>::~GdbSrvRspClient()
 {
     ShutDownRsp();
+    for (size_t channel = 0; channel < m_numberOfChannels; ++channel)
+    {
+        DeleteCriticalSection(&m_pChannels[channel].channelLock);
+    }
     DeleteCriticalSection(&m_gdbSrvRspLock);
     m_interruptEvent.Close();
 }
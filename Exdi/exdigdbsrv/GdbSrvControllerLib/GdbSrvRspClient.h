@@ -17,6 +17,7 @@
 #include <string>
 #include <memory>
 #include <vector>
+#include <atomic>
 #include "TextHelpers.h"
 #include "HandleHelpers.h"
 #include "TcpConnectorStream.h"
@@ -103,6 +104,27 @@ namespace GdbSrvControllerLib
         IGdbSrvTextHandler * pTextHandler;
     } RSP_CONFIG_COMM_SESSION;
 
+    //  This type contains the receive state of one link layer channel.
+    //  The characters read ahead from the channel stream are dispatched from this buffer.
+    typedef struct
+    {
+        unique_ptr<char[]> pReadInputStream;
+        int readInputStreamCharCounter;
+        char * pReadInputStreamBuffer;
+        int maximumPacketLength;
+    } RspReceiveBuffer;
+
+    //  This type contains the state of one link layer channel (a channel per core in multi-core sessions).
+    //  The channel lock serializes the packets exchanged over the channel stream, so
+    //  requests sent on different channels can be processed concurrently.
+    //  The last error is the link layer error of the last failed packet on the channel.
+    typedef struct
+    {
+        CRITICAL_SECTION channelLock;
+        RspReceiveBuffer receiveBuffer;
+        int lastError;
+    } RspChannel;
+
 
     //  This class implement the client RSP protocol used to communicate
     //  with the GdbServer
@@ -152,6 +174,13 @@ namespace GdbSrvControllerLib
         //  Retrieves the last error from the link layer
         int GetRspLastError(); 
 
+        //  Retrieves the error of the last failed packet on the channel used by the processor core.
+        int GetRspLastError(_In_ unsigned core);
+
+        //  Gets the lock serializing the packets of the channel used by the processor core,
+        //  it has to be held across a request/response exchange.
+        CRITICAL_SECTION & GetChannelLock(_In_ unsigned core);
+
         //  Shutdown the RSP protocol
         bool ShutDownRsp();
 
@@ -161,6 +190,9 @@ namespace GdbSrvControllerLib
         //  Display RSP linklayer errors
         void HandleRspErrors(_In_ GdbSrvTextType textType);
 
+        //  Display the error of the last failed packet on the channel used by the processor core.
+        void HandleRspErrors(_In_ GdbSrvTextType textType, _In_ unsigned core);
+
         //  Updates the RSP query packet storage. 
         bool UpdateRspPacketFeatures(_In_ const string & features);
         
@@ -200,16 +232,25 @@ namespace GdbSrvControllerLib
         private:
         ValidHandleWrapper m_interruptEvent;
         unique_ptr <TConnectStream> m_pConnector;
+        //  The protocol features are negotiated (qSupported/QStartNoAckMode) and the link layer options are set
+        //  while connecting, before any concurrent channel traffic, and they are only read afterwards.
+        //  The writers and the non trivial readers hold m_gdbSrvRspLock.
         static PacketConfig s_RspProtocolFeatures[MAX_FEATURES];
         static RSP_CONFIG_COMM_SESSION s_LinkLayerConfigOptions;
+        //  Protects the session configuration and the connection state, the packets are
+        //  protected by the channel locks. The lock order is m_gdbSrvRspLock -> channelLock.
         CRITICAL_SECTION m_gdbSrvRspLock;
-        int WaitForRspPacketStart(_In_ int maxPacketLength, _In_ TcpIpStream * pStream, _In_ bool isRspWaitNeeded, 
-                                  _Inout_ bool & IsPollingChannelMode, _In_ bool fResetBuffer);
+        unique_ptr<RspChannel[]> m_pChannels;
+        size_t m_numberOfChannels;
+        RspChannel & GetChannel(_In_ unsigned core);
+        int GetChannelError();
+        int WaitForRspPacketStart(_In_ int maxPacketLength, _In_ TcpIpStream * pStream, _Inout_ RspReceiveBuffer & receiveBuffer,
+                                  _In_ bool isRspWaitNeeded, _Inout_ bool & IsPollingChannelMode, _In_ bool fResetBuffer);
         string CreateSendRspPacket(_In_ const string & command);
         void SetProtocolFeatureValue(_In_ size_t index, _In_ int value);
         void SetProtocolFeatureFlag(_In_ size_t index, _In_ bool value);
         bool GetNoAckModeRequired(_In_ const string & command);
         bool SendRspInterruptEx(_In_ bool fResetAllCores, _In_ unsigned activeCore);
-        bool m_fInterruptFlag;
+        atomic<bool> m_fInterruptFlag;
     }; 
 }
\ No newline at end of file
@@ -0,0 +1,364 @@
+//----------------------------------------------------------------------------
+//
+// PageTableWalker.cpp
+//
+// Host-side virtual to physical address translation for GDB server targets
+// that can only access memory by physical address.
+//
+// Copyright (c) Microsoft. All rights reserved.
+//----------------------------------------------------------------------------
+
+#include "stdafx.h"
+#include <comdef.h>
+#include "PageTableWalker.h"
+
+using namespace GdbSrvControllerLib;
+using namespace std;
+
+//=============================================================================
+// Private data definitions
+//=============================================================================
+//  Smallest page size used for tracking the memory containing the page tables.
+const unsigned C_PAGE_TABLE_TRACKING_SHIFT = 12;
+
+//  Maximum number of cached translations, the cache is flushed when it's full.
+const size_t C_MAX_CACHED_TRANSLATIONS = 8192;
+
+//  x64 control register bits
+const ULONGLONG C_X64_CR0_PG = 1ULL << 31;
+const ULONGLONG C_X64_CR4_PAE = 1ULL << 5;
+const ULONGLONG C_X64_CR4_LA57 = 1ULL << 12;
+
+//  x64 page table entry fields
+const ULONGLONG C_X64_PTE_PRESENT = 1ULL;
+const ULONGLONG C_X64_PTE_LARGE_PAGE = 1ULL << 7;
+const ULONGLONG C_X64_PTE_ADDRESS_MASK = 0x000ffffffffff000ULL;
+const unsigned C_X64_PAGE_SHIFT = 12;
+const unsigned C_X64_BITS_PER_LEVEL = 9;
+
+//  ARM64 SCTLR_EL1/TCR_EL1 fields
+const ULONGLONG C_ARM64_SCTLR_M = 1ULL;
+const ULONGLONG C_ARM64_TCR_EPD0 = 1ULL << 7;
+const ULONGLONG C_ARM64_TCR_EPD1 = 1ULL << 23;
+
+//  ARM64 translation table descriptor fields
+const ULONGLONG C_ARM64_DESC_VALID = 1ULL;
+const ULONGLONG C_ARM64_DESC_TABLE = 1ULL << 1;
+const ULONGLONG C_ARM64_DESC_ADDRESS_MASK = 0x0000fffffffff000ULL;
+const ULONGLONG C_ARM64_TTBR_ADDRESS_MASK = 0x0000fffffffffffeULL;
+const unsigned C_ARM64_4KB_GRANULE_SHIFT = 12;
+const unsigned C_ARM64_64KB_GRANULE_SHIFT = 16;
+
+//=============================================================================
+// Public function definitions
+//=============================================================================
+PageTableWalker::PageTableWalker(_In_ const ReadPageTableEntryFunction & readEntryFunction) :
+    m_readEntryFunction(readEntryFunction)
+{
+    assert(m_readEntryFunction != nullptr);
+}
+
+//
+//  TranslateVirtualAddress     Translates a virtual address to a physical address.
+//
+//  Parameters:
+//  pagingRegisters             Translation registers of the processor accessing the memory.
+//  virtualAddress              Virtual address to translate.
+//  pPhysicalAddress            Pointer to the returned physical address.
+//  pBytesToPageEnd             Pointer to the number of bytes left in the translated page.
+//
+//  Return:
+//  true                        if the address is mapped.
+//  false                       if the address is not mapped, or the paging mode is not supported.
+//
+//  Note.
+//  A cached translation does not require reading the target memory.
+//  The function throws an exception if a page table entry cannot be read.
+//
+bool PageTableWalker::TranslateVirtualAddress(_In_ const PagingRegisters & pagingRegisters, _In_ AddressType virtualAddress,
+                                              _Out_ AddressType * pPhysicalAddress, _Out_ size_t * pBytesToPageEnd)
+{
+    assert(pPhysicalAddress != nullptr && pBytesToPageEnd != nullptr);
+
+    //  Translation disabled, the virtual addresses are physical addresses.
+    //  The translation control register is not used, so its granule bits may not be valid.
+    if ((pagingRegisters.arch == AMD64_ARCH && (pagingRegisters.systemControl & C_X64_CR0_PG) == 0) ||
+        (pagingRegisters.arch == ARM64_ARCH && (pagingRegisters.systemControl & C_ARM64_SCTLR_M) == 0))
+    {
+        const AddressType trackingPageSize = 1ULL << C_PAGE_TABLE_TRACKING_SHIFT;
+        *pBytesToPageEnd = static_cast<size_t>(trackingPageSize - (virtualAddress & (trackingPageSize - 1)));
+        *pPhysicalAddress = virtualAddress;
+        return true;
+    }
+
+    //  A non canonical x64 address raises a fault on the target, so it's never mapped.
+    if (pagingRegisters.arch == AMD64_ARCH && !IsX64CanonicalAddress(pagingRegisters, virtualAddress))
+    {
+        return false;
+    }
+
+    unsigned granuleShift = GetTranslationGranuleShift(pagingRegisters, virtualAddress);
+    if (granuleShift == 0)
+    {
+        return false;
+    }
+
+    const AddressType pageOffsetMask = (1ULL << granuleShift) - 1;
+    const AddressType pageOffset = virtualAddress & pageOffsetMask;
+    *pBytesToPageEnd = static_cast<size_t>((1ULL << granuleShift) - pageOffset);
+
+    TranslationKey key(GetTranslationTableBase(pagingRegisters, virtualAddress), virtualAddress >> granuleShift);
+    auto it = m_translations.find(key);
+    if (it != m_translations.end())
+    {
+        *pPhysicalAddress = it->second + pageOffset;
+        return true;
+    }
+
+    AddressType physicalAddress = 0;
+    bool isMapped = (pagingRegisters.arch == AMD64_ARCH) ?
+                    WalkX64PageTables(pagingRegisters, virtualAddress, &physicalAddress) :
+                    WalkArm64PageTables(pagingRegisters, virtualAddress, granuleShift, &physicalAddress);
+    if (!isMapped)
+    {
+        return false;
+    }
+
+    if (m_translations.size() >= C_MAX_CACHED_TRANSLATIONS)
+    {
+        m_translations.clear();
+    }
+    m_translations[key] = physicalAddress & ~pageOffsetMask;
+    *pPhysicalAddress = physicalAddress;
+    return true;
+}
+
+//
+//  IsPageTableMemory   Checks if a physical memory range contains page table entries used by the cached translations.
+//
+//  Parameters:
+//  physicalAddress     Start of the physical memory range.
+//  size                Size of the range.
+//
+//  Return:
+//  true                if the range overlaps a page that contains a walked table entry.
+//  false               otherwise.
+//
+bool PageTableWalker::IsPageTableMemory(_In_ AddressType physicalAddress, _In_ size_t size) const
+{
+    if (m_pageTablePages.empty() || size == 0)
+    {
+        return false;
+    }
+
+    AddressType firstPage = physicalAddress >> C_PAGE_TABLE_TRACKING_SHIFT;
+    AddressType lastPage = (physicalAddress + size - 1) >> C_PAGE_TABLE_TRACKING_SHIFT;
+    auto it = m_pageTablePages.lower_bound(firstPage);
+    return it != m_pageTablePages.end() && *it <= lastPage;
+}
+
+//
+//  FlushTranslations   Discards all the cached translations.
+//
+void PageTableWalker::FlushTranslations()
+{
+    m_translations.clear();
+    m_pageTablePages.clear();
+}
+
+//=============================================================================
+// Private function definitions
+//=============================================================================
+//
+//  WalkX64PageTables   Walks the x64 4 or 5 level page tables (the LA57 mode is set in CR4).
+//
+//  Parameters:
+//  pagingRegisters     Translation registers.
+//  virtualAddress      Virtual address to translate.
+//  pPhysicalAddress    Pointer to the returned physical address.
+//
+//  Return:
+//  true                if the address is mapped.
+//  false               otherwise.
+//
+bool PageTableWalker::WalkX64PageTables(_In_ const PagingRegisters & pagingRegisters, _In_ AddressType virtualAddress,
+                                        _Out_ AddressType * pPhysicalAddress)
+{
+    assert(pPhysicalAddress != nullptr);
+
+    //  The 32 bits (non-PAE) paging mode is not supported.
+    if ((pagingRegisters.translationControl & C_X64_CR4_PAE) == 0)
+    {
+        return false;
+    }
+
+    unsigned numberOfLevels = ((pagingRegisters.translationControl & C_X64_CR4_LA57) != 0) ? 5 : 4;
+    AddressType tableAddress = pagingRegisters.translationBase0 & C_X64_PTE_ADDRESS_MASK;
+    for (unsigned level = numberOfLevels; level > 0; --level)
+    {
+        unsigned shift = C_X64_PAGE_SHIFT + (C_X64_BITS_PER_LEVEL * (level - 1));
+        AddressType index = (virtualAddress >> shift) & ((1ULL << C_X64_BITS_PER_LEVEL) - 1);
+        ULONGLONG entry = ReadTableEntry(tableAddress + (index * sizeof(ULONGLONG)));
+        if ((entry & C_X64_PTE_PRESENT) == 0)
+        {
+            return false;
+        }
+
+        //  The PDPT (1GB) and PD (2MB) entries can map a large page.
+        bool isLargePage = (level == 2 || level == 3) && (entry & C_X64_PTE_LARGE_PAGE) != 0;
+        if (level == 1 || isLargePage)
+        {
+            AddressType pageOffsetMask = (1ULL << shift) - 1;
+            *pPhysicalAddress = (entry & C_X64_PTE_ADDRESS_MASK & ~pageOffsetMask) | (virtualAddress & pageOffsetMask);
+            return true;
+        }
+        tableAddress = entry & C_X64_PTE_ADDRESS_MASK;
+    }
+    return false;
+}
+
+//
+//  WalkArm64PageTables     Walks the ARM64 translation tables (stage 1, EL1&0 regime).
+//
+//  Parameters:
+//  pagingRegisters         Translation registers.
+//  virtualAddress          Virtual address to translate.
+//  granuleShift            Translation granule shift (4KB or 64KB granule).
+//  pPhysicalAddress        Pointer to the returned physical address.
+//
+//  Return:
+//  true                    if the address is mapped.
+//  false                   otherwise.
+//
+bool PageTableWalker::WalkArm64PageTables(_In_ const PagingRegisters & pagingRegisters, _In_ AddressType virtualAddress,
+                                          _In_ unsigned granuleShift, _Out_ AddressType * pPhysicalAddress)
+{
+    assert(pPhysicalAddress != nullptr);
+
+    const bool isUpperRange = ((virtualAddress >> 55) & 1) != 0;
+    const ULONGLONG tcr = pagingRegisters.translationControl;
+    if ((isUpperRange && (tcr & C_ARM64_TCR_EPD1) != 0) || (!isUpperRange && (tcr & C_ARM64_TCR_EPD0) != 0))
+    {
+        return false;
+    }
+
+    const unsigned sizeOffset = static_cast<unsigned>(isUpperRange ? ((tcr >> 16) & 0x3f) : (tcr & 0x3f));
+    const unsigned inputBits = 64 - sizeOffset;
+    if (inputBits <= granuleShift || inputBits > 52)
+    {
+        return false;
+    }
+
+    //  The bits above the input address size have to be all ones (upper range) or all zeros (lower range).
+    const AddressType topBits = virtualAddress >> inputBits;
+    if ((isUpperRange && topBits != ((~0ULL) >> inputBits)) || (!isUpperRange && topBits != 0))
+    {
+        return false;
+    }
+
+    const unsigned bitsPerLevel = granuleShift - 3;
+    const unsigned numberOfLevels = (inputBits - granuleShift + bitsPerLevel - 1) / bitsPerLevel;
+    AddressType tableAddress = GetTranslationTableBase(pagingRegisters, virtualAddress) & C_ARM64_TTBR_ADDRESS_MASK;
+    for (unsigned level = 0; level < numberOfLevels; ++level)
+    {
+        const unsigned shift = granuleShift + (bitsPerLevel * (numberOfLevels - 1 - level));
+        //  The first level table resolves the remaining input address bits.
+        const unsigned indexBits = (level == 0) ? (inputBits - shift) : bitsPerLevel;
+        AddressType index = (virtualAddress >> shift) & ((1ULL << indexBits) - 1);
+        ULONGLONG descriptor = ReadTableEntry(tableAddress + (index * sizeof(ULONGLONG)));
+        if ((descriptor & C_ARM64_DESC_VALID) == 0)
+        {
+            return false;
+        }
+
+        const bool isLastLevel = (level == numberOfLevels - 1);
+        const bool isTable = (descriptor & C_ARM64_DESC_TABLE) != 0;
+        if (isLastLevel && !isTable)
+        {
+            //  Reserved descriptor type at the last level
+            return false;
+        }
+
+        //  A page descriptor (last level) or a block descriptor.
+        if (isLastLevel || !isTable)
+        {
+            AddressType pageOffsetMask = (1ULL << shift) - 1;
+            *pPhysicalAddress = (descriptor & C_ARM64_DESC_ADDRESS_MASK & ~pageOffsetMask) | (virtualAddress & pageOffsetMask);
+            return true;
+        }
+        tableAddress = descriptor & C_ARM64_DESC_ADDRESS_MASK & ~((1ULL << granuleShift) - 1);
+    }
+    return false;
+}
+
+//
+//  IsX64CanonicalAddress   Checks if an x64 virtual address is canonical.
+//
+//  Parameters:
+//  pagingRegisters         Translation registers.
+//  virtualAddress          Virtual address to check.
+//
+//  Return:
+//  true                    if the bits above the linear address size (48 bits, or 57 bits in LA57 mode)
+//                          are a sign extension of the most significant address bit.
+//  false                   otherwise.
+//
+bool PageTableWalker::IsX64CanonicalAddress(_In_ const PagingRegisters & pagingRegisters, _In_ AddressType virtualAddress)
+{
+    const unsigned addressBits = ((pagingRegisters.translationControl & C_X64_CR4_LA57) != 0) ? 57 : 48;
+    const AddressType topBits = virtualAddress >> (addressBits - 1);
+    return topBits == 0 || topBits == ((~0ULL) >> (addressBits - 1));
+}
+
+//
+//  GetTranslationGranuleShift  Gets the translation granule used by the virtual address.
+//
+//  Parameters:
+//  pagingRegisters             Translation registers.
+//  virtualAddress              Virtual address to translate.
+//
+//  Return:
+//  The granule shift, or 0 if the architecture/granule is not supported.
+//
+unsigned PageTableWalker::GetTranslationGranuleShift(_In_ const PagingRegisters & pagingRegisters, _In_ AddressType virtualAddress)
+{
+    if (pagingRegisters.arch == AMD64_ARCH)
+    {
+        return C_X64_PAGE_SHIFT;
+    }
+
+    if (pagingRegisters.arch == ARM64_ARCH)
+    {
+        //  TG0 and TG1 encode the granule size differently.
+        if (((virtualAddress >> 55) & 1) != 0)
+        {
+            ULONGLONG tg1 = (pagingRegisters.translationControl >> 30) & 0x3;
+            return (tg1 == 2) ? C_ARM64_4KB_GRANULE_SHIFT : ((tg1 == 3) ? C_ARM64_64KB_GRANULE_SHIFT : 0);
+        }
+        ULONGLONG tg0 = (pagingRegisters.translationControl >> 14) & 0x3;
+        return (tg0 == 0) ? C_ARM64_4KB_GRANULE_SHIFT : ((tg0 == 1) ? C_ARM64_64KB_GRANULE_SHIFT : 0);
+    }
+    return 0;
+}
+
+//
+//  GetTranslationTableBase     Gets the translation table base register used by the virtual address.
+//
+ULONGLONG PageTableWalker::GetTranslationTableBase(_In_ const PagingRegisters & pagingRegisters, _In_ AddressType virtualAddress)
+{
+    if (pagingRegisters.arch == ARM64_ARCH && ((virtualAddress >> 55) & 1) != 0)
+    {
+        return pagingRegisters.translationBase1;
+    }
+    return pagingRegisters.translationBase0;
+}
+
+//
+//  ReadTableEntry  Reads a table entry and tracks the page containing it.
+//
+ULONGLONG PageTableWalker::ReadTableEntry(_In_ AddressType entryAddress)
+{
+    ULONGLONG entry = m_readEntryFunction(entryAddress);
+    m_pageTablePages.insert(entryAddress >> C_PAGE_TABLE_TRACKING_SHIFT);
+    return entry;
+}
@@ -0,0 +1,72 @@
+//----------------------------------------------------------------------------
+//
+// PageTableWalker.h
+//
+// Host-side virtual to physical address translation for GDB server targets
+// that can only access memory by physical address.
+//
+// Copyright (c) Microsoft. All rights reserved.
+//----------------------------------------------------------------------------
+
+#pragma once
+#include "stdafx.h"
+#include <functional>
+#include <map>
+#include <set>
+#include "GdbSrvControllerLib.h"
+
+namespace GdbSrvControllerLib
+{
+    //  This type contains the processor registers that control the address translation.
+    //  x64:    systemControl = CR0, translationControl = CR4, translationBase0 = CR3.
+    //  ARM64:  systemControl = SCTLR_EL1, translationControl = TCR_EL1,
+    //          translationBase0 = TTBR0_EL1, translationBase1 = TTBR1_EL1.
+    typedef struct
+    {
+        TargetArchitecture arch;            //  Target architecture.
+        ULONGLONG systemControl;            //  Register containing the translation enable bit.
+        ULONGLONG translationControl;       //  Register containing the paging mode and granule fields.
+        ULONGLONG translationBase0;         //  Translation table base (lower VA range for ARM64).
+        ULONGLONG translationBase1;         //  Translation table base for the upper VA range (ARM64 only).
+    } PagingRegisters;
+
+    //  Function used for reading a 64 bits page table entry by physical address.
+    //  It throws an exception if the entry cannot be read.
+    typedef std::function<ULONGLONG (_In_ AddressType physicalAddress)> ReadPageTableEntryFunction;
+
+    //  This class walks the target page tables (x64 4/5 levels, ARM64 4KB/64KB granule)
+    //  by reading the table entries through the physical memory path.
+    //  The translated pages are kept in a TLB like cache keyed by the translation
+    //  table base and the virtual page, so repeated accesses to the same page do not
+    //  walk the tables again. The cache has to be flushed when the target resumes.
+    class PageTableWalker final
+    {
+    public:
+        explicit PageTableWalker(_In_ const ReadPageTableEntryFunction & readEntryFunction);
+
+        bool TranslateVirtualAddress(_In_ const PagingRegisters & pagingRegisters, _In_ AddressType virtualAddress,
+                                     _Out_ AddressType * pPhysicalAddress, _Out_ size_t * pBytesToPageEnd);
+        bool IsPageTableMemory(_In_ AddressType physicalAddress, _In_ size_t size) const;
+        void FlushTranslations();
+
+    private:
+        PageTableWalker(_In_ const PageTableWalker &);
+        void operator=(_In_ const PageTableWalker &);
+
+        bool WalkX64PageTables(_In_ const PagingRegisters & pagingRegisters, _In_ AddressType virtualAddress,
+                               _Out_ AddressType * pPhysicalAddress);
+        bool WalkArm64PageTables(_In_ const PagingRegisters & pagingRegisters, _In_ AddressType virtualAddress,
+                                 _In_ unsigned granuleShift, _Out_ AddressType * pPhysicalAddress);
+        static bool IsX64CanonicalAddress(_In_ const PagingRegisters & pagingRegisters, _In_ AddressType virtualAddress);
+        static unsigned GetTranslationGranuleShift(_In_ const PagingRegisters & pagingRegisters, _In_ AddressType virtualAddress);
+        static ULONGLONG GetTranslationTableBase(_In_ const PagingRegisters & pagingRegisters, _In_ AddressType virtualAddress);
+        ULONGLONG ReadTableEntry(_In_ AddressType entryAddress);
+
+        //  Translation cache key: translation table base and virtual page number.
+        typedef std::pair<ULONGLONG, AddressType> TranslationKey;
+
+        ReadPageTableEntryFunction m_readEntryFunction;
+        std::map<TranslationKey, AddressType> m_translations;
+        std::set<AddressType> m_pageTablePages;
+    };
+}
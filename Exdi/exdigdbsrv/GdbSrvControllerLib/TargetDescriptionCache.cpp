@@ -0,0 +1,445 @@
+//----------------------------------------------------------------------------
+//
+// TargetDescriptionCache.cpp
+//
+// Cache for the register layout compiled from the GDB server target
+// description xml files (qXfer:features:read).
+//
+// Copyright (c) Microsoft. All rights reserved.
+//----------------------------------------------------------------------------
+
+#include "stdafx.h"
+#include <new>
+#include <fstream>
+#include <comdef.h>
+#include "TargetDescriptionCache.h"
+
+using namespace GdbSrvControllerLib;
+using namespace std;
+
+//=============================================================================
+// Private data definitions
+//=============================================================================
+//  Binary cache file signature ('TDLC') and format version.
+//  Please increment the version number if the layout file format changes.
+const DWORD C_TARGET_LAYOUT_FILE_SIGNATURE = 0x434c4454;
+const DWORD C_TARGET_LAYOUT_FILE_VERSION = 1;
+
+//  Limits used for validating the cache file content
+const DWORD C_MAX_LAYOUT_STRING_LENGTH = 0x10000;
+const DWORD C_MAX_LAYOUT_ELEMENTS = 0x100000;
+
+//  Name of the cache folder created under the user temporary folder
+LPCWSTR const g_TargetLayoutCacheFolder = L"ExdiGdbSrvTargetCache";
+
+//  FNV-1a 64 bits hash constants
+const ULONGLONG C_FNV_OFFSET_BASIS = 0xcbf29ce484222325ULL;
+const ULONGLONG C_FNV_PRIME = 0x100000001b3ULL;
+
+//=============================================================================
+// Private function definitions
+//=============================================================================
+//
+//  HashBytes   Calculates the FNV-1a hash of the passed in buffer.
+//
+//  Parameters:
+//  hash        Initial hash value.
+//  pBuffer     Pointer to the buffer to hash.
+//  length      Buffer length in bytes.
+//
+//  Return:
+//  The calculated hash.
+//
+static ULONGLONG HashBytes(_In_ ULONGLONG hash, _In_reads_bytes_(length) const void * pBuffer, _In_ size_t length)
+{
+    const unsigned char * pBytes = reinterpret_cast<const unsigned char *>(pBuffer);
+    for (size_t index = 0; index < length; ++index)
+    {
+        hash ^= pBytes[index];
+        hash *= C_FNV_PRIME;
+    }
+    return hash;
+}
+
+template <typename T>
+static inline void WriteValue(_Inout_ ofstream & stream, _In_ const T & value)
+{
+    stream.write(reinterpret_cast<const char *>(&value), sizeof(value));
+}
+
+template <typename T>
+static inline bool ReadValue(_Inout_ ifstream & stream, _Out_ T & value)
+{
+    stream.read(reinterpret_cast<char *>(&value), sizeof(value));
+    return stream.good();
+}
+
+template <typename TString>
+static void WriteString(_Inout_ ofstream & stream, _In_ const TString & value)
+{
+    DWORD length = static_cast<DWORD>(value.length());
+    WriteValue(stream, length);
+    stream.write(reinterpret_cast<const char *>(value.c_str()), length * sizeof(value[0]));
+}
+
+template <typename TString>
+static bool ReadString(_Inout_ ifstream & stream, _Out_ TString & value)
+{
+    DWORD length = 0;
+    if (!ReadValue(stream, length) || length > C_MAX_LAYOUT_STRING_LENGTH)
+    {
+        return false;
+    }
+    value.resize(length);
+    if (length != 0)
+    {
+        stream.read(reinterpret_cast<char *>(&value[0]), length * sizeof(value[0]));
+    }
+    return stream.good();
+}
+
+static void WriteRegisterVector(_Inout_ ofstream & stream, _In_ const vector<RegistersStruct> & registers)
+{
+    WriteValue(stream, static_cast<DWORD>(registers.size()));
+    for (auto const & reg : registers)
+    {
+        WriteString(stream, reg.name);
+        WriteString(stream, reg.nameOrder);
+        WriteValue(stream, static_cast<ULONGLONG>(reg.registerSize));
+        WriteString(stream, reg.group);
+    }
+}
+
+static bool ReadRegisterVector(_Inout_ ifstream & stream, _Out_ vector<RegistersStruct> & registers)
+{
+    DWORD numberOfElements = 0;
+    if (!ReadValue(stream, numberOfElements) || numberOfElements > C_MAX_LAYOUT_ELEMENTS)
+    {
+        return false;
+    }
+    registers.resize(numberOfElements);
+    for (auto & reg : registers)
+    {
+        ULONGLONG registerSize = 0;
+        if (!ReadString(stream, reg.name) || !ReadString(stream, reg.nameOrder) ||
+            !ReadValue(stream, registerSize) || !ReadString(stream, reg.group))
+        {
+            return false;
+        }
+        reg.registerSize = static_cast<size_t>(registerSize);
+    }
+    return true;
+}
+
+//=============================================================================
+// Public function definitions
+//=============================================================================
+TargetDescriptionCache::TargetDescriptionCache()
+{
+    InitializeCriticalSection(&m_cacheLock);
+}
+
+TargetDescriptionCache::~TargetDescriptionCache()
+{
+    DeleteCriticalSection(&m_cacheLock);
+}
+
+TargetDescriptionCache & TargetDescriptionCache::GetInstance()
+{
+    //  The initialization of a function-local static object is thread safe and
+    //  the object is destroyed when the module unloads.
+    static TargetDescriptionCache instance;
+    return instance;
+}
+
+//
+//  ComputeContentHash  Calculates the hash used as the cache key of a target description file.
+//
+//  Parameters:
+//  content             Reference to the xml file content sent by the GDB server.
+//
+//  Return:
+//  The content hash.
+//
+ULONGLONG TargetDescriptionCache::ComputeContentHash(_In_ const string & content)
+{
+    return HashBytes(C_FNV_OFFSET_BASIS, content.c_str(), content.length());
+}
+
+//
+//  ComputeFileContentHash  Calculates the content hash of a local file.
+//
+//  Parameters:
+//  pFileName               Pointer to the full path file name.
+//
+//  Return:
+//  The content hash, or 0 if the file name is not set or the file cannot be read.
+//
+ULONGLONG TargetDescriptionCache::ComputeFileContentHash(_In_opt_z_ PCWSTR pFileName)
+{
+    if (pFileName == nullptr)
+    {
+        return 0;
+    }
+
+    ifstream fileStream(pFileName, ios::in | ios::binary);
+    if (!fileStream.is_open())
+    {
+        return 0;
+    }
+
+    ULONGLONG hash = C_FNV_OFFSET_BASIS;
+    char buffer[4096];
+    while (fileStream.read(buffer, sizeof(buffer)) || fileStream.gcount() != 0)
+    {
+        hash = HashBytes(hash, buffer, static_cast<size_t>(fileStream.gcount()));
+    }
+    return hash;
+}
+
+//
+//  ComputeLayoutKey    Calculates the cache key of a layout compiled from a target description
+//                      file. The compiled layout depends also on the local exdiConfigData.xml
+//                      configuration (target architecture and core register set), so the key
+//                      covers both.
+//
+//  Parameters:
+//  contentHash         Hash of the target description file content.
+//  targetArchitecture  The target architecture set by the configuration file.
+//  pCoreRegisters      Pointer to the core register set read from the configuration file.
+//
+//  Return:
+//  The layout cache key.
+//
+ULONGLONG TargetDescriptionCache::ComputeLayoutKey(_In_ ULONGLONG contentHash,
+                                                   _In_ TargetArchitecture targetArchitecture,
+                                                   _In_opt_ const vector<RegistersStruct> * pCoreRegisters)
+{
+    ULONGLONG key = HashBytes(C_FNV_OFFSET_BASIS, &contentHash, sizeof(contentHash));
+    key = HashBytes(key, &targetArchitecture, sizeof(targetArchitecture));
+    if (pCoreRegisters != nullptr)
+    {
+        for (auto const & reg : *pCoreRegisters)
+        {
+            const ULONGLONG registerSize = static_cast<ULONGLONG>(reg.registerSize);
+            key = HashBytes(key, reg.name.c_str(), reg.name.length() + 1);
+            key = HashBytes(key, reg.nameOrder.c_str(), reg.nameOrder.length() + 1);
+            key = HashBytes(key, &registerSize, sizeof(registerSize));
+            key = HashBytes(key, reg.group.c_str(), reg.group.length() + 1);
+        }
+    }
+    return key;
+}
+
+//
+//  FindLayout      Looks for a compiled layout in the memory cache, and
+//                  then in the layout cache file.
+//
+//  Parameters:
+//  contentHash     Hash of the target description file content.
+//  layout          Reference to the output layout.
+//
+//  Return:
+//  true            If a layout was found for the passed in hash.
+//  false           Otherwise.
+//
+bool TargetDescriptionCache::FindLayout(_In_ ULONGLONG contentHash, _Out_ TargetDescriptionLayout & layout)
+{
+    scoped_lock cacheGuard(m_cacheLock);
+
+    auto it = m_layoutMap.find(contentHash);
+    if (it != m_layoutMap.end())
+    {
+        layout = *it->second;
+        return true;
+    }
+
+    wstring fileName;
+    if (!GetCacheFileName(contentHash, fileName))
+    {
+        return false;
+    }
+
+    unique_ptr<TargetDescriptionLayout> spLayout(new (nothrow) TargetDescriptionLayout());
+    if (spLayout == nullptr || !ReadLayoutFile(fileName, *spLayout))
+    {
+        return false;
+    }
+    layout = *spLayout;
+    m_layoutMap[contentHash] = move(spLayout);
+    return true;
+}
+
+//
+//  StoreLayout     Stores the compiled layout in the memory cache and in the layout cache file.
+//                  Failing to write the cache file is not an error, the layout will
+//                  be compiled again on the next session.
+//
+//  Parameters:
+//  contentHash     Hash of the target description file content.
+//  layout          Reference to the layout to store.
+//
+//  Return:
+//  Nothing.
+//
+void TargetDescriptionCache::StoreLayout(_In_ ULONGLONG contentHash, _In_ const TargetDescriptionLayout & layout)
+{
+    scoped_lock cacheGuard(m_cacheLock);
+
+    unique_ptr<TargetDescriptionLayout> spLayout(new (nothrow) TargetDescriptionLayout(layout));
+    if (spLayout == nullptr)
+    {
+        return;
+    }
+    m_layoutMap[contentHash] = move(spLayout);
+
+    wstring fileName;
+    if (GetCacheFileName(contentHash, fileName))
+    {
+        WriteLayoutFile(fileName, layout);
+    }
+}
+
+//
+//  GetCacheFileName    Builds the layout cache file name (%TEMP%\ExdiGdbSrvTargetCache\<hash>.bin)
+//                      It creates the cache folder if it does not exist.
+//
+bool TargetDescriptionCache::GetCacheFileName(_In_ ULONGLONG contentHash, _Out_ wstring & fileName)
+{
+    WCHAR tempPath[MAX_PATH + 1] = {0};
+    DWORD length = GetTempPathW(ARRAYSIZE(tempPath), tempPath);
+    if (length == 0 || length > ARRAYSIZE(tempPath))
+    {
+        return false;
+    }
+
+    fileName = tempPath;
+    fileName += g_TargetLayoutCacheFolder;
+    if (!CreateDirectoryW(fileName.c_str(), nullptr) && GetLastError() != ERROR_ALREADY_EXISTS)
+    {
+        return false;
+    }
+
+    WCHAR hashName[32] = {0};
+    swprintf_s(hashName, ARRAYSIZE(hashName), L"\\%016I64x.bin", contentHash);
+    fileName += hashName;
+    return true;
+}
+
+bool TargetDescriptionCache::ReadLayoutFile(_In_ const wstring & fileName, _Out_ TargetDescriptionLayout & layout)
+{
+    ifstream fileStream(fileName.c_str(), ios::in | ios::binary);
+    if (!fileStream.is_open())
+    {
+        return false;
+    }
+
+    DWORD signature = 0;
+    DWORD version = 0;
+    if (!ReadValue(fileStream, signature) || signature != C_TARGET_LAYOUT_FILE_SIGNATURE ||
+        !ReadValue(fileStream, version) || version != C_TARGET_LAYOUT_FILE_VERSION)
+    {
+        return false;
+    }
+
+    DWORD architecture = 0;
+    BYTE flag = 0;
+    if (!ReadValue(fileStream, architecture) || architecture > ARM64_ARCH)
+    {
+        return false;
+    }
+    layout.registerGroupArchitecture = static_cast<TargetArchitecture>(architecture);
+
+    if (!ReadValue(fileStream, flag) ||
+        !ReadString(fileStream, layout.systemRegFileName) ||
+        !ReadValue(fileStream, layout.systemRegFileHash) ||
+        !ReadValue(fileStream, layout.systemRegMapFileHash))
+    {
+        return false;
+    }
+    layout.fCoreRegistersFromTarget = (flag != 0);
+    if (!ReadRegisterVector(fileStream, layout.coreRegisters))
+    {
+        return false;
+    }
+
+    if (!ReadValue(fileStream, flag) || !ReadRegisterVector(fileStream, layout.systemRegisters))
+    {
+        return false;
+    }
+    layout.fSystemRegistersAvailable = (flag != 0);
+
+    DWORD numberOfElements = 0;
+    if (!ReadValue(fileStream, flag) || !ReadValue(fileStream, numberOfElements) ||
+        numberOfElements > C_MAX_LAYOUT_ELEMENTS)
+    {
+        return false;
+    }
+    layout.fSystemRegMapAvailable = (flag != 0);
+    layout.systemRegAccessCodeMap.clear();
+    for (DWORD index = 0; index < numberOfElements; ++index)
+    {
+        AddressType accessCode = 0;
+        SystemPairRegOrderNameType orderName;
+        if (!ReadValue(fileStream, accessCode) ||
+            !ReadString(fileStream, orderName.first) ||
+            !ReadString(fileStream, orderName.second))
+        {
+            return false;
+        }
+        layout.systemRegAccessCodeMap.emplace(accessCode, orderName);
+    }
+
+    //  The trailing signature validates that the file was completely written.
+    return (ReadValue(fileStream, signature) && signature == C_TARGET_LAYOUT_FILE_SIGNATURE);
+}
+
+bool TargetDescriptionCache::WriteLayoutFile(_In_ const wstring & fileName, _In_ const TargetDescriptionLayout & layout)
+{
+    //  Write a process private file first and then replace the cache file,
+    //  so concurrent debugger sessions never read a partially written file.
+    WCHAR processId[32] = {0};
+    swprintf_s(processId, ARRAYSIZE(processId), L".%u.tmp", GetCurrentProcessId());
+    wstring tempFileName = fileName + processId;
+
+    {
+        ofstream fileStream(tempFileName.c_str(), ios::out | ios::binary | ios::trunc);
+        if (!fileStream.is_open())
+        {
+            return false;
+        }
+
+        WriteValue(fileStream, C_TARGET_LAYOUT_FILE_SIGNATURE);
+        WriteValue(fileStream, C_TARGET_LAYOUT_FILE_VERSION);
+        WriteValue(fileStream, static_cast<DWORD>(layout.registerGroupArchitecture));
+        WriteValue(fileStream, static_cast<BYTE>(layout.fCoreRegistersFromTarget));
+        WriteString(fileStream, layout.systemRegFileName);
+        WriteValue(fileStream, layout.systemRegFileHash);
+        WriteValue(fileStream, layout.systemRegMapFileHash);
+        WriteRegisterVector(fileStream, layout.coreRegisters);
+        WriteValue(fileStream, static_cast<BYTE>(layout.fSystemRegistersAvailable));
+        WriteRegisterVector(fileStream, layout.systemRegisters);
+        WriteValue(fileStream, static_cast<BYTE>(layout.fSystemRegMapAvailable));
+        WriteValue(fileStream, static_cast<DWORD>(layout.systemRegAccessCodeMap.size()));
+        for (auto const & entry : layout.systemRegAccessCodeMap)
+        {
+            WriteValue(fileStream, entry.first);
+            WriteString(fileStream, entry.second.first);
+            WriteString(fileStream, entry.second.second);
+        }
+        WriteValue(fileStream, C_TARGET_LAYOUT_FILE_SIGNATURE);
+        if (!fileStream.good())
+        {
+            fileStream.close();
+            DeleteFileW(tempFileName.c_str());
+            return false;
+        }
+    }
+
+    if (!MoveFileExW(tempFileName.c_str(), fileName.c_str(), MOVEFILE_REPLACE_EXISTING))
+    {
+        DeleteFileW(tempFileName.c_str());
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,69 @@
+//----------------------------------------------------------------------------
+//
+// TargetDescriptionCache.h
+//
+// Cache for the register layout compiled from the GDB server target
+// description xml files (qXfer:features:read).
+//
+// Copyright (c) Microsoft. All rights reserved.
+//----------------------------------------------------------------------------
+
+#pragma once
+#include "stdafx.h"
+#include <string>
+#include <memory>
+#include <vector>
+#include <map>
+#include "HandleHelpers.h"
+#include "GdbSrvControllerLib.h"
+
+namespace GdbSrvControllerLib
+{
+    //  This type indicates the register layout obtained after processing
+    //  the target description files sent by the GDB server.
+    typedef struct
+    {
+        TargetArchitecture registerGroupArchitecture;   //  Architecture reported by the target description file.
+        bool fCoreRegistersFromTarget;                  //  Flag set if the core register set was replaced by the target file.
+        std::wstring systemRegFileName;                 //  Name of the system register group file (empty if not present).
+        ULONGLONG systemRegFileHash;                    //  Content hash of the system register group file.
+        ULONGLONG systemRegMapFileHash;                 //  Content hash of the local system register mapping file.
+        std::vector<RegistersStruct> coreRegisters;     //  Core registers (valid only if fCoreRegistersFromTarget is set).
+        bool fSystemRegistersAvailable;                 //  Flag set if the systemRegisters vector is valid.
+        std::vector<RegistersStruct> systemRegisters;   //  System registers
+        bool fSystemRegMapAvailable;                    //  Flag set if the systemRegAccessCodeMap is valid.
+        SystemRegistersMapType systemRegAccessCodeMap;  //  Map of system register access codes.
+    } TargetDescriptionLayout;
+
+    //  This class keeps the compiled target description layout in memory and
+    //  in a binary file, so later connections to a GDB server that sends the same
+    //  target description files can skip the xml parsing phase.
+    //  The cache entry key is a hash of the target description file content and of the
+    //  local configuration the layout was compiled against.
+    class TargetDescriptionCache final
+    {
+    public:
+        static TargetDescriptionCache & GetInstance();
+        static ULONGLONG ComputeContentHash(_In_ const std::string & content);
+        static ULONGLONG ComputeFileContentHash(_In_opt_z_ PCWSTR pFileName);
+        static ULONGLONG ComputeLayoutKey(_In_ ULONGLONG contentHash,
+                                          _In_ TargetArchitecture targetArchitecture,
+                                          _In_opt_ const std::vector<RegistersStruct> * pCoreRegisters);
+
+        bool FindLayout(_In_ ULONGLONG contentHash, _Out_ TargetDescriptionLayout & layout);
+        void StoreLayout(_In_ ULONGLONG contentHash, _In_ const TargetDescriptionLayout & layout);
+
+    private:
+        TargetDescriptionCache();
+        ~TargetDescriptionCache();
+        TargetDescriptionCache(_In_ const TargetDescriptionCache &);
+        void operator=(_In_ const TargetDescriptionCache &);
+
+        bool GetCacheFileName(_In_ ULONGLONG contentHash, _Out_ std::wstring & fileName);
+        bool ReadLayoutFile(_In_ const std::wstring & fileName, _Out_ TargetDescriptionLayout & layout);
+        bool WriteLayoutFile(_In_ const std::wstring & fileName, _In_ const TargetDescriptionLayout & layout);
+
+        CRITICAL_SECTION m_cacheLock;
+        std::map<ULONGLONG, std::unique_ptr<TargetDescriptionLayout>> m_layoutMap;
+    };
+}
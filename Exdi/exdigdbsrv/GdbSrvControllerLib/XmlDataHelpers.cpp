@@ -102,6 +102,8 @@ typedef struct
     WCHAR fForcedLegacyResumeStepCommands[C_MAX_ATTR_LENGTH]; //  Flag if set, then use the legacy step/resume command mode.
     WCHAR fServerRequirePAMemoryAccess[C_MAX_ATTR_LENGTH]; //  if set the server requires PAs for all memory access R/W.
     WCHAR fGdbMonitorCmdDoNotWaitOnOK[C_MAX_ATTR_LENGTH]; //  if set the server requires PAs for all memory access R/W.
+    WCHAR fMemoryWriteCoalescing[C_MAX_ATTR_LENGTH];    //  if set the memory writes are buffered and merged until the target resumes.
+    WCHAR fHostPageTableWalk[C_MAX_ATTR_LENGTH];        //  if set the virtual addresses are translated by walking the target page tables.
 } ConfigExdiDataEntry;
 
 typedef struct
@@ -179,6 +181,8 @@ const WCHAR gdbQSupportedPacket[] = L"qSupportedPacket";
 const WCHAR gdbTreatSwBpAsHwBp[] = L"enableTreatingSwBpAsHwBp";
 const WCHAR gdbRequirePAMemoryAccess[] = L"requirePAMemoryAccess";
 const WCHAR gdbMonitorCmdDoNotWaitOnOK[] = L"gdbMonitorCmdDoNotWaitOnOK";
+const WCHAR enableMemoryWriteCoalescing[] = L"enableMemoryWriteCoalescing";
+const WCHAR enableHostPageTableWalk[] = L"enableHostPageTableWalk";
 const WCHAR gdbServerUuid[] = L"uuid";
 const WCHAR displayCommPackets[] = L"displayCommPackets";
 const WCHAR debuggerSessionByCore[] = L"debuggerSessionByCore";
@@ -260,6 +264,8 @@ const XML_ATTRNAME_HANDLER_STRUCT attrExdiServerHandlerMap[] =
     {exdiGdbServerConfigData, forceLegacyResumeStepCmds,  XmlDataHelpers::XmlGetStringValue, FIELD_OFFSET(ConfigExdiDataEntry, fForcedLegacyResumeStepCommands), C_MAX_ATTR_LENGTH},
     {exdiGdbServerConfigData, gdbRequirePAMemoryAccess,   XmlDataHelpers::XmlGetStringValue, FIELD_OFFSET(ConfigExdiDataEntry, fServerRequirePAMemoryAccess), C_MAX_ATTR_LENGTH},
     {exdiGdbServerConfigData, gdbMonitorCmdDoNotWaitOnOK, XmlDataHelpers::XmlGetStringValue, FIELD_OFFSET(ConfigExdiDataEntry, fGdbMonitorCmdDoNotWaitOnOK), C_MAX_ATTR_LENGTH},
+    {exdiGdbServerConfigData, enableMemoryWriteCoalescing, XmlDataHelpers::XmlGetStringValue, FIELD_OFFSET(ConfigExdiDataEntry, fMemoryWriteCoalescing), C_MAX_ATTR_LENGTH},
+    {exdiGdbServerConfigData, enableHostPageTableWalk,     XmlDataHelpers::XmlGetStringValue, FIELD_OFFSET(ConfigExdiDataEntry, fHostPageTableWalk), C_MAX_ATTR_LENGTH},
 };
 
 //  Attribute name - handler map for the GdbServer server tag info
@@ -447,6 +453,11 @@ inline bool XmlDataHelpers::IsExdiGdbTargetDataTag(_In_ PCWSTR pTagName)
     return isDone;
 }
 
+bool XmlDataHelpers::IsExdiGdbTargetTag(_In_ PCWSTR pTagName)
+{
+    return IsExdiGdbTargetDataTag(pTagName);
+}
+
 inline bool XmlDataHelpers::IsCurrentTarget(_In_ PCWSTR pTargetToSelect, _In_ PCWSTR pCurrentTarget)
 {
     assert(pTargetToSelect != nullptr && pCurrentTarget != nullptr);
@@ -710,9 +721,9 @@ HRESULT XmlDataHelpers::GetXmlTagAttributeValues(_In_ TAG_ATTR_LIST* const pTagA
                         PAttrList_NodeElem_Struct pElem = CONTAINING_RECORD(next, AttrList_NodeElem_Struct, token);
                         assert(pElem != nullptr);
 
-                        if (_wcsicmp(pMap->pLocalName, pElem->localName.c_str()) == 0)
+                        if (_wcsicmp(pMap->pLocalName, pElem->localName) == 0)
                         {
-                            bool isDone = pMap->pHandler(pElem->value.c_str(),
+                            bool isDone = pMap->pHandler(pElem->value,
                                 pMap->outStructFieldOffset,
                                 maxSizeOfOutStructData,
                                 pMap->structFieldNumberOfElements,
@@ -823,6 +834,8 @@ HRESULT XmlDataHelpers::HandleTagAttributeList(_In_ TAG_ATTR_LIST* const pTagAtt
                     pConfigTable->component.fForcedLegacyResumeStepCommands = (_wcsicmp(exdiData.fForcedLegacyResumeStepCommands, L"yes") == 0) ? true : false;
                     pConfigTable->component.fPAMemoryAccess = (_wcsicmp(exdiData.fServerRequirePAMemoryAccess, L"yes") == 0) ? true : false;
                     pConfigTable->component.fgdbMonitorCmdDoNotWaitOnOK = (_wcsicmp(exdiData.fGdbMonitorCmdDoNotWaitOnOK, L"yes") == 0) ? true : false;
+                    pConfigTable->component.fMemoryWriteCoalescing = (_wcsicmp(exdiData.fMemoryWriteCoalescing, L"yes") == 0) ? true : false;
+                    pConfigTable->component.fHostPageTableWalk = (_wcsicmp(exdiData.fHostPageTableWalk, L"yes") == 0) ? true : false;
                     isSet = true;
                 }
             }
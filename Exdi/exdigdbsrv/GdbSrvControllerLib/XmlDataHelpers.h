@@ -59,6 +59,8 @@ namespace GdbSrvControllerLib
         bool fForcedLegacyResumeStepCommands; //  Flag if set the GDB server will use the legacy resume/step command mode
         bool fPAMemoryAccess;           //  GDB server reuires memory access via PA
         bool fgdbMonitorCmdDoNotWaitOnOK; //  Flag if set then the GDB monitor response processing won't wait on the "OK" string
+        bool fMemoryWriteCoalescing;    //  Flag if set then the memory writes are merged and sent before the target resumes
+        bool fHostPageTableWalk;        //  Flag if set then the virtual addresses are translated by the host (requires PA memory access)
     } ConfigExdiData;
 
     //  This type indicates the Target data.
@@ -165,9 +167,10 @@ namespace GdbSrvControllerLib
     typedef struct
     {
         LIST_ENTRY  token;
-        //  Attribute pair localName="value"
-        std::wstring localName;
-        std::wstring value;
+        //  Attribute pair localName="value", both strings point into the text buffer
+        //  of the parser and they are valid until the list is cleared.
+        PCWSTR localName;
+        PCWSTR value;
     } AttrList_NodeElem_Struct, * PAttrList_NodeElem_Struct;
 
     //  List Tag-Attributes
@@ -197,6 +200,7 @@ namespace GdbSrvControllerLib
 
         static inline bool IsExdiGdbTargetsDataTag(_In_ PCWSTR pTagName);
         static inline bool IsExdiGdbTargetDataTag(_In_ PCWSTR pTagName);
+        static bool IsExdiGdbTargetTag(_In_ PCWSTR pTagName);
         static inline bool IsCurrentTarget(_In_ PCWSTR pTargetToSelect, _In_ PCWSTR pCurrentTarget);
         static inline bool IsExdiGdbServerConfigDataTag(_In_ PCWSTR pTagName);
         static inline bool IsExdiGdbServerTargetDataTag(_In_ PCWSTR pTagName);
@@ -35,10 +35,16 @@ class ConfigExdiGdbServerHelper::ConfigExdiGdbServerHelperImpl
     ConfigExdiGdbServerHelperImpl::ConfigExdiGdbServerHelperImpl(): m_XmlLiteReader(nullptr), m_IStream(nullptr), m_XmlConfigBuffer(nullptr)
     {
         ZeroMemory(&m_ExdiGdbServerData, sizeof(ConfigExdiGdbSrvData));
+        ZeroMemory(&m_targetSettings, sizeof(m_targetSettings));
     }
 
     ConfigExdiGdbServerHelperImpl::~ConfigExdiGdbServerHelperImpl()
     {
+        for (auto pElem : m_freeAttrNodes)
+        {
+            delete pElem;
+        }
+        m_freeAttrNodes.clear();
     }
 
     //  This function will read the file/default memory and load the 
@@ -77,9 +83,18 @@ class ConfigExdiGdbServerHelper::ConfigExdiGdbServerHelperImpl
                 GetExceptionCode());
             throw;
         }
+        if (isReadDone)
+        {
+            BuildTargetSettings();
+        }
         return isReadDone;
     }
 
+    inline const ConfigExdiTargetSettings & ConfigExdiGdbServerHelperImpl::GetTargetSettings() const
+    {
+        return m_targetSettings;
+    }
+
     inline void ConfigExdiGdbServerHelperImpl::GetTargetDescriptionFileName(_Out_ wstring & fileName)
     {
         fileName = m_ExdiGdbServerData.target.targetDescriptionFileName;
@@ -131,67 +146,69 @@ class ConfigExdiGdbServerHelper::ConfigExdiGdbServerHelperImpl
 
     inline bool ConfigExdiGdbServerHelperImpl::GetDisplayCommPacketsCharacters()
     {
-        return m_ExdiGdbServerData.component.fDisplayCommPackets;
+        return m_targetSettings.fDisplayCommPackets;
     }
 
     inline bool ConfigExdiGdbServerHelperImpl::GetDebuggerSessionByCore()
     {
-        return m_ExdiGdbServerData.component.fDebuggerSessionByCore;
+        return m_targetSettings.fDebuggerSessionByCore;
     }
 
     inline TargetArchitecture ConfigExdiGdbServerHelperImpl::GetTargetArchitecture()
     {
-        return m_ExdiGdbServerData.target.targetArchitecture;
+        return m_targetSettings.targetArchitecture;
     }
 
     inline void ConfigExdiGdbServerHelperImpl::SetTargetArchitecture(_In_ TargetArchitecture targetArch)
     {
         m_ExdiGdbServerData.target.targetArchitecture = targetArch;
+        m_targetSettings.targetArchitecture = targetArch;
+        m_targetSettings.fSystemRegistersAvailable = HasSystemRegistersForTarget();
     }
 
     inline DWORD ConfigExdiGdbServerHelperImpl::GetTargetFamily()
     {
-        return m_ExdiGdbServerData.target.targetFamily;
+        return m_targetSettings.targetFamily;
     }
 
     inline unsigned ConfigExdiGdbServerHelperImpl::GetNumberOfCores()
     {
-        return m_ExdiGdbServerData.target.numberOfCores;
+        return m_targetSettings.numberOfCores;
     }
 
     inline bool ConfigExdiGdbServerHelperImpl::GetIntelSseContext()
     {
-        return m_ExdiGdbServerData.target.fEnabledIntelFpSseContext;
+        return m_targetSettings.fEnabledIntelFpSseContext;
     }
 
     inline DWORD64 ConfigExdiGdbServerHelperImpl::GetHeuristicScanMemorySize()
     {
-        return m_ExdiGdbServerData.target.heuristicChunkSize;
+        return m_targetSettings.heuristicChunkSize;
     }
 
     inline bool ConfigExdiGdbServerHelperImpl::GetMultiCoreGdbServer()
     {
-        return m_ExdiGdbServerData.gdbServer.fMultiCoreGdbServer;
+        return m_targetSettings.fMultiCoreGdbServer;
     }
 
     inline size_t ConfigExdiGdbServerHelperImpl::GetMaxServerPacketLength()
     {
-        return m_ExdiGdbServerData.gdbServer.maxServerPacketLength;
+        return m_targetSettings.maxServerPacketLength;
     }
 
     inline int ConfigExdiGdbServerHelperImpl::GetMaxConnectAttempts()
     {
-        return m_ExdiGdbServerData.gdbServer.maxConnectAttempts;
+        return m_targetSettings.maxConnectAttempts;
     }
 
     inline int ConfigExdiGdbServerHelperImpl::GetSendPacketTimeout()
     {
-        return m_ExdiGdbServerData.gdbServer.sendTimeout;
+        return m_targetSettings.sendTimeout;
     }
 
     inline int ConfigExdiGdbServerHelperImpl::GetReceiveTimeout()
     {
-        return m_ExdiGdbServerData.gdbServer.receiveTimeout;
+        return m_targetSettings.receiveTimeout;
     }
 
     inline void ConfigExdiGdbServerHelperImpl::GetGdbServerConnectionParameters(_Out_ vector<wstring> & coreConnections)
@@ -201,12 +218,12 @@ class ConfigExdiGdbServerHelper::ConfigExdiGdbServerHelperImpl
 
     inline bool ConfigExdiGdbServerHelperImpl::IsExceptionThrowEnabled()
     {
-        return m_ExdiGdbServerData.component.fExceptionThrowEnabled;
+        return m_targetSettings.fExceptionThrowEnabled;
     }
 
     inline bool ConfigExdiGdbServerHelperImpl::IsForcedLegacyResumeStepMode()
     {
-        return m_ExdiGdbServerData.component.fForcedLegacyResumeStepCommands;
+        return m_targetSettings.fForcedLegacyResumeStepCommands;
     }
 
     inline TargetArchitecture ConfigExdiGdbServerHelperImpl::GetLastGdbServerRegisterArchitecture() const 
@@ -251,6 +268,11 @@ class ConfigExdiGdbServerHelper::ConfigExdiGdbServerHelperImpl
     }
 
     inline bool ConfigExdiGdbServerHelperImpl::IsSystemRegistersAvailable()
+    {
+        return m_targetSettings.fSystemRegistersAvailable;
+    }
+
+    bool ConfigExdiGdbServerHelperImpl::HasSystemRegistersForTarget() const
     {
         if (m_ExdiGdbServerData.gdbServerRegisters.spRegisterSystemSet != nullptr)
         {
@@ -276,37 +298,37 @@ class ConfigExdiGdbServerHelper::ConfigExdiGdbServerHelperImpl
 
     inline bool ConfigExdiGdbServerHelperImpl::IsSupportedSpecialMemoryCommand() const
     {
-        return m_ExdiGdbServerData.gdbMemoryCommands.fGdbSpecialMemoryCommand;
+        return m_targetSettings.fGdbSpecialMemoryCommand;
     }
 
     inline bool ConfigExdiGdbServerHelperImpl::IsSupportedPhysicalMemoryCommand() const
     {
-        return m_ExdiGdbServerData.gdbMemoryCommands.fGdbPhysicalMemoryCommand;
+        return m_targetSettings.fGdbPhysicalMemoryCommand;
     }
     
     inline bool ConfigExdiGdbServerHelperImpl::IsSupportedSupervisorMemoryCommand() const
     {
-        return m_ExdiGdbServerData.gdbMemoryCommands.fGdbSupervisorMemoryCommand;
+        return m_targetSettings.fGdbSupervisorMemoryCommand;
     }
     
     inline bool ConfigExdiGdbServerHelperImpl::IsSupportedHypervisorMemoryCommand() const
     {
-        return m_ExdiGdbServerData.gdbMemoryCommands.fGdbHypervisorMemoryCommand;
+        return m_targetSettings.fGdbHypervisorMemoryCommand;
     }
 
     inline bool ConfigExdiGdbServerHelperImpl::IsSupportedSpecialMemoryRegister() const
     {
-        return m_ExdiGdbServerData.gdbMemoryCommands.fGdbSpecialMemoryRegister;
+        return m_targetSettings.fGdbSpecialMemoryRegister;
     }
 
     inline bool ConfigExdiGdbServerHelperImpl::IsSupportedSystemRegistersGdbMonitor() const
     {
-        return m_ExdiGdbServerData.gdbMemoryCommands.fGdbSystemRegistersGdbMonitor;
+        return m_targetSettings.fGdbSystemRegistersGdbMonitor;
     }
 
     inline bool ConfigExdiGdbServerHelperImpl::IsSupportedSystemRegisterDecoding() const
     {
-        return m_ExdiGdbServerData.gdbMemoryCommands.fGdbSystemRegisterDecoding;
+        return m_targetSettings.fGdbSystemRegisterDecoding;
     }
 
     //  set an XML buffer to parse
@@ -336,24 +358,45 @@ class ConfigExdiGdbServerHelper::ConfigExdiGdbServerHelperImpl
 
     inline bool ConfigExdiGdbServerHelperImpl::GetTreatSwBpAsHwBp() const
     {
-        return m_ExdiGdbServerData.component.fTreatSwBpAsHwBp;
+        return m_targetSettings.fTreatSwBpAsHwBp;
     }
 
     inline bool ConfigExdiGdbServerHelperImpl::GetServerRequirePAMemoryAccess() const
     {
-        return m_ExdiGdbServerData.component.fPAMemoryAccess;
+        return m_targetSettings.fPAMemoryAccess;
     }
 
     inline bool ConfigExdiGdbServerHelperImpl::IsGdbMonitorCmdDoNotWaitOnOKEnable()
     {
-        return m_ExdiGdbServerData.component.fgdbMonitorCmdDoNotWaitOnOK;
+        return m_targetSettings.fgdbMonitorCmdDoNotWaitOnOK;
+    }
+
+    inline bool ConfigExdiGdbServerHelperImpl::IsMemoryWriteCoalescingEnabled() const
+    {
+        return m_targetSettings.fMemoryWriteCoalescing;
+    }
+
+    inline bool ConfigExdiGdbServerHelperImpl::IsHostPageTableWalkEnabled() const
+    {
+        return m_targetSettings.fHostPageTableWalk;
     }
 
     private:
     CComPtr<IXmlReader> m_XmlLiteReader;
     CComPtr<IStream> m_IStream;
     ConfigExdiGdbSrvData m_ExdiGdbServerData;
+    //  Memoized view of the selected target, rebuilt after each read.
+    ConfigExdiTargetSettings m_targetSettings;
     PCWSTR m_XmlConfigBuffer;
+    //  Attribute list nodes released by ClearTagAttributesList(), they are reused 
+    //  by ParseAttributes(), so parsing does not allocate one node per attribute.
+    vector<PAttrList_NodeElem_Struct> m_freeAttrNodes;
+    //  Attribute names and values of the current tag, stored as consecutive null terminated strings.
+    //  Both buffers keep their capacity between tags, so the attribute strings are not allocated.
+    vector<WCHAR> m_attrText;
+    vector<size_t> m_attrTextOffsets;
+    //  Current processed tag name
+    wstring m_tagName;
 
     //  Xml helper related functionality
     inline bool IsMemoryXmlBuffer(_In_opt_ PCWSTR pXmlConfigFile) {return (pXmlConfigFile == nullptr);}
@@ -361,6 +404,47 @@ class ConfigExdiGdbServerHelper::ConfigExdiGdbServerHelperImpl
     //  set an XML buffer to parse
     inline PCWSTR GetXmlBufferToParse() {return m_XmlConfigBuffer;}
 
+    //  Copies the scalar settings of the selected target to the flat view.
+    void ConfigExdiGdbServerHelperImpl::BuildTargetSettings()
+    {
+        ConfigExdiTargetSettings & settings = m_targetSettings;
+        settings.targetArchitecture = m_ExdiGdbServerData.target.targetArchitecture;
+        settings.targetFamily = m_ExdiGdbServerData.target.targetFamily;
+        settings.numberOfCores = m_ExdiGdbServerData.target.numberOfCores;
+        settings.heuristicChunkSize = m_ExdiGdbServerData.target.heuristicChunkSize;
+        settings.fEnabledIntelFpSseContext = m_ExdiGdbServerData.target.fEnabledIntelFpSseContext;
+        settings.maxServerPacketLength = m_ExdiGdbServerData.gdbServer.maxServerPacketLength;
+        settings.maxConnectAttempts = m_ExdiGdbServerData.gdbServer.maxConnectAttempts;
+        settings.sendTimeout = m_ExdiGdbServerData.gdbServer.sendTimeout;
+        settings.receiveTimeout = m_ExdiGdbServerData.gdbServer.receiveTimeout;
+        settings.fMultiCoreGdbServer = m_ExdiGdbServerData.gdbServer.fMultiCoreGdbServer;
+        settings.fDisplayCommPackets = m_ExdiGdbServerData.component.fDisplayCommPackets;
+        settings.fDebuggerSessionByCore = m_ExdiGdbServerData.component.fDebuggerSessionByCore;
+        settings.fExceptionThrowEnabled = m_ExdiGdbServerData.component.fExceptionThrowEnabled;
+        settings.fTreatSwBpAsHwBp = m_ExdiGdbServerData.component.fTreatSwBpAsHwBp;
+        settings.fForcedLegacyResumeStepCommands = m_ExdiGdbServerData.component.fForcedLegacyResumeStepCommands;
+        settings.fPAMemoryAccess = m_ExdiGdbServerData.component.fPAMemoryAccess;
+        settings.fgdbMonitorCmdDoNotWaitOnOK = m_ExdiGdbServerData.component.fgdbMonitorCmdDoNotWaitOnOK;
+        settings.fMemoryWriteCoalescing = m_ExdiGdbServerData.component.fMemoryWriteCoalescing;
+        settings.fHostPageTableWalk = m_ExdiGdbServerData.component.fHostPageTableWalk;
+        settings.fGdbSpecialMemoryCommand = m_ExdiGdbServerData.gdbMemoryCommands.fGdbSpecialMemoryCommand;
+        settings.fGdbPhysicalMemoryCommand = m_ExdiGdbServerData.gdbMemoryCommands.fGdbPhysicalMemoryCommand;
+        settings.fGdbSupervisorMemoryCommand = m_ExdiGdbServerData.gdbMemoryCommands.fGdbSupervisorMemoryCommand;
+        settings.fGdbHypervisorMemoryCommand = m_ExdiGdbServerData.gdbMemoryCommands.fGdbHypervisorMemoryCommand;
+        settings.fGdbSpecialMemoryRegister = m_ExdiGdbServerData.gdbMemoryCommands.fGdbSpecialMemoryRegister;
+        settings.fGdbSystemRegistersGdbMonitor = m_ExdiGdbServerData.gdbMemoryCommands.fGdbSystemRegistersGdbMonitor;
+        settings.fGdbSystemRegisterDecoding = m_ExdiGdbServerData.gdbMemoryCommands.fGdbSystemRegisterDecoding;
+        settings.fSystemRegistersAvailable = HasSystemRegistersForTarget();
+    }
+
+    //  Appends a null terminated string to the attribute text buffer
+    void ConfigExdiGdbServerHelperImpl::AppendAttributeText(_In_ PCWSTR pText, _In_ UINT textLength)
+    {
+        m_attrTextOffsets.push_back(m_attrText.size());
+        m_attrText.insert(m_attrText.end(), pText, pText + textLength);
+        m_attrText.push_back(L'\x0');
+    }
+
     bool GetPrevProcessTagElementStatus() { return m_ExdiGdbServerData.file.isTargetTagEmpty; }
     void SetPrevProcessTagElementDone() { m_ExdiGdbServerData.file.isTargetTagEmpty = false; }
 
@@ -456,7 +540,7 @@ class ConfigExdiGdbServerHelper::ConfigExdiGdbServerHelperImpl
                 assert(pElem != nullptr);
                 RemoveEntryList(next);
                 next = pElem->token.Flink;
-                delete pElem;
+                m_freeAttrNodes.push_back(pElem);
             }
         }
     }
@@ -483,23 +567,44 @@ class ConfigExdiGdbServerHelper::ConfigExdiGdbServerHelperImpl
     
         try
         {
+            m_attrText.clear();
+            m_attrTextOffsets.clear();
             hr = m_XmlLiteReader->MoveToFirstAttribute();
             while (SUCCEEDED(hr))
             {
                 PCWSTR pAttribName = nullptr;
                 PCWSTR pAttribValue = nullptr;
+                UINT attribNameLength = 0;
+                UINT attribValueLength = 0;
 
-                HRESULT hr = m_XmlLiteReader->GetLocalName(&pAttribName, nullptr);
+                HRESULT hr = m_XmlLiteReader->GetLocalName(&pAttribName, &attribNameLength);
                 if (SUCCEEDED(hr))
                 {
-                    hr = m_XmlLiteReader->GetValue(&pAttribValue, nullptr);
+                    hr = m_XmlLiteReader->GetValue(&pAttribValue, &attribValueLength);
                     if (SUCCEEDED(hr))
                     {
+                        //  The strings are linked to the node once all attributes are read,
+                        //  since the text buffer can still be reallocated.
+                        AppendAttributeText(pAttribName, attribNameLength);
+                        AppendAttributeText(pAttribValue, attribValueLength);
+
                         //  Add a new element to the list
-                        PAttrList_NodeElem_Struct pListNode = new (nothrow) AttrList_NodeElem_Struct;
-                        assert(pListNode != nullptr);
-                        pListNode->localName += pAttribName;
-                        pListNode->value += pAttribValue;
+                        PAttrList_NodeElem_Struct pListNode = nullptr;
+                        if (!m_freeAttrNodes.empty())
+                        {
+                            pListNode = m_freeAttrNodes.back();
+                            m_freeAttrNodes.pop_back();
+                        }
+                        else
+                        {
+                            pListNode = new (nothrow) AttrList_NodeElem_Struct;
+                            if (pListNode == nullptr)
+                            {
+                                throw _com_error(E_OUTOFMEMORY);
+                            }
+                        }
+                        pListNode->localName = nullptr;
+                        pListNode->value = nullptr;
                         //  Insert the element in the list
                         InsertTailList(&pTagAttrList->attrPair, &pListNode->token);
                     }
@@ -521,6 +626,18 @@ class ConfigExdiGdbServerHelper::ConfigExdiGdbServerHelperImpl
                     }
                 }
             } 
+
+            //  Link the list nodes to their strings, the nodes are in the same order as the offsets.
+            size_t offsetIndex = 0;
+            PLIST_ENTRY next = pTagAttrList->attrPair.Flink;
+            while (next != &pTagAttrList->attrPair)
+            {
+                PAttrList_NodeElem_Struct pElem = CONTAINING_RECORD(next, AttrList_NodeElem_Struct, token);
+                assert(offsetIndex + 1 < m_attrTextOffsets.size());
+                pElem->localName = &m_attrText[m_attrTextOffsets[offsetIndex++]];
+                pElem->value = &m_attrText[m_attrTextOffsets[offsetIndex++]];
+                next = pElem->token.Flink;
+            }
         }
         catch (exception & ex)
         {
@@ -535,6 +652,46 @@ class ConfigExdiGdbServerHelper::ConfigExdiGdbServerHelperImpl
         return hr;
     }
 
+    //  Check if the tag is a target element that is not the current selected target
+    inline bool ConfigExdiGdbServerHelperImpl::IsNotSelectedExdiTarget(_In_ PCWSTR pTagName)
+    {
+        return (!m_ExdiGdbServerData.gdbTargetName.isTargetSelected &&
+                m_ExdiGdbServerData.gdbCurrentTargetName.currentTargetName[0] != L'\x0' &&
+                XmlDataHelpers::IsExdiGdbTargetTag(pTagName));
+    }
+
+    //  Skips the current element and all its child nodes without processing them.
+    HRESULT ConfigExdiGdbServerHelperImpl::SkipCurrentElement()
+    {
+        HRESULT hr = m_XmlLiteReader->MoveToElement();
+        if (FAILED(hr) || m_XmlLiteReader->IsEmptyElement())
+        {
+            return hr;
+        }
+
+        UINT elementDepth = 0;
+        hr = m_XmlLiteReader->GetDepth(&elementDepth);
+        while (SUCCEEDED(hr) && !m_XmlLiteReader->IsEOF())
+        {
+            XmlNodeType nodeType;
+            hr = m_XmlLiteReader->Read(&nodeType);
+            if (FAILED(hr) || (hr == S_FALSE))
+            {
+                break;
+            }
+            if (nodeType == XmlNodeType_EndElement)
+            {
+                UINT depth = 0;
+                hr = m_XmlLiteReader->GetDepth(&depth);
+                if (SUCCEEDED(hr) && depth == elementDepth)
+                {
+                    break;
+                }
+            }
+        }
+        return hr;
+    }
+
     HRESULT ConfigExdiGdbServerHelperImpl::ReadStream()
     {
         HRESULT hr = E_FAIL;
@@ -578,40 +735,54 @@ class ConfigExdiGdbServerHelper::ConfigExdiGdbServerHelperImpl
                     {
                         TAG_ATTR_LIST tagAttrList = {};
                         InitializeListHead(&tagAttrList.attrPair);
-                        size_t copyLength = wcslen(pTagName) + 1;
-                        unique_ptr<WCHAR> pTagNameCopy(new (nothrow) WCHAR[copyLength]);
-                        if (pTagNameCopy != nullptr)
-                        {
-                            ZeroMemory(pTagNameCopy.get(), sizeof(WCHAR) * (copyLength));
-                            wcscpy_s(pTagNameCopy.get(), copyLength, pTagName);
-                            tagAttrList.tagName = pTagNameCopy.get();
+                        m_tagName.assign(pTagName);
+                        tagAttrList.tagName = m_tagName.c_str();
 
-                            //  Parse the XML tag
-                            hr = ParseAttributes(&tagAttrList);
-                            if (SUCCEEDED(hr))
+                        //  Parse the XML tag
+                        hr = ParseAttributes(&tagAttrList);
+                        if (SUCCEEDED(hr))
+                        {
+                            hr = ProcessAttributeList(&tagAttrList);
+                            if (FAILED(hr))
                             {
-                                hr = ProcessAttributeList(&tagAttrList);
+                                isForcedEnd = true;
+                                break;
+                            }
+                            //  Only the current target section is processed, so skip
+                            //  the entire element of any other target in the configuration file.
+                            if (IsNotSelectedExdiTarget(m_tagName.c_str()))
+                            {
+                                hr = SkipCurrentElement();
                                 if (FAILED(hr))
                                 {
                                     isForcedEnd = true;
-                                    break;
                                 }
                             }
-                            else
-                            {
-                                //  Try removing any added element to the list 
-                                ClearTagAttributesList(&tagAttrList);
-                                isForcedEnd = true;
-                            }
                         }
                         else
                         {
+                            //  Try removing any added element to the list 
+                            ClearTagAttributesList(&tagAttrList);
                             isForcedEnd = true;
-                            hr = E_OUTOFMEMORY;
                         }
                     }
                 }
                 break;
+                case XmlNodeType_EndElement:
+                {
+                    PCWSTR pTagName = nullptr;
+                    hr = m_XmlLiteReader->GetLocalName(&pTagName, nullptr);
+                    if (SUCCEEDED(hr) && (pTagName != nullptr) &&
+                        m_ExdiGdbServerData.gdbTargetName.isTargetSelected &&
+                        XmlDataHelpers::IsExdiGdbTargetTag(pTagName))
+                    {
+                        //  The current target section has been processed, so there is
+                        //  nothing else to read from the configuration file.
+                        m_ExdiGdbServerData.gdbTargetName.isTargetSelected = false;
+                        isForcedEnd = true;
+                    }
+                }
+                break;
             }
         }
         return hr;
@@ -900,4 +1071,22 @@ bool ConfigExdiGdbServerHelper::IsGdbMonitorCmdDoNotWaitOnOKEnable()
 {
     assert(m_pConfigExdiGdbServerHelperImpl != nullptr);
     return m_pConfigExdiGdbServerHelperImpl->IsGdbMonitorCmdDoNotWaitOnOKEnable();
+}
+
+bool ConfigExdiGdbServerHelper::IsMemoryWriteCoalescingEnabled()
+{
+    assert(m_pConfigExdiGdbServerHelperImpl != nullptr);
+    return m_pConfigExdiGdbServerHelperImpl->IsMemoryWriteCoalescingEnabled();
+}
+
+const ConfigExdiTargetSettings & ConfigExdiGdbServerHelper::GetTargetSettings()
+{
+    assert(m_pConfigExdiGdbServerHelperImpl != nullptr);
+    return m_pConfigExdiGdbServerHelperImpl->GetTargetSettings();
+}
+
+bool ConfigExdiGdbServerHelper::IsHostPageTableWalkEnabled()
+{
+    assert(m_pConfigExdiGdbServerHelperImpl != nullptr);
+    return m_pConfigExdiGdbServerHelperImpl->IsHostPageTableWalkEnabled();
 }
\ No newline at end of file
@@ -22,10 +22,44 @@ using namespace GdbSrvControllerLib;
 // Public defines and typedefs
 //=============================================================================
 
+//  Flat view of the scalar settings of the selected target.
+//  It is built once after each configuration read, so the getters do not walk the parsed tables.
+typedef struct
+{
+    TargetArchitecture targetArchitecture;  //  The target architecture.
+    DWORD targetFamily;                     //  The target processor family.
+    unsigned numberOfCores;                 //  Number of cores of the target processor CPU.
+    DWORD64 heuristicChunkSize;             //  Chunk size used by the heurisitic scanning memory mechanism.
+    size_t maxServerPacketLength;           //  Maximum GdbServer packet length.
+    int maxConnectAttempts;                 //  Connect session maximum attempts
+    int sendTimeout;                        //  Send RSP packet timeout
+    int receiveTimeout;                     //  Receive timeout
+    bool fDisplayCommPackets;
+    bool fDebuggerSessionByCore;
+    bool fExceptionThrowEnabled;
+    bool fTreatSwBpAsHwBp;
+    bool fForcedLegacyResumeStepCommands;
+    bool fPAMemoryAccess;
+    bool fgdbMonitorCmdDoNotWaitOnOK;
+    bool fMemoryWriteCoalescing;
+    bool fHostPageTableWalk;
+    bool fEnabledIntelFpSseContext;
+    bool fMultiCoreGdbServer;
+    bool fGdbSpecialMemoryCommand;
+    bool fGdbPhysicalMemoryCommand;
+    bool fGdbSupervisorMemoryCommand;
+    bool fGdbHypervisorMemoryCommand;
+    bool fGdbSpecialMemoryRegister;
+    bool fGdbSystemRegistersGdbMonitor;
+    bool fGdbSystemRegisterDecoding;
+    bool fSystemRegistersAvailable;         //  System registers are described for the target architecture.
+} ConfigExdiTargetSettings;
+
 class ConfigExdiGdbServerHelper final
 {
     public:
         static ConfigExdiGdbServerHelper & GetInstanceCfgExdiGdbServer(_In_opt_ PCWSTR pXmlConfigFile);
+        const ConfigExdiTargetSettings & GetTargetSettings();
         TargetArchitecture GetTargetArchitecture();
         DWORD GetTargetFamily();
         bool GetDisplayCommPacketsCharacters();
@@ -67,6 +101,8 @@ class ConfigExdiGdbServerHelper final
         void SetXmlBufferToParse(_In_ PCWSTR pXmlConfigFile);
         void SetTargetArchitecture(_In_ TargetArchitecture targetArch);
         bool IsGdbMonitorCmdDoNotWaitOnOKEnable();
+        bool IsMemoryWriteCoalescingEnabled();
+        bool IsHostPageTableWalkEnabled();
 
     private:
         ConfigExdiGdbServerHelper(_In_opt_ PCWSTR pXmlConfigFile);
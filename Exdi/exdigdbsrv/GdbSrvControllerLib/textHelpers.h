@@ -9,6 +9,8 @@
 
 #pragma once
 
+#include "HandleHelpers.h"
+
 namespace GdbSrvControllerLib
 {
     enum class GdbSrvTextType
@@ -25,6 +27,39 @@ namespace GdbSrvControllerLib
                                 _In_ size_t readSize) = 0;
         virtual ~IGdbSrvTextHandler(){}
     };
+
+    //  Text handler that serializes the calls to the wrapped handler, so the text can be
+    //  written from the threads exchanging packets on different channels concurrently.
+    //  It owns the wrapped handler.
+    class SerializedTextHandler : public IGdbSrvTextHandler
+    {
+    public:
+        SerializedTextHandler(_In_ IGdbSrvTextHandler * pTextHandler) : m_pTextHandler(pTextHandler)
+        {
+            assert(pTextHandler != nullptr);
+            InitializeCriticalSection(&m_textLock);
+        }
+
+        ~SerializedTextHandler()
+        {
+            delete m_pTextHandler;
+            DeleteCriticalSection(&m_textLock);
+        }
+
+        void HandleText(_In_ GdbSrvTextType textType, _In_reads_bytes_(readSize) const char *pText,
+                        _In_ size_t readSize)
+        {
+            scoped_lock textGuard(m_textLock);
+            m_pTextHandler->HandleText(textType, pText, readSize);
+        }
+
+    private:
+        IGdbSrvTextHandler * m_pTextHandler;
+        CRITICAL_SECTION m_textLock;
+
+        SerializedTextHandler(_In_ const SerializedTextHandler &);
+        void operator=(_In_ const SerializedTextHandler &);
+    };
     //  This type is used to set the call back function for displaying send/recv data
     typedef void (*pSetDisplayCommData)(_In_reads_bytes_(readSize) const char * pData,  _In_ size_t readSize, _In_ GdbSrvTextType textType, IGdbSrvTextHandler * const pTextHandler, _In_ unsigned channel);
 }
\ No newline at end of file
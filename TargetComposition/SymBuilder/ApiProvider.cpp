@@ -136,6 +136,59 @@ std::wstring ValueToString(_In_ VARIANT const& val)
     return (std::wstring)buf;
 }
 
+// FindNextSymbol():
+//
+// Finds the next symbol of the given kind in a list of symbol ids at or after a positional counter and moves the
+// counter past it.  The caller must hold the symbol set shared.  Returns nullptr once there are no more.
+//
+BaseSymbol *FindNextSymbol(_In_ SymbolSet *pSymbolSet,
+                           _In_ std::vector<ULONG64> const& symbolIds,
+                           _In_ SvcSymbolKind kind,
+                           _Inout_ size_t *pCur,
+                           _Out_ ComPtr<ISvcSymbol> *pspSymbol)
+{
+    while (*pCur < symbolIds.size())
+    {
+        BaseSymbol *pSymbol = pSymbolSet->InternalGetSymbol(symbolIds[*pCur]);
+        ++(*pCur);
+
+        if (pSymbol != nullptr && pSymbol->InternalGetKind() == kind)
+        {
+            *pspSymbol = pSymbol;
+            return pSymbol;
+        }
+    }
+
+    return nullptr;
+}
+
+// GetNextChild() / GetNextGlobal():
+//
+// Gets the next child of a symbol (or global symbol of a symbol set) of the given kind for a generator which
+// walks them with a positional counter.  The symbol set is held shared only while the list is read.  It must
+// *NOT* be held across a co_yield: the consumer may change the symbol set (or a background import may need to)
+// before the generator is resumed.  The returned reference keeps the symbol alive should it be deleted in the
+// meantime.  Returns nullptr once there are no more.
+//
+BaseSymbol *GetNextChild(_In_ BaseSymbol *pParent,
+                         _In_ SvcSymbolKind kind,
+                         _Inout_ size_t *pCur,
+                         _Out_ ComPtr<ISvcSymbol> *pspSymbol)
+{
+    SymbolSet *pSymbolSet = pParent->InternalGetSymbolSet();
+    SymbolSetSharedLock lock(pSymbolSet->GetLock());
+    return FindNextSymbol(pSymbolSet, pParent->InternalGetChildren(), kind, pCur, pspSymbol);
+}
+
+BaseSymbol *GetNextGlobal(_In_ SymbolSet *pSymbolSet,
+                          _In_ SvcSymbolKind kind,
+                          _Inout_ size_t *pCur,
+                          _Out_ ComPtr<ISvcSymbol> *pspSymbol)
+{
+    SymbolSetSharedLock lock(pSymbolSet->GetLock());
+    return FindNextSymbol(pSymbolSet, pSymbolSet->InternalGetGlobalSymbols(), kind, pCur, pspSymbol);
+}
+
 //*************************************************
 // Provider Implementation
 //
@@ -366,6 +419,10 @@ Object SymbolBuilderNamespace::CreateSymbols(_In_ const Object& /*contextObject*
     ModelObjectKind moduleArgKind = moduleArg.GetKind();
 
     bool autoImportSymbols = false;
+    bool shareImageSymbols = false;
+    bool backgroundImport = false;
+    bool allowImageMismatch = false;
+    std::optional<std::wstring> snapshotFile;
     ULONG64 moduleBase = 0;
     Object moduleObject;
     switch(moduleArgKind)
@@ -416,6 +473,30 @@ Object SymbolBuilderNamespace::CreateSymbols(_In_ const Object& /*contextObject*
         {
             autoImportSymbols = (bool)autoImportSymbolsKey.value();
         }
+
+        std::optional<Object> snapshotFileKey = optionsObj.TryGetKeyValue(L"SnapshotFile");
+        if (snapshotFileKey.has_value())
+        {
+            snapshotFile = (std::wstring)snapshotFileKey.value();
+        }
+
+        std::optional<Object> allowImageMismatchKey = optionsObj.TryGetKeyValue(L"AllowImageMismatch");
+        if (allowImageMismatchKey.has_value())
+        {
+            allowImageMismatch = (bool)allowImageMismatchKey.value();
+        }
+
+        std::optional<Object> shareImageSymbolsKey = optionsObj.TryGetKeyValue(L"ShareImageSymbols");
+        if (shareImageSymbolsKey.has_value())
+        {
+            shareImageSymbols = (bool)shareImageSymbolsKey.value();
+        }
+
+        std::optional<Object> backgroundImportKey = optionsObj.TryGetKeyValue(L"BackgroundImport");
+        if (backgroundImportKey.has_value())
+        {
+            backgroundImport = (bool)backgroundImportKey.value();
+        }
     }
 
     ComPtr<ISvcSymbolBuilderManager> spSymbolManager;
@@ -442,7 +523,12 @@ Object SymbolBuilderNamespace::CreateSymbols(_In_ const Object& /*contextObject*
         throw std::invalid_argument("module");
     }
 
-    CheckHr(spSymbolProcess->CreateSymbolsForModule(spModule.Get(), moduleKey, &spSymbolSet));
+    CheckHr(spSymbolProcess->CreateSymbolsForModule(spModule.Get(), 
+                                                    moduleKey, 
+                                                    &spSymbolSet,
+                                                    snapshotFile.has_value() ? snapshotFile.value().c_str() : nullptr,
+                                                    shareImageSymbols,
+                                                    allowImageMismatch));
 
     //
     // If we have been asked to automatically import symbols, set up an appropriate "on demand" importer.
@@ -468,6 +554,15 @@ Object SymbolBuilderNamespace::CreateSymbols(_In_ const Object& /*contextObject*
         if (SUCCEEDED(spImporter->ConnectToSource()))
         {
             spSymbolSet->SetImporter(std::move(spImporter));
+
+            //
+            // Failing to start the background import is not a failure either.  Everything is still imported on
+            // demand.
+            //
+            if (backgroundImport)
+            {
+                (void)spSymbolSet->GetImporter()->StartBackgroundImport();
+            }
         }
     }
 
@@ -518,6 +613,273 @@ Object ModuleExtension::GetSymbolBuilderSymbols(_In_ const Object& moduleObject)
 // Symbol Set APIs:
 //
 
+void SymbolSetObject::BeginBatch(_In_ const Object& /*symbolSetObject*/,
+                                 _In_ ComPtr<SymbolSet>& spSymbolSet)
+{
+    spSymbolSet->BeginBatch();
+}
+
+void SymbolSetObject::CommitBatch(_In_ const Object& /*symbolSetObject*/,
+                                  _In_ ComPtr<SymbolSet>& spSymbolSet)
+{
+    if (!spSymbolSet->IsBatchOpen())
+    {
+        throw std::runtime_error("no batch is open on the symbol set");
+    }
+
+    CheckHr(spSymbolSet->CommitBatch());
+}
+
+void SymbolSetObject::Batch(_In_ const Object& /*symbolSetObject*/,
+                            _In_ ComPtr<SymbolSet>& spSymbolSet,
+                            _In_ Object callback)
+{
+    IModelObject *pCallbackObject = callback.GetObject();
+
+    ModelObjectKind callbackKind;
+    CheckHr(pCallbackObject->GetKind(&callbackKind));
+    if (callbackKind != ObjectMethod)
+    {
+        throw std::invalid_argument("callback");
+    }
+
+    VARIANT vtMethod;
+    CheckHr(pCallbackObject->GetIntrinsicValue(&vtMethod));
+    ComPtr<IModelMethod> spMethod;
+    HRESULT hr = vtMethod.punkVal->QueryInterface(IID_PPV_ARGS(&spMethod));
+    VariantClear(&vtMethod);
+    CheckHr(hr);
+
+    //
+    // The batch must not outlive the call: a script exception comes back as a failed HRESULT and the batch
+    // is committed before that error is rethrown.
+    //
+    SymbolSetBatch batch(spSymbolSet.Get());
+    ComPtr<IModelObject> spResult;
+    ComPtr<IKeyStore> spMetadata;
+    hr = spMethod->Call(nullptr, 0, nullptr, &spResult, &spMetadata);
+    HRESULT hrCommit = batch.Commit();
+    CheckHr(hr);
+    CheckHr(hrCommit);
+}
+
+std::experimental::generator<Object> SymbolSetObject::FindSymbols(_In_ const Object /*symbolSetObject*/,
+                                                                  _In_ ComPtr<SymbolSet>& spSymbolSet,
+                                                                  _In_ std::wstring pattern,
+                                                                  _In_ std::optional<bool> isRegex)
+{
+    bool regex = isRegex.value_or(false);
+
+    //
+    // Give any underlying importer a chance to pull in symbols matching a wildcard pattern.  It does not
+    // understand regular expressions.  Failure to import should not fail the search.
+    //
+    if (!regex)
+    {
+        spSymbolSet->ImportForNameQuery(SvcSymbol, pattern.c_str());
+    }
+
+    std::vector<ULONG64> matches;
+    {
+        SymbolSetSharedLock lock(spSymbolSet->GetLock());
+        spSymbolSet->InternalFindSymbolsMatching(pattern, regex, &matches);
+    }
+
+    //
+    // After a co_yield, symbols may have been deleted.  Refetch each one by id (holding the symbol set shared
+    // only while doing so and never across the co_yield).
+    //
+    for (ULONG64 match : matches)
+    {
+        ComPtr<ISvcSymbol> spSymbol;
+        BaseSymbol *pSymbol;
+        {
+            SymbolSetSharedLock lock(spSymbolSet->GetLock());
+            pSymbol = spSymbolSet->InternalGetSymbol(match);
+            if (pSymbol == nullptr || !pSymbol->IsGlobal())
+            {
+                continue;
+            }
+            spSymbol = pSymbol;
+        }
+
+        Object symbolObject = BoxSymbol(pSymbol);
+        co_yield symbolObject;
+    }
+}
+
+Object SymbolSetObject::MeasureLookups(_In_ const Object& /*symbolSetObject*/,
+                                       _In_ ComPtr<SymbolSet>& spSymbolSet,
+                                       _In_ ULONG64 threadCount,
+                                       _In_ std::optional<ULONG64> rounds)
+{
+    if (threadCount == 0 || threadCount > 256)
+    {
+        throw std::invalid_argument("Invalid thread count");
+    }
+    ULONG64 roundCount = rounds.value_or(1);
+
+    std::vector<std::wstring> names;
+    {
+        SymbolSetSharedLock lock(spSymbolSet->GetLock());
+        size_t symbolCount = spSymbolSet->InternalGetSymbols().size();
+        for (size_t id = 1; id < symbolCount; ++id)
+        {
+            BaseSymbol *pSymbol = spSymbolSet->InternalGetSymbol(id);
+            if (pSymbol != nullptr && pSymbol->IsGlobal() && !pSymbol->InternalGetQualifiedName().empty())
+            {
+                names.push_back(pSymbol->InternalGetQualifiedName());
+            }
+        }
+    }
+
+    //
+    // Each thread goes through the names from a different starting point so that the threads are not all
+    // looking up (and importing) the same name at the same moment.
+    //
+    std::atomic<ULONG64> found = 0;
+    auto worker = [&](_In_ size_t threadNumber)
+    {
+        ULONG64 threadFound = 0;
+        for (ULONG64 round = 0; round < roundCount; ++round)
+        {
+            for (size_t i = 0; i < names.size(); ++i)
+            {
+                std::wstring const& name = names[(i + threadNumber * names.size() / threadCount) % names.size()];
+                ComPtr<ISvcSymbol> spSymbol;
+                bstr_ptr spName;
+                BSTR symbolName;
+                if (SUCCEEDED(spSymbolSet->FindSymbolByName(name.c_str(), &spSymbol)) &&
+                    SUCCEEDED(spSymbol->GetName(&symbolName)))
+                {
+                    spName.reset(symbolName);
+                    ++threadFound;
+                }
+            }
+        }
+        found += threadFound;
+    };
+
+    auto startTime = std::chrono::steady_clock::now();
+    std::vector<std::thread> threads;
+    for (size_t t = 1; t < threadCount; ++t)
+    {
+        HRESULT hr = ConvertException([&](){
+            threads.emplace_back(worker, t);
+            return S_OK;
+        });
+        if (FAILED(hr))
+        {
+            break;
+        }
+    }
+    worker(0);
+    for (auto&& thread : threads)
+    {
+        thread.join();
+    }
+    auto elapsed = std::chrono::steady_clock::now() - startTime;
+
+    //
+    // If a thread could not be created, fewer threads ran than were asked for.
+    //
+    ULONG64 threadsRun = static_cast<ULONG64>(threads.size()) + 1;
+    return Object::Create(HostContext(),
+                          L"Threads", threadsRun,
+                          L"Lookups", threadsRun * roundCount * static_cast<ULONG64>(names.size()),
+                          L"Found", found.load(),
+                          L"Microseconds",
+                          static_cast<ULONG64>(std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count()));
+}
+
+void SymbolSetObject::CancelImport(_In_ const Object& /*symbolSetObject*/,
+                                   _In_ ComPtr<SymbolSet>& spSymbolSet)
+{
+    if (spSymbolSet->HasImporter())
+    {
+        spSymbolSet->GetImporter()->CancelBackgroundImport();
+    }
+}
+
+void SymbolSetObject::SaveSnapshot(_In_ const Object& /*symbolSetObject*/,
+                                   _In_ ComPtr<SymbolSet>& spSymbolSet,
+                                   _In_ std::wstring fileName)
+{
+    SymbolSnapshotWriter writer(spSymbolSet.Get());
+    CheckHr(writer.WriteToFile(fileName.c_str()));
+}
+
+Object SymbolSetObject::GetImportProgress(_In_ const Object& /*symbolSetObject*/,
+                                          _In_ ComPtr<SymbolSet>& spSymbolSet)
+{
+    BackgroundImportProgress progress;
+    if (!spSymbolSet->HasImporter() ||
+        FAILED(spSymbolSet->GetImporter()->GetBackgroundImportProgress(&progress)) ||
+        progress.State == BackgroundImportState::NotStarted)
+    {
+        return Object::CreateNoValue();
+    }
+
+    PCWSTR pwszState;
+    switch(progress.State)
+    {
+        case BackgroundImportState::Enumerating:
+            pwszState = L"Enumerating";
+            break;
+
+        case BackgroundImportState::Importing:
+            pwszState = L"Importing";
+            break;
+
+        case BackgroundImportState::Completed:
+            pwszState = L"Completed";
+            break;
+
+        case BackgroundImportState::Cancelled:
+            pwszState = L"Cancelled";
+            break;
+
+        default:
+            pwszState = L"Failed";
+            break;
+    }
+
+    return Object::Create(HostContext(),
+                          L"State", pwszState,
+                          L"Processed", progress.SymbolsProcessed,
+                          L"Total", progress.SymbolsTotal);
+}
+
+Object SymbolSetObject::GetNameStatistics(_In_ const Object& /*symbolSetObject*/,
+                                          _In_ ComPtr<SymbolSet>& spSymbolSet)
+{
+    size_t nameCount;
+    size_t referenceCount;
+    size_t pooledBytes;
+    size_t unpooledBytes;
+    spSymbolSet->GetNamePool()->GetStatistics(&nameCount, &referenceCount, &pooledBytes, &unpooledBytes);
+
+    return Object::Create(HostContext(),
+                          L"Names", static_cast<ULONG64>(nameCount),
+                          L"References", static_cast<ULONG64>(referenceCount),
+                          L"PooledBytes", static_cast<ULONG64>(pooledBytes),
+                          L"UnpooledBytes", static_cast<ULONG64>(unpooledBytes));
+}
+
+Object SymbolSetObject::GetImageSharing(_In_ const Object& /*symbolSetObject*/,
+                                        _In_ ComPtr<SymbolSet>& spSymbolSet)
+{
+    size_t sharingSets;
+    size_t symbolCount;
+    size_t heldSnapshotBytes;
+    spSymbolSet->GetImageSharingStatistics(&sharingSets, &symbolCount, &heldSnapshotBytes);
+
+    return Object::Create(HostContext(),
+                          L"Sets", static_cast<ULONG64>(sharingSets),
+                          L"Symbols", static_cast<ULONG64>(symbolCount),
+                          L"SnapshotBytes", static_cast<ULONG64>(heldSnapshotBytes));
+}
+
 Object SymbolSetObject::GetTypes(_In_ const Object& /*symbolSetObject*/,
                                  _In_ ComPtr<SymbolSet>& spSymbolSet)
 {
@@ -948,21 +1310,13 @@ std::experimental::generator<Object> TypesObject::GetIterator(_In_ const Object
     size_t cur = 0;
     for(;;)
     {
-        auto&& globalSymbols = spSymbolSet->InternalGetGlobalSymbols();
-        if (cur >= globalSymbols.size())
+        ComPtr<ISvcSymbol> spNextSymbol;
+        BaseSymbol *pNextSymbol = GetNextGlobal(spSymbolSet.Get(), SvcSymbolType, &cur, &spNextSymbol);
+        if (pNextSymbol == nullptr)
         {
             break;
         }
 
-        ULONG64 nextGlobal = globalSymbols[cur];
-        ++cur;
-
-        BaseSymbol *pNextSymbol = spSymbolSet->InternalGetSymbol(nextGlobal);
-        if (pNextSymbol->InternalGetKind() != SvcSymbolType)
-        {
-            continue;
-        }
-
         BaseTypeSymbol *pNextType = static_cast<BaseTypeSymbol *>(pNextSymbol);
         Object typeObject = BoxType(pNextType);
         co_yield typeObject;
@@ -1134,24 +1488,22 @@ std::experimental::generator<Object> FieldsObject::GetIterator(_In_ const Object
     // of things may have drastically changed.  We must refetch things and only rely upon positional
     // counters!
     //
+
+    //
+    // If the members of the UDT have not yet been imported, do so before walking them.
+    //
+    CheckHr(spUdtTypeSymbol->EnsureMembers());
+
     size_t cur = 0;
     for(;;)
     {
-        auto&& children = spUdtTypeSymbol->InternalGetChildren();
-        if (cur >= children.size())
+        ComPtr<ISvcSymbol> spNextSymbol;
+        BaseSymbol *pNextSymbol = GetNextChild(spUdtTypeSymbol.Get(), SvcSymbolField, &cur, &spNextSymbol);
+        if (pNextSymbol == nullptr)
         {
             break;
         }
 
-        ULONG64 nextChild = children[cur];
-        ++cur;
-
-        BaseSymbol *pNextSymbol = spUdtTypeSymbol->InternalGetSymbolSet()->InternalGetSymbol(nextChild);
-        if (pNextSymbol->InternalGetKind() != SvcSymbolField)
-        {
-            continue;
-        }
-
         FieldSymbol *pNextField = static_cast<FieldSymbol *>(pNextSymbol);
         ComPtr<FieldSymbol> spNextField = pNextField;
         FieldObject& fieldFactory = ApiProvider::Get().GetFieldFactory();
@@ -1258,21 +1610,13 @@ std::experimental::generator<Object> EnumerantsObject::GetIterator(_In_ const Ob
     size_t cur = 0;
     for(;;)
     {
-        auto&& children = spEnumTypeSymbol->InternalGetChildren();
-        if (cur >= children.size())
+        ComPtr<ISvcSymbol> spNextSymbol;
+        BaseSymbol *pNextSymbol = GetNextChild(spEnumTypeSymbol.Get(), SvcSymbolField, &cur, &spNextSymbol);
+        if (pNextSymbol == nullptr)
         {
             break;
         }
 
-        ULONG64 nextChild = children[cur];
-        ++cur;
-
-        BaseSymbol *pNextSymbol = spEnumTypeSymbol->InternalGetSymbolSet()->InternalGetSymbol(nextChild);
-        if (pNextSymbol->InternalGetKind() != SvcSymbolField)
-        {
-            continue;
-        }
-
         FieldSymbol *pNextField = static_cast<FieldSymbol *>(pNextSymbol);
         ComPtr<FieldSymbol> spNextField = pNextField;
         FieldObject& fieldFactory = ApiProvider::Get().GetFieldFactory();
@@ -1643,24 +1987,22 @@ std::experimental::generator<Object> BaseClassesObject::GetIterator(_In_ const O
     // of things may have drastically changed.  We must refetch things and only rely upon positional
     // counters!
     //
+
+    //
+    // If the members of the UDT have not yet been imported, do so before walking them.
+    //
+    CheckHr(spUdtTypeSymbol->EnsureMembers());
+
     size_t cur = 0;
     for(;;)
     {
-        auto&& children = spUdtTypeSymbol->InternalGetChildren();
-        if (cur >= children.size())
+        ComPtr<ISvcSymbol> spNextSymbol;
+        BaseSymbol *pNextSymbol = GetNextChild(spUdtTypeSymbol.Get(), SvcSymbolBaseClass, &cur, &spNextSymbol);
+        if (pNextSymbol == nullptr)
         {
             break;
         }
 
-        ULONG64 nextChild = children[cur];
-        ++cur;
-
-        BaseSymbol *pNextSymbol = spUdtTypeSymbol->InternalGetSymbolSet()->InternalGetSymbol(nextChild);
-        if (pNextSymbol->InternalGetKind() != SvcSymbolBaseClass)
-        {
-            continue;
-        }
-
         BaseClassSymbol *pNextBaseClass = static_cast<BaseClassSymbol *>(pNextSymbol);
         ComPtr<BaseClassSymbol> spNextBaseClass = pNextBaseClass;
         BaseClassObject& baseClassFactory = ApiProvider::Get().GetBaseClassFactory();
@@ -1867,21 +2209,13 @@ std::experimental::generator<Object> DataObject::GetIterator(_In_ const Object /
     size_t cur = 0;
     for(;;)
     {
-        auto&& globalSymbols = spSymbolSet->InternalGetGlobalSymbols();
-        if (cur >= globalSymbols.size())
+        ComPtr<ISvcSymbol> spNextSymbol;
+        BaseSymbol *pNextSymbol = GetNextGlobal(spSymbolSet.Get(), SvcSymbolData, &cur, &spNextSymbol);
+        if (pNextSymbol == nullptr)
         {
             break;
         }
 
-        ULONG64 nextGlobal = globalSymbols[cur];
-        ++cur;
-
-        BaseSymbol *pNextSymbol = spSymbolSet->InternalGetSymbol(nextGlobal);
-        if (pNextSymbol->InternalGetKind() != SvcSymbolData)
-        {
-            continue;
-        }
-
         GlobalDataSymbol *pNextGlobalData = static_cast<GlobalDataSymbol *>(pNextSymbol);
         ComPtr<GlobalDataSymbol> spGlobalData = pNextGlobalData;
         GlobalDataObject& globalDataFactory = ApiProvider::Get().GetGlobalDataFactory();
@@ -2069,25 +2403,90 @@ std::experimental::generator<Object> FunctionsObject::GetIterator(_In_ const Obj
     size_t cur = 0;
     for(;;)
     {
-        auto&& globalSymbols = spSymbolSet->InternalGetGlobalSymbols();
-        if (cur >= globalSymbols.size())
+        ComPtr<ISvcSymbol> spNextSymbol;
+        BaseSymbol *pNextSymbol = GetNextGlobal(spSymbolSet.Get(), SvcSymbolFunction, &cur, &spNextSymbol);
+        if (pNextSymbol == nullptr)
         {
             break;
         }
 
-        ULONG64 nextGlobal = globalSymbols[cur];
-        ++cur;
+        FunctionSymbol *pNextFunction = static_cast<FunctionSymbol *>(pNextSymbol);
+        Object functionObject = BoxSymbol(pNextFunction);
+        co_yield functionObject;
+    }
+}
 
-        BaseSymbol *pNextSymbol = spSymbolSet->InternalGetSymbol(nextGlobal);
-        if (pNextSymbol->InternalGetKind() != SvcSymbolFunction)
+ULONG64 FunctionsObject::PropagateLiveRangesFromCallingConvention(_In_ const Object& /*functionsObject*/,
+                                                                  _In_ ComPtr<SymbolSet>& spSymbolSet,
+                                                                  _In_ std::optional<Object> options)
+{
+    size_t threadCount = 0;
+    bool useNativeDecoder = true;
+    if (options.has_value())
+    {
+        Object optionsObj = options.value();
+        std::optional<Object> threadCountKey = optionsObj.TryGetKeyValue(L"ThreadCount");
+        if (threadCountKey.has_value())
         {
-            continue;
+            threadCount = static_cast<size_t>((ULONG64)threadCountKey.value());
         }
 
-        FunctionSymbol *pNextFunction = static_cast<FunctionSymbol *>(pNextSymbol);
-        Object functionObject = BoxSymbol(pNextFunction);
-        co_yield functionObject;
+        std::optional<Object> useNativeDecoderKey = optionsObj.TryGetKeyValue(L"UseNativeDecoder");
+        if (useNativeDecoderKey.has_value())
+        {
+            useNativeDecoder = (bool)useNativeDecoderKey.value();
+        }
+    }
+
+    auto pManager = spSymbolSet->GetSymbolBuilderManager();
+
+    CallingConvention *pConvention;
+    CheckHr(pManager->GetDefaultCallingConvention(&pConvention));
+
+    //
+    // Progress is logged to the debugger after each batch.  A user interrupt (e.g.: ctrl-break) cancels the
+    // remainder of the run.  Anything already committed stays.
+    //
+    ComPtr<IDebugHostDiagnostics> spDiagnostics;
+    ComPtr<IDebugHostStatus> spStatus;
+    (void)GetHost()->QueryInterface(IID_PPV_ARGS(&spDiagnostics));
+    (void)GetHost()->QueryInterface(IID_PPV_ARGS(&spStatus));
+
+    auto progress = [&](_In_ size_t processed, _In_ size_t total)
+    {
+        if (spDiagnostics != nullptr)
+        {
+            wchar_t buf[128];
+            swprintf_s(buf, ARRAYSIZE(buf), L"Propagated live ranges for %Iu of %Iu functions\n", processed, total);
+            (void)spDiagnostics->LogW(ErrorClassWarning, buf);
+        }
+
+        bool interrupted = false;
+        if (spStatus != nullptr && FAILED(spStatus->PollUserInterrupt(&interrupted)))
+        {
+            interrupted = false;
+        }
+        return !interrupted;
+    };
+
+    ModuleRangeBuilder builder(spSymbolSet.Get(), pConvention, threadCount);
+    builder.SetUseNativeDecoder(useNativeDecoder);
+    ModuleRangeBuilder::Results results = builder.PropagateParameterRanges(progress);
+    if (results.Cancelled)
+    {
+        throw std::runtime_error("Live range propagation was cancelled");
+    }
+
+    if (spDiagnostics != nullptr)
+    {
+        wchar_t buf[128];
+        swprintf_s(buf, ARRAYSIZE(buf),
+                   L"Propagated live ranges for %Iu functions (%Iu failed, %Iu natively decoded) in %Iu block traversals\n",
+                   results.Propagated, results.Failed, results.NativelyDecoded, results.BlockTraversals);
+        (void)spDiagnostics->LogW(ErrorClassWarning, buf);
     }
+
+    return static_cast<ULONG64>(results.Propagated);
 }
 
 //*************************************************
@@ -2169,8 +2568,8 @@ Object ParametersObject::Add(_In_ const Object& /*parametersObject*/,
     return parameterFactory.CreateInstance(spParameter);
 }
 
-void ParametersObject::PropagateLiveRangesFromCallingConvention(_In_ const Object& /*parametersObject*/,
-                                                                _In_ ComPtr<FunctionSymbol>& spFunctionSymbol)
+Object ParametersObject::PropagateLiveRangesFromCallingConvention(_In_ const Object& /*parametersObject*/,
+                                                                  _In_ ComPtr<FunctionSymbol>& spFunctionSymbol)
 {
     //
     // Determine the platform default calling convention.  If we do not understand the calling convention,
@@ -2183,6 +2582,10 @@ void ParametersObject::PropagateLiveRangesFromCallingConvention(_In_ const Objec
 
     RangeBuilder builder;
     builder.PropagateParameterRanges(spFunctionSymbol.Get(), pConvention);
+
+    return Object::Create(HostContext(),
+                          L"BasicBlocks", static_cast<ULONG64>(builder.GetBasicBlockCount()),
+                          L"BlockTraversals", static_cast<ULONG64>(builder.GetBlockTraversalCount()));
 }
 
 std::experimental::generator<Object> ParametersObject::GetIterator(_In_ const Object /*parametersObject*/,
@@ -2196,21 +2599,13 @@ std::experimental::generator<Object> ParametersObject::GetIterator(_In_ const Ob
     size_t cur = 0;
     for(;;)
     {
-        auto&& children = spFunctionSymbol->InternalGetChildren();
-        if (cur >= children.size())
+        ComPtr<ISvcSymbol> spNextSymbol;
+        BaseSymbol *pNextSymbol = GetNextChild(spFunctionSymbol.Get(), SvcSymbolDataParameter, &cur, &spNextSymbol);
+        if (pNextSymbol == nullptr)
         {
             break;
         }
 
-        ULONG64 nextChild = children[cur];
-        ++cur;
-
-        BaseSymbol *pNextSymbol = spFunctionSymbol->InternalGetSymbolSet()->InternalGetSymbol(nextChild);
-        if (pNextSymbol->InternalGetKind() != SvcSymbolDataParameter)
-        {
-            continue;
-        }
-
         VariableSymbol *pNextParameter = static_cast<VariableSymbol *>(pNextSymbol);
         ComPtr<VariableSymbol> spNextParameter = pNextParameter;
         ParameterObject& parameterFactory = ApiProvider::Get().GetParameterFactory();
@@ -2228,6 +2623,7 @@ std::wstring ParametersObject::ToString(_In_ const Object& /*parametersObject*/,
     bool first = true;
     std::wstring str = L"(";
 
+    SymbolSetSharedLock lock(pSymbolSet->GetLock());
     auto&& children = spFunctionSymbol->InternalGetChildren();
     for(size_t i = 0; i < children.size(); ++i)
     {
@@ -2294,21 +2690,13 @@ std::experimental::generator<Object> LocalVariablesObject::GetIterator(_In_ cons
     size_t cur = 0;
     for(;;)
     {
-        auto&& children = spFunctionSymbol->InternalGetChildren();
-        if (cur >= children.size())
+        ComPtr<ISvcSymbol> spNextSymbol;
+        BaseSymbol *pNextSymbol = GetNextChild(spFunctionSymbol.Get(), SvcSymbolDataLocal, &cur, &spNextSymbol);
+        if (pNextSymbol == nullptr)
         {
             break;
         }
 
-        ULONG64 nextChild = children[cur];
-        ++cur;
-
-        BaseSymbol *pNextSymbol = spFunctionSymbol->InternalGetSymbolSet()->InternalGetSymbol(nextChild);
-        if (pNextSymbol->InternalGetKind() != SvcSymbolDataLocal)
-        {
-            continue;
-        }
-
         VariableSymbol *pNextLocalVariable = static_cast<VariableSymbol *>(pNextSymbol);
         ComPtr<VariableSymbol> spNextLocalVariable = pNextLocalVariable;
         LocalVariableObject& localVariableFactory = ApiProvider::Get().GetLocalVariableFactory();
@@ -2453,17 +2841,21 @@ std::experimental::generator<Object> LiveRangesObject::GetIterator(_In_ const Ob
     size_t cur = 0;
     for(;;)
     {
-        auto&& liveRanges = spVariableSymbol->InternalGetLiveRanges();
-        if (cur >= liveRanges.size())
+        ULONG64 liveRangeId;
         {
-            break;
-        }
+            SymbolSetSharedLock lock(spVariableSymbol->InternalGetSymbolSet()->GetLock());
+            auto&& liveRanges = spVariableSymbol->InternalGetLiveRanges();
+            if (cur >= liveRanges.size())
+            {
+                break;
+            }
 
-        VariableSymbol::LiveRange *pLiveRange = liveRanges[cur];
-        ++cur;
+            liveRangeId = liveRanges[cur]->UniqueId;
+            ++cur;
+        }
 
         LiveRangeObject& liveRangeFactory = ApiProvider::Get().GetLiveRangeFactory();
-        Object liveRangeObj = liveRangeFactory.CreateInstance( { spVariableSymbol, pLiveRange->UniqueId } );
+        Object liveRangeObj = liveRangeFactory.CreateInstance( { spVariableSymbol, liveRangeId } );
         co_yield liveRangeObj;
     }
 }
@@ -2604,14 +2996,18 @@ std::experimental::generator<Object> AddressRangesObject::GetIterator(_In_ const
     size_t cur = 0;
     for(;;)
     {
-        auto&& ranges = spFunctionSymbol->InternalGetAddressRanges();
-        if (cur >= ranges.size())
+        std::pair<ULONG64, ULONG64> range;
         {
-            break;
-        }
+            SymbolSetSharedLock lock(spFunctionSymbol->InternalGetSymbolSet()->GetLock());
+            auto&& ranges = spFunctionSymbol->InternalGetAddressRanges();
+            if (cur >= ranges.size())
+            {
+                break;
+            }
 
-        std::pair<ULONG64, ULONG64> range = ranges[cur];
-        ++cur;
+            range = ranges[cur];
+            ++cur;
+        }
 
         AddressRangeObject& addressRangeFactory = ApiProvider::Get().GetAddressRangeFactory();
         Object addressRangeObj = addressRangeFactory.CreateInstance(range);
@@ -2626,6 +3022,7 @@ std::wstring AddressRangesObject::ToString(_In_ const Object& /*functionObject*/
     std::wstring displayString = L"";
     bool first = true;
 
+    SymbolSetSharedLock lock(spFunctionSymbol->InternalGetSymbolSet()->GetLock());
     auto&& ranges = spFunctionSymbol->InternalGetAddressRanges();
     for(auto&& range : ranges)
     {
@@ -2687,21 +3084,13 @@ std::experimental::generator<Object> PublicsObject::GetIterator(_In_ const Objec
     size_t cur = 0;
     for(;;)
     {
-        auto&& globalSymbols = spSymbolSet->InternalGetGlobalSymbols();
-        if (cur >= globalSymbols.size())
+        ComPtr<ISvcSymbol> spNextSymbol;
+        BaseSymbol *pNextSymbol = GetNextGlobal(spSymbolSet.Get(), SvcSymbolPublic, &cur, &spNextSymbol);
+        if (pNextSymbol == nullptr)
         {
             break;
         }
 
-        ULONG64 nextGlobal = globalSymbols[cur];
-        ++cur;
-
-        BaseSymbol *pNextSymbol = spSymbolSet->InternalGetSymbol(nextGlobal);
-        if (pNextSymbol->InternalGetKind() != SvcSymbolPublic)
-        {
-            continue;
-        }
-
         PublicSymbol *pNextPublic = static_cast<PublicSymbol *>(pNextSymbol);
         Object publicObject = BoxSymbol(pNextPublic);
         co_yield publicObject;
@@ -2923,11 +3312,41 @@ SymbolSetObject::SymbolSetObject() :
     AddReadOnlyProperty(L"Functions", this, &SymbolSetObject::GetFunctions,
                         Metadata(L"Help", DeferredResourceString { SYMBOLBUILDER_IDS_SYMBOLSET_FUNCTIONS }));
 
+    AddReadOnlyProperty(L"ImageSharing", this, &SymbolSetObject::GetImageSharing,
+                        Metadata(L"Help", DeferredResourceString { SYMBOLBUILDER_IDS_SYMBOLSET_IMAGESHARING }));
+
+    AddReadOnlyProperty(L"ImportProgress", this, &SymbolSetObject::GetImportProgress,
+                        Metadata(L"Help", DeferredResourceString { SYMBOLBUILDER_IDS_SYMBOLSET_IMPORTPROGRESS }));
+
+    AddReadOnlyProperty(L"NameStatistics", this, &SymbolSetObject::GetNameStatistics,
+                        Metadata(L"Help", DeferredResourceString { SYMBOLBUILDER_IDS_SYMBOLSET_NAMESTATISTICS }));
+
     AddReadOnlyProperty(L"Publics", this, &SymbolSetObject::GetPublics,
                         Metadata(L"Help", DeferredResourceString { SYMBOLBUILDER_IDS_SYMBOLSET_PUBLICS }));
 
     AddReadOnlyProperty(L"Types", this, &SymbolSetObject::GetTypes,
                         Metadata(L"Help", DeferredResourceString { SYMBOLBUILDER_IDS_SYMBOLSET_TYPES }));
+
+    AddMethod(L"BeginBatch", this, &SymbolSetObject::BeginBatch,
+              Metadata(L"Help", DeferredResourceString { SYMBOLBUILDER_IDS_SYMBOLSET_BEGINBATCH }));
+
+    AddMethod(L"CommitBatch", this, &SymbolSetObject::CommitBatch,
+              Metadata(L"Help", DeferredResourceString { SYMBOLBUILDER_IDS_SYMBOLSET_COMMITBATCH }));
+
+    AddMethod(L"Batch", this, &SymbolSetObject::Batch,
+              Metadata(L"Help", DeferredResourceString { SYMBOLBUILDER_IDS_SYMBOLSET_BATCH }));
+
+    AddMethod(L"CancelImport", this, &SymbolSetObject::CancelImport,
+              Metadata(L"Help", DeferredResourceString { SYMBOLBUILDER_IDS_SYMBOLSET_CANCELIMPORT }));
+
+    AddMethod(L"FindSymbols", this, &SymbolSetObject::FindSymbols,
+              Metadata(L"Help", DeferredResourceString { SYMBOLBUILDER_IDS_SYMBOLSET_FINDSYMBOLS }));
+
+    AddMethod(L"MeasureLookups", this, &SymbolSetObject::MeasureLookups,
+              Metadata(L"Help", DeferredResourceString { SYMBOLBUILDER_IDS_SYMBOLSET_MEASURELOOKUPS }));
+
+    AddMethod(L"SaveSnapshot", this, &SymbolSetObject::SaveSnapshot,
+              Metadata(L"Help", DeferredResourceString { SYMBOLBUILDER_IDS_SYMBOLSET_SAVESNAPSHOT }));
 }
 
 TypesObject::TypesObject() :
@@ -3152,6 +3571,9 @@ FunctionsObject::FunctionsObject() :
               Metadata(L"Help", DeferredResourceString { SYMBOLBUILDER_IDS_FUNCTIONS_CREATE },
                        L"PreferShow", true));
 
+    AddMethod(L"PropagateLiveRangesFromCallingConvention", this, &FunctionsObject::PropagateLiveRangesFromCallingConvention,
+              Metadata(L"Help", DeferredResourceString { SYMBOLBUILDER_IDS_FUNCTIONS_PROPAGATELIVERANGESFROMCALLINGCONVENTION }));
+
     AddGeneratorFunction(this, &FunctionsObject::GetIterator);
 }
 
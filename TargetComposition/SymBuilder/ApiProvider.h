@@ -87,7 +87,8 @@ public:
 //
 // Represents one of our symbol set objects boxed into the data model.
 //
-class SymbolSetObject : public TypedInstanceModel<ComPtr<SymbolSet>>
+class SymbolSetObject : public TypedInstanceModel<ComPtr<SymbolSet>>,
+                        public SymbolObjectHelpers
 {
 public:
 
@@ -95,6 +96,80 @@ public:
 
 private:
 
+    // BeginBatch():
+    //
+    // Bound API which opens a batch on the symbol set.  Layout and cache invalidation for changes made within
+    // the batch are deferred until the matching CommitBatch call.
+    //
+    void BeginBatch(_In_ const Object& symbolSetObject, _In_ ComPtr<SymbolSet>& spSymbolSet);
+
+    // CommitBatch():
+    //
+    // Bound API which commits a batch opened by BeginBatch.
+    //
+    void CommitBatch(_In_ const Object& symbolSetObject, _In_ ComPtr<SymbolSet>& spSymbolSet);
+
+    // Batch():
+    //
+    // Bound API which calls a script callback with a batch open on the symbol set.  The batch is committed
+    // even if the callback fails.
+    //
+    void Batch(_In_ const Object& symbolSetObject, _In_ ComPtr<SymbolSet>& spSymbolSet, _In_ Object callback);
+
+    // FindSymbols():
+    //
+    // Bound API which returns the global symbols whose qualified name matches a wildcard pattern (or a
+    // regular expression).
+    //
+    std::experimental::generator<Object> FindSymbols(_In_ const Object symbolSetObject,
+                                                     _In_ ComPtr<SymbolSet>& spSymbolSet,
+                                                     _In_ std::wstring pattern,
+                                                     _In_ std::optional<bool> isRegex);
+
+    // MeasureLookups():
+    //
+    // Bound API which looks up every global symbol of the symbol set by name on a number of threads at once and
+    // returns how long it took.
+    //
+    Object MeasureLookups(_In_ const Object& symbolSetObject,
+                          _In_ ComPtr<SymbolSet>& spSymbolSet,
+                          _In_ ULONG64 threadCount,
+                          _In_ std::optional<ULONG64> rounds);
+
+    // CancelImport():
+    //
+    // Bound API which cancels a background import of the symbol set.
+    //
+    void CancelImport(_In_ const Object& symbolSetObject, _In_ ComPtr<SymbolSet>& spSymbolSet);
+
+    // SaveSnapshot():
+    //
+    // Bound API which writes a binary snapshot of the symbol set to a file.  The snapshot can be reloaded in a
+    // later session through the 'SnapshotFile' option to CreateSymbols.
+    //
+    void SaveSnapshot(_In_ const Object& symbolSetObject,
+                      _In_ ComPtr<SymbolSet>& spSymbolSet,
+                      _In_ std::wstring fileName);
+
+    // GetImportProgress():
+    //
+    // Property accessor which gets the progress of a background import of the symbol set.
+    //
+    Object GetImportProgress(_In_ const Object& /*symbolSetObject*/, _In_ ComPtr<SymbolSet>& spSymbolSet);
+
+    // GetNameStatistics():
+    //
+    // Property accessor which gets statistics about the pool of names used by the symbol set.
+    //
+    Object GetNameStatistics(_In_ const Object& /*symbolSetObject*/, _In_ ComPtr<SymbolSet>& spSymbolSet);
+
+    // GetImageSharing():
+    //
+    // Property accessor which gets what the symbol set shares with the symbol sets for the same module image in
+    // other processes.
+    //
+    Object GetImageSharing(_In_ const Object& /*symbolSetObject*/, _In_ ComPtr<SymbolSet>& spSymbolSet);
+
     // GetTypes():
     //
     // Property accessor which gets the types on this symbol set.
@@ -782,6 +857,16 @@ private:
                   _In_ size_t argCount,                 // [qualifiedName], [parameter]...
                   _In_reads_(argCount) Object *pArgs);
 
+    // PropagateLiveRangesFromCallingConvention():
+    //
+    // Does what Parameters.PropagateLiveRangesFromCallingConvention does for every function in the symbol set
+    // with the analysis spread across multiple threads.  The options object may supply 'ThreadCount'.  This
+    // returns the number of functions whose parameter live ranges were propagated.
+    //
+    ULONG64 PropagateLiveRangesFromCallingConvention(_In_ const Object& functionsObject,
+                                                     _In_ ComPtr<SymbolSet>& spSymbolSet,
+                                                     _In_ std::optional<Object> options);
+
     // GetIterator():
     //
     // Bound generator for iterating over functions within a symbol set.
@@ -872,10 +957,11 @@ private:
     //
     // Takes the list of parameters which have been defined and uses knowledge of the calling convention
     // and the disassembler to walk the code of the function and determine where the parameters are at 
-    // at each given instruciton and add appropriate live ranges.
+    // at each given instruciton and add appropriate live ranges.  Returns the number of basic blocks in the
+    // function and the number of times they were walked.
     //
-    void PropagateLiveRangesFromCallingConvention(_In_ const Object& parametersObject,
-                                                  _In_ ComPtr<FunctionSymbol>& spFunctionSymbol);
+    Object PropagateLiveRangesFromCallingConvention(_In_ const Object& parametersObject,
+                                                    _In_ ComPtr<FunctionSymbol>& spFunctionSymbol);
 
     // GetIterator():
     //
@@ -32,6 +32,16 @@
 #define SYMBOLBUILDER_IDS_SYMBOLSET_DATA 201
 #define SYMBOLBUILDER_IDS_SYMBOLSET_FUNCTIONS 202
 #define SYMBOLBUILDER_IDS_SYMBOLSET_PUBLICS 203
+#define SYMBOLBUILDER_IDS_SYMBOLSET_BEGINBATCH 204
+#define SYMBOLBUILDER_IDS_SYMBOLSET_COMMITBATCH 205
+#define SYMBOLBUILDER_IDS_SYMBOLSET_FINDSYMBOLS 206
+#define SYMBOLBUILDER_IDS_SYMBOLSET_SAVESNAPSHOT 207
+#define SYMBOLBUILDER_IDS_SYMBOLSET_IMPORTPROGRESS 208
+#define SYMBOLBUILDER_IDS_SYMBOLSET_CANCELIMPORT 209
+#define SYMBOLBUILDER_IDS_SYMBOLSET_BATCH 210
+#define SYMBOLBUILDER_IDS_SYMBOLSET_NAMESTATISTICS 211
+#define SYMBOLBUILDER_IDS_SYMBOLSET_IMAGESHARING 212
+#define SYMBOLBUILDER_IDS_SYMBOLSET_MEASURELOOKUPS 213
 
 //
 // <SymbolSet>.Types:
@@ -153,6 +163,7 @@
 //
 
 #define SYMBOLBUILDER_IDS_FUNCTIONS_CREATE 2200
+#define SYMBOLBUILDER_IDS_FUNCTIONS_PROPAGATELIVERANGESFROMCALLINGCONVENTION 2201
 
 //
 // <Function>.*
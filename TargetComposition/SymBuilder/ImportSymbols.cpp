@@ -110,7 +110,10 @@ HRESULT SymbolImporter::ImportFailure(_In_ HRESULT hr, _In_opt_ PCWSTR /*pwszImp
 
 HRESULT SymbolImporter_DbgHelp::ConnectToSource()
 {
-    HRESULT hr = InternalConnectToSource();
+    HRESULT hr = ConvertException([&](){
+        std::lock_guard<std::recursive_mutex> dbgHelpLock(GetDbgHelpLock());
+        return InternalConnectToSource();
+    });
     if (FAILED(hr))
     {
         DisconnectFromSource();
@@ -232,9 +235,18 @@ HRESULT SymbolImporter_DbgHelp::InternalConnectToSource()
 
 void SymbolImporter_DbgHelp::DisconnectFromSource()
 {
+    //
+    // The background import uses the DbgHelp session.  It must be gone before the session is.
+    //
+    CancelBackgroundImport();
+
     if (m_symHandle != NULL)
     {
-        SymCleanup(m_symHandle);
+        (void)ConvertException([&](){
+            std::lock_guard<std::recursive_mutex> dbgHelpLock(GetDbgHelpLock());
+            SymCleanup(m_symHandle);
+            return S_OK;
+        });
         m_symHandle = NULL;
         m_importerInfo.clear();
     }
@@ -824,16 +836,16 @@ HRESULT SymbolImporter_DbgHelp::ImportUDT(_In_ ULONG symIndex, _Out_ ULONG64 *pB
     localstr_ptr spSymName(pSymName);
 
     ULONG64 udtSize;
-    ULONG childCount;
-    if (!SymGetTypeInfo(m_symHandle, m_moduleBase, symIndex, TI_GET_LENGTH, &udtSize) ||
-        !SymGetTypeInfo(m_symHandle, m_moduleBase, symIndex, TI_GET_CHILDRENCOUNT, &childCount))
+    if (!SymGetTypeInfo(m_symHandle, m_moduleBase, symIndex, TI_GET_LENGTH, &udtSize))
     {
         return ImportFailure(E_FAIL);
     }
 
     //
     // Now that we have some basic information about the UDT, go and create the shell of it in the symbol
-    // builder and then copy over base classes, fields, and any other data we wish to import one by one.
+    // builder.  Many queries (e.g.: looking up a pointer to the UDT) never need anything more than its name and
+    // size.  The base classes, fields, and any other data we wish to import are copied over by ImportMembers
+    // the first time the UDT's members are enumerated or it is laid out within another type.
     //
     ComPtr<UdtTypeSymbol> spUdt;
     hr = MakeAndInitialize<UdtTypeSymbol>(&spUdt, m_pOwningSet, parentId, pSymName, nullptr);
@@ -849,10 +861,77 @@ HRESULT SymbolImporter_DbgHelp::ImportUDT(_In_ ULONG symIndex, _Out_ ULONG64 *pB
     //
     IfFailedReturn(ConvertException([&]()
     {
+        std::lock_guard<std::mutex> importedIndexLock(m_importedIndexLock);
         m_importedIndexMap.insert({ symIndex, spUdt->InternalGetId() });
+        m_deferredUdts.insert({ spUdt->InternalGetId(), symIndex });
         return S_OK;
     }));
 
+    spUdt->InternalDeferMembers(udtSize);
+
+    *pBuilderId = spUdt->InternalGetId();
+    return S_OK;
+}
+
+HRESULT SymbolImporter_DbgHelp::ImportMembers(_In_ ULONG64 udtBuilderId)
+{
+    auto it = m_deferredUdts.find(udtBuilderId);
+    if (it == m_deferredUdts.end())
+    {
+        return S_FALSE;
+    }
+
+    ULONG symIndex = it->second;
+    m_deferredUdts.erase(it);
+
+    //
+    // The UDT may have been deleted since it was imported.
+    //
+    BaseSymbol *pSymbol = m_pOwningSet->InternalGetSymbol(udtBuilderId);
+    if (pSymbol == nullptr)
+    {
+        return S_FALSE;
+    }
+
+    SvcSymbolTypeKind typeKind;
+    if (pSymbol->InternalGetKind() != SvcSymbolType ||
+        FAILED(static_cast<BaseTypeSymbol *>(pSymbol)->GetTypeKind(&typeKind)) ||
+        typeKind != SvcSymbolTypeUDT)
+    {
+        return E_UNEXPECTED;
+    }
+
+    //
+    // This may happen at type query time as part of the *TARGET COMPOSITION* layer.  We *ABSOLUTELY CANNOT*
+    // send a cache invalidation at this time.  Filling in the members of a type which already exists is not
+    // a change anyone else needs to know about in any case.
+    //
+    bool cacheInvalidationDisabled = m_pOwningSet->IsCacheInvalidationDisabled();
+    m_pOwningSet->SetCacheInvalidationDisable(true);
+
+    HRESULT hr = ConvertException([&](){
+        std::lock_guard<std::recursive_mutex> dbgHelpLock(GetDbgHelpLock());
+        return ImportUDTMembers(symIndex, static_cast<UdtTypeSymbol *>(pSymbol));
+    });
+
+    m_pOwningSet->SetCacheInvalidationDisable(cacheInvalidationDisabled);
+    return hr;
+}
+
+HRESULT SymbolImporter_DbgHelp::ImportUDTMembers(_In_ ULONG symIndex, _In_ UdtTypeSymbol *pUdt)
+{
+    ULONG childCount;
+    if (!SymGetTypeInfo(m_symHandle, m_moduleBase, symIndex, TI_GET_CHILDRENCOUNT, &childCount))
+    {
+        return ImportFailure(E_FAIL);
+    }
+
+    //
+    // All of this happens within a batch so that the UDT is laid out once after its last member is added
+    // rather than once per member.
+    //
+    SymbolSetBatch batch(m_pOwningSet);
+
     std::unique_ptr<char []> spBuf(new char[sizeof(TI_FINDCHILDREN_PARAMS) + sizeof(ULONG) * childCount]);
     TI_FINDCHILDREN_PARAMS *pChildQuery = reinterpret_cast<TI_FINDCHILDREN_PARAMS *>(spBuf.get());
 
@@ -882,7 +961,7 @@ HRESULT SymbolImporter_DbgHelp::ImportUDT(_In_ ULONG symIndex, _Out_ ULONG64 *pB
             }
 
             ULONG64 childBuilderId;
-            HRESULT hrChild = ImportSymbol(childIndex, &childBuilderId, spUdt->InternalGetId());
+            HRESULT hrChild = ImportSymbol(childIndex, &childBuilderId, pUdt->InternalGetId());
             if (FAILED(hrChild))
             {
                 //
@@ -897,7 +976,7 @@ HRESULT SymbolImporter_DbgHelp::ImportUDT(_In_ ULONG symIndex, _Out_ ULONG64 *pB
         }
     }
 
-    *pBuilderId = spUdt->InternalGetId();
+    IfFailedReturn(batch.Commit());
     return S_OK;
 }
 
@@ -933,6 +1012,7 @@ HRESULT SymbolImporter_DbgHelp::ImportFunctionType(_In_ ULONG symIndex, _Out_ UL
     //
     IfFailedReturn(ConvertException([&]()
     {
+        std::lock_guard<std::mutex> importedIndexLock(m_importedIndexLock);
         m_importedIndexMap.insert({ symIndex, spFunctionType->InternalGetId() });
         return S_OK;
     }));
@@ -1388,6 +1468,7 @@ HRESULT SymbolImporter_DbgHelp::ImportSymbol(_In_ ULONG symIndex, _Out_ ULONG64
             auto itpost = m_importedIndexMap.find(symIndex);
             if (itpost == m_importedIndexMap.end())
             {
+                std::lock_guard<std::mutex> importedIndexLock(m_importedIndexLock);
                 m_importedIndexMap.insert( { symIndex, builderId });
             }
             else
@@ -1413,38 +1494,12 @@ HRESULT SymbolImporter_DbgHelp::ImportSymbol(_In_ ULONG symIndex, _Out_ ULONG64
 bool SymbolImporter_DbgHelp::LegacyReadMemory(_Inout_ IMAGEHLP_CBA_READ_MEMORY *pReadMemory)
 {
     auto pOwningProcess = m_pOwningSet->GetOwningProcess();
-    auto pVirtualMemory = pOwningProcess->GetVirtualMemory();
-    bool isKernel = pOwningProcess->IsKernel();
-    ULONG64 processKey = pOwningProcess->GetProcessKey();
-
-    //
-    // If we have a generalized view of the kernel and not a specific "process context", we can go and ask
-    // for the generalized kernel address context in which to perform any memory reads.
-    //
-    ComPtr<ISvcAddressContext> spAddrCtx;
-    if (isKernel && processKey == 0)
-    {
-        if (FAILED(pOwningProcess->GetSymbolBuilderManager()->GetKernelAddressContext(&spAddrCtx)))
-        {
-            return false;
-        }
-    }
-    else
-    {
-        ComPtr<ISvcProcess> spProcess;
-        if (FAILED(pOwningProcess->GetSymbolBuilderManager()->ProcessKeyToProcess(processKey, &spProcess)) ||
-            FAILED(spProcess.As(&spAddrCtx)))
-        {
-            return false;
-        }
-    }
 
     ULONG64 bytesRead;
-    HRESULT hr = pVirtualMemory->ReadMemory(spAddrCtx.Get(),
-                                            pReadMemory->addr,
-                                            pReadMemory->buf,
-                                            pReadMemory->bytes,
-                                            &bytesRead);
+    HRESULT hr = pOwningProcess->ReadVirtualMemory(pReadMemory->addr,
+                                                   pReadMemory->buf,
+                                                   pReadMemory->bytes,
+                                                   &bytesRead);
 
     if (SUCCEEDED(hr))
     {
@@ -1461,10 +1516,46 @@ bool SymbolImporter_DbgHelp::LegacySymbolEnumerate(_In_ SymbolQueryInformation *
 {
     auto fn = [&]()
     {
-        auto it = m_importedIndexMap.find(pSymInfo->Index);
-        if (it != m_importedIndexMap.end())
+        //
+        // Returning a failure stops the enumeration.  A cancelled background import need not see the rest.  A
+        // background enumeration also stops (after seeing at least a chunk of new symbols) when a query is
+        // waiting to import, since the query cannot call into DbgHelp until the enumeration returns.  The next
+        // pass skips what this one saw.
+        //
+        if (pQueryInfo->CollectedIndices != nullptr)
         {
-            return S_OK;
+            if (m_backgroundCancel)
+            {
+                return E_ABORT;
+            }
+
+            if (pQueryInfo->SeenCount < pQueryInfo->SkipCount)
+            {
+                ++pQueryInfo->SeenCount;
+                return S_OK;
+            }
+
+            if (pQueryInfo->SeenCount - pQueryInfo->SkipCount >= BackgroundEnumerationChunkSize &&
+                m_pOwningSet->HasForegroundImports())
+            {
+                pQueryInfo->Interrupted = true;
+                return E_ABORT;
+            }
+
+            ++pQueryInfo->SeenCount;
+        }
+
+        //
+        // A background enumeration gets here without holding the symbol set.  A query may be adding to the map
+        // at the same time.
+        //
+        {
+            std::lock_guard<std::mutex> importedIndexLock(m_importedIndexLock);
+            auto it = m_importedIndexMap.find(pSymInfo->Index);
+            if (it != m_importedIndexMap.end())
+            {
+                return S_OK;
+            }
         }
 
         //
@@ -1475,6 +1566,12 @@ bool SymbolImporter_DbgHelp::LegacySymbolEnumerate(_In_ SymbolQueryInformation *
             return S_OK;
         }
 
+        if (pQueryInfo->CollectedIndices != nullptr)
+        {
+            pQueryInfo->CollectedIndices->push_back(pSymInfo->Index);
+            return S_OK;
+        }
+
         ULONG64 importedId;
         (void)ImportSymbol(pSymInfo, &importedId);
 
@@ -1495,8 +1592,9 @@ HRESULT SymbolImporter_DbgHelp::ImportForOffsetQuery(_In_ SvcSymbolKind searchKi
     //
     // This is happening at type query time as part of the *TARGET COMPOSITION* layer.  We 
     // *ABSOLUTELY CANNOT* send a cache invalidation at this time.  To do so might flush caches that
-    // are in the middle of use!
+    // are in the middle of use!  This may run within another import which has done the same.
     //
+    bool cacheInvalidationDisabled = m_pOwningSet->IsCacheInvalidationDisabled();
     m_pOwningSet->SetCacheInvalidationDisable(true);
 
     auto fn = [&]()
@@ -1518,6 +1616,8 @@ HRESULT SymbolImporter_DbgHelp::ImportForOffsetQuery(_In_ SvcSymbolKind searchKi
             return S_FALSE;
         }
 
+        std::lock_guard<std::recursive_mutex> dbgHelpLock(GetDbgHelpLock());
+
         ULONG64 displacement;
         if (!SymFromAddrW(m_symHandle,
                           m_moduleBase + offset,
@@ -1536,10 +1636,31 @@ HRESULT SymbolImporter_DbgHelp::ImportForOffsetQuery(_In_ SvcSymbolKind searchKi
     };
     HRESULT hr = ConvertException(fn);
 
-    m_pOwningSet->SetCacheInvalidationDisable(false);
+    m_pOwningSet->SetCacheInvalidationDisable(cacheInvalidationDisabled);
     return hr;
 }
 
+bool SymbolImporter_DbgHelp::IsOffsetQueryImported(_In_ SvcSymbolKind /*searchKind*/,
+                                                   _In_ ULONG64 offset)
+{
+    return m_fullGlobalImport || m_addressQueries.find(offset) != m_addressQueries.end();
+}
+
+bool SymbolImporter_DbgHelp::IsNameQueryImported(_In_ SvcSymbolKind /*searchKind*/,
+                                                 _In_opt_ PCWSTR pwszName)
+{
+    //
+    // A query for everything is never imported by name (see ImportForNameQuery).  Looking up the name may throw
+    // (it is copied to search the set of names queried).  That is left to the caller.
+    //
+    if (pwszName == nullptr || m_fullGlobalImport)
+    {
+        return true;
+    }
+
+    return m_nameQueries.find(pwszName) != m_nameQueries.end();
+}
+
 HRESULT SymbolImporter_DbgHelp::ImportForNameQuery(_In_ SvcSymbolKind searchKind,
                                                    _In_opt_ PCWSTR pwszName)
 {
@@ -1550,6 +1671,9 @@ HRESULT SymbolImporter_DbgHelp::ImportForNameQuery(_In_ SvcSymbolKind searchKind
     //              a global query.  It prevents a number of huge performance pains around checking
     //              nested types or our lack of RegEx support.
     //
+    //              Wildcard masks (e.g.: "prefix*") are fine.  DbgHelp imports what matches the mask and the
+    //              symbol set answers the pattern from its name trie.
+    //
     if (pwszName == nullptr)
     {
         return E_NOTIMPL;
@@ -1558,8 +1682,9 @@ HRESULT SymbolImporter_DbgHelp::ImportForNameQuery(_In_ SvcSymbolKind searchKind
     //
     // This is happening at type query time as part of the *TARGET COMPOSITION* layer.  We 
     // *ABSOLUTELY CANNOT* send a cache invalidation at this time.  To do so might flush caches that
-    // are in the middle of use!
+    // are in the middle of use!  This may run within another import which has done the same.
     //
+    bool cacheInvalidationDisabled = m_pOwningSet->IsCacheInvalidationDisabled();
     m_pOwningSet->SetCacheInvalidationDisable(true);
 
     auto fn = [&]()
@@ -1586,6 +1711,8 @@ HRESULT SymbolImporter_DbgHelp::ImportForNameQuery(_In_ SvcSymbolKind searchKind
             }
         }
 
+        std::lock_guard<std::recursive_mutex> dbgHelpLock(GetDbgHelpLock());
+
         SymbolQueryCallbackInformation info { };
         info.Query.SearchKind = searchKind;
         info.Query.SearchMask = pwszName;
@@ -1631,7 +1758,275 @@ HRESULT SymbolImporter_DbgHelp::ImportForNameQuery(_In_ SvcSymbolKind searchKind
     };
     HRESULT hr = ConvertException(fn);
 
-    m_pOwningSet->SetCacheInvalidationDisable(false);
+    m_pOwningSet->SetCacheInvalidationDisable(cacheInvalidationDisabled);
+    return hr;
+}
+
+//*************************************************
+// Background Import:
+//
+
+HRESULT SymbolImporter_DbgHelp::StartBackgroundImport()
+{
+    if (m_symHandle == NULL)
+    {
+        return E_UNEXPECTED;
+    }
+
+    if (m_backgroundState != BackgroundImportState::NotStarted)
+    {
+        return S_FALSE;
+    }
+
+    m_backgroundState = BackgroundImportState::Enumerating;
+
+    //
+    // We cannot let a C++ exception escape.
+    //
+    auto fn = [&]()
+    {
+        m_backgroundThread = std::thread(&SymbolImporter_DbgHelp::BackgroundImportThread, this);
+        return S_OK;
+    };
+    HRESULT hr = ConvertException(fn);
+
+    if (FAILED(hr))
+    {
+        m_backgroundState = BackgroundImportState::NotStarted;
+    }
+    return hr;
+}
+
+void SymbolImporter_DbgHelp::CancelBackgroundImport()
+{
+    m_backgroundCancel = true;
+    if (m_backgroundThread.joinable())
+    {
+        m_backgroundThread.join();
+    }
+}
+
+HRESULT SymbolImporter_DbgHelp::GetBackgroundImportProgress(_Out_ BackgroundImportProgress *pProgress)
+{
+    pProgress->State = m_backgroundState;
+    pProgress->SymbolsProcessed = m_backgroundProcessed;
+    pProgress->SymbolsTotal = m_backgroundTotal;
+    return S_OK;
+}
+
+HRESULT SymbolImporter_DbgHelp::GetImportState(_Out_ ImportState *pState)
+{
+    return ConvertException([&](){
+        std::lock_guard<std::mutex> importedIndexLock(m_importedIndexLock);
+        pState->FullGlobalImport = m_fullGlobalImport;
+        pState->NameQueries = m_nameQueries;
+        pState->AddressQueries = m_addressQueries;
+        pState->ImportedSymbols = m_importedIndexMap;
+        pState->DeferredUdts = m_deferredUdts;
+        return S_OK;
+    });
+}
+
+HRESULT SymbolImporter_DbgHelp::SetImportState(_In_ ImportState const& state)
+{
+    //
+    // The background import (if any) has not been started yet and nothing else touches these before the first
+    // import.
+    //
+    return ConvertException([&](){
+        std::lock_guard<std::mutex> importedIndexLock(m_importedIndexLock);
+        m_fullGlobalImport = state.FullGlobalImport;
+        m_nameQueries = state.NameQueries;
+        m_addressQueries = state.AddressQueries;
+        m_importedIndexMap = state.ImportedSymbols;
+        m_deferredUdts = state.DeferredUdts;
+        return S_OK;
+    });
+}
+
+void SymbolImporter_DbgHelp::BackgroundImportThread()
+{
+    HRESULT hr = ConvertException([&](){
+        return BackgroundImport();
+    });
+
+    if (hr == E_ABORT)
+    {
+        m_backgroundState = BackgroundImportState::Cancelled;
+    }
+    else if (FAILED(hr))
+    {
+        m_backgroundState = BackgroundImportState::Failed;
+    }
+    else
+    {
+        m_backgroundState = BackgroundImportState::Completed;
+    }
+}
+
+void SymbolImporter_DbgHelp::YieldToForegroundImports()
+{
+    while (m_pOwningSet->HasForegroundImports() && !m_backgroundCancel)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+}
+
+HRESULT SymbolImporter_DbgHelp::BackgroundImport()
+{
+    HRESULT hr = S_OK;
+
+    //
+    // Find everything DbgHelp has for the module.  This only collects indices.  It does not change the symbol set
+    // and so does not hold it: lookups carry on while DbgHelp walks the module.  An enumeration holds DbgHelp for
+    // as long as it runs and cannot be picked up again part way through.  Instead, it stops when a query is
+    // waiting to import (see LegacySymbolEnumerate) and is started again once the query is done, skipping as many
+    // symbols as the earlier passes saw.  This relies on DbgHelp enumerating a module in the same order each time.
+    // A symbol seen twice is harmless (the indices are made unique below).
+    //
+    // 'indices' is only ever touched on this thread (DbgHelp calls back on the thread which made the call).  The
+    // callback's check of what has already been imported takes the importer's own lock on that table.
+    //
+    std::vector<ULONG> indices;
+    for (SvcSymbolKind searchKind : { SvcSymbol, SvcSymbolType })
+    {
+        size_t seen = 0;
+        for(;;)
+        {
+            YieldToForegroundImports();
+            if (m_backgroundCancel)
+            {
+                return E_ABORT;
+            }
+
+            std::lock_guard<std::recursive_mutex> dbgHelpLock(GetDbgHelpLock());
+
+            SymbolQueryCallbackInformation info { };
+            info.Query.SearchKind = searchKind;
+            info.Query.SearchMask = L"*";
+            info.Query.MaskIsRegEx = false;
+            info.Query.QueryOffset = 0;
+            info.Query.CollectedIndices = &indices;
+            info.Query.SkipCount = seen;
+            info.Importer = this;
+
+            //
+            // A module may well have nothing of one kind (e.g.: export symbols have no types).  That is not a
+            // failure of the import.
+            //
+            if (searchKind == SvcSymbolType)
+            {
+                (void)SymEnumTypesByNameW(m_symHandle,
+                                          m_moduleBase,
+                                          L"*",
+                                          &SymbolImporter_DbgHelp::LegacySymbolEnumerateBridge,
+                                          reinterpret_cast<void *>(&info));
+            }
+            else
+            {
+                (void)SymEnumSymbolsExW(m_symHandle,
+                                        m_moduleBase,
+                                        L"*",
+                                        &SymbolImporter_DbgHelp::LegacySymbolEnumerateBridge,
+                                        reinterpret_cast<void *>(&info),
+                                        SYMENUM_OPTIONS_DEFAULT);
+            }
+
+            if (!info.Query.Interrupted)
+            {
+                break;
+            }
+            seen = info.Query.SeenCount;
+        }
+    }
+
+    if (m_backgroundCancel)
+    {
+        return E_ABORT;
+    }
+
+    std::sort(indices.begin(), indices.end());
+    indices.erase(std::unique(indices.begin(), indices.end()), indices.end());
+
+    m_backgroundTotal = indices.size();
+    m_backgroundState = BackgroundImportState::Importing;
+
+    //
+    // Import and publish a batch at a time.  Each batch holds the symbol set exclusive and so is seen all at
+    // once or not at all.  A query which needs to import something ends the batch early and goes first.
+    //
+    // DbgHelp is taken after the symbol set.  Another importer may hold it for a long time (e.g.: while it
+    // enumerates a module), and lookups in this symbol set must not wait on that.  So DbgHelp is only tried
+    // while holding the symbol set.  If it is busy, the symbol set is given up and DbgHelp is waited for
+    // without it.
+    //
+    // The symbols are new.  Nothing can have cached them and there is no cache invalidation.  A query which
+    // needs a symbol before the background import reaches it imports it on demand as it always has.
+    //
+    bool allImported = true;
+    bool waitForDbgHelp = false;
+    size_t next = 0;
+    while (next < indices.size())
+    {
+        if (waitForDbgHelp)
+        {
+            std::lock_guard<std::recursive_mutex> dbgHelpWait(GetDbgHelpLock());
+            waitForDbgHelp = false;
+        }
+
+        YieldToForegroundImports();
+        if (m_backgroundCancel)
+        {
+            return E_ABORT;
+        }
+
+        SymbolSetExclusiveLock lock(m_pOwningSet->GetLock());
+        std::unique_lock<std::recursive_mutex> dbgHelpLock(GetDbgHelpLock(), std::try_to_lock);
+        if (!dbgHelpLock.owns_lock())
+        {
+            waitForDbgHelp = true;
+            continue;
+        }
+
+        bool cacheInvalidationDisabled = m_pOwningSet->IsCacheInvalidationDisabled();
+        m_pOwningSet->SetCacheInvalidationDisable(true);
+
+        hr = ConvertException([&](){
+            SymbolSetBatch batch(m_pOwningSet);
+
+            size_t batchEnd = std::min(next + BackgroundBatchSize, indices.size());
+            while (next < batchEnd && !m_pOwningSet->HasForegroundImports() && !m_backgroundCancel)
+            {
+                ULONG64 importedId;
+                if (FAILED(ImportSymbol(indices[next], &importedId)))
+                {
+                    allImported = false;
+                }
+
+                ++next;
+                m_backgroundProcessed = next;
+            }
+
+            //
+            // Laying out the batch does not need DbgHelp.
+            //
+            dbgHelpLock.unlock();
+            return batch.Commit();
+        });
+
+        m_pOwningSet->SetCacheInvalidationDisable(cacheInvalidationDisabled);
+        IfFailedReturn(hr);
+    }
+
+    //
+    // If everything made it across, there is no need for queries to go back to DbgHelp.
+    //
+    if (allImported)
+    {
+        SymbolSetExclusiveLock lock(m_pOwningSet->GetLock());
+        m_fullGlobalImport = true;
+    }
+
     return hr;
 }
 
@@ -111,6 +111,46 @@ class SymbolSet;
 // Generic Import:
 //
 
+// BackgroundImportState:
+//
+// The state of a background import (see SymbolImporter::StartBackgroundImport).
+//
+enum class BackgroundImportState
+{
+    NotStarted,
+    Enumerating,                // Finding everything the source has to import
+    Importing,                  // Importing and publishing symbols in batches
+    Completed,
+    Cancelled,
+    Failed
+};
+
+// BackgroundImportProgress:
+//
+// The progress of a background import.
+//
+struct BackgroundImportProgress
+{
+    BackgroundImportState State;
+    ULONG64 SymbolsProcessed;
+    ULONG64 SymbolsTotal;
+};
+
+// ImportState:
+//
+// What an importer remembers about what it has already imported.  This is carried from one symbol set to another
+// which starts as a copy of it (see SymbolBuilderManager::GetSharedImageSymbols) so that the importer of the copy
+// does not import the same symbols again.
+//
+struct ImportState
+{
+    bool FullGlobalImport = false;
+    std::unordered_set<std::wstring> NameQueries;
+    std::unordered_set<ULONG64> AddressQueries;
+    std::unordered_map<ULONG, ULONG64> ImportedSymbols;     // Source index -> builder id
+    std::unordered_map<ULONG64, ULONG> DeferredUdts;        // Builder id -> source index
+};
+
 // SymbolImporter:
 //
 // An abstract class which provides the interfaces necessary to import symbols from a secondary data source
@@ -161,6 +201,18 @@ public:
     virtual HRESULT ImportForNameQuery(_In_ SvcSymbolKind searchKind,
                                        _In_opt_ PCWSTR pwszName) =0;
 
+    // IsOffsetQueryImported() / IsNameQueryImported():
+    //
+    // Indicates whether an offset / name query has nothing left to import (so that ImportForOffsetQuery or
+    // ImportForNameQuery would return without doing anything).  This only looks at what the importer has
+    // recorded and must be called with the owning symbol set held (shared is sufficient).  The importer only
+    // changes that record with the owning symbol set held exclusive.
+    //
+    virtual bool IsOffsetQueryImported(_In_ SvcSymbolKind searchKind,
+                                       _In_ ULONG64 offset) =0;
+    virtual bool IsNameQueryImported(_In_ SvcSymbolKind searchKind,
+                                     _In_opt_ PCWSTR pwszName) =0;
+
     // ImportForRegExQuery():
     //
     // Imports the necessary symbols to handle a regex query.  If the necessary imports have already occurred,
@@ -169,12 +221,70 @@ public:
     virtual HRESULT ImportForRegExQuery(_In_ SvcSymbolKind searchKind,
                                         _In_opt_ PCWSTR pwszRegEx) =0;
 
+    // ImportMembers():
+    //
+    // Imports the members of a UDT which the importer previously created as a shell (see
+    // UdtTypeSymbol::InternalDeferMembers).  If the members have already been imported, this method may return
+    // S_FALSE and do nothing.
+    //
+    virtual HRESULT ImportMembers(_In_ ULONG64 udtBuilderId) =0;
+
     // GetImporterDescription():
     //
     // Gets a description of where the import is taking place from.
     //
     virtual HRESULT GetImporterDescription(_Out_ std::wstring *pImporterInfo) =0;
 
+    // StartBackgroundImport():
+    //
+    // Starts importing everything from the underlying source on a worker thread.  Symbols are published to the
+    // owning symbol set in batches as they are imported.  Queries continue to import what they need on demand
+    // and take priority over the background import.  If a background import has already been started, this
+    // method returns S_FALSE and does nothing.
+    //
+    virtual HRESULT StartBackgroundImport()
+    {
+        return E_NOTIMPL;
+    }
+
+    // CancelBackgroundImport():
+    //
+    // Cancels a background import and waits for the worker thread to exit.  Anything already published stays in
+    // the symbol set.  This must not be called while holding the symbol set lock.
+    //
+    virtual void CancelBackgroundImport()
+    {
+    }
+
+    // GetBackgroundImportProgress():
+    //
+    // Gets the progress of a background import.
+    //
+    virtual HRESULT GetBackgroundImportProgress(_Out_ BackgroundImportProgress * /*pProgress*/)
+    {
+        return E_NOTIMPL;
+    }
+
+    // GetImportState():
+    //
+    // Gets what the importer has already imported.  This must be called with the owning symbol set held
+    // exclusive.  An importer which does not remember what it has imported may fail this.
+    //
+    virtual HRESULT GetImportState(_Out_ ImportState * /*pState*/)
+    {
+        return E_NOTIMPL;
+    }
+
+    // SetImportState():
+    //
+    // Tells the importer what has already been imported into its owning symbol set (e.g.: because the set
+    // started as a copy of another).  This must be called before any import takes place.
+    //
+    virtual HRESULT SetImportState(_In_ ImportState const& /*state*/)
+    {
+        return E_NOTIMPL;
+    }
+
     // ImportFailure():
     //
     // Any failure from the import process as a result of import error (and not something like out
@@ -211,7 +321,11 @@ public:
         SymbolImporter(pOwningSet),
         m_searchPath(pwszSearchPath),
         m_symHandle(NULL),
-        m_fullGlobalImport(false)
+        m_fullGlobalImport(false),
+        m_backgroundState(BackgroundImportState::NotStarted),
+        m_backgroundCancel(false),
+        m_backgroundProcessed(0),
+        m_backgroundTotal(0)
     {
     }
 
@@ -250,6 +364,16 @@ public:
     virtual HRESULT ImportForNameQuery(_In_ SvcSymbolKind searchKind,
                                        _In_opt_ PCWSTR pwszName);
 
+    // IsOffsetQueryImported() / IsNameQueryImported():
+    //
+    // Indicates whether an offset / name query has nothing left to import.  This must be called with the owning
+    // symbol set held (shared is sufficient).
+    //
+    virtual bool IsOffsetQueryImported(_In_ SvcSymbolKind searchKind,
+                                       _In_ ULONG64 offset);
+    virtual bool IsNameQueryImported(_In_ SvcSymbolKind searchKind,
+                                     _In_opt_ PCWSTR pwszName);
+
     // ImportForRegExQuery():
     //
     // Imports the necessary symbols to handle a regex query.  If the necessary imports have already occurred,
@@ -261,6 +385,42 @@ public:
         return S_FALSE;
     }
 
+    // ImportMembers():
+    //
+    // Imports the base classes and fields of a UDT which ImportUDT created as a shell.
+    //
+    virtual HRESULT ImportMembers(_In_ ULONG64 udtBuilderId);
+
+    // StartBackgroundImport():
+    //
+    // Starts importing every symbol and type DbgHelp has for the module on a worker thread.
+    //
+    virtual HRESULT StartBackgroundImport();
+
+    // CancelBackgroundImport():
+    //
+    // Cancels a background import and waits for the worker thread to exit.
+    //
+    virtual void CancelBackgroundImport();
+
+    // GetBackgroundImportProgress():
+    //
+    // Gets the progress of a background import.
+    //
+    virtual HRESULT GetBackgroundImportProgress(_Out_ BackgroundImportProgress *pProgress);
+
+    // GetImportState():
+    //
+    // Gets what the importer has already imported.
+    //
+    virtual HRESULT GetImportState(_Out_ ImportState *pState);
+
+    // SetImportState():
+    //
+    // Tells the importer what has already been imported into its owning symbol set.
+    //
+    virtual HRESULT SetImportState(_In_ ImportState const& state);
+
     // GetImporterDescription():
     //
     // Gets a description of where the import is taking place from.
@@ -295,6 +455,13 @@ private:
         PCWSTR SearchMask;
         bool MaskIsRegEx;
         ULONG64 QueryOffset;
+        std::vector<ULONG> *CollectedIndices;   // If set, matches are collected here rather than imported
+
+        // For a background enumeration (CollectedIndices set), which can stop to let a query import and is then
+        // started again from the beginning:
+        size_t SkipCount;                       // The number of symbols seen by earlier passes (skipped)
+        size_t SeenCount;                       // The number of symbols seen so far (including those skipped)
+        bool Interrupted;                       // Whether this pass stopped early for a query
     };
 
     // SymbolQueryCallbackInformation:
@@ -376,10 +543,17 @@ private:
 
     // ImportUDT():
     //
-    // Imports the given UDT into the symbol builder.
+    // Imports the given UDT into the symbol builder.  Only the name and size of the UDT are imported.  Its
+    // members are imported by ImportMembers when something first needs them.
     //
     HRESULT ImportUDT(_In_ ULONG symIndex, _Out_ ULONG64 *pBuilderId, _In_ ULONG64 parentId = 0);
 
+    // ImportUDTMembers():
+    //
+    // Imports the base classes and fields of the given UDT into an already imported UDT symbol.
+    //
+    HRESULT ImportUDTMembers(_In_ ULONG symIndex, _In_ UdtTypeSymbol *pUdt);
+
     // ImportEnum():
     //
     // Imports the given enum into the symbol builder.
@@ -442,6 +616,29 @@ private:
     //
     static bool TagMatchesSearchCriteria(_In_ ULONG tag, _In_ SvcSymbolKind searchKind);
 
+    //********************
+    // Background Import:
+    //
+
+    // BackgroundImportThread():
+    //
+    // The body of the background import worker thread.
+    //
+    void BackgroundImportThread();
+
+    // BackgroundImport():
+    //
+    // Finds everything DbgHelp has for the module and imports it in batches.  Both the enumeration and the import
+    // stop to let a query import and then carry on.  Returns E_ABORT if cancelled.
+    //
+    HRESULT BackgroundImport();
+
+    // YieldToForegroundImports():
+    //
+    // Waits on the worker thread until no query is waiting to import into the symbol set.
+    //
+    void YieldToForegroundImports();
+
     //*************************************************
     // DbgHelp Callback Handlers:
     //
@@ -537,6 +734,19 @@ private:
                                                                                 symbolSize));
     }
 
+    // GetDbgHelpLock():
+    //
+    // DbgHelp is single threaded.  Nothing may call into it (on any session, for any importer in the process)
+    // while anything else does.  Every call into DbgHelp holds this lock.  It is taken after the owning symbol
+    // set's lock and may be taken recursively (e.g.: importing the deferred members of a UDT in the middle of
+    // another import).
+    //
+    static std::recursive_mutex& GetDbgHelpLock()
+    {
+        static std::recursive_mutex dbgHelpLock;
+        return dbgHelpLock;
+    }
+
     //*************************************************
     // Data:
     //
@@ -566,6 +776,32 @@ private:
     std::unordered_set<ULONG64> m_addressQueries;
     std::unordered_map<ULONG, ULONG64> m_importedIndexMap;
 
+    // The UDTs imported as shells whose members have not yet been imported: builder id -> DbgHelp index
+    std::unordered_map<ULONG64, ULONG> m_deferredUdts;
+
+    // The number of symbols imported by the background import while holding the symbol set at once.
+    static constexpr size_t BackgroundBatchSize = 256;
+
+    // The number of symbols a pass of the background enumeration sees (beyond those skipped) before it will stop
+    // for a query.  Each pass starts from the beginning of the module again, so this bounds how often that
+    // happens.
+    static constexpr size_t BackgroundEnumerationChunkSize = 4096;
+
+    // Guards m_importedIndexMap (and the rest of the import state when it is copied in or out) against the
+    // background enumeration, which reads it without holding the owning symbol set.  Anything which adds to the
+    // map holds both the owning symbol set exclusive and this.  Anything holding the symbol set exclusive may
+    // read the map without this.
+    std::mutex m_importedIndexLock;
+
+    // The background import worker and its state.  The worker enumerates the module holding only the DbgHelp lock
+    // (and this importer's lock on the index map).  It imports (and touches the other tables above) only while
+    // holding the owning symbol set exclusive, exactly as a query does.
+    std::thread m_backgroundThread;
+    std::atomic<BackgroundImportState> m_backgroundState;
+    std::atomic<bool> m_backgroundCancel;
+    std::atomic<ULONG64> m_backgroundProcessed;
+    std::atomic<ULONG64> m_backgroundTotal;
+
 };
 
 } // SymbolBuilder
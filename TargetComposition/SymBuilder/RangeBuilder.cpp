@@ -38,7 +38,10 @@ bool LocationsAreEquivalent(_In_ const SvcSymbolLocation &a, _In_ const SvcSymbo
             a.Offset == b.Offset);
 }
 
-RangeBuilder::RangeBuilder()
+RangeBuilder::RangeBuilder() :
+    m_useNativeDecoder(true),
+    m_usedNativeDecoder(false),
+    m_blockTraversals(0)
 {
     //
     // Go and create an instance of the disassembler we can use for our walk of the disassembly.  This
@@ -51,18 +54,28 @@ RangeBuilder::RangeBuilder()
 
 ULONG RangeBuilder::GetBaseRegister(_In_ ULONG canonId)
 {
+    auto it = m_canonicalToBase.find(canonId);
+    if (it != m_canonicalToBase.end())
+    {
+        return it->second;
+    }
+
     auto pSymManager = m_pFunction->InternalGetSymbolSet()->GetSymbolBuilderManager();
+    ULONG baseId = canonId;
     for(;;)
     {
         RegisterInformation *pRegInfo;
-        CheckHr(pSymManager->FindInformationForRegisterById(canonId, &pRegInfo));
+        CheckHr(pSymManager->FindInformationForRegisterById(baseId, &pRegInfo));
         
         if (pRegInfo->ParentId == static_cast<ULONG>(-1))
         {
-            return canonId;
+            break;
         }
-        canonId = pRegInfo->ParentId;
+        baseId = pRegInfo->ParentId;
     }
+
+    m_canonicalToBase.insert( { canonId, baseId } );
+    return baseId;
 }
 
 ULONG RangeBuilder::GetCanonicalRegisterId(_In_ Object regObj)
@@ -365,8 +378,7 @@ void RangeBuilder::GetInstructionInfo(_In_ Object& instr, _Out_ InstructionInfo
     wchar_t const *pc = instrStr.c_str();
     wchar_t const *pe = pc;
     while (*pe && !iswspace(*pe)) { ++pe; }
-    std::wstring mnemonic(pc, pe - pc);
-    pInstructionInfo->Instr = GetRecognizedInstruction(mnemonic);
+    pInstructionInfo->Instr = GetRecognizedInstruction(pc, pe - pc);
     
     pInstructionInfo->NumOperands = 0;
 
@@ -390,6 +402,371 @@ void RangeBuilder::GetInstructionInfo(_In_ Object& instr, _Out_ InstructionInfo
 
         pInstructionInfo->NumOperands++;
     }
+
+    MarkChkStkCall(pInstructionInfo);
+}
+
+void RangeBuilder::MarkChkStkCall(_Inout_ InstructionInfo *pInstructionInfo)
+{
+    //
+    // A direct call to __chkstk changes how the following "sub rsp, <reg>" is understood.  Resolving the call
+    // target is a symbol lookup which must happen here rather than during the traversal (which may run away
+    // from the thread that owns the symbol set).
+    //
+    pInstructionInfo->CallsChkStk = false;
+    if (pInstructionInfo->IsCall)
+    {
+        OperandInfo const *pTarget = FindFirstImmediate(*pInstructionInfo);
+        if (pTarget != nullptr)
+        {
+            pInstructionInfo->CallsChkStk = IsChkStk(static_cast<ULONG64>(pTarget->ConstantValue));
+        }
+    }
+}
+
+ULONG RangeBuilder::GetNativeRegisterId(_In_ ULONG nativeReg)
+{
+    if (m_nativeRegToCanonical.empty())
+    {
+        m_nativeRegToCanonical.resize(X64Decoder::RegisterCount, UnresolvedRegister);
+    }
+
+    ULONG& canonId = m_nativeRegToCanonical[nativeReg];
+    if (canonId == UnresolvedRegister)
+    {
+        auto pSymManager = m_pFunction->InternalGetSymbolSet()->GetSymbolBuilderManager();
+
+        RegisterInformation *pRegInfo;
+        if (SUCCEEDED(pSymManager->FindInformationForRegister(X64Decoder::GetRegisterName(nativeReg), &pRegInfo)))
+        {
+            canonId = pRegInfo->Id;
+        }
+        else
+        {
+            canonId = NoRegister;
+        }
+    }
+
+    return canonId;
+}
+
+bool RangeBuilder::ConvertNativeInstruction(_In_ NativeInstruction const& nativeInstr,
+                                            _Out_ InstructionInfo *pInstructionInfo)
+{
+    static_assert(NativeOperandInput == OperandInput &&
+                  NativeOperandOutput == OperandOutput &&
+                  NativeOperandRegister == OperandRegister &&
+                  NativeOperandMemory == OperandMemory &&
+                  NativeOperandImmediate == OperandImmediate,
+                  "built in decoder operand flags must match range builder operand flags");
+
+    pInstructionInfo->Address = nativeInstr.Address;
+    pInstructionInfo->Length = nativeInstr.Length;
+    pInstructionInfo->IsCall = nativeInstr.IsCall;
+
+    switch(nativeInstr.Kind)
+    {
+        case NativeInstructionKind::Mov:
+            pInstructionInfo->Instr = RecognizedInstruction::Mov;
+            break;
+        case NativeInstructionKind::Push:
+            pInstructionInfo->Instr = RecognizedInstruction::Push;
+            break;
+        case NativeInstructionKind::Pop:
+            pInstructionInfo->Instr = RecognizedInstruction::Pop;
+            break;
+        case NativeInstructionKind::Add:
+            pInstructionInfo->Instr = RecognizedInstruction::Add;
+            break;
+        case NativeInstructionKind::Sub:
+            pInstructionInfo->Instr = RecognizedInstruction::Sub;
+            break;
+        case NativeInstructionKind::Lea:
+            pInstructionInfo->Instr = RecognizedInstruction::Lea;
+            break;
+        default:
+            pInstructionInfo->Instr = RecognizedInstruction::Unknown;
+            break;
+    }
+
+    pInstructionInfo->NumOperands = nativeInstr.NumOperands;
+    for (size_t o = 0; o < nativeInstr.NumOperands; ++o)
+    {
+        NativeOperand const& nativeOp = nativeInstr.Operands[o];
+        OperandInfo& opInfo = pInstructionInfo->Operands[o];
+
+        opInfo.Flags = nativeOp.Flags;
+        opInfo.ScalingFactor = nativeOp.ScalingFactor;
+        opInfo.ConstantValue = nativeOp.ConstantValue;
+        for (size_t r = 0; r < ARRAYSIZE(opInfo.Regs); ++r)
+        {
+            opInfo.Regs[r] = NoRegister;
+            if (nativeOp.Regs[r] != X64Decoder::NoRegister)
+            {
+                opInfo.Regs[r] = GetNativeRegisterId(nativeOp.Regs[r]);
+                if (opInfo.Regs[r] == NoRegister)
+                {
+                    return false;
+                }
+            }
+        }
+    }
+
+    MarkChkStkCall(pInstructionInfo);
+    return true;
+}
+
+bool RangeBuilder::DecodeFunctionNative()
+{
+    SymbolBuilderProcess *pProcess = m_pFunction->InternalGetSymbolSet()->GetOwningProcess();
+    if (pProcess->GetArchInfo()->GetArchitecture() != IMAGE_FILE_MACHINE_AMD64)
+    {
+        return false;
+    }
+
+    //
+    // Read the code bytes of every address range of the function.
+    //
+    struct CodeRange
+    {
+        ULONG64 StartAddress;
+        std::vector<unsigned char> Bytes;
+    };
+
+    std::vector<CodeRange> codeRanges;
+    for (auto&& range : m_pFunction->InternalGetAddressRanges())
+    {
+        if (range.second == 0)
+        {
+            return false;
+        }
+
+        CodeRange codeRange { m_modBase + range.first, std::vector<unsigned char>(static_cast<size_t>(range.second)) };
+
+        ULONG64 bytesRead;
+        if (FAILED(pProcess->ReadVirtualMemory(codeRange.StartAddress, codeRange.Bytes.data(), range.second, &bytesRead)) ||
+            bytesRead != range.second)
+        {
+            return false;
+        }
+
+        codeRanges.push_back(std::move(codeRange));
+    }
+
+    auto findCode = [&](_In_ ULONG64 address, _Out_ unsigned char const **ppBytes, _Out_ size_t *pAvailable)
+    {
+        for (auto&& codeRange : codeRanges)
+        {
+            if (address >= codeRange.StartAddress && address - codeRange.StartAddress < codeRange.Bytes.size())
+            {
+                size_t offset = static_cast<size_t>(address - codeRange.StartAddress);
+                *ppBytes = codeRange.Bytes.data() + offset;
+                *pAvailable = codeRange.Bytes.size() - offset;
+                return true;
+            }
+        }
+        return false;
+    };
+
+    //
+    // Follow every control flow from the entry point decoding instructions and noting where blocks must start.
+    // A branch out of the function is a tail call and has no flow within it.  Anything which lands in the
+    // middle of an already decoded instruction or runs off the end of the function's code is a failure.
+    //
+    std::map<ULONG64, NativeInstruction> instrs;
+    std::set<ULONG64> leaders;
+    std::vector<ULONG64> pending;
+
+    ULONG64 entryAddress = m_modBase + m_functionOffset;
+    leaders.insert(entryAddress);
+    pending.push_back(entryAddress);
+
+    while (!pending.empty())
+    {
+        ULONG64 address = pending.back();
+        pending.pop_back();
+
+        bool continues = true;
+        while (continues)
+        {
+            auto itNext = instrs.lower_bound(address);
+            if (itNext != instrs.end() && itNext->first == address)
+            {
+                break;
+            }
+            if (itNext != instrs.begin())
+            {
+                auto itPrev = std::prev(itNext);
+                if (itPrev->first + itPrev->second.Length > address)
+                {
+                    return false;
+                }
+            }
+
+            unsigned char const *pBytes;
+            size_t available;
+            NativeInstruction nativeInstr;
+            if (!findCode(address, &pBytes, &available) ||
+                !X64Decoder::Decode(pBytes, available, address, &nativeInstr) ||
+                (itNext != instrs.end() && address + nativeInstr.Length > itNext->first))
+            {
+                return false;
+            }
+
+            instrs.insert( { address, nativeInstr } );
+            ULONG64 nextAddress = address + nativeInstr.Length;
+
+            switch(nativeInstr.Kind)
+            {
+                case NativeInstructionKind::ConditionalJump:
+                case NativeInstructionKind::Jump:
+                {
+                    unsigned char const *pTargetBytes;
+                    size_t targetAvailable;
+                    if (findCode(nativeInstr.BranchTarget, &pTargetBytes, &targetAvailable))
+                    {
+                        leaders.insert(nativeInstr.BranchTarget);
+                        pending.push_back(nativeInstr.BranchTarget);
+                    }
+
+                    if (nativeInstr.Kind == NativeInstructionKind::ConditionalJump)
+                    {
+                        leaders.insert(nextAddress);
+                    }
+                    else
+                    {
+                        continues = false;
+                    }
+                    break;
+                }
+
+                case NativeInstructionKind::Return:
+                case NativeInstructionKind::Trap:
+                    continues = false;
+                    break;
+
+                default:
+                    break;
+            }
+
+            address = nextAddress;
+        }
+    }
+
+    //
+    // Split the decoded instructions into basic blocks: a block starts at every leader and after every
+    // instruction which does not simply continue to the next.
+    //
+    auto addOutboundFlows = [&](_In_ BasicBlockInfo& bbInfo, _In_ NativeInstruction const& lastInstr)
+    {
+        ULONG64 nextAddress = lastInstr.Address + lastInstr.Length;
+        bool fallsThrough = true;
+
+        switch(lastInstr.Kind)
+        {
+            case NativeInstructionKind::Jump:
+            case NativeInstructionKind::ConditionalJump:
+                if (instrs.find(lastInstr.BranchTarget) != instrs.end())
+                {
+                    bbInfo.OutboundFlows.push_back( { lastInstr.BranchTarget, lastInstr.Address } );
+                }
+                fallsThrough = (lastInstr.Kind == NativeInstructionKind::ConditionalJump &&
+                                lastInstr.BranchTarget != nextAddress);
+                break;
+
+            case NativeInstructionKind::Return:
+            case NativeInstructionKind::Trap:
+                fallsThrough = false;
+                break;
+
+            default:
+                break;
+        }
+
+        if (fallsThrough && instrs.find(nextAddress) != instrs.end())
+        {
+            bbInfo.OutboundFlows.push_back( { nextAddress, lastInstr.Address } );
+        }
+    };
+
+    BasicBlockInfo *pCurrentBlock = nullptr;
+    NativeInstruction const *pLastInstr = nullptr;
+    for (auto&& kvp : instrs)
+    {
+        NativeInstruction const& nativeInstr = kvp.second;
+
+        bool startsBlock = (pCurrentBlock == nullptr ||
+                            pCurrentBlock->EndAddress != nativeInstr.Address ||
+                            leaders.find(nativeInstr.Address) != leaders.end());
+        if (!startsBlock)
+        {
+            switch(pLastInstr->Kind)
+            {
+                case NativeInstructionKind::Jump:
+                case NativeInstructionKind::ConditionalJump:
+                case NativeInstructionKind::Return:
+                case NativeInstructionKind::Trap:
+                    startsBlock = true;
+                    break;
+                default:
+                    break;
+            }
+        }
+
+        if (startsBlock)
+        {
+            if (pCurrentBlock != nullptr)
+            {
+                addOutboundFlows(*pCurrentBlock, *pLastInstr);
+            }
+            pCurrentBlock = &(m_bbInfo.insert( { nativeInstr.Address, BasicBlockInfo(nativeInstr.Address) } ).first->second);
+        }
+
+        InstructionInfo instrInfo;
+        if (!ConvertNativeInstruction(nativeInstr, &instrInfo))
+        {
+            return false;
+        }
+        pCurrentBlock->Instructions.push_back(instrInfo);
+        pCurrentBlock->EndAddress = nativeInstr.Address + nativeInstr.Length;
+        pLastInstr = &nativeInstr;
+    }
+
+    if (pCurrentBlock != nullptr)
+    {
+        addOutboundFlows(*pCurrentBlock, *pLastInstr);
+    }
+
+    return true;
+}
+
+bool RangeBuilder::IsChkStk(_In_ ULONG64 address)
+{
+    auto it = m_chkStkTargets.find(address);
+    if (it != m_chkStkTargets.end())
+    {
+        return it->second;
+    }
+
+    bool isChkStk = false;
+    ComPtr<ISvcSymbol> spSymbol;
+    ULONG64 displacement;
+    HRESULT hrSym = m_pFunction->InternalGetSymbolSet()->FindSymbolByOffset(address - m_modBase,
+                                                                           true,
+                                                                           &spSymbol,
+                                                                           &displacement);
+    if (SUCCEEDED(hrSym) && displacement == 0)
+    {
+        BSTR symName;
+        if (SUCCEEDED(spSymbol->GetName(&symName)))
+        {
+            isChkStk = (wcscmp(symName, L"__chkstk") == 0);
+            SysFreeString(symName);
+        }
+    }
+
+    m_chkStkTargets.insert( { address, isChkStk } );
+    return isChkStk;
 }
 
 RangeBuilder::OperandInfo const *RangeBuilder::FindFirstInput(_In_ InstructionInfo const& instructionInfo)
@@ -433,41 +810,36 @@ bool RangeBuilder::CarryoverLiveRange(_In_ BasicBlockInfo& bbTo,
                                       _In_ size_t paramNum,
                                       _In_ LocationRange const& liveRange)
 {
-    bool matched = false;
-    ULONG64 bbToStart = bbTo.StartAddress;
-
-    ParameterRanges& pr = bbTo.BlockParameterRanges[paramNum];
-    for (size_t i = 0; i < pr.size(); ++i)
+    //
+    // Is this location already one that the parameter occupies on entry to the block...?
+    //
+    ULONG locationId = GetLocationId(liveRange.ParamLocation.ParamLocation);
+    std::vector<EntryLocation>& entryLocations = bbTo.EntryLocations[paramNum];
+    auto it = std::lower_bound(entryLocations.begin(), entryLocations.end(), locationId,
+                               [](_In_ EntryLocation const& entryLocation, _In_ ULONG id)
+                               {
+                                   return entryLocation.LocationId < id;
+                               });
+
+    if (it != entryLocations.end() && it->LocationId == locationId)
     {
-        LocationRange &lrTo = pr[i];
-        if (lrTo.StartAddress == bbTo.StartAddress)
-        {
-            //
-            // Is this the same...?
-            //
-            if (LocationsAreEquivalent(lrTo.ParamLocation.ParamLocation, liveRange.ParamLocation.ParamLocation))
-            {
-                matched = true;
-                bbTo.TraversalCountSlots[lrTo.ParamLocation.TraversalCountSlot]++;
-            }
-        }
+        bbTo.TraversalCountSlots[it->TraversalCountSlot]++;
+        return false;
     }
 
-    if (!matched)
-    {
-        bbTo.TraversalCountSlots.push_back(1);
-        size_t traversalCountSlot = bbTo.TraversalCountSlots.size() - 1;
+    bbTo.TraversalCountSlots.push_back(1);
+    size_t traversalCountSlot = bbTo.TraversalCountSlots.size() - 1;
 
-        pr.push_back(
-            { 
-                bbTo.StartAddress,                  // [StartAddress, StartAddress) -- "empty" until traversed
-                bbTo.StartAddress,
-                { liveRange.ParamLocation.ParamLocation, traversalCountSlot },
-                LiveState::Live
-            });
-    }
+    bbTo.BlockParameterRanges[paramNum].push_back(
+        { 
+            bbTo.StartAddress,                  // [StartAddress, StartAddress) -- "empty" until traversed
+            bbTo.StartAddress,
+            { liveRange.ParamLocation.ParamLocation, traversalCountSlot },
+            LiveState::Live
+        });
 
-    return !matched;
+    entryLocations.insert(it, { locationId, traversalCountSlot });
+    return true;
 }
 
 bool RangeBuilder::CarryoverLiveRanges(_In_ BasicBlockInfo& bbFrom, 
@@ -483,6 +855,7 @@ bool RangeBuilder::CarryoverLiveRanges(_In_ BasicBlockInfo& bbFrom,
     if (firstEntry)
     {
         bbTo.BlockParameterRanges.resize(bbFrom.BlockParameterRanges.size());
+        bbTo.EntryLocations.resize(bbFrom.BlockParameterRanges.size());
     }
 
     //
@@ -502,7 +875,10 @@ bool RangeBuilder::CarryoverLiveRanges(_In_ BasicBlockInfo& bbFrom,
                 lr.EndAddress > entry.SourceBlockInstructionAddress &&
                 lr.State == LiveState::LiveAtEndOfBlock)
             {
-                changedRanges = CarryoverLiveRange(bbTo, p, lr);
+                if (CarryoverLiveRange(bbTo, p, lr))
+                {
+                    changedRanges = true;
+                }
             }
         }
     }
@@ -510,29 +886,42 @@ bool RangeBuilder::CarryoverLiveRanges(_In_ BasicBlockInfo& bbFrom,
     return (changedRanges && !firstEntry);
 }
 
-RangeBuilder::RecognizedInstruction RangeBuilder::GetRecognizedInstruction(_In_ std::wstring const& mnemonic)
+RangeBuilder::RecognizedInstruction RangeBuilder::GetRecognizedInstruction(_In_reads_(mnemonicLength) wchar_t const *pMnemonic,
+                                                                           _In_ size_t mnemonicLength)
 {
-    if (wcscmp(mnemonic.c_str(), L"mov") == 0) { return RecognizedInstruction::Mov; }
-    if (wcscmp(mnemonic.c_str(), L"push") == 0) { return RecognizedInstruction::Push; }
-    if (wcscmp(mnemonic.c_str(), L"pop") == 0) { return RecognizedInstruction::Pop; }
-    if (wcscmp(mnemonic.c_str(), L"add") == 0) { return RecognizedInstruction::Add; }
-    if (wcscmp(mnemonic.c_str(), L"sub") == 0) { return RecognizedInstruction::Sub; }
-    if (wcscmp(mnemonic.c_str(), L"lea") == 0) { return RecognizedInstruction::Lea; }
-    else
+    struct RecognizedMnemonic
+    {
+        wchar_t const *Mnemonic;
+        size_t Length;
+        RecognizedInstruction Instr;
+    };
+
+    static RecognizedMnemonic const recognizedMnemonics[] =
     {
-        return RecognizedInstruction::Unknown;
+        { L"mov",  3, RecognizedInstruction::Mov },
+        { L"push", 4, RecognizedInstruction::Push },
+        { L"pop",  3, RecognizedInstruction::Pop },
+        { L"add",  3, RecognizedInstruction::Add },
+        { L"sub",  3, RecognizedInstruction::Sub },
+        { L"lea",  3, RecognizedInstruction::Lea }
+    };
+
+    for (auto&& recognized : recognizedMnemonics)
+    {
+        if (recognized.Length == mnemonicLength && wcsncmp(recognized.Mnemonic, pMnemonic, mnemonicLength) == 0)
+        {
+            return recognized.Instr;
+        }
     }
+
+    return RecognizedInstruction::Unknown;
 }
 
-void RangeBuilder::UpdateRangesForInstruction(_In_ BasicBlockInfo& block, _In_ Object instr)
+void RangeBuilder::UpdateRangesForInstruction(_In_ BasicBlockInfo& block, _In_ InstructionInfo const& curInstr)
 {
-    auto pSymbolSet = m_pFunction->InternalGetSymbolSet();
-    auto pSymManager = pSymbolSet->GetSymbolBuilderManager();
+    auto pSymManager = m_pFunction->InternalGetSymbolSet()->GetSymbolBuilderManager();
     ULONG spId = m_pConvention->GetSpId();
 
-    InstructionInfo curInstr;
-    GetInstructionInfo(instr, &curInstr);
-
     if (curInstr.IsCall)
     {
         //
@@ -608,7 +997,7 @@ void RangeBuilder::UpdateRangesForInstruction(_In_ BasicBlockInfo& block, _In_ O
                 {
                     for (size_t o = 0; o < curInstr.NumOperands; ++o)
                     {
-                        OperandInfo& opInfo = curInstr.Operands[o];
+                        OperandInfo const& opInfo = curInstr.Operands[o];
                         if (CheckForKill(opInfo, lr))
                         {
                             lr.State = LiveState::MarkedForKill;
@@ -750,8 +1139,8 @@ void RangeBuilder::UpdateRangesForInstruction(_In_ BasicBlockInfo& block, _In_ O
                                     //
                                     // At this point, we've seen a sub rsp, <register>.  Look for the pattern.
                                     //
-                                    InstructionInfo *pNMinus1 = GetPreviousInstructionN(1);
-                                    InstructionInfo *pNMinus2 = GetPreviousInstructionN(2);
+                                    InstructionInfo const *pNMinus1 = GetPreviousInstructionN(1);
+                                    InstructionInfo const *pNMinus2 = GetPreviousInstructionN(2);
 
                                     if (pNMinus1 && pNMinus2 &&
                                         pNMinus2->Address + pNMinus2->Length == pNMinus1->Address &&
@@ -768,8 +1157,7 @@ void RangeBuilder::UpdateRangesForInstruction(_In_ BasicBlockInfo& block, _In_ O
                                         //
                                         OperandInfo const *pOutputNMinus2 = FindFirstOutput(*pNMinus2);
                                         OperandInfo const *pImmNMinus2 = FindFirstImmediate(*pNMinus2);
-                                        OperandInfo const *pImmNMinus1 = FindFirstImmediate(*pNMinus1);
-                                        if (pImmNMinus2 && pOutputNMinus2 && pImmNMinus1)
+                                        if (pImmNMinus2 && pOutputNMinus2)
                                         {
                                             RegisterInformation *pSrc;
                                             RegisterInformation *pDest;
@@ -779,25 +1167,7 @@ void RangeBuilder::UpdateRangesForInstruction(_In_ BasicBlockInfo& block, _In_ O
                                             if (pOutputNMinus2->Regs[0] == curInstr.Operands[1].Regs[0] ||
                                                 GetBaseRegister(pOutputNMinus2->Regs[0]) == curInstr.Operands[1].Regs[0])
                                             {
-                                                bool isChkStk = false;
-                                                ULONG64 offs = pImmNMinus1->ConstantValue - m_modBase;
-                                                ComPtr<ISvcSymbol> spSymbol;
-                                                ULONG64 displacement;
-                                                HRESULT hrSym = pSymbolSet->FindSymbolByOffset(offs,
-                                                                                               true,
-                                                                                               &spSymbol,
-                                                                                               &displacement);
-                                                if (SUCCEEDED(hrSym) && displacement == 0)
-                                                {
-                                                    BSTR symName;
-                                                    if (SUCCEEDED(spSymbol->GetName(&symName)))
-                                                    {
-                                                        isChkStk = (wcscmp(symName, L"__chkstk") == 0);
-                                                        SysFreeString(symName);
-                                                    }
-                                                }
-
-                                                if (isChkStk)
+                                                if (pNMinus1->CallsChkStk)
                                                 {
                                                     //
                                                     // We've recognized the pattern.  Substitute the <reg2> with
@@ -867,9 +1237,10 @@ void RangeBuilder::UpdateRangesForInstruction(_In_ BasicBlockInfo& block, _In_ O
 
     //
     // Update the processing window so that we can go back and deal with some particular patterns that might
-    // be interesting.
+    // be interesting.  The window refers into the decoded instructions of the blocks which remain in place
+    // until the ranges are built.
     //
-    m_processingWindow[m_processingWindowCur] = curInstr;
+    m_processingWindow[m_processingWindowCur] = &curInstr;
     m_processingWindowCur = (m_processingWindowCur + 1) % ARRAYSIZE(m_processingWindow);
     if (m_processingWindowSize < ARRAYSIZE(m_processingWindow))
     {
@@ -877,35 +1248,141 @@ void RangeBuilder::UpdateRangesForInstruction(_In_ BasicBlockInfo& block, _In_ O
     }
 }
 
-void RangeBuilder::TraverseBasicBlock(_In_ TraversalEntry const& entry)
+void RangeBuilder::DecodeBasicBlock(_In_ BasicBlockInfo& bbInfo)
+{
+    Object instrs = bbInfo.BasicBlock.KeyValue(L"Instructions");
+    for (auto&& instr : instrs)
+    {
+        InstructionInfo instrInfo;
+        GetInstructionInfo(instr, &instrInfo);
+        bbInfo.Instructions.push_back(instrInfo);
+    }
+
+    Object outboundFlows = bbInfo.BasicBlock.KeyValue(L"OutboundControlFlows");
+    for (auto&& outboundFlow : outboundFlows)
+    {
+        Object destBlock = outboundFlow.KeyValue(L"LinkedBlock");
+        Object linkageInstr = outboundFlow.KeyValue(L"SourceInstruction");
+        ULONG64 linkageInstrAddr = (ULONG64)linkageInstr.KeyValue(L"Address");
+        ULONG64 destAddr = (ULONG64)destBlock.KeyValue(L"StartAddress");
+        bbInfo.OutboundFlows.push_back( { destAddr, linkageInstrAddr } );
+    }
+}
+
+ULONG RangeBuilder::GetLocationId(_In_ SvcSymbolLocation const& location)
+{
+    LocationKey key { static_cast<ULONG>(location.Kind),
+                      static_cast<ULONG>(location.RegInfo.Number),
+                      static_cast<ULONG>(location.RegInfo.Size),
+                      location.Offset };
+
+    auto it = m_locationIds.find(key);
+    if (it != m_locationIds.end())
+    {
+        return it->second;
+    }
+
+    ULONG locationId = static_cast<ULONG>(m_locationIds.size());
+    m_locationIds.insert( { key, locationId } );
+    return locationId;
+}
+
+void RangeBuilder::ComputeBlockOrder()
+{
+    //
+    // Iterative depth first walk from the entry block recording the postorder.  Each stack entry is a block
+    // and the index of the next outbound flow of that block to follow.
+    //
+    std::vector<BasicBlockInfo *> postorder;
+    std::vector<std::pair<BasicBlockInfo *, size_t>> stack;
+    std::unordered_set<ULONG64> visited;
+
+    auto itbbFirst = m_bbInfo.find(m_modBase + m_functionOffset);
+    if (itbbFirst == m_bbInfo.end())
+    {
+        throw std::runtime_error("Unable to find entry basic block to function");
+    }
+
+    visited.insert(itbbFirst->first);
+    stack.push_back( { &(itbbFirst->second), 0 } );
+    while (!stack.empty())
+    {
+        BasicBlockInfo *pbb = stack.back().first;
+        size_t& nextFlow = stack.back().second;
+        if (nextFlow < pbb->OutboundFlows.size())
+        {
+            ULONG64 destAddr = pbb->OutboundFlows[nextFlow].DestinationAddress;
+            ++nextFlow;
+
+            auto itbbDest = m_bbInfo.find(destAddr);
+            if (itbbDest != m_bbInfo.end() && visited.insert(destAddr).second)
+            {
+                stack.push_back( { &(itbbDest->second), 0 } );
+            }
+        }
+        else
+        {
+            postorder.push_back(pbb);
+            stack.pop_back();
+        }
+    }
+
+    for (size_t i = 0; i < postorder.size(); ++i)
+    {
+        postorder[i]->Order = postorder.size() - 1 - i;
+    }
+}
+
+void RangeBuilder::QueueTraversal(_In_ TraversalEntry const& entry)
 {
     //
     // We should already have traversed the basic block list, so nothing should ever "not be found"
     //
-    auto itbbAddr = m_bbInfo.find(entry.BlockAddress);
+    auto itbb = m_bbInfo.find(entry.BlockAddress);
+    if (itbb == m_bbInfo.end())
+    {
+        throw std::logic_error("Unexpected failure to find basic block");
+    }
+
+    m_worklist.insert( { itbb->second.Order, entry } );
+}
+
+void RangeBuilder::TraverseBasicBlock(_In_ std::vector<TraversalEntry> const& entries)
+{
+    auto itbbAddr = m_bbInfo.find(entries[0].BlockAddress);
     if (itbbAddr == m_bbInfo.end())
     {
         throw std::logic_error("Unexpected failure to find basic block");
     }
     BasicBlockInfo& bbInfo = itbbAddr->second;
 
+    bool firstTraversal = (bbInfo.TraversalCount == 0);
+
+    //
+    // Carry the state at the end of every source block into this one before walking it.  Each entry still
+    // counts against the block as a separate inbound flow.
+    //
     bool changedRanges = false;
-    if (entry.SourceBlockAddress != 0)
+    for (auto&& entry : entries)
     {
-        auto itbbFrom = m_bbInfo.find(entry.SourceBlockAddress);
-        if (itbbFrom == m_bbInfo.end())
+        if (entry.SourceBlockAddress != 0)
         {
-            throw std::logic_error("Unexpected failure to find basic block");
+            auto itbbFrom = m_bbInfo.find(entry.SourceBlockAddress);
+            if (itbbFrom == m_bbInfo.end())
+            {
+                throw std::logic_error("Unexpected failure to find basic block");
+            }
+            BasicBlockInfo& bbInfoFrom = itbbFrom->second;
+            if (CarryoverLiveRanges(bbInfoFrom, bbInfo, entry))
+            {
+                changedRanges = true;
+            }
         }
-        BasicBlockInfo& bbInfoFrom = itbbFrom->second;
-        changedRanges = CarryoverLiveRanges(bbInfoFrom, bbInfo, entry);
-    }
 
-    bool firstTraversal = (bbInfo.TraversalCount == 0);
-
-    if (++bbInfo.TraversalCount > MaximumTraversalCount)
-    {
-        throw std::runtime_error("Unable to propagate live ranges: maximum basic block traversal count exceeded");
+        if (++bbInfo.TraversalCount > MaximumTraversalCount)
+        {
+            throw std::runtime_error("Unable to propagate live ranges: maximum basic block traversal count exceeded");
+        }
     }
 
     //
@@ -914,12 +1391,13 @@ void RangeBuilder::TraverseBasicBlock(_In_ TraversalEntry const& entry)
     //
     if (firstTraversal || changedRanges)
     {
+        ++m_blockTraversals;
+
         //
         // Walk each instruction in the block and update live range information as appropriate based on
         // what the instructions are doing.
         //
-        Object instrs = bbInfo.BasicBlock.KeyValue(L"Instructions");
-        for (auto&& instr : instrs)
+        for (auto&& instr : bbInfo.Instructions)
         {
             UpdateRangesForInstruction(bbInfo, instr);
         }
@@ -945,14 +1423,9 @@ void RangeBuilder::TraverseBasicBlock(_In_ TraversalEntry const& entry)
         // Add each outbound control flow to the list of blocks to traverse (whether it is a fall through
         // flow, a branch flow, ...)
         //
-        Object outboundFlows = bbInfo.BasicBlock.KeyValue(L"OutboundControlFlows");
-        for (auto&& outboundFlow : outboundFlows)
+        for (auto&& outboundFlow : bbInfo.OutboundFlows)
         {
-            Object destBlock = outboundFlow.KeyValue(L"LinkedBlock");
-            Object linkageInstr = outboundFlow.KeyValue(L"SourceInstruction");
-            ULONG64 linkageInstrAddr = (ULONG64)linkageInstr.KeyValue(L"Address");
-            ULONG64 destAddr = (ULONG64)destBlock.KeyValue(L"StartAddress");
-            m_bbTrav.push( { destAddr, bbInfo.StartAddress, linkageInstrAddr });
+            QueueTraversal( { outboundFlow.DestinationAddress, bbInfo.StartAddress, outboundFlow.SourceInstructionAddress } );
         }
     }
 }
@@ -967,6 +1440,7 @@ void RangeBuilder::InitializeParameterLocations(_In_ CallingConvention *pConvent
                                         &entryLocations[0]);
 
     entryBlock.BlockParameterRanges.resize(m_parameters.size());
+    entryBlock.EntryLocations.resize(m_parameters.size());
     for (size_t i = 0; i < m_parameters.size(); ++i)
     {
         ParameterRanges& ranges = entryBlock.BlockParameterRanges[i];
@@ -981,90 +1455,153 @@ void RangeBuilder::InitializeParameterLocations(_In_ CallingConvention *pConvent
                 { entryLocations[i], traversalCountSlot },
                 LiveState::Live
             });
+
+        entryBlock.EntryLocations[i].push_back( { GetLocationId(entryLocations[i]), traversalCountSlot } );
     }
 }
 
 void RangeBuilder::PropagateParameterRanges(_In_ FunctionSymbol *pFunction,
                                             _In_ CallingConvention *pConvention)
 {
-    m_bbInfo.clear();
+    if (PrepareParameterRanges(pFunction, pConvention))
     {
-        decltype(m_bbTrav) emptyQueue;
-        std::swap(m_bbTrav, emptyQueue);
+        AnalyzeParameterRanges();
+        CommitParameterRanges();
     }
+}
+
+bool RangeBuilder::PrepareParameterRanges(_In_ FunctionSymbol *pFunction,
+                                          _In_ CallingConvention *pConvention)
+{
+    m_bbInfo.clear();
+    m_worklist.clear();
+    m_locationIds.clear();
+    m_blockTraversals = 0;
     m_parameters.clear();
+    m_parameterRefs.clear();
+    m_pendingRanges.clear();
 
     m_processingWindowCur = m_processingWindowSize = 0;
 
     //
     // Build a quick index of the parameters of the function.  If there are none, we need do nothing.
-    // This will require that we walk all the children of the function looking for parameters.
+    // This will require that we walk all the children of the function looking for parameters.  The walk is
+    // made under the symbol set lock and each parameter is held so that it stays valid after the lock is
+    // released.
     //
-    auto&& children = pFunction->InternalGetChildren();
-    for (auto&& childId : children)
     {
-        BaseSymbol *pSymbol = pFunction->InternalGetSymbolSet()->InternalGetSymbol(childId);
-        if (pSymbol->InternalGetKind() != SvcSymbolDataParameter)
+        SymbolSetSharedLock lock(pFunction->InternalGetSymbolSet()->GetLock());
+        auto&& children = pFunction->InternalGetChildren();
+        for (auto&& childId : children)
         {
-            continue;
-        }
+            BaseSymbol *pSymbol = pFunction->InternalGetSymbolSet()->InternalGetSymbol(childId);
+            if (pSymbol == nullptr || pSymbol->InternalGetKind() != SvcSymbolDataParameter)
+            {
+                continue;
+            }
 
-        VariableSymbol *pParameter = static_cast<VariableSymbol *>(pSymbol);
-        m_parameters.push_back(pParameter);
+            VariableSymbol *pParameter = static_cast<VariableSymbol *>(pSymbol);
+            m_parameterRefs.push_back(pParameter);
+            m_parameters.push_back(pParameter);
+        }
     }
 
-    if (m_parameters.size() > 0)
+    if (m_parameters.size() == 0)
     {
-        m_pFunction = pFunction;
-        m_pConvention = pConvention;
-        CheckHr(pFunction->GetOffset(&m_functionOffset));
-        CheckHr(pFunction->InternalGetSymbolSet()->GetModule()->GetBaseAddress(&m_modBase));
+        return false;
+    }
 
-        //
-        // If there are existing live ranges on any of the parameters, they need to be deleted at this point.
-        // Care needs to be taken to synchronize everything here properly.
-        //
-        for (auto&& pParam : m_parameters)
-        {
-            pParam->InternalDeleteAllLiveRanges();
-        }
+    m_pFunction = pFunction;
+    m_pConvention = pConvention;
+    CheckHr(pFunction->GetOffset(&m_functionOffset));
+    CheckHr(pFunction->InternalGetSymbolSet()->GetModule()->GetBaseAddress(&m_modBase));
+
+    //
+    // The built in decoder handles most functions without going through the data model at all.  Anything it
+    // does not understand goes to the data model disassembler.
+    //
+    m_usedNativeDecoder = (m_useNativeDecoder && DecodeFunctionNative());
+    if (!m_usedNativeDecoder)
+    {
+        m_bbInfo.clear();
 
         Object disResult = m_dis.CallMethod(L"DisassembleFunction", m_modBase + m_functionOffset);
         Object bbs = disResult.KeyValue(L"BasicBlocks");
 
         //
-        // Walk the basic block list and build our quick index.
+        // Walk the basic block list and build our quick index.  Every block is decoded now so that the
+        // traversal never needs to go back to the disassembler.
         //
         for(auto&& bb : bbs)
         {
             ULONG64 startAddress = (ULONG64)bb.KeyValue(L"StartAddress");
-            m_bbInfo.insert( { startAddress, bb } );
+            auto itbb = m_bbInfo.insert( { startAddress, bb } ).first;
+            DecodeBasicBlock(itbb->second);
         }
+    }
 
-        auto itbbFirst = m_bbInfo.find(m_modBase + m_functionOffset);
-        if (itbbFirst == m_bbInfo.end())
-        {
-            throw std::runtime_error("Unable to find entry basic block to function");
-        }
-        InitializeParameterLocations(pConvention, itbbFirst->second);
+    auto itbbFirst = m_bbInfo.find(m_modBase + m_functionOffset);
+    if (itbbFirst == m_bbInfo.end())
+    {
+        throw std::runtime_error("Unable to find entry basic block to function");
+    }
+    InitializeParameterLocations(pConvention, itbbFirst->second);
 
-        //
-        // Start at the entry basic block and keep walking control flows until we reach a state where
-        // we have no more control flows with different variable locations on entry.
-        //
-        m_bbTrav.push({ m_modBase + m_functionOffset, 0, 0 });
-        while (!m_bbTrav.empty())
+    return true;
+}
+
+void RangeBuilder::AnalyzeParameterRanges()
+{
+    ComputeBlockOrder();
+
+    //
+    // Start at the entry basic block and keep walking control flows until we reach a state where
+    // we have no more control flows with different variable locations on entry.  Blocks are taken in
+    // reverse postorder and all of the pending entries into a block are handled by a single walk of it.
+    //
+    QueueTraversal( { m_modBase + m_functionOffset, 0, 0 } );
+    while (!m_worklist.empty())
+    {
+        auto it = m_worklist.begin();
+        ULONG64 blockAddress = it->Entry.BlockAddress;
+
+        m_blockEntries.clear();
+        while (it != m_worklist.end() && it->Entry.BlockAddress == blockAddress)
         {
-            TraversalEntry entry = m_bbTrav.front();
-            m_bbTrav.pop();
-            TraverseBasicBlock(entry);
+            m_blockEntries.push_back(it->Entry);
+            it = m_worklist.erase(it);
         }
 
-        //
-        // Move our built data over to the parameter symbol.
-        //
-        CreateLiveRangeSets();
+        TraverseBasicBlock(m_blockEntries);
     }
+
+    //
+    // Merge our built data into the ranges which will be handed to the parameter symbols.
+    //
+    CreateLiveRangeSets();
+}
+
+void RangeBuilder::CommitParameterRanges()
+{
+    //
+    // If there are existing live ranges on any of the parameters, they need to be deleted at this point.
+    //
+    for (auto&& pParam : m_parameters)
+    {
+        pParam->InternalDeleteAllLiveRanges();
+    }
+
+    for (auto&& pending : m_pendingRanges)
+    {
+        VariableSymbol *pParam = m_parameters[pending.ParamNum];
+
+        ULONG64 uniqueId;
+        (void)pParam->AddLiveRange(pending.StartAddress - m_modBase - m_functionOffset,
+                                   pending.EndAddress - pending.StartAddress,
+                                   pending.Location,
+                                   &uniqueId);
+    }
+    m_pendingRanges.clear();
 }
 
 bool RangeBuilder::AddParameterRangeToFunction(_In_ size_t paramNum,
@@ -1072,20 +1609,14 @@ bool RangeBuilder::AddParameterRangeToFunction(_In_ size_t paramNum,
                                                _In_ ULONG64 &endAddress,
                                                _In_ SvcSymbolLocation const& location)
 {
-    VariableSymbol *pParam = m_parameters[paramNum];
-
-    ULONG64 uniqueId;
-    HRESULT hr = pParam->AddLiveRange(startAddress - m_modBase - m_functionOffset, 
-                                      endAddress - startAddress,
-                                      location,
-                                      &uniqueId);
+    m_pendingRanges.push_back( { paramNum, startAddress, endAddress, location } );
 
     //
     // Mark there as no "current range" from the caller's side.
     //
     startAddress = endAddress = 0;
 
-    return SUCCEEDED(hr);
+    return true;
 }
 
 void RangeBuilder::CreateLiveRangeSets()
@@ -1132,6 +1663,20 @@ void RangeBuilder::CreateLiveRangeSets()
             auto&& pr = bb.BlockParameterRanges[p];
             auto&& tc = bb.TraversalCountSlots;
 
+            //
+            // Drop the ranges which can never be chosen: empty ones and control flow dependent ones.
+            //
+            // @TODO: For now, we are choosing to ignore control flow dependent locations.  In reality, if
+            //        there are no better options, we should be able to plumb this upward.
+            //
+            pr.erase(std::remove_if(pr.begin(), pr.end(),
+                                    [&](_In_ const LocationRange& lr)
+                                    {
+                                        return tc[lr.ParamLocation.TraversalCountSlot] != traversalCount ||
+                                               lr.EndAddress <= lr.StartAddress;
+                                    }),
+                     pr.end());
+
             //
             // Ranges may have gotten out of order linearly depending on how many control flows entered the 
             // block.  Sort them to make it easier to figure out.
@@ -1142,6 +1687,7 @@ void RangeBuilder::CreateLiveRangeSets()
                           return a.StartAddress < b.StartAddress;
                       });
 
+            size_t nextRange = 0;
             while (instrp < bb.EndAddress)
             {
                 //
@@ -1149,21 +1695,14 @@ void RangeBuilder::CreateLiveRangeSets()
                 // instrp.  It cannot be one which ends *BELOW* 'instrp'.  Remember that everything is half-open, so
                 // the range's EndAddress must be above 'instrp' for it to be useful to us.
                 //
-                LocationRange const *pLR = nullptr;
-                for (size_t i = 0; i < pr.size(); ++i)
+                // As 'instrp' only ever moves forward, a range which is passed over here can never be chosen
+                // later and the search picks up where it last left off.
+                //
+                while (nextRange < pr.size() && pr[nextRange].EndAddress <= instrp)
                 {
-                    //
-                    // @TODO: For now, we are choosing to ignore control flow dependent locations.  In reality, if
-                    //        there are no better options, we should be able to plumb this upward.
-                    //
-                    LocationRange const& lr = pr[i];
-                    if (tc[lr.ParamLocation.TraversalCountSlot] == traversalCount && lr.EndAddress > instrp &&
-                        lr.EndAddress > lr.StartAddress)
-                    {
-                        pLR = &lr;
-                        break;
-                    }
+                    ++nextRange;
                 }
+                LocationRange const *pLR = (nextRange < pr.size() ? &pr[nextRange] : nullptr);
 
                 //
                 // Are there other ranges in this basic block that we need to deal with...?  Do we need to merge
@@ -1240,6 +1779,187 @@ void RangeBuilder::CreateLiveRangeSets()
     }
 }
 
+//*************************************************
+// Module Range Builder:
+//
+
+ModuleRangeBuilder::ModuleRangeBuilder(_In_ SymbolSet *pSymbolSet,
+                                       _In_ CallingConvention *pConvention,
+                                       _In_ size_t threadCount) :
+    m_pSymbolSet(pSymbolSet),
+    m_pConvention(pConvention),
+    m_threadCount(threadCount),
+    m_useNativeDecoder(true)
+{
+    if (m_threadCount == 0)
+    {
+        m_threadCount = std::thread::hardware_concurrency();
+        if (m_threadCount == 0)
+        {
+            m_threadCount = 1;
+        }
+    }
+}
+
+void ModuleRangeBuilder::AnalyzeBatch(_In_ std::vector<std::unique_ptr<RangeBuilder>>& builders,
+                                      _Inout_ std::vector<HRESULT>& results)
+{
+    //
+    // Each worker pulls the next unanalyzed function from a shared index until there are none left.  Functions
+    // vary wildly in size and this keeps every thread busy until the batch is done without any up front
+    // partitioning.
+    //
+    std::atomic<size_t> nextBuilder(0);
+    auto worker = [&]()
+    {
+        for(;;)
+        {
+            size_t i = nextBuilder.fetch_add(1);
+            if (i >= builders.size())
+            {
+                break;
+            }
+
+            if (builders[i] != nullptr)
+            {
+                results[i] = ConvertException([&](){
+                    builders[i]->AnalyzeParameterRanges();
+                    return S_OK;
+                });
+            }
+        }
+    };
+
+    size_t threadCount = std::min(m_threadCount, builders.size());
+    if (threadCount <= 1)
+    {
+        worker();
+        return;
+    }
+
+    //
+    // The calling thread is one of the workers.  If a thread cannot be created, the batch simply runs on
+    // those which could.
+    //
+    std::vector<std::thread> threads;
+    for (size_t t = 1; t < threadCount; ++t)
+    {
+        HRESULT hr = ConvertException([&](){
+            threads.emplace_back(worker);
+            return S_OK;
+        });
+        if (FAILED(hr))
+        {
+            break;
+        }
+    }
+    worker();
+
+    for (auto&& thread : threads)
+    {
+        thread.join();
+    }
+}
+
+ModuleRangeBuilder::Results ModuleRangeBuilder::PropagateParameterRanges(_In_opt_ ProgressCallback const& progress)
+{
+    Results results = { };
+
+    //
+    // The symbol set may be changed by other threads while the functions are analyzed.  Copy the function ids
+    // under the lock and look up each function under the lock as it is reached.  A function deleted in the
+    // meantime is simply skipped.
+    //
+    std::vector<ULONG64> functionIds;
+    {
+        SymbolSetSharedLock lock(m_pSymbolSet->GetLock());
+        auto pFunctionIds = m_pSymbolSet->InternalGetSymbolsByKind(SvcSymbolFunction);
+        if (pFunctionIds != nullptr)
+        {
+            functionIds.assign(pFunctionIds->begin(), pFunctionIds->end());
+        }
+    }
+    results.FunctionCount = functionIds.size();
+
+    //
+    // One disassembler is shared amongst every range builder.  It is only ever used while preparing functions
+    // on this thread.
+    //
+    Object codeNS = Object::RootNamespace().KeyValue(L"Debugger").KeyValue(L"Utility").KeyValue(L"Code");
+    Object dis = codeNS.CallMethod(L"CreateDisassembler");
+
+    SymbolSetBatch batch(m_pSymbolSet);
+
+    size_t processed = 0;
+    while (processed < functionIds.size())
+    {
+        size_t batchCount = std::min(BatchSize, functionIds.size() - processed);
+        std::vector<ComPtr<FunctionSymbol>> functions(batchCount);
+        std::vector<std::unique_ptr<RangeBuilder>> builders(batchCount);
+        std::vector<HRESULT> batchResults(batchCount, S_FALSE);
+
+        //
+        // Disassemble and decode the batch.  Functions without parameters have nothing to propagate and are
+        // left without a builder.
+        //
+        for (size_t i = 0; i < batchCount; ++i)
+        {
+            {
+                SymbolSetSharedLock lock(m_pSymbolSet->GetLock());
+                BaseSymbol *pSymbol = m_pSymbolSet->InternalGetSymbol(functionIds[processed + i]);
+                if (pSymbol == nullptr || pSymbol->InternalGetKind() != SvcSymbolFunction)
+                {
+                    continue;
+                }
+                functions[i] = static_cast<FunctionSymbol *>(pSymbol);
+            }
+
+            FunctionSymbol *pFunction = functions[i].Get();
+            auto spBuilder = std::make_unique<RangeBuilder>(dis);
+            spBuilder->SetUseNativeDecoder(m_useNativeDecoder);
+            batchResults[i] = ConvertException([&](){
+                return spBuilder->PrepareParameterRanges(pFunction, m_pConvention) ? S_OK : S_FALSE;
+            });
+
+            if (batchResults[i] == S_OK)
+            {
+                if (spBuilder->UsedNativeDecoder())
+                {
+                    ++results.NativelyDecoded;
+                }
+                builders[i] = std::move(spBuilder);
+            }
+        }
+
+        AnalyzeBatch(builders, batchResults);
+
+        for (size_t i = 0; i < batchCount; ++i)
+        {
+            if (FAILED(batchResults[i]))
+            {
+                ++results.Failed;
+            }
+            else if (builders[i] != nullptr)
+            {
+                builders[i]->CommitParameterRanges();
+                results.BlockTraversals += builders[i]->GetBlockTraversalCount();
+                ++results.Propagated;
+            }
+        }
+
+        processed += batchCount;
+
+        if (progress && !progress(processed, functionIds.size()))
+        {
+            results.Cancelled = (processed < functionIds.size());
+            break;
+        }
+    }
+
+    CheckHr(batch.Commit());
+    return results;
+}
+
 } // SymbolBuilder
 } // Services
 } // TargetComposition
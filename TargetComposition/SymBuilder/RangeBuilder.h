@@ -36,12 +36,87 @@ public:
 
     RangeBuilder();
 
+    // RangeBuilder():
+    //
+    // Constructs a range builder which shares an already created data model disassembler.
+    //
+    RangeBuilder(_In_ Object const& dis) :
+        m_dis(dis),
+        m_useNativeDecoder(true),
+        m_usedNativeDecoder(false),
+        m_blockTraversals(0)
+    {
+    }
+
+    // SetUseNativeDecoder():
+    //
+    // Sets whether functions are first decoded with the built in x64 decoder (the default).  If this is off or
+    // the built in decoder cannot handle a function, the data model disassembler is used.
+    //
+    void SetUseNativeDecoder(_In_ bool useNativeDecoder)
+    {
+        m_useNativeDecoder = useNativeDecoder;
+    }
+
+    // UsedNativeDecoder():
+    //
+    // Indicates whether the last function prepared was decoded with the built in decoder.
+    //
+    bool UsedNativeDecoder() const
+    {
+        return m_usedNativeDecoder;
+    }
+
     // PropagateParameterRanges():
     //
-    // 
+    // Determines the live ranges of the parameters of the given function and replaces any which the parameters
+    // already have.  This is PrepareParameterRanges, AnalyzeParameterRanges, and CommitParameterRanges in turn.
+    //
     void PropagateParameterRanges(_In_ FunctionSymbol *pFunction,
                                   _In_ CallingConvention *pConvention);
 
+    // PrepareParameterRanges():
+    //
+    // Finds the parameters of the given function, disassembles it, and decodes every basic block.  This
+    // returns false if the function has no parameters (and there is nothing further to do).  This uses the
+    // data model and the symbol set and must be called on the thread which owns them.
+    //
+    bool PrepareParameterRanges(_In_ FunctionSymbol *pFunction,
+                                _In_ CallingConvention *pConvention);
+
+    // AnalyzeParameterRanges():
+    //
+    // Walks the decoded basic blocks and builds the live ranges of the parameters.  This only reads the decoded
+    // blocks, the calling convention, and the register tables of the symbol builder manager.  It may be called
+    // on any thread and separate range builders may analyze concurrently.
+    //
+    void AnalyzeParameterRanges();
+
+    // CommitParameterRanges():
+    //
+    // Replaces the live ranges of the parameters with those built by AnalyzeParameterRanges.  This must be
+    // called on the thread which owns the symbol set.
+    //
+    void CommitParameterRanges();
+
+    // GetBlockTraversalCount():
+    //
+    // Gets the number of times that AnalyzeParameterRanges walked the instructions of a basic block.
+    //
+    size_t GetBlockTraversalCount() const
+    {
+        return m_blockTraversals;
+    }
+
+    // GetBasicBlockCount():
+    //
+    // Gets the number of basic blocks in the last function prepared.
+    //
+    size_t GetBasicBlockCount() const
+    {
+        return m_bbInfo.size();
+    }
+
 private:
 
     // The maximum number of times that a basic block can be traversed before we consider it an error.  There
@@ -55,6 +130,9 @@ private:
     // A constant defining no register
     static constexpr ULONG NoRegister = static_cast<ULONG>(-1);
 
+    // A constant defining a built in decoder register whose canonical ID has not yet been looked up
+    static constexpr ULONG UnresolvedRegister = static_cast<ULONG>(-2);
+
     //*************************************************
     // Permanent State:
     //
@@ -62,6 +140,9 @@ private:
     // The data model disassembler
     Object m_dis;
 
+    // Whether to try the built in decoder before the data model disassembler
+    bool m_useNativeDecoder;
+
     //*************************************************
     // Ephemeral State:
     //
@@ -73,6 +154,7 @@ private:
     CallingConvention *m_pConvention;
     ULONG64 m_functionOffset;
     ULONG64 m_modBase;
+    bool m_usedNativeDecoder;
 
     // LocationInfo:
     //
@@ -118,44 +200,6 @@ private:
     //
     using ParameterRanges = std::vector<LocationRange>;
 
-    // BasicBlockInfo:
-    //
-    // Records information about a particular basic block.
-    //
-    struct BasicBlockInfo
-    {
-        //*************************************************
-        // Data:
-        //
-
-        // The disassembler's representation of a basic block.
-        Object BasicBlock;
-        ULONG64 StartAddress;
-        ULONG64 EndAddress;
-
-        //
-        // The locations of parameters within this basic block.
-        //
-        std::vector<ParameterRanges> BlockParameterRanges;
-        std::vector<ULONG> TraversalCountSlots;
-
-        // How many times has our traversal entered this basic block.
-        ULONG TraversalCount;
-
-        //*************************************************
-        // Constructors:
-        //
-
-        // Constructs a basic block info
-        BasicBlockInfo(_In_ Object basicBlock) :
-            BasicBlock(std::move(basicBlock))
-        {
-            StartAddress = (ULONG64)BasicBlock.KeyValue(L"StartAddress");
-            EndAddress = (ULONG64)BasicBlock.KeyValue(L"EndAddress");
-            TraversalCount = 0;
-        }
-    };
-
     // RecognizedInstruction:
     //
     // Defines instructions that we recognize for specific purposes.
@@ -186,6 +230,42 @@ private:
         ULONG64 SourceBlockInstructionAddress;
     };
 
+    // WorklistEntry:
+    //
+    // A traversal entry keyed by the reverse postorder position of the block it enters.  The worklist always
+    // hands out the earliest block in reverse postorder so that a block is normally reached only after all of
+    // its forward predecessors, and every pending entry into that block is carried over before it is walked.
+    //
+    struct WorklistEntry
+    {
+        size_t Order;
+        TraversalEntry Entry;
+
+        bool operator<(_In_ WorklistEntry const& other) const
+        {
+            return std::tie(Order, Entry.BlockAddress, Entry.SourceBlockAddress, Entry.SourceBlockInstructionAddress) <
+                   std::tie(other.Order, other.Entry.BlockAddress, other.Entry.SourceBlockAddress,
+                            other.Entry.SourceBlockInstructionAddress);
+        }
+    };
+
+    // EntryLocation:
+    //
+    // A location which a parameter occupies on entry to a basic block.  The location is identified by its index
+    // in the location table of the builder and the list of such for a block is kept sorted by that index.
+    //
+    struct EntryLocation
+    {
+        ULONG LocationId;
+        size_t TraversalCountSlot;
+    };
+
+    // LocationKey:
+    //
+    // The parts of a location which are compared by LocationsAreEquivalent.
+    //
+    using LocationKey = std::tuple<ULONG, ULONG, ULONG, ULONG64>;
+
     enum OperandFlags
     {
         OperandInput = 0x00000001,
@@ -217,16 +297,110 @@ private:
         ULONG64 Length;
         RecognizedInstruction Instr;
         bool IsCall;
+        bool CallsChkStk;           // A direct call to __chkstk (resolved when the instruction is decoded)
         size_t NumOperands;
         OperandInfo Operands[4];
     };
 
+    // OutboundFlow:
+    //
+    // A control flow out of a basic block: the block it enters and the instruction which transfers control
+    // (whether a branch or fall through).
+    //
+    struct OutboundFlow
+    {
+        ULONG64 DestinationAddress;
+        ULONG64 SourceInstructionAddress;
+    };
+
+    // BasicBlockInfo:
+    //
+    // Records information about a particular basic block.
+    //
+    struct BasicBlockInfo
+    {
+        //*************************************************
+        // Data:
+        //
+
+        // The disassembler's representation of a basic block.
+        Object BasicBlock;
+        ULONG64 StartAddress;
+        ULONG64 EndAddress;
+
+        //
+        // The decoded instructions of this basic block and its outbound control flows.  These are read from the
+        // disassembler when the ranges are prepared and reused by every traversal.
+        //
+        std::vector<InstructionInfo> Instructions;
+        std::vector<OutboundFlow> OutboundFlows;
+
+        //
+        // The locations of parameters within this basic block and, for each parameter, the sorted set of
+        // locations it occupies on entry to the block.
+        //
+        std::vector<ParameterRanges> BlockParameterRanges;
+        std::vector<std::vector<EntryLocation>> EntryLocations;
+        std::vector<ULONG> TraversalCountSlots;
+
+        // How many times has our traversal entered this basic block.
+        ULONG TraversalCount;
+
+        // The position of this block in a reverse postorder walk of the control flow graph from the entry block.
+        size_t Order;
+
+        //*************************************************
+        // Constructors:
+        //
+
+        // Constructs a basic block info
+        BasicBlockInfo(_In_ Object basicBlock) :
+            BasicBlock(std::move(basicBlock))
+        {
+            StartAddress = (ULONG64)BasicBlock.KeyValue(L"StartAddress");
+            EndAddress = (ULONG64)BasicBlock.KeyValue(L"EndAddress");
+            TraversalCount = 0;
+            Order = 0;
+        }
+
+        // Constructs a basic block info for a block found by the built in decoder.  The block is empty
+        // until instructions are added to it.
+        BasicBlockInfo(_In_ ULONG64 startAddress) :
+            StartAddress(startAddress),
+            EndAddress(startAddress),
+            TraversalCount(0),
+            Order(0)
+        {
+        }
+    };
+
     std::unordered_map<ULONG64, BasicBlockInfo> m_bbInfo;
-    std::queue<TraversalEntry> m_bbTrav;
+    std::set<WorklistEntry> m_worklist;
+    std::vector<TraversalEntry> m_blockEntries;                     // Entries into the block being traversed
+    std::map<LocationKey, ULONG> m_locationIds;                     // Maps locations to their index
+    size_t m_blockTraversals;
     std::vector<VariableSymbol *> m_parameters;
+    std::vector<Microsoft::WRL::ComPtr<VariableSymbol>> m_parameterRefs;   // Keeps m_parameters alive
     std::unordered_map<ULONG, ULONG> m_disRegToCanonical;           // Maps disassembler IDs to canonical ones
+    std::vector<ULONG> m_nativeRegToCanonical;                      // Maps built in decoder registers to canonical IDs
+    std::unordered_map<ULONG, ULONG> m_canonicalToBase;             // Maps canonical IDs to their base register
+    std::unordered_map<ULONG64, bool> m_chkStkTargets;              // Maps call targets to whether they are __chkstk
+
+    // PendingRange:
+    //
+    // A live range which has been built for a parameter but not yet added to it.
+    //
+    struct PendingRange
+    {
+        size_t ParamNum;
+        ULONG64 StartAddress;
+        ULONG64 EndAddress;
+        SvcSymbolLocation Location;
+    };
+
+    std::vector<PendingRange> m_pendingRanges;
 
-    InstructionInfo m_processingWindow[3];                          // Window of last three instructions walked
+    InstructionInfo const *m_processingWindow[3];                   // Window of last three instructions walked
     size_t m_processingWindowCur;
     size_t m_processingWindowSize;
 
@@ -237,7 +411,8 @@ private:
     // GetBaseRegister():
     //
     // Gets the base register of a given canonical register.  This will return the topmost parent for any
-    // sub-register.  It will, for example, return 'rax' when passed ID for 'ah', 'al', 'ax', or 'eax'.
+    // sub-register.  It will, for example, return 'rax' when passed ID for 'ah', 'al', 'ax', or 'eax'.  The
+    // result is cached as this is asked for every live range on every instruction.
     //
     ULONG GetBaseRegister(_In_ ULONG canonId);
 
@@ -256,10 +431,35 @@ private:
 
     // CreateLiveRangeSets():
     //
-    // Transfers live range data from our build to the parameters.
+    // Merges the live range data from our build into the final set of ranges for each parameter.
     //
     void CreateLiveRangeSets();
 
+    // IsChkStk():
+    //
+    // Determines whether the given absolute address is the start of __chkstk.
+    //
+    bool IsChkStk(_In_ ULONG64 address);
+
+    // GetLocationId():
+    //
+    // Gets the index of the given location in the location table, adding it if it is not already present.
+    //
+    ULONG GetLocationId(_In_ SvcSymbolLocation const& location);
+
+    // ComputeBlockOrder():
+    //
+    // Numbers every basic block reachable from the entry block by its position in a reverse postorder walk of
+    // the control flow graph.
+    //
+    void ComputeBlockOrder();
+
+    // QueueTraversal():
+    //
+    // Adds an entry into the worklist of basic blocks to traverse.
+    //
+    void QueueTraversal(_In_ TraversalEntry const& entry);
+
     // InitializeParameterLocations():
     //
     // Creates the initial placement of parameters via calling convention on the first instruction in the given
@@ -267,28 +467,62 @@ private:
     //
     void InitializeParameterLocations(_In_ CallingConvention *pConvention, _In_ BasicBlockInfo &entryBlock);
     
+    // DecodeFunctionNative():
+    //
+    // Reads the code bytes of the function and builds the basic blocks, their instructions, and their control
+    // flows with the built in decoder.  This returns false (leaving the basic block index in an indeterminate
+    // state) if the architecture, any instruction, or any control flow (e.g.: a jump through a switch table)
+    // is not something the built in decoder understands.
+    //
+    bool DecodeFunctionNative();
+
+    // ConvertNativeInstruction():
+    //
+    // Converts an instruction from the built in decoder to the form the traversal works on.  This returns false
+    // if a register cannot be mapped to a canonical one.
+    //
+    bool ConvertNativeInstruction(_In_ NativeInstruction const& nativeInstr, _Out_ InstructionInfo *pInstructionInfo);
+
+    // GetNativeRegisterId():
+    //
+    // Gets the canonical ID of a register in the built in decoder's numbering or NoRegister if there is none.
+    //
+    ULONG GetNativeRegisterId(_In_ ULONG nativeReg);
+
+    // MarkChkStkCall():
+    //
+    // Resolves whether a decoded call instruction is a direct call to __chkstk.
+    //
+    void MarkChkStkCall(_Inout_ InstructionInfo *pInstructionInfo);
+
+    // DecodeBasicBlock():
+    //
+    // Reads the instructions and outbound control flows of a basic block from the disassembler into the
+    // compact form that the traversal works on.  This happens once per basic block when the ranges are prepared.
+    //
+    void DecodeBasicBlock(_In_ BasicBlockInfo& bbInfo);
+
     // TraverseBasicBlock():
     //
-    // Walks through the instructions in the basic block starting at 'entry.BlockAddress' until it hits the end of the
-    // basic block.  During the instruction traversal, propagate information we have about the state of parameters
-    // at the start of the basic block through to the end of the basic block.
+    // Walks through the instructions in the basic block which every entry in 'entries' enters until it hits the end
+    // of the basic block.  During the instruction traversal, propagate information we have about the state of
+    // parameters at the start of the basic block through to the end of the basic block.
     //
-    // If 'entry.SourceBlock*' is not 0, the state from the end of that block will carry into the start of the 
-    // traversal.  If this does not change the live ranges at the start of 'entry.BlockAddress', the traversal is
-    // considered complete.  Otherwise, the block will be traversed again to find and propagate any control flow 
-    // dependent locations.
+    // For each entry whose 'SourceBlock*' is not 0, the state from the end of that block will carry into the start
+    // of the traversal.  If none of this changes the live ranges at the start of the block (and the block has been
+    // walked before), the traversal is considered complete.  Otherwise, the block will be walked (again) to find
+    // and propagate any control flow dependent locations.
     //
-    // If the block starting at 'entry.BlockAddress' is traversed, this will add outbound control flows from the 
-    // traversed block to the traversal queue.
+    // If the block is walked, this will add outbound control flows from the block to the worklist.
     //
-    void TraverseBasicBlock(_In_ TraversalEntry const& entry);
+    void TraverseBasicBlock(_In_ std::vector<TraversalEntry> const& entries);
 
     // UpdateRangesForInstruction():
     // 
-    // Updates parameter live range information *WITHIN* this basic block given the disassembled instruction
-    // "instr".
+    // Updates parameter live range information *WITHIN* this basic block given the decoded instruction
+    // "curInstr".
     //
-    void UpdateRangesForInstruction(_In_ BasicBlockInfo& block, _In_ Object instr);
+    void UpdateRangesForInstruction(_In_ BasicBlockInfo& block, _In_ InstructionInfo const& curInstr);
 
     // CarryoverLiveRange():
     //
@@ -308,8 +542,8 @@ private:
 
     // AddParameterRangeToFunction()
     //
-    // For the [startAddress, endAddress) half-open range (given by absolute VAs), add the range to the function
-    // we are building data for.
+    // For the [startAddress, endAddress) half-open range (given by absolute VAs), record the range to be added
+    // to the function we are building data for when the ranges are committed.
     //
     bool AddParameterRangeToFunction(_In_ size_t paramNum,
                                      _Inout_ ULONG64 &startAddress,
@@ -390,7 +624,8 @@ private:
     //
     // Is this a "*" instruction (or the equivalent on whatever architecture we understand)
     //
-    RecognizedInstruction GetRecognizedInstruction(_In_ std::wstring const& mnemonic);
+    RecognizedInstruction GetRecognizedInstruction(_In_reads_(mnemonicLength) wchar_t const *pMnemonic,
+                                                   _In_ size_t mnemonicLength);
 
     // FindFirst*():
     //
@@ -407,7 +642,7 @@ private:
     // not in the cache, nullptr is returned.  Note that it is assumed that the current instruction is not in
     // the processing window.
     //
-    InstructionInfo *GetPreviousInstructionN(_In_ size_t nback = 1)
+    InstructionInfo const *GetPreviousInstructionN(_In_ size_t nback = 1)
     {
         if (m_processingWindowSize < nback)
         {
@@ -416,9 +651,85 @@ private:
         size_t pos = m_processingWindowCur;
         if (pos < nback) { pos += ARRAYSIZE(m_processingWindow); }
         pos -= nback;
-        return &(m_processingWindow[pos]);
+        return m_processingWindow[pos];
+    }
+
+};
+
+// ModuleRangeBuilder:
+//
+// Propagates parameter live ranges for every function in a symbol set.  Functions are prepared in batches on
+// the calling thread (everything which touches the data model or the symbol set happens there), analyzed on
+// a set of worker threads, and committed back on the calling thread.  The entire run is a single batch
+// against the symbol set.
+//
+class ModuleRangeBuilder
+{
+public:
+
+    // ProgressCallback:
+    //
+    // Called on the calling thread after each batch of functions has been committed with the number of functions
+    // processed so far and the total.  Returning false cancels the remainder of the run.
+    //
+    using ProgressCallback = std::function<bool(_In_ size_t processed, _In_ size_t total)>;
+
+    // Results:
+    //
+    // The outcome of a run.
+    //
+    struct Results
+    {
+        size_t FunctionCount;           // The number of functions in the symbol set
+        size_t Propagated;              // The number of functions whose parameter ranges were replaced
+        size_t Failed;                  // The number of functions which could not be analyzed
+        bool Cancelled;                 // Whether the progress callback cancelled the run
+        size_t BlockTraversals;         // The number of basic block walks across every analyzed function
+        size_t NativelyDecoded;         // The number of functions decoded with the built in decoder
+    };
+
+    // ModuleRangeBuilder():
+    //
+    // Constructs a module range builder which will use up to 'threadCount' worker threads.  A thread count of
+    // zero uses one thread per hardware thread.
+    //
+    ModuleRangeBuilder(_In_ SymbolSet *pSymbolSet,
+                       _In_ CallingConvention *pConvention,
+                       _In_ size_t threadCount = 0);
+
+    // PropagateParameterRanges():
+    //
+    // Propagates parameter live ranges for every function in the symbol set.
+    //
+    Results PropagateParameterRanges(_In_opt_ ProgressCallback const& progress = ProgressCallback());
+
+    // SetUseNativeDecoder():
+    //
+    // Sets whether functions are first decoded with the built in decoder (the default).
+    //
+    void SetUseNativeDecoder(_In_ bool useNativeDecoder)
+    {
+        m_useNativeDecoder = useNativeDecoder;
     }
 
+private:
+
+    // The number of functions prepared (and hence disassembled) before the worker threads are run over them.
+    // This bounds the amount of decoded disassembly held at any one time.
+    static constexpr size_t BatchSize = 256;
+
+    // AnalyzeBatch():
+    //
+    // Runs AnalyzeParameterRanges for each prepared builder in the batch across the worker threads.  Any
+    // failure is recorded in the builder's slot in 'results'.
+    //
+    void AnalyzeBatch(_In_ std::vector<std::unique_ptr<RangeBuilder>>& builders,
+                      _Inout_ std::vector<HRESULT>& results);
+
+    SymbolSet *m_pSymbolSet;
+    CallingConvention *m_pConvention;
+    size_t m_threadCount;
+    bool m_useNativeDecoder;
 };
 
 } // SymbolBuilder
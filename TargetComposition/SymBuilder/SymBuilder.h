@@ -29,14 +29,25 @@
 #include <utility>
 #include <memory>
 #include <string>
+#include <string_view>
 #include <vector>
+#include <list>
 #include <stack>
 #include <queue>
 #include <map>
+#include <set>
 #include <unordered_map>
 #include <unordered_set>
 #include <algorithm>
+#include <regex>
 #include <functional>
+#include <tuple>
+#include <stdexcept>
+#include <chrono>
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <shared_mutex>
 #include <experimental/generator>
 
 #include <DbgServices.h>
@@ -167,8 +178,10 @@ HRESULT DiagnosticLog(_In_opt_ ISvcDiagnosticLogging *pDiagnosticLogging,
 #include "SymbolTypes.h"
 #include "SymbolFunction.h"
 #include "ImportSymbols.h"
+#include "SymbolSnapshot.h"
 #include "SymbolSet.h"
 #include "CallingConvention.h"
+#include "X64Decoder.h"
 #include "SymManager.h"
 #include "SymbolServices.h"
 
@@ -35,6 +35,8 @@
 var __symbolBuilderSymbols = null;
 var __ctl = null;
 var __symBuilder = null;
+var __ntdllSymbols = null;
+var __ntdllModule = null;
 
 var __uniqueId = 0;
 
@@ -587,6 +589,230 @@ function Test_StructMoveField()
     return true;
 }
 
+// Test_StructBatchedLayout:
+//
+// Verifies that fields added to a UDT within a batch are laid out once the batch commits, that nested batches
+// defer layout until the outermost one commits, and that types dependent on the UDT pick up its final size.
+//
+function Test_StructBatchedLayout()
+{
+    var fooName = __getUniqueName("foo");
+    var barName = __getUniqueName("bar");
+
+    var foo = __symbolBuilderSymbols.Types.Create(fooName);
+    var bar = __symbolBuilderSymbols.Types.Create(barName);
+    var barFldA = bar.Fields.Add("a", foo);
+    var barFldB = bar.Fields.Add("b", "char");
+    var fooArray = __symbolBuilderSymbols.Types.CreateArray(foo, 4);
+
+    __symbolBuilderSymbols.BeginBatch();
+    var fooFlds = [];
+    for (var i = 0; i < 100; ++i)
+    {
+        fooFlds.push(foo.Fields.Add("f" + i.toString(), (i % 2 == 0) ? "char" : "int"));
+    }
+
+    __symbolBuilderSymbols.BeginBatch();
+    var fooFldLast = foo.Fields.Add("last", "__int64");
+    __symbolBuilderSymbols.CommitBatch();
+
+    //
+    // The inner commit must not have laid anything out.
+    //
+    __VERIFY(foo.Size == 0, "unexpected layout of 'foo' before the outermost batch committed");
+
+    __symbolBuilderSymbols.CommitBatch();
+
+    //
+    // Each (char, int) pair takes 8 bytes.  The trailing __int64 lands at 400 and the whole type is padded to its
+    // natural alignment of 8.
+    //
+    __VERIFY(fooFlds[0].Offset == 0 && fooFlds[1].Offset == 4, "unexpected offsets of leading fields");
+    __VERIFY(fooFlds[98].Offset == 392 && fooFlds[99].Offset == 396, "unexpected offsets of trailing fields");
+    __VERIFY(fooFldLast.Offset == 400, "unexpected offset of 'last'");
+    __VERIFY(foo.Size == 408 && foo.Alignment == 8, "unexpected layout of 'foo'");
+
+    //
+    // Dependent types must have been brought up to date on commit.
+    //
+    __VERIFY(fooArray.Size == 408 * 4, "unexpected size of array of 'foo'");
+    __VERIFY(barFldA.Offset == 0 && barFldB.Offset == 408, "unexpected offsets in 'bar'");
+    __VERIFY(bar.Size == 416, "unexpected size of 'bar'");
+
+    //
+    // A commit without a matching open batch is an error.
+    //
+    var caught = false;
+    try
+    {
+        __symbolBuilderSymbols.CommitBatch();
+    }
+    catch(exc)
+    {
+        caught = true;
+    }
+
+    __VERIFY(caught, "unexpected success of committing a batch which was never opened!");
+
+    bar.Delete();
+    fooArray.Delete();
+    foo.Delete();
+    return true;
+}
+
+// Test_StructBatchCallback:
+//
+// Verifies that Batch(callback) lays out the changes made by the callback once it returns, and that the batch is
+// committed (not left open) when the callback throws.
+//
+function Test_StructBatchCallback()
+{
+    var fooName = __getUniqueName("foo");
+    var foo = __symbolBuilderSymbols.Types.Create(fooName);
+
+    var fldA;
+    var fldB;
+    __symbolBuilderSymbols.Batch(function()
+    {
+        fldA = foo.Fields.Add("a", "char");
+        fldB = foo.Fields.Add("b", "int");
+        __VERIFY(foo.Size == 0, "unexpected layout of 'foo' within the batch");
+    });
+
+    __VERIFY(fldA.Offset == 0 && fldB.Offset == 4 && foo.Size == 8, "unexpected layout of 'foo' after the batch");
+
+    var fldC;
+    var caught = false;
+    try
+    {
+        __symbolBuilderSymbols.Batch(function()
+        {
+            fldC = foo.Fields.Add("c", "__int64");
+            throw new Error("callback failure");
+        });
+    }
+    catch(exc)
+    {
+        caught = true;
+    }
+
+    __VERIFY(caught, "the failure of the callback was not rethrown");
+    __VERIFY(fldC.Offset == 8 && foo.Size == 16, "the batch was not committed after the callback threw");
+
+    //
+    // No batch may remain open.
+    //
+    caught = false;
+    try
+    {
+        __symbolBuilderSymbols.CommitBatch();
+    }
+    catch(exc)
+    {
+        caught = true;
+    }
+
+    __VERIFY(caught, "a batch was left open by a callback which threw");
+
+    foo.Delete();
+    return true;
+}
+
+// Test_DeepDependencyGraphLayout:
+//
+// Benchmark style test which builds a deep "diamond" dependency graph of types (each level embeds the previous
+// level twice) and then changes the type at the bottom.  Each type must be laid out again exactly once; if the
+// change were propagated along every path, the work would double with every level.
+//
+function Test_DeepDependencyGraphLayout()
+{
+    var depth = 16;
+    var levels = [];
+
+    var bottom = __symbolBuilderSymbols.Types.Create(__getUniqueName("level"));
+    bottom.Fields.Add("a", "char");
+    levels.push(bottom);
+
+    for (var i = 1; i <= depth; ++i)
+    {
+        var level = __symbolBuilderSymbols.Types.Create(__getUniqueName("level"));
+        level.Fields.Add("a", levels[i - 1]);
+        level.Fields.Add("b", levels[i - 1]);
+        levels.push(level);
+    }
+
+    __VERIFY(levels[depth].Size == Math.pow(2, depth), "unexpected size of top level before change");
+
+    var startTime = Date.now();
+    var fldB = bottom.Fields.Add("b", "char");
+    var elapsed = Date.now() - startTime;
+    host.diagnostics.debugLog("    DeepDependencyGraphLayout: depth ", depth, " relayout took ", elapsed, "ms\n");
+
+    for (var i = 0; i <= depth; ++i)
+    {
+        __VERIFY(levels[i].Size == Math.pow(2, i + 1), "unexpected size of level " + i.toString() + " after change");
+    }
+
+    for (var i = depth; i >= 0; --i)
+    {
+        levels[i].Delete();
+    }
+    return true;
+}
+
+// Test_WideDependencyGraphLayout:
+//
+// Benchmark style test which embeds a single type in many others directly, through a typedef, and through an
+// array of that typedef and then changes the embedded type.  Every dependent type must pick up the new layout.
+//
+function Test_WideDependencyGraphLayout()
+{
+    var width = 256;
+
+    var base = __symbolBuilderSymbols.Types.Create(__getUniqueName("base"));
+    base.Fields.Add("a", "int");
+
+    var baseTypedef = __symbolBuilderSymbols.Types.CreateTypedef(__getUniqueName("base_t"), base);
+    var baseArray = __symbolBuilderSymbols.Types.CreateArray(baseTypedef, 4);
+
+    var users = [];
+    for (var i = 0; i < width; ++i)
+    {
+        var user = __symbolBuilderSymbols.Types.Create(__getUniqueName("user"));
+        user.Fields.Add("direct", base);
+        user.Fields.Add("viaTypedef", baseTypedef);
+        user.Fields.Add("viaArray", baseArray);
+        users.push(user);
+    }
+
+    __VERIFY(users[0].Size == 4 * 6, "unexpected size of user before change");
+
+    var startTime = Date.now();
+    base.Fields.Add("b", "__int64");
+    var elapsed = Date.now() - startTime;
+    host.diagnostics.debugLog("    WideDependencyGraphLayout: width ", width, " relayout took ", elapsed, "ms\n");
+
+    //
+    // base is now { int a; __int64 b; } -- 16 bytes with an alignment of 8.
+    //
+    __VERIFY(base.Size == 16, "unexpected size of base after change");
+    __VERIFY(baseTypedef.Size == 16 && baseTypedef.Alignment == 8, "unexpected layout of typedef after change");
+    __VERIFY(baseArray.Size == 16 * 4, "unexpected size of array after change");
+    for (var i = 0; i < width; ++i)
+    {
+        __VERIFY(users[i].Size == 16 * 6, "unexpected size of user " + i.toString() + " after change");
+    }
+
+    for (var i = 0; i < width; ++i)
+    {
+        users[i].Delete();
+    }
+    baseArray.Delete();
+    baseTypedef.Delete();
+    base.Delete();
+    return true;
+}
+
 // Test_ArrayCreation:
 //
 // Verify that we can create arrays and get back expected results.
@@ -1159,6 +1385,889 @@ function Test_BitfieldMoveField()
     return true;
 }
 
+// Test_PublicsBulkLoadAndQuery:
+//
+// Benchmark style test which creates a million public symbols spread across the module and then looks up
+// a sample of their addresses through the debugger.  Each sampled address must resolve to the first public
+// symbol created at it.  This takes a while to run.
+//
+function Test_PublicsBulkLoadAndQuery()
+{
+    var count = 1000000;
+    var samples = 1000;
+
+    var notepadModule = host.currentProcess.Modules.getValueAt("notepad.exe");
+    var span = notepadModule.Size;
+
+    var publics = [];
+    var firstNames = [];
+
+    var startTime = Date.now();
+    for (var i = 0; i < count; ++i)
+    {
+        var offset = Math.floor(i * span / count);
+        var name = __getUniqueName("bulkpub");
+        publics.push(__symbolBuilderSymbols.Publics.Create(name, offset));
+        if (firstNames[offset] === undefined)
+        {
+            firstNames[offset] = name;
+        }
+    }
+    var loadElapsed = Date.now() - startTime;
+
+    startTime = Date.now();
+    for (var i = 0; i < samples; ++i)
+    {
+        var offset = Math.floor(Math.floor(i * count / samples) * span / count);
+        var output = "";
+        for (var line of __ctl.ExecuteCommand("ln notepad+0x" + offset.toString(16)))
+        {
+            output += line;
+            output += "\n";
+        }
+
+        __VERIFY(output.indexOf(firstNames[offset]) != -1,
+                 "unexpected nearest symbol for offset 0x" + offset.toString(16));
+    }
+    var queryElapsed = Date.now() - startTime;
+
+    host.diagnostics.debugLog("    PublicsBulkLoadAndQuery: ", count, " publics loaded in ", loadElapsed, "ms; ",
+                              samples, " queries took ", queryElapsed, "ms\n");
+
+    for (var pub of publics)
+    {
+        pub.Delete();
+    }
+    return true;
+}
+
+// Test_WideUdtFieldLookup:
+//
+// Verifies that fields of a very wide struct can be found by name through the underlying type system and
+// that the lookup remains correct as fields are deleted.  Also looks up a set of types by name amongst
+// many other symbols.
+//
+function Test_WideUdtFieldLookup()
+{
+    var fieldCount = 5000;
+    var typeCount = 500;
+
+    var name = __getUniqueName("wide");
+    var wide = __symbolBuilderSymbols.Types.Create(name);
+
+    var flds = [];
+    for (var i = 0; i < fieldCount; ++i)
+    {
+        flds.push(wide.Fields.Add("f" + i, "int"));
+    }
+
+    __VERIFY(wide.Size == fieldCount * 4, "unexpected size of wide type");
+
+    var wideTy = host.getModuleType("notepad.exe", name);
+    for (var i = 0; i < fieldCount; i += 97)
+    {
+        __VERIFY(wideTy.fields["f" + i].offset == i * 4, "unexpected offset of 'f" + i + "'");
+    }
+
+    flds[10].Delete();
+
+    wideTy = host.getModuleType("notepad.exe", name);
+    __VERIFY(wideTy.fields.f10 === undefined, "unexpected ability to find 'f10' after field delete");
+    __VERIFY(wideTy.fields.f11.offset == 40, "unexpected offset of 'f11' after 'f10' delete");
+    __VERIFY(wideTy.fields["f" + (fieldCount - 1)].offset == (fieldCount - 2) * 4,
+             "unexpected offset of last field after 'f10' delete");
+
+    var types = [];
+    var typeNames = [];
+    for (var i = 0; i < typeCount; ++i)
+    {
+        var typeName = __getUniqueName("idx");
+        typeNames.push(typeName);
+        types.push(__symbolBuilderSymbols.Types.Create(typeName));
+        types[i].Fields.Add("a", "char");
+        types[i].Fields.Add("b", "int");
+    }
+
+    for (var i = 0; i < typeCount; i += 37)
+    {
+        var ty = host.getModuleType("notepad.exe", typeNames[i]);
+        __VERIFY(ty.fields.b.offset == 4, "unexpected offset of 'b' within '" + typeNames[i] + "'");
+    }
+
+    for (var ty of types)
+    {
+        ty.Delete();
+    }
+    wide.Delete();
+    return true;
+}
+
+// Test_FindSymbolsByPattern:
+//
+// Verifies that global symbols can be found by wildcard pattern and regular expression and that the results
+// track symbols being deleted.
+//
+function Test_FindSymbolsByPattern()
+{
+    var count = 200;
+    var prefix = __getUniqueName("pat");
+
+    var types = [];
+    for (var i = 0; i < count; ++i)
+    {
+        types.push(__symbolBuilderSymbols.Types.Create(prefix + "_" + (i % 2 == 0 ? "even" : "odd") + "_" + i));
+    }
+
+    var countMatches = function(pattern, isRegex)
+    {
+        var matches = 0;
+        for (var sym of __symbolBuilderSymbols.FindSymbols(pattern, isRegex))
+        {
+            __VERIFY(sym.Name.startsWith(prefix), "unexpected match '" + sym.Name + "' for '" + pattern + "'");
+            ++matches;
+        }
+        return matches;
+    };
+
+    __VERIFY(countMatches(prefix + "*") == count, "unexpected number of prefix matches");
+    __VERIFY(countMatches(prefix + "_even_*") == count / 2, "unexpected number of 'even' matches");
+    __VERIFY(countMatches(prefix + "_*_1?") == 10, "unexpected number of two digit matches ending in 1?");
+    __VERIFY(countMatches("*" + prefix + "_odd_19?") == 5, "unexpected number of leading wildcard matches");
+    __VERIFY(countMatches(prefix + "_odd_[0-9]*7", true) == 20, "unexpected number of regex matches");
+    __VERIFY(countMatches(prefix + "_(even|odd)_1[0-9]", true) == 10, "unexpected number of alternation matches");
+    __VERIFY(countMatches(prefix + "_none*") == 0, "unexpected match for pattern with no matches");
+
+    for (var i = 0; i < count; i += 2)
+    {
+        types[i].Delete();
+    }
+
+    __VERIFY(countMatches(prefix + "_even_*") == 0, "unexpected 'even' match after delete");
+    __VERIFY(countMatches(prefix + "*") == count / 2, "unexpected number of prefix matches after delete");
+
+    for (var i = 1; i < count; i += 2)
+    {
+        types[i].Delete();
+    }
+    return true;
+}
+
+// Test_LookupThroughput:
+//
+// Benchmark style test which measures the rate of lookups by name and by address through the debugger while
+// the symbol set holds its lookups shared.  Types are changed between rounds; every lookup must see the change
+// from the prior round.  The script host drives lookups from a single thread and so this measures the cost of
+// the lock on that path rather than scaling across threads.
+//
+function Test_LookupThroughput()
+{
+    var typeCount = 1000;
+    var publicCount = 100;
+    var rounds = 4;
+
+    var notepadModule = host.currentProcess.Modules.getValueAt("notepad.exe");
+    var span = notepadModule.Size;
+
+    var types = [];
+    var names = [];
+    for (var i = 0; i < typeCount; ++i)
+    {
+        names.push(__getUniqueName("lookup"));
+        types.push(__symbolBuilderSymbols.Types.Create(names[i]));
+    }
+
+    var publics = [];
+    var publicNames = [];
+    for (var i = 0; i < publicCount; ++i)
+    {
+        publicNames.push(__getUniqueName("lookuppub"));
+        publics.push(__symbolBuilderSymbols.Publics.Create(publicNames[i], Math.floor((i + 0.5) * span / publicCount)));
+    }
+
+    for (var round = 0; round < rounds; ++round)
+    {
+        //
+        // Change every type between rounds so that each round's lookups follow a set of writes.
+        //
+        for (var i = 0; i < typeCount; ++i)
+        {
+            types[i].Fields.Add("f" + round, "int");
+        }
+
+        var startTime = Date.now();
+        for (var i = 0; i < typeCount; ++i)
+        {
+            var ty = host.getModuleType("notepad.exe", names[i]);
+            __VERIFY(ty.size == 4 * (round + 1), "unexpected size for '" + names[i] + "' in round " + round);
+        }
+        var nameElapsed = Date.now() - startTime;
+
+        startTime = Date.now();
+        for (var i = 0; i < publicCount; ++i)
+        {
+            var offset = Math.floor((i + 0.5) * span / publicCount);
+            var output = "";
+            for (var line of __ctl.ExecuteCommand("ln notepad+0x" + offset.toString(16)))
+            {
+                output += line;
+                output += "\n";
+            }
+
+            __VERIFY(output.indexOf(publicNames[i]) != -1,
+                     "unexpected nearest symbol for offset 0x" + offset.toString(16));
+        }
+        var addressElapsed = Date.now() - startTime;
+
+        host.diagnostics.debugLog("    LookupThroughput: round ", round, ": ", typeCount, " name lookups in ",
+                                  nameElapsed, "ms; ", publicCount, " address lookups in ", addressElapsed, "ms\n");
+    }
+
+    for (var ty of types)
+    {
+        ty.Delete();
+    }
+    for (var pub of publics)
+    {
+        pub.Delete();
+    }
+    return true;
+}
+
+// Test_ConcurrentLookupThroughput:
+//
+// Benchmark style test which looks up the global symbols of an automatically imported module by name from several
+// threads at once.  The first round imports each symbol on demand.  Later rounds find everything already imported
+// and only hold the symbol set shared, so their throughput should scale with the number of threads.  Every thread
+// must find what a single thread found.  Note that combase keeps these symbols for the remainder of the session.
+//
+function Test_ConcurrentLookupThroughput()
+{
+    var rounds = 4;
+    var syms = __symBuilder.CreateSymbols("combase.dll", { AutoImportSymbols: true });
+
+    var matches = 0;
+    for (var sym of syms.FindSymbols("Co*"))
+    {
+        ++matches;
+    }
+    __VERIFY(matches > 0, "unable to find 'Co*' in combase");
+
+    var first = syms.MeasureLookups(1, 1);
+    host.diagnostics.debugLog("    ConcurrentLookupThroughput: first lookups of ", first.Lookups, " names in ",
+                              first.Microseconds, "us\n");
+    __VERIFY(first.Found > 0, "nothing was found by name");
+
+    for (var threadCount of [1, 2, 4, 8])
+    {
+        var result = syms.MeasureLookups(threadCount, rounds);
+        var perSecond = (result.Microseconds == 0) ? 0 : Math.floor(result.Lookups * 1000000 / result.Microseconds);
+        host.diagnostics.debugLog("    ConcurrentLookupThroughput: ", result.Threads, " thread(s): ", result.Lookups,
+                                  " lookups in ", result.Microseconds, "us (", perSecond, " per second)\n");
+
+        __VERIFY(result.Threads == threadCount, "unable to run " + threadCount + " threads");
+        __VERIFY(result.Found == first.Found * threadCount * rounds,
+                 "a different set of symbols was found with " + threadCount + " threads");
+    }
+    return true;
+}
+
+// Test_DerivedTypeFields:
+//
+// Benchmark style test which measures adding fields whose types are pointers and arrays of a created type
+// spelled in several equivalent ways.  Each spelling after the first resolves to a derived type which already
+// exists rather than creating another.
+//
+function Test_DerivedTypeFields()
+{
+    var typeCount = 1000;
+    var fieldsPerType = 100;
+
+    var genPtr = host.getModuleType("ntdll", "int *");
+    var ptrSize = genPtr.size;
+
+    var baseName = __getUniqueName("derived");
+    var base = __symbolBuilderSymbols.Types.Create(baseName);
+    base.Fields.Add("x", "int");
+
+    var spellings = [baseName + "*", baseName + " *", baseName + " * [4]", baseName + "*[4]", baseName + " &",
+                     "int*[2]", "int *[2]"];
+    var sizes = [ptrSize, ptrSize, 4 * ptrSize, 4 * ptrSize, ptrSize, 2 * ptrSize, 2 * ptrSize];
+
+    var types = [];
+    var fields = [];
+    var startTime = Date.now();
+    for (var i = 0; i < typeCount; ++i)
+    {
+        var ty = __symbolBuilderSymbols.Types.Create(__getUniqueName("derivedfields"));
+        for (var j = 0; j < fieldsPerType; ++j)
+        {
+            var fld = ty.Fields.Add("f" + j, spellings[j % spellings.length]);
+            if (i == 0)
+            {
+                fields.push(fld);
+            }
+        }
+        types.push(ty);
+    }
+    var elapsed = Date.now() - startTime;
+
+    host.diagnostics.debugLog("    DerivedTypeFields: ", typeCount * fieldsPerType, " fields in ", elapsed, "ms\n");
+
+    for (var j = 0; j < spellings.length; ++j)
+    {
+        __VERIFY(fields[j].Type.Size == sizes[j], "unexpected size of field type '" + spellings[j] + "'");
+    }
+
+    __VERIFY(fields[0].Type.BaseType.Name == baseName, "unexpected base type of '" + spellings[0] + "'");
+    __VERIFY(fields[3].Type.ArraySize == 4, "unexpected array dimension of '" + spellings[3] + "'");
+    __VERIFY(fields[3].Type.BaseType.BaseType.Name == baseName, "unexpected base type of '" + spellings[3] + "'");
+
+    for (var ty of types)
+    {
+        ty.Delete();
+    }
+    base.Delete();
+    return true;
+}
+
+// Test_NamePoolWorkload:
+//
+// Benchmark style test which builds a million field symbols whose names repeat across types, measures the time
+// taken and the name storage held by the name pool against the storage the same names would take if each
+// symbol held its own copy, and then checks that the names are given back to the pool as the symbols go away.
+//
+function Test_NamePoolWorkload()
+{
+    var typeCount = 1000;
+    var fieldsPerType = 1000;
+
+    var before = __symbolBuilderSymbols.NameStatistics;
+
+    var types = [];
+    var startTime = Date.now();
+    for (var i = 0; i < typeCount; ++i)
+    {
+        var ty = __symbolBuilderSymbols.Types.Create(__getUniqueName("namepool"));
+        __symbolBuilderSymbols.Batch(function()
+        {
+            for (var j = 0; j < fieldsPerType; ++j)
+            {
+                ty.Fields.Add("field" + j, "int");
+            }
+        });
+        types.push(ty);
+    }
+    var elapsed = Date.now() - startTime;
+
+    var peak = __symbolBuilderSymbols.NameStatistics;
+    var addedNames = peak.Names - before.Names;
+    var addedReferences = peak.References - before.References;
+    var addedPooledBytes = peak.PooledBytes - before.PooledBytes;
+    var addedUnpooledBytes = peak.UnpooledBytes - before.UnpooledBytes;
+
+    host.diagnostics.debugLog("    NamePoolWorkload: ", typeCount * (fieldsPerType + 1), " symbols built in ", elapsed,
+                              "ms; ", addedReferences, " names pooled as ", addedNames, " distinct names in ",
+                              addedPooledBytes, " bytes rather than ", addedUnpooledBytes, " bytes\n");
+
+    //
+    // Each field name is shared by every type and each type name is distinct.
+    //
+    __VERIFY(addedNames == fieldsPerType + typeCount, "unexpected number of pooled names");
+    __VERIFY(addedReferences == typeCount * (fieldsPerType + 1), "unexpected number of pooled name references");
+    __VERIFY(addedPooledBytes < addedUnpooledBytes / 100, "repeated names were not stored once");
+
+    startTime = Date.now();
+    for (var ty of types)
+    {
+        ty.Delete();
+    }
+    types = [];
+    elapsed = Date.now() - startTime;
+
+    //
+    // The script may still hold a few of the symbols until it collects them; the rest must already have given
+    // back their names.
+    //
+    var after = __symbolBuilderSymbols.NameStatistics;
+    host.diagnostics.debugLog("    NamePoolWorkload: deleted in ", elapsed, "ms; ", after.References - before.References,
+                              " name references and ", after.PooledBytes - before.PooledBytes,
+                              " bytes of names remain\n");
+
+    __VERIFY(after.References - before.References < addedReferences / 2, "names were not released by deleted symbols");
+    return true;
+}
+
+// Test_BackgroundImport:
+//
+// Benchmark style test which creates automatically imported symbols for a module with a background import.  A
+// query made while the background import runs is answered on demand ahead of it.  The background import must
+// then run to completion and account for every symbol it found.
+//
+function Test_BackgroundImport()
+{
+    var startTime = Date.now();
+    var syms = __symBuilder.CreateSymbols("user32.dll", { AutoImportSymbols: true, BackgroundImport: true });
+
+    var queryStart = Date.now();
+    var matches = 0;
+    for (var sym of syms.FindSymbols("MessageBox*"))
+    {
+        ++matches;
+    }
+    var queryElapsed = Date.now() - queryStart;
+    __VERIFY(matches > 0, "unable to find 'MessageBox*' during a background import");
+
+    var progress = syms.ImportProgress;
+    while (progress.State == "Enumerating" || progress.State == "Importing")
+    {
+        __VERIFY(Date.now() - startTime < 300000, "background import did not finish in time");
+        progress = syms.ImportProgress;
+    }
+    var importElapsed = Date.now() - startTime;
+
+    __VERIFY(progress.State == "Completed", "unexpected background import state '" + progress.State + "'");
+    __VERIFY(progress.Total > 0, "background import found nothing to import");
+    __VERIFY(progress.Processed == progress.Total, "background import did not process everything it found");
+
+    host.diagnostics.debugLog("    BackgroundImport: query in ", queryElapsed, "ms; ", progress.Total,
+                              " symbols imported in ", importElapsed, "ms\n");
+
+    //
+    // Cancelling a finished import changes nothing.
+    //
+    syms.CancelImport();
+    __VERIFY(syms.ImportProgress.State == "Completed", "unexpected background import state after cancel");
+    return true;
+}
+
+// Test_ImageSharingStatistics:
+//
+// Creates shared, automatically imported symbols for kernelbase and reports what a second process with the same image
+// would hold privately (its own copy of every symbol) and what it would share (the names).  The test harness only runs
+// one process, so this symbol set is the only one sharing the image and there is no in memory snapshot to hold.  Note
+// that kernelbase keeps these symbols for the remainder of the session.
+//
+function Test_ImageSharingStatistics()
+{
+    var syms = __symBuilder.CreateSymbols("kernelbase.dll", { AutoImportSymbols: true, ShareImageSymbols: true });
+
+    var matches = 0;
+    for (var sym of syms.FindSymbols("CreateFile*"))
+    {
+        ++matches;
+    }
+    __VERIFY(matches > 0, "unable to find 'CreateFile*' in kernelbase");
+
+    var sharing = syms.ImageSharing;
+    var names = syms.NameStatistics;
+    host.diagnostics.debugLog("    ImageSharingStatistics: ", sharing.Sets, " set(s) share the image; ", sharing.Symbols,
+                              " private symbols per process; ", names.PooledBytes, " bytes of shared names (",
+                              names.UnpooledBytes, " bytes unshared); ", sharing.SnapshotBytes,
+                              " bytes of snapshot held\n");
+
+    __VERIFY(sharing.Sets == 1, "unexpected number of symbol sets sharing kernelbase");
+    __VERIFY(sharing.Symbols > 0, "no private symbols were counted");
+    __VERIFY(sharing.SnapshotBytes == 0, "a snapshot is held without another process to copy from");
+
+    var unshared = __symbolBuilderSymbols.ImageSharing;
+    __VERIFY(unshared.Sets == 0, "symbols created without ShareImageSymbols report sharing");
+    __VERIFY(unshared.SnapshotBytes == 0, "symbols created without a snapshot hold one");
+    return true;
+}
+
+// Test_SnapshotRoundTrip:
+//
+// Saves the symbols for notepad to a snapshot and loads that snapshot as the symbols for kernel32.  Verifies that the
+// snapshot is rejected for kernel32 unless a mismatch of the module image is explicitly allowed, and that types, fields,
+// enumerants, globals, functions (with their parameters, locals, and live ranges), and publics survive the round trip.
+// Reports how long a large synthetic symbol set takes to save and load and how long creating the (deferred) members
+// of its types takes on first use.  Note that kernel32 keeps the loaded symbols for the remainder of the session.
+//
+function Test_SnapshotRoundTrip()
+{
+    var typeCount = 5000;
+    var fieldCount = 10;
+    var prefix = __getUniqueName("snap");
+    var fileName = prefix + ".symsnap";
+
+    var types = [];
+    __symbolBuilderSymbols.BeginBatch();
+    for (var i = 0; i < typeCount; ++i)
+    {
+        var ty = __symbolBuilderSymbols.Types.Create(prefix + "_t" + i);
+        for (var f = 0; f < fieldCount; ++f)
+        {
+            ty.Fields.Add("f" + f, (f % 2 == 0) ? "int" : "char");
+        }
+        types.push(ty);
+    }
+    __symbolBuilderSymbols.CommitBatch();
+
+    var outerName = prefix + "_outer";
+    var outer = __symbolBuilderSymbols.Types.Create(outerName);
+    outer.BaseClasses.Add(types[0]);
+    outer.Fields.Add("p", prefix + "_t1 *");
+    outer.Fields.Add("arr", __symbolBuilderSymbols.Types.CreateArray("int", 4));
+    outer.Fields.Add("bits", "char: 3");
+    outer.Fields.Add("manual", "int", 0x100);
+
+    var enumName = prefix + "_enum";
+    var enumType = __symbolBuilderSymbols.Types.CreateEnum(enumName);
+    enumType.Enumerants.Add("first");
+    enumType.Enumerants.Add("second", 42);
+    enumType.Enumerants.Add("third");
+
+    var typedefName = prefix + "_outer_t";
+    var typedefType = __symbolBuilderSymbols.Types.CreateTypedef(typedefName, outer);
+
+    var globalName = prefix + "_global";
+    var global = __symbolBuilderSymbols.Data.CreateGlobal(globalName, typedefName, 0x100);
+
+    var fnName = prefix + "_fn";
+    var fn = __symbolBuilderSymbols.Functions.Create(fnName, "int", 0x1000, 0x40);
+    var param = fn.Parameters.Add("a", "int");
+    param.LiveRanges.Add(0, 0x10, "@rcx");
+    param.LiveRanges.Add(0x10, 0x20, "[@rsp + 8]");
+    fn.LocalVariables.Add("l", outer);
+
+    var publicName = prefix + "_pub";
+    var pub = __symbolBuilderSymbols.Publics.Create(publicName, 0x2000);
+
+    var startTime = Date.now();
+    __symbolBuilderSymbols.SaveSnapshot(fileName);
+    var saveElapsed = Date.now() - startTime;
+
+    var rejected = false;
+    try
+    {
+        __symBuilder.CreateSymbols("kernel32.dll", { SnapshotFile: fileName });
+    }
+    catch(exc)
+    {
+        rejected = true;
+    }
+    __VERIFY(rejected, "snapshot of notepad loaded for kernel32 without allowing an image mismatch");
+
+    startTime = Date.now();
+    var loaded = __symBuilder.CreateSymbols("kernel32.dll", { SnapshotFile: fileName, AllowImageMismatch: true });
+    var loadElapsed = Date.now() - startTime;
+
+    __ctl.ExecuteCommand(".reload");
+
+    var lastOf = function(data)
+    {
+        var last = null;
+        for (var datum of data)
+        {
+            last = datum;
+        }
+        return last;
+    };
+
+    var matches = 0;
+    for (var sym of loaded.FindSymbols(prefix + "_t*"))
+    {
+        ++matches;
+    }
+    __VERIFY(matches == typeCount, "unexpected number of loaded types");
+
+    startTime = Date.now();
+    var loadedFields = 0;
+    for (var i = 0; i < typeCount; ++i)
+    {
+        var lazyTy = host.getModuleType("kernel32.dll", prefix + "_t" + i);
+        loadedFields += __COUNTOF(Object.getOwnPropertyNames(lazyTy.fields));
+    }
+    var membersElapsed = Date.now() - startTime;
+    __VERIFY(loadedFields == typeCount * fieldCount, "unexpected number of loaded fields");
+
+    var origTy = host.getModuleType("notepad.exe", outerName);
+    var loadedTy = host.getModuleType("kernel32.dll", outerName);
+    __VERIFY(loadedTy.size == origTy.size, "unexpected size of loaded type");
+    for (var fld of ["p", "arr", "bits", "manual"])
+    {
+        __VERIFY(loadedTy.fields[fld].offset == origTy.fields[fld].offset, "unexpected offset of loaded '" + fld + "'");
+    }
+    __VERIFY(loadedTy.fields.manual.offset == 0x100, "unexpected offset of loaded manual field");
+    __VERIFY(loadedTy.fields.p.type.baseType.name == prefix + "_t1", "unexpected type of loaded pointer field");
+
+    var loadedEnum = host.getModuleType("kernel32.dll", enumName);
+    __VERIFY(loadedEnum.fields.first.value == 0, "unexpected value of loaded 'first'");
+    __VERIFY(loadedEnum.fields.second.value == 42, "unexpected value of loaded 'second'");
+    __VERIFY(loadedEnum.fields.third.value == 43, "unexpected value of loaded 'third'");
+
+    var loadedTypedef = host.getModuleType("kernel32.dll", typedefName);
+    __VERIFY(loadedTypedef.size == origTy.size, "unexpected size of loaded typedef");
+
+    var loadedGlobal = lastOf(loaded.FindSymbols(globalName));
+    __VERIFY(loadedGlobal.Offset == 0x100, "unexpected offset of loaded global");
+    __VERIFY(loadedGlobal.Type.Name == typedefName, "unexpected type of loaded global");
+
+    var loadedFn = lastOf(loaded.FindSymbols(fnName));
+    __VERIFY(loadedFn.ReturnType.Name == "int", "unexpected return type of loaded function");
+    __VERIFY(__COUNTOF(loadedFn.Parameters) == 1, "unexpected parameter count of loaded function");
+    __VERIFY(__COUNTOF(loadedFn.LocalVariables) == 1, "unexpected local count of loaded function");
+    var loadedParam = lastOf(loadedFn.Parameters);
+    __VERIFY(loadedParam.Name == "a", "unexpected name of loaded parameter");
+    __VERIFY(__COUNTOF(loadedParam.LiveRanges) == 2, "unexpected live range count of loaded parameter");
+    var loadedRange = lastOf(loadedParam.LiveRanges);
+    __VERIFY(loadedRange.Offset == 0x10 && loadedRange.Size == 0x20, "unexpected loaded live range");
+
+    var loadedPub = lastOf(loaded.FindSymbols(publicName));
+    __VERIFY(loadedPub.Offset == 0x2000, "unexpected offset of loaded public");
+
+    host.diagnostics.debugLog("    SnapshotRoundTrip: ", typeCount * (fieldCount + 1), " symbols saved in ", saveElapsed,
+                              "ms; loaded in ", loadElapsed, "ms; members of ", typeCount, " types created on first use in ",
+                              membersElapsed, "ms\n");
+
+    host.namespace.Debugger.Utility.FileSystem.DeleteFile(fileName);
+
+    pub.Delete();
+    fn.Delete();
+    global.Delete();
+    typedefType.Delete();
+    enumType.Delete();
+    outer.Delete();
+    for (var ty of types)
+    {
+        ty.Delete();
+    }
+    return true;
+}
+
+// __getNtdllSymbols:
+//
+// Creates (once) and returns symbol builder symbols for ntdll.  The ntdll module itself is left in
+// __ntdllModule.
+//
+function __getNtdllSymbols()
+{
+    if (__ntdllSymbols == null)
+    {
+        for (var mod of host.currentProcess.Modules)
+        {
+            if (mod.Name.toLowerCase().endsWith("ntdll.dll"))
+            {
+                __ntdllModule = mod;
+                break;
+            }
+        }
+        __VERIFY(__ntdllModule != null, "unable to find ntdll");
+
+        __ntdllSymbols = __symBuilder.CreateSymbols("ntdll.dll");
+    }
+    return __ntdllSymbols;
+}
+
+// Test_ModuleLiveRangeScaling:
+//
+// Promotes a set of exports from ntdll into functions with a single parameter and propagates parameter
+// live ranges across the whole module at a number of thread counts.  Every run must propagate the same
+// functions to the same live ranges.
+//
+function Test_ModuleLiveRangeScaling()
+{
+    var functionLimit = 512;
+
+    var symbols = __getNtdllSymbols();
+    var ntdll = __ntdllModule;
+
+    var functionCount = 0;
+    for (var exp of ntdll.Contents.Exports)
+    {
+        if (functionCount >= functionLimit)
+        {
+            break;
+        }
+
+        try
+        {
+            var pub = symbols.Publics.Create(exp.Name, exp.CodeAddress - ntdll.BaseAddress);
+            var fn = pub.PromoteToFunction(0, "int");
+            fn.Parameters.Add("p", "void *");
+            ++functionCount;
+        }
+        catch(exc)
+        {
+            //
+            // Forwarded exports, data exports, and anything the disassembler cannot walk are simply skipped.
+            //
+        }
+    }
+    __VERIFY(functionCount > 0, "unable to promote any ntdll exports");
+
+    var propagatedCount = -1;
+    var expectedRanges = null;
+    for (var threadCount of [1, 2, 4, 8])
+    {
+        var startTime = Date.now();
+        var propagated = symbols.Functions.PropagateLiveRangesFromCallingConvention({ ThreadCount: threadCount });
+        var elapsed = Date.now() - startTime;
+
+        __VERIFY(propagated > 0, "no functions propagated");
+        if (propagatedCount == -1)
+        {
+            propagatedCount = propagated;
+        }
+        __VERIFY(propagated == propagatedCount, "unexpected change in propagated count with thread count");
+
+        host.diagnostics.debugLog("    ModuleLiveRangeScaling: ", propagated, " of ", functionCount, 
+                                  " functions on ", threadCount, " thread(s) in ", elapsed, "ms\n");
+
+        var ranges = __describeLiveRanges(symbols);
+        if (expectedRanges == null)
+        {
+            expectedRanges = ranges;
+        }
+        for (var name in expectedRanges)
+        {
+            __VERIFY(ranges[name] == expectedRanges[name],
+                     "unexpected change in live ranges of " + name + " on " + threadCount + " thread(s)");
+        }
+        __VERIFY(Object.keys(ranges).length == Object.keys(expectedRanges).length,
+                 "unexpected change in the functions with live ranges on " + threadCount + " thread(s)");
+    }
+
+    return true;
+}
+
+// Test_LiveRangeLoopsAndSwitches:
+//
+// Propagates parameter live ranges through a set of ntdll routines which are dominated by loops (string and
+// memory routines) or large switch tables (status translation and compression format dispatch) and logs how
+// long each takes.  Blocks are walked in reverse postorder: a block in an acyclic region is walked once and a
+// loop is walked again only while the ranges entering it change, so the number of block walks must stay within
+// a small multiple of the number of blocks and must be the same each time the function is propagated.
+//
+function Test_LiveRangeLoopsAndSwitches()
+{
+    var routines = ["RtlCompareMemory", "RtlMultiByteToUnicodeN", "RtlUnicodeToMultiByteN",
+                    "RtlNtStatusToDosError", "RtlDecompressBuffer", "RtlCompressBuffer"];
+
+    var symbols = __getNtdllSymbols();
+    var ntdll = __ntdllModule;
+
+    var propagatedCount = 0;
+    for (var exp of ntdll.Contents.Exports)
+    {
+        if (routines.indexOf(exp.Name) == -1)
+        {
+            continue;
+        }
+
+        var fn = null;
+        try
+        {
+            var pub = symbols.Publics.Create(exp.Name, exp.CodeAddress - ntdll.BaseAddress);
+            fn = pub.PromoteToFunction(0, "int");
+            for (var i = 0; i < 4; ++i)
+            {
+                fn.Parameters.Add("p" + i, "void *");
+            }
+        }
+        catch(exc)
+        {
+            //
+            // Already promoted by an earlier test or not something the disassembler can walk.
+            //
+            continue;
+        }
+
+        var startTime = Date.now();
+        var stats = fn.Parameters.PropagateLiveRangesFromCallingConvention();
+        var elapsed = Date.now() - startTime;
+
+        __VERIFY(stats.BasicBlocks > 0, "no basic blocks found for " + exp.Name);
+        __VERIFY(stats.BlockTraversals >= 1, "no basic blocks walked for " + exp.Name);
+        __VERIFY(stats.BlockTraversals <= 4 * stats.BasicBlocks,
+                 "too many basic block walks for " + exp.Name + ": " + stats.BlockTraversals + " for " +
+                 stats.BasicBlocks + " blocks");
+
+        var restats = fn.Parameters.PropagateLiveRangesFromCallingConvention();
+        __VERIFY(restats.BasicBlocks == stats.BasicBlocks && restats.BlockTraversals == stats.BlockTraversals,
+                 "unexpected change in basic block walks when propagating " + exp.Name + " again");
+
+        var rangeCount = 0;
+        for (var param of fn.Parameters)
+        {
+            rangeCount += __COUNTOF(param.LiveRanges);
+        }
+        __VERIFY(rangeCount > 0, "no live ranges propagated for " + exp.Name);
+        ++propagatedCount;
+
+        host.diagnostics.debugLog("    LiveRangeLoopsAndSwitches: ", exp.Name, " has ", rangeCount,
+                                  " live ranges in ", elapsed, "ms (", stats.BlockTraversals, " walks of ",
+                                  stats.BasicBlocks, " blocks)\n");
+    }
+    __VERIFY(propagatedCount > 0, "unable to propagate live ranges for any routine");
+
+    return true;
+}
+
+// __describeLiveRanges:
+//
+// Returns a string describing every parameter live range of every function in the symbol set keyed by function
+// name.
+//
+function __describeLiveRanges(symbols)
+{
+    var descriptions = {};
+    for (var fn of symbols.Functions)
+    {
+        var desc = "";
+        for (var param of fn.Parameters)
+        {
+            for (var range of param.LiveRanges)
+            {
+                desc += param.Name + ":" + range.Offset.toString(16) + "+" + range.Size.toString(16) + "=" +
+                        range.Location + ";";
+            }
+        }
+        descriptions[fn.Name] = desc;
+    }
+    return descriptions;
+}
+
+// Test_NativeDecoderLiveRanges:
+//
+// Propagates parameter live ranges across the ntdll functions promoted by earlier tests both with and without
+// the built in decoder and logs how long each takes.  Every function must end up with the same ranges either way.
+//
+function Test_NativeDecoderLiveRanges()
+{
+    var symbols = __getNtdllSymbols();
+
+    var startTime = Date.now();
+    var disPropagated = symbols.Functions.PropagateLiveRangesFromCallingConvention({ UseNativeDecoder: false });
+    var disElapsed = Date.now() - startTime;
+    var disRanges = __describeLiveRanges(symbols);
+
+    startTime = Date.now();
+    var nativePropagated = symbols.Functions.PropagateLiveRangesFromCallingConvention({ UseNativeDecoder: true });
+    var nativeElapsed = Date.now() - startTime;
+    var nativeRanges = __describeLiveRanges(symbols);
+
+    __VERIFY(disPropagated > 0, "no functions propagated");
+    __VERIFY(nativePropagated == disPropagated, "unexpected change in propagated count with the built in decoder");
+
+    var differing = [];
+    for (var name in disRanges)
+    {
+        if (disRanges[name] != nativeRanges[name])
+        {
+            differing.push(name);
+        }
+    }
+
+    host.diagnostics.debugLog("    NativeDecoderLiveRanges: ", nativePropagated, " functions in ", disElapsed,
+                              "ms with the disassembler and ", nativeElapsed, "ms with the built in decoder (",
+                              differing.length, " with different ranges)\n");
+
+    __VERIFY(differing.length == 0, "different live ranges with the built in decoder for: " + differing.join(", "));
+
+    return true;
+}
+
 //**************************************************************************
 // Initialization:
 //
@@ -1187,6 +2296,10 @@ var __testSuite =
     { Name: "StructDeleteFields", Code: Test_StructDeleteFields },
     { Name: "StructChangeFieldType", Code: Test_StructChangeFieldType },
     { Name: "StructMoveField", Code: Test_StructMoveField },
+    { Name: "StructBatchedLayout", Code: Test_StructBatchedLayout },
+    { Name: "StructBatchCallback", Code: Test_StructBatchCallback },
+    { Name: "DeepDependencyGraphLayout", Code: Test_DeepDependencyGraphLayout },
+    { Name: "WideDependencyGraphLayout", Code: Test_WideDependencyGraphLayout },
 
     //
     // Pointer/Array Tests:
@@ -1209,7 +2322,32 @@ var __testSuite =
     {Name: "BitfieldWithAutoLayout", Code: Test_BitfieldWithAutoLayout },
     {Name: "BitfieldWithManualLayout", Code: Test_BitfieldWithManualLayout },
     {Name: "BitfieldWithMixedAutoManualLayout", Code: Test_BitfieldWithMixedAutoManualLayout },
-    {Name: "BitfieldMoveField", Code: Test_BitfieldMoveField }
+    {Name: "BitfieldMoveField", Code: Test_BitfieldMoveField },
+
+    //
+    // Symbol Index Tests:
+    //
+    {Name: "PublicsBulkLoadAndQuery", Code: Test_PublicsBulkLoadAndQuery },
+    {Name: "WideUdtFieldLookup", Code: Test_WideUdtFieldLookup },
+    {Name: "FindSymbolsByPattern", Code: Test_FindSymbolsByPattern },
+    {Name: "LookupThroughput", Code: Test_LookupThroughput },
+    {Name: "ConcurrentLookupThroughput", Code: Test_ConcurrentLookupThroughput },
+    {Name: "DerivedTypeFields", Code: Test_DerivedTypeFields },
+    {Name: "NamePoolWorkload", Code: Test_NamePoolWorkload },
+    {Name: "BackgroundImport", Code: Test_BackgroundImport },
+
+    //
+    // Snapshot Tests:
+    //
+    {Name: "SnapshotRoundTrip", Code: Test_SnapshotRoundTrip },
+    {Name: "ImageSharingStatistics", Code: Test_ImageSharingStatistics },
+
+    //
+    // Live Range Tests:
+    //
+    {Name: "ModuleLiveRangeScaling", Code: Test_ModuleLiveRangeScaling },
+    {Name: "LiveRangeLoopsAndSwitches", Code: Test_LiveRangeLoopsAndSwitches },
+    {Name: "NativeDecoderLiveRanges", Code: Test_NativeDecoderLiveRanges }
 
 ];
 
@@ -39,9 +39,56 @@ ISvcMemoryAccess *SymbolBuilderProcess::GetVirtualMemory() const
     return m_pOwningManager->GetVirtualMemory();
 }
 
+HRESULT SymbolBuilderProcess::ReadVirtualMemory(_In_ ULONG64 address,
+                                                _Out_writes_bytes_(size) void *pBuffer,
+                                                _In_ ULONG64 size,
+                                                _Out_ ULONG64 *pBytesRead) const
+{
+    HRESULT hr = S_OK;
+    *pBytesRead = 0;
+
+    //
+    // If we have a generalized view of the kernel and not a specific "process context", we can go and ask
+    // for the generalized kernel address context in which to perform any memory reads.
+    //
+    ComPtr<ISvcAddressContext> spAddrCtx;
+    if (m_isKernel && m_processKey == 0)
+    {
+        IfFailedReturn(m_pOwningManager->GetKernelAddressContext(&spAddrCtx));
+    }
+    else
+    {
+        ComPtr<ISvcProcess> spProcess;
+        IfFailedReturn(m_pOwningManager->ProcessKeyToProcess(m_processKey, &spProcess));
+        IfFailedReturn(spProcess.As(&spAddrCtx));
+    }
+
+    return GetVirtualMemory()->ReadMemory(spAddrCtx.Get(), address, pBuffer, size, pBytesRead);
+}
+
+bool SymbolBuilderProcess::TryGetSymbolsForImage(_In_ std::wstring const& imageIdentity,
+                                                 _COM_Outptr_ SymbolSet **ppSymbols)
+{
+    *ppSymbols = nullptr;
+    for (auto&& kvp : m_symbols)
+    {
+        if (kvp.second->GetImageIdentity() == imageIdentity)
+        {
+            ComPtr<SymbolSet> spSymbols = kvp.second;
+            *ppSymbols = spSymbols.Detach();
+            return true;
+        }
+    }
+
+    return false;
+}
+
 HRESULT SymbolBuilderProcess::CreateSymbolsForModule(_In_ ISvcModule *pModule,
                                                      _In_ ULONG64 moduleKey,
-                                                     _COM_Outptr_ SymbolSet **ppSymbols)
+                                                     _COM_Outptr_ SymbolSet **ppSymbols,
+                                                     _In_opt_z_ PCWSTR pwszSnapshotFile,
+                                                     _In_ bool shareImageSymbols,
+                                                     _In_ bool allowImageMismatch)
 {
     HRESULT hr = S_OK;
     *ppSymbols = nullptr;
@@ -56,8 +103,88 @@ HRESULT SymbolBuilderProcess::CreateSymbolsForModule(_In_ ISvcModule *pModule,
         return E_INVALIDARG;
     }
 
+    //
+    // The same image loaded into many processes (or sessions) has the same symbols.  Share the names and start
+    // from a copy of the symbols another process has already built or imported.  Failure to find any of this
+    // just means the symbol set starts from scratch.
+    //
+    std::wstring imageIdentity;
+    std::shared_ptr<SharedImageSymbols> spSharedImage;
+    std::shared_ptr<NamePool> spNamePool;
+    std::shared_ptr<std::vector<BYTE> const> spSnapshot;
+    if (shareImageSymbols && SUCCEEDED(SymbolBuilderManager::GetModuleImageIdentity(pModule, &imageIdentity)))
+    {
+        if (SUCCEEDED(m_pOwningManager->GetSharedImageSymbols(imageIdentity, this, &spSharedImage)))
+        {
+            spNamePool = spSharedImage->Names;
+            if (pwszSnapshotFile == nullptr)
+            {
+                spSnapshot = spSharedImage->Snapshot;
+            }
+        }
+        else
+        {
+            imageIdentity.clear();
+        }
+    }
+
+    bool addBasicCTypes = (pwszSnapshotFile == nullptr && spSnapshot == nullptr);
+
     ComPtr<SymbolSet> spSymbolSet;
-    IfFailedReturn(MakeAndInitialize<SymbolSet>(&spSymbolSet, pModule, this));
+    IfFailedReturn(MakeAndInitialize<SymbolSet>(&spSymbolSet, pModule, this, addBasicCTypes, spNamePool));
+
+    IfFailedReturn(ConvertException([&](){
+        spSymbolSet->SetSharedImage(imageIdentity, spSharedImage);
+        return S_OK;
+    }));
+
+    //
+    // A snapshot carries its own basic types.  The members of its UDTs are created from it when they are first
+    // needed, so the symbol set owns the reader (and hence the snapshot) until then.  The reader must be set
+    // before the snapshot is read since anything which needs the layout of a UDT during the load creates its
+    // members through the symbol set.
+    //
+    if (pwszSnapshotFile != nullptr || spSnapshot != nullptr)
+    {
+        SymbolSnapshotReader *pReader = nullptr;
+        IfFailedReturn(ConvertException([&](){
+            std::unique_ptr<SymbolSnapshotReader> spReader =
+                std::make_unique<SymbolSnapshotReader>(spSymbolSet.Get(), allowImageMismatch);
+            pReader = spReader.get();
+            spSymbolSet->SetSnapshotReader(std::move(spReader));
+            return S_OK;
+        }));
+
+        if (pwszSnapshotFile != nullptr)
+        {
+            IfFailedReturn(pReader->ReadFromFile(pwszSnapshotFile));
+        }
+        else
+        {
+            IfFailedReturn(pReader->ReadFromBuffer(spSnapshot));
+
+            //
+            // What the importer of the source symbols had already imported is now in this symbol set too.  Hand
+            // that (in terms of this symbol set's ids) to whatever importer is set so that it does not import it
+            // again.
+            //
+            if (spSharedImage->SnapshotImportState != nullptr)
+            {
+                std::unique_ptr<ImportState> spImportState;
+                IfFailedReturn(ConvertException([&](){
+                    spImportState = std::make_unique<ImportState>(*spSharedImage->SnapshotImportState);
+                    return S_OK;
+                }));
+                IfFailedReturn(pReader->LoadImportState(spImportState.get()));
+                spSymbolSet->SetSeedImportState(std::move(spImportState));
+            }
+        }
+
+        if (!pReader->HasDeferredMembers())
+        {
+            spSymbolSet->SetSnapshotReader(nullptr);
+        }
+    }
 
     //
     // We cannot let a C++ exception escape.
@@ -73,6 +200,130 @@ HRESULT SymbolBuilderProcess::CreateSymbolsForModule(_In_ ISvcModule *pModule,
     return hr;
 }
 
+HRESULT SymbolBuilderManager::GetModuleImageIdentity(_In_ ISvcModule *pModule, _Out_ std::wstring *pImageIdentity)
+{
+    HRESULT hr = S_OK;
+
+    ComPtr<ISvcModuleWithTimestampAndChecksum> spModuleTimestamp;
+    IfFailedReturn(pModule->QueryInterface(IID_PPV_ARGS(&spModuleTimestamp)));
+
+    ULONG timeStamp;
+    IfFailedReturn(spModuleTimestamp->GetTimeDateStamp(&timeStamp));
+
+    ULONG64 moduleSize;
+    IfFailedReturn(pModule->GetSize(&moduleSize));
+
+    BSTR moduleName;
+    IfFailedReturn(pModule->GetName(&moduleName));
+    bstr_ptr spModuleName(moduleName);
+
+    auto fn = [&]()
+    {
+        wchar_t buf[64];
+        swprintf_s(buf, ARRAYSIZE(buf), L"|%08x|%I64x", timeStamp, moduleSize);
+
+        *pImageIdentity = moduleName;
+        std::transform(pImageIdentity->begin(), pImageIdentity->end(), pImageIdentity->begin(), towlower);
+        *pImageIdentity += buf;
+        return S_OK;
+    };
+    return ConvertException(fn);
+}
+
+HRESULT SymbolBuilderManager::GetSharedImageSymbols(_In_ std::wstring const& imageIdentity,
+                                                    _In_ SymbolBuilderProcess *pRequestingProcess,
+                                                    _Out_ std::shared_ptr<SharedImageSymbols> *pspSharedImage)
+{
+    pspSharedImage->reset();
+
+    auto fn = [&]()
+    {
+        HRESULT hr = S_OK;
+
+        //
+        // Once the last symbol set for an image has gone away, so has what was shared for it (names and any
+        // snapshot).  Drop any such entries.
+        //
+        for (auto its = m_sharedImages.begin(); its != m_sharedImages.end(); )
+        {
+            if (its->second.expired())
+            {
+                its = m_sharedImages.erase(its);
+            }
+            else
+            {
+                ++its;
+            }
+        }
+
+        std::shared_ptr<SharedImageSymbols> spShared;
+        auto it = m_sharedImages.find(imageIdentity);
+        if (it != m_sharedImages.end())
+        {
+            spShared = it->second.lock();
+        }
+
+        if (spShared == nullptr)
+        {
+            spShared = std::make_shared<SharedImageSymbols>();
+            spShared->Names = std::make_shared<NamePool>();
+            spShared->SnapshotProcessKey = 0;
+            spShared->SnapshotVersion = 0;
+            m_sharedImages[imageIdentity] = spShared;
+        }
+        SharedImageSymbols& shared = *spShared;
+
+        //
+        // The last snapshot can be handed out again if the symbols it was taken from are still there and have not
+        // changed since.
+        //
+        if (shared.Snapshot != nullptr)
+        {
+            ComPtr<SymbolSet> spSource;
+            auto itp = m_trackedProcesses.find(shared.SnapshotProcessKey);
+            if (itp == m_trackedProcesses.end() ||
+                !itp->second->TryGetSymbolsForImage(imageIdentity, &spSource) ||
+                spSource->GetChangeVersion() != shared.SnapshotVersion)
+            {
+                shared.Snapshot = nullptr;
+                shared.SnapshotImportState = nullptr;
+            }
+        }
+
+        if (shared.Snapshot == nullptr)
+        {
+            for (auto&& kvp : m_trackedProcesses)
+            {
+                ComPtr<SymbolSet> spSource;
+                if (kvp.second.Get() == pRequestingProcess ||
+                    !kvp.second->TryGetSymbolsForImage(imageIdentity, &spSource))
+                {
+                    continue;
+                }
+
+                auto spBuffer = std::make_shared<std::vector<BYTE>>();
+                auto spImportState = std::make_shared<ImportState>();
+                SymbolSnapshotWriter writer(spSource.Get());
+                IfFailedReturn(writer.WriteToBuffer(spBuffer.get(), spImportState.get()));
+
+                //
+                // Taking the snapshot may itself have changed the source (e.g.: importing deferred members).  The
+                // version after the snapshot is the one it reflects.
+                //
+                shared.Snapshot = std::move(spBuffer);
+                shared.SnapshotImportState = std::move(spImportState);
+                shared.SnapshotProcessKey = kvp.first;
+                shared.SnapshotVersion = spSource->GetChangeVersion();
+                break;
+            }
+        }
+
+        *pspSharedImage = std::move(spShared);
+        return hr;
+    };
+    return ConvertException(fn);
+}
+
 HRESULT SymbolBuilderManager::TrackProcessForKey(_In_ bool isKernel,
                                                  _In_ ULONG64 processKey,
                                                  _COM_Outptr_ SymbolBuilderProcess **ppProcess)
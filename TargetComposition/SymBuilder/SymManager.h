@@ -25,6 +25,21 @@ namespace SymbolBuilder
 
 class SymbolBuilderManager;
 
+// SharedImageSymbols:
+//
+// What is shared between the symbol sets for the same module image in different processes.  Each such symbol set
+// holds a reference to this.  The manager only refers to it weakly so that it (and the snapshot it holds) goes away
+// along with the last symbol set for the image.
+//
+struct SharedImageSymbols
+{
+    std::shared_ptr<NamePool> Names;                            // The names of every such symbol set
+    std::shared_ptr<std::vector<BYTE> const> Snapshot;          // The last snapshot taken (if any)
+    std::shared_ptr<ImportState const> SnapshotImportState;     // What had been imported as of the snapshot
+    ULONG64 SnapshotProcessKey;                                 // The process whose symbols were snapshot
+    ULONG64 SnapshotVersion;                                    // The change version they were snapshot at
+};
+
 // SymbolBuilderProcess:
 //
 // Tracks what modules we have defined symbols for within a given process context.
@@ -64,9 +79,30 @@ public:
     // Creates a new symbol set for a given module by its unique "key".  This method will fail if symbols already
     // exist for the module.  The caller has responsibility to check first.
     //
+    // If a snapshot file is given, the symbol set is loaded from it instead of starting with the basic C types.
+    // The symbol set is only associated with the module if the snapshot loads successfully.  A snapshot saved for
+    // a different module image (name, timestamp, and size) does not load unless 'allowImageMismatch' is true.
+    //
+    // Otherwise, if 'shareImageSymbols' is true and another process has shared symbols for the same module image,
+    // the new symbol set starts as a copy of the shared symbols for the image rather than being built or imported
+    // again.  What the importer of those symbols had imported is given to the importer of the new symbol set when
+    // it is set.  Changes to either symbol set after this are private to it.
+    //
     HRESULT CreateSymbolsForModule(_In_ ISvcModule *pModule,
                                    _In_ ULONG64 moduleKey,
-                                   _COM_Outptr_ SymbolSet **ppSymbols);
+                                   _COM_Outptr_ SymbolSet **ppSymbols,
+                                   _In_opt_z_ PCWSTR pwszSnapshotFile = nullptr,
+                                   _In_ bool shareImageSymbols = false,
+                                   _In_ bool allowImageMismatch = false);
+
+    // TryGetSymbolsForImage():
+    //
+    // Checks whether we have symbols for a module with the given image identity (see
+    // SymbolBuilderManager::GetModuleImageIdentity).  If so, true is returned and a pointer to the symbol set
+    // is passed back; otherwise, false is returned.
+    //
+    bool TryGetSymbolsForImage(_In_ std::wstring const& imageIdentity,
+                               _COM_Outptr_ SymbolSet **ppSymbols);
 
     //*************************************************
     // Internal APIs:
@@ -113,6 +149,16 @@ public:
     //
     ISvcMemoryAccess *GetVirtualMemory() const;
 
+    // ReadVirtualMemory():
+    //
+    // Reads memory from the address space of what we are targeting (the process or, for the kernel, the
+    // generalized kernel address context).
+    //
+    HRESULT ReadVirtualMemory(_In_ ULONG64 address,
+                              _Out_writes_bytes_(size) void *pBuffer,
+                              _In_ ULONG64 size,
+                              _Out_ ULONG64 *pBytesRead) const;
+
     // GetProcessKey():
     //
     // Gets the process key for this process.  This will be zero if this represents the kernel and its
@@ -640,6 +686,24 @@ public:
     // Internal APIs:
     //
 
+    // GetModuleImageIdentity():
+    //
+    // Gets a string which identifies the image of a module (its name, timestamp, and size) regardless of
+    // which process it is loaded into.  This fails if the module does not have a timestamp.
+    //
+    static HRESULT GetModuleImageIdentity(_In_ ISvcModule *pModule, _Out_ std::wstring *pImageIdentity);
+
+    // GetSharedImageSymbols():
+    //
+    // Gets what is shared between the symbol sets for a given module image: the pool of names and (if any
+    // process other than the requesting one has shared symbols for the image) a snapshot of those symbols along
+    // with what their importer had imported.  The snapshot is taken once and reused until the symbol set it came
+    // from changes.  The caller must hold the returned shared state for as long as its symbol set exists.
+    //
+    HRESULT GetSharedImageSymbols(_In_ std::wstring const& imageIdentity,
+                                  _In_ SymbolBuilderProcess *pRequestingProcess,
+                                  _Out_ std::shared_ptr<SharedImageSymbols> *pspSharedImage);
+
     // RuntimeClassInitialzie():
     //
     // Initializes the symbol builder manager for a given service container (e.g.: target).  If the 
@@ -671,6 +735,10 @@ private:
     // A listing of our tracked processes.
     std::unordered_map<ULONG64, Microsoft::WRL::ComPtr<SymbolBuilderProcess>> m_trackedProcesses;
 
+    // Shared symbols by module image identity.  Entries whose symbol sets have all gone away are removed the next
+    // time shared symbols are looked up.
+    std::unordered_map<std::wstring, std::weak_ptr<SharedImageSymbols>> m_sharedImages;
+
     // Information about registers so that we can manage live range information for variables.
     std::unordered_map<ULONG, RegisterInformation> m_regInfosById;
     std::unordered_map<std::wstring, ULONG> m_regIds;
@@ -26,15 +26,222 @@ namespace Services
 namespace SymbolBuilder
 {
 
+//*************************************************
+// Name Pool:
+//
+
+std::wstring const NamePool::EmptyName;
+
 //*************************************************
 // Base Symbols:
 //
 
+std::unordered_map<ULONG64, ULONG64> const BaseSymbol::s_noDependentNotifySymbols;
+
 HRESULT BaseSymbol::InitializeNewSymbol(_In_ ULONG64 reservedId)
 {
     return m_pSymbolSet->AddNewSymbol(this, &m_id, reservedId);
 }
 
+void BaseSymbol::InitializeNames(_In_opt_ PCWSTR pwszSymbolName, _In_opt_ PCWSTR pwszQualifiedName)
+{
+    m_spNamePool = m_pSymbolSet->GetNamePool();
+    m_pName = m_spNamePool->Intern(pwszSymbolName);
+    m_pQualifiedName = m_spNamePool->Intern(pwszQualifiedName);
+}
+
+HRESULT BaseSymbol::AddChild(_In_ ULONG64 uniqueId)
+{
+    //
+    // We cannot let a C++ exception escape.
+    //
+    auto fn = [&]()
+    {
+        SymbolSetExclusiveLock lock(InternalGetSymbolSet()->GetLock());
+
+        m_children.push_back(uniqueId);
+
+        //
+        // Children are always added at the end, so the new child is also last amongst those of the same name.
+        //
+        BaseSymbol *pChild = InternalGetSymbolSet()->InternalGetSymbol(uniqueId);
+        if (pChild != nullptr && !pChild->InternalGetName().empty())
+        {
+            if (m_spChildNameIndex == nullptr)
+            {
+                m_spChildNameIndex = std::make_unique<ChildNameIndex>();
+            }
+            (*m_spChildNameIndex)[pChild->InternalGetName()].push_back(uniqueId);
+        }
+
+        return NotifyDependentChange();
+    };
+    return ConvertException(fn);
+}
+
+void BaseSymbol::UnindexChildName(_In_ ULONG64 uniqueId)
+{
+    if (m_spChildNameIndex == nullptr)
+    {
+        return;
+    }
+
+    auto&& childNameIndex = *m_spChildNameIndex;
+    auto removeFrom = [&](ChildNameIndex::iterator it)
+    {
+        auto&& ids = it->second;
+        auto idIt = std::find(ids.begin(), ids.end(), uniqueId);
+        if (idIt == ids.end())
+        {
+            return false;
+        }
+
+        ids.erase(idIt);
+        if (ids.empty())
+        {
+            childNameIndex.erase(it);
+        }
+        return true;
+    };
+
+    BaseSymbol *pChild = InternalGetSymbolSet()->InternalGetSymbol(uniqueId);
+    if (pChild != nullptr)
+    {
+        auto it = childNameIndex.find(pChild->InternalGetName());
+        if (it != childNameIndex.end() && removeFrom(it))
+        {
+            return;
+        }
+    }
+
+    //
+    // The child is no longer resolvable (or was indexed under a different name).  Fall back to searching
+    // every entry.
+    //
+    for (auto it = childNameIndex.begin(); it != childNameIndex.end(); ++it)
+    {
+        if (removeFrom(it))
+        {
+            return;
+        }
+    }
+}
+
+void BaseSymbol::ReindexChildrenNamed(_In_ std::wstring const& name)
+{
+    if (name.empty())
+    {
+        return;
+    }
+
+    std::vector<ULONG64> ids;
+    for (auto&& child : m_children)
+    {
+        BaseSymbol *pChild = InternalGetSymbolSet()->InternalGetSymbol(child);
+        if (pChild != nullptr && pChild->InternalGetName() == name)
+        {
+            ids.push_back(child);
+        }
+    }
+
+    if (ids.empty())
+    {
+        if (m_spChildNameIndex != nullptr)
+        {
+            m_spChildNameIndex->erase(name);
+        }
+    }
+    else
+    {
+        if (m_spChildNameIndex == nullptr)
+        {
+            m_spChildNameIndex = std::make_unique<ChildNameIndex>();
+        }
+        (*m_spChildNameIndex)[name] = std::move(ids);
+    }
+}
+
+bool BaseSymbol::InternalSetName(_In_opt_ PCWSTR pwszName)
+{
+    return SUCCEEDED(ConvertException([&](){
+        //
+        // The old name holds a reference on its pooled copy until it is released below, so it remains valid
+        // while the parent's index is updated.  It is released with the symbol set held exclusive.  Readers on
+        // other threads (e.g.: GetName and GetQualifiedName) hold the symbol set shared while they look at a
+        // name, so none of them can still be looking at it.
+        //
+        std::wstring const *pOldName = m_pName;
+        std::wstring const *pNewName = m_spNamePool->Intern(pwszName);
+        SymbolSet *pSymbolSet = InternalGetSymbolSet();
+        SymbolSetExclusiveLock lock(pSymbolSet->GetLock());
+
+        pSymbolSet->UnindexSymbolName(this);
+        m_pName = pNewName;
+        pSymbolSet->IndexSymbolName(this);
+
+        BaseSymbol *pParentSymbol = pSymbolSet->InternalGetSymbol(m_parentId);
+        if (pParentSymbol != nullptr)
+        {
+            pParentSymbol->ReindexChildrenNamed(*pOldName);
+            pParentSymbol->ReindexChildrenNamed(*m_pName);
+        }
+        m_spNamePool->Release(pOldName);
+
+        if (m_kind == SvcSymbolType)
+        {
+            pSymbolSet->InvalidateTypeExpressionCaches();
+        }
+        return S_OK;
+    }));
+}
+
+HRESULT BaseSymbol::GetName(_Out_ BSTR *pSymbolName)
+{
+    *pSymbolName = nullptr;
+
+    //
+    // We cannot let a C++ exception escape.
+    //
+    auto fn = [&]()
+    {
+        //
+        // The name is copied out with the symbol set held shared so that a rename on another thread cannot
+        // release it while it is being read.
+        //
+        SymbolSetSharedLock lock(InternalGetSymbolSet()->GetLock());
+        if (m_pName->empty())
+        {
+            return E_NOT_SET;
+        }
+
+        *pSymbolName = SysAllocString(m_pName->c_str());
+        return (*pSymbolName == nullptr ? E_OUTOFMEMORY : S_OK);
+    };
+    return ConvertException(fn);
+}
+
+HRESULT BaseSymbol::GetQualifiedName(_Out_ BSTR *pQualifiedName)
+{
+    *pQualifiedName = nullptr;
+
+    //
+    // We cannot let a C++ exception escape.
+    //
+    auto fn = [&]()
+    {
+        SymbolSetSharedLock lock(InternalGetSymbolSet()->GetLock());
+        std::wstring const& qualifiedName = InternalGetQualifiedName();
+        if (qualifiedName.empty())
+        {
+            return E_NOT_SET;
+        }
+
+        *pQualifiedName = SysAllocString(qualifiedName.c_str());
+        return (*pQualifiedName == nullptr ? E_OUTOFMEMORY : S_OK);
+    };
+    return ConvertException(fn);
+}
+
 HRESULT BaseSymbol::RemoveChild(_In_ ULONG64 uniqueId)
 {
     //
@@ -43,6 +250,7 @@ HRESULT BaseSymbol::RemoveChild(_In_ ULONG64 uniqueId)
     auto fn = [&]()
     {
         HRESULT hr = S_OK;
+        SymbolSetExclusiveLock lock(InternalGetSymbolSet()->GetLock());
 
         bool found = false;
         for (auto it = m_children.begin(); it != m_children.end(); ++it)
@@ -55,6 +263,11 @@ HRESULT BaseSymbol::RemoveChild(_In_ ULONG64 uniqueId)
             }
         }
 
+        if (found)
+        {
+            UnindexChildName(uniqueId);
+        }
+
         if (found)
         {
             return NotifyDependentChange();
@@ -71,6 +284,8 @@ HRESULT BaseSymbol::MoveChildBefore(_In_ ULONG64 childId,
 {
     auto fn = [&]()
     {
+        SymbolSetExclusiveLock lock(InternalGetSymbolSet()->GetLock());
+
         if (pos > std::numeric_limits<size_t>::max())
         {
             return E_INVALIDARG;
@@ -125,6 +340,20 @@ HRESULT BaseSymbol::MoveChildBefore(_In_ ULONG64 childId,
         m_children.erase(m_children.begin() + idx);
         m_children.insert(m_children.begin() + newIdx, childId);
 
+        //
+        // The relative order of children sharing this child's name may have changed.  The index entry only
+        // needs rebuilding if there is more than one such child.
+        //
+        BaseSymbol *pChild = InternalGetSymbolSet()->InternalGetSymbol(childId);
+        if (pChild != nullptr && m_spChildNameIndex != nullptr)
+        {
+            auto it = m_spChildNameIndex->find(pChild->InternalGetName());
+            if (it != m_spChildNameIndex->end() && it->second.size() > 1)
+            {
+                ReindexChildrenNamed(pChild->InternalGetName());
+            }
+        }
+
         // 
         // Changing the position of a field may actually change the size of the type due to alignment and packing.
         // This means anyone dependent on this symbol must recompute their layouts.  We need to pass this notification
@@ -158,105 +387,134 @@ HRESULT BaseSymbol::EnumerateChildren(_In_ SvcSymbolKind kind,
 
 HRESULT BaseSymbol::NotifyDependentChange()
 {
-    HRESULT hr = S_OK;
-    for (auto&& kvp : m_dependentNotifySymbols)
+    SymbolSet *pSymbolSet = InternalGetSymbolSet();
+    ULONG64 uniqueId = InternalGetId();
+
+    if (pSymbolSet->DeferDependentChange(uniqueId))
     {
-        ULONG64 uniqueId = kvp.first;
-        BaseSymbol *pNotifySymbol = InternalGetSymbolSet()->InternalGetSymbol(uniqueId);
-        if (pNotifySymbol != nullptr)
-        {
-            hr = pNotifySymbol->NotifyDependentChange();
-            if (FAILED(hr))
-            {
-                return hr;
-            }
-        }
+        return S_OK;
     }
 
-    return hr;
+    return pSymbolSet->PropagateDependentChanges(&uniqueId, 1);
 }
 
 HRESULT BaseSymbol::Delete()
 {
-    HRESULT hr = S_OK;
-    for (auto&& child : m_children)
+    //
+    // We cannot let a C++ exception escape.
+    //
+    auto fn = [&]()
     {
-        HRESULT hrChild = S_OK;
+        //
+        // Children are deleted and the parent is changed along with this symbol.  Do all of it with the symbol
+        // set held exclusive.
+        //
+        SymbolSetExclusiveLock lock(InternalGetSymbolSet()->GetLock());
 
-        BaseSymbol *pSymbol = InternalGetSymbolSet()->InternalGetSymbol(child);
-        if (pSymbol != nullptr)
+        HRESULT hr = S_OK;
+        for (auto&& child : m_children)
         {
-            hrChild = (pSymbol->Delete());
+            HRESULT hrChild = S_OK;
+
+            BaseSymbol *pSymbol = InternalGetSymbolSet()->InternalGetSymbol(child);
+            if (pSymbol != nullptr)
+            {
+                hrChild = (pSymbol->Delete());
+            }
+
+            if (FAILED(hrChild) && SUCCEEDED(hr))
+            {
+                hr = hrChild;
+            }
         }
+        m_children.clear();
+        m_spChildNameIndex.reset();
 
-        if (FAILED(hrChild) && SUCCEEDED(hr))
+        BaseSymbol *pParentSymbol = InternalGetSymbolSet()->InternalGetSymbol(m_parentId);
+        if (pParentSymbol != nullptr)
         {
-            hr = hrChild;
+            HRESULT hrParent = pParentSymbol->RemoveChild(InternalGetId());
+            if (FAILED(hrParent) && SUCCEEDED(hr))
+            {
+                hr = hrParent;
+            }
         }
-    }
-    m_children.clear();
 
-    BaseSymbol *pParentSymbol = InternalGetSymbolSet()->InternalGetSymbol(m_parentId);
-    if (pParentSymbol != nullptr)
-    {
-        HRESULT hrParent = pParentSymbol->RemoveChild(InternalGetId());
-        if (FAILED(hrParent) && SUCCEEDED(hr))
+        HRESULT hrDelete = InternalGetSymbolSet()->DeleteExistingSymbol(InternalGetId());
+        if (FAILED(hrDelete) && SUCCEEDED(hr))
         {
-            hr = hrParent;
+            hr = hrDelete;
         }
-    }
-
-    HRESULT hrDelete = InternalGetSymbolSet()->DeleteExistingSymbol(InternalGetId());
-    if (FAILED(hrDelete) && SUCCEEDED(hr))
-    {
-        hr = hrDelete;
-    }
 
-    return hr;
+        return hr;
+    };
+    return ConvertException(fn);
 }
 
 HRESULT ChildEnumerator::GetNext(_COM_Outptr_ ISvcSymbol **ppSymbol)
 {
     *ppSymbol = nullptr;
 
-    auto&& children = m_pSymbol->InternalGetChildren();
-
-    while (m_pos < children.size())
+    //
+    // We cannot let a C++ exception escape.
+    //
+    auto fn = [&]()
     {
-        BaseSymbol *pBaseSymbol = m_pSymbol->InternalGetSymbolSet()->InternalGetSymbol(children[m_pos]);
-        ++m_pos;
-
-        if (pBaseSymbol == nullptr)
-        {
-            //
-            // Something has gone *SERIOUSLY* wrong if we have a child id that no longer happens to be indexed
-            // by the symbol set!
-            //
-            return E_UNEXPECTED;
-        }
+        SymbolSetSharedLock lock(m_pSymbol->InternalGetSymbolSet()->GetLock());
 
         //
-        // Do we have any additional match criteria...?
-        //
-        //     - Are we searching for a specific symbol kind or any symbol...?
-        //     - Are we searching for a specific symbol by name...?
+        // If we are searching by name, only walk the children which have that name rather than every child.
         //
-        if (m_kind != SvcSymbol && m_kind != pBaseSymbol->InternalGetKind())
+        std::vector<ULONG64> const *pChildren = &(m_pSymbol->InternalGetChildren());
+        if (!m_name.empty())
         {
-            continue;
+            pChildren = m_pSymbol->InternalGetChildrenByName(m_name);
+            if (pChildren == nullptr)
+            {
+                return E_BOUNDS;
+            }
         }
 
-        if (!m_name.empty() && m_name != pBaseSymbol->InternalGetName())
+        auto&& children = *pChildren;
+
+        while (m_pos < children.size())
         {
-            continue;
-        }
+            BaseSymbol *pBaseSymbol = m_pSymbol->InternalGetSymbolSet()->InternalGetSymbol(children[m_pos]);
+            ++m_pos;
 
-        ComPtr<ISvcSymbol> spSymbol = pBaseSymbol;
-        *ppSymbol = spSymbol.Detach();
-        return S_OK;
-    }
+            if (pBaseSymbol == nullptr)
+            {
+                //
+                // Something has gone *SERIOUSLY* wrong if we have a child id that no longer happens to be indexed
+                // by the symbol set!
+                //
+                return E_UNEXPECTED;
+            }
+
+            //
+            // Do we have any additional match criteria...?
+            //
+            //     - Are we searching for a specific symbol kind or any symbol...?
+            //     - Are we searching for a specific symbol by name...?
+            //
+            if (m_kind != SvcSymbol && m_kind != pBaseSymbol->InternalGetKind())
+            {
+                continue;
+            }
+
+            if (!m_name.empty() && m_name != pBaseSymbol->InternalGetName())
+            {
+                continue;
+            }
+
+            ComPtr<ISvcSymbol> spSymbol = pBaseSymbol;
+            *ppSymbol = spSymbol.Detach();
+            return S_OK;
+        }
 
-    return E_BOUNDS;
+        return E_BOUNDS;
+    };
+    return ConvertException(fn);
 }
 
 //*************************************************
@@ -28,6 +28,103 @@ namespace SymbolBuilder
 class SymbolSet;                        // Forward declaration from SymbolSet.h
 class SymbolBuilderProcess;             // Forward declaration from SymManager.h
 
+//*************************************************
+// Name Pool:
+//
+
+// NamePool:
+//
+// A pool of interned names shared by every symbol within a symbol set.  Many symbols share a name (e.g.: the
+// fields of similar types) and most have a qualified name which is the same as their name.  Each distinct name
+// is stored once and symbols refer to the pooled copy.  Each pooled name is reference counted by the symbols
+// which refer to it and is removed from the pool when the last of them is renamed or destroyed.  The pool is
+// shared with each symbol so that a symbol which outlives its symbol set still has valid names.
+//
+class NamePool
+{
+public:
+
+    // Intern():
+    //
+    // Returns the pooled copy of a name and adds a reference to it.  Each reference must be given back with
+    // Release().  A null or empty name returns EmptyName, which is not counted.  A pool may be shared by
+    // symbol sets (and so changed under different symbol set locks); this is safe to call from any thread.  This
+    // may throw.
+    //
+    std::wstring const *Intern(_In_opt_ PCWSTR pwszName)
+    {
+        if (pwszName == nullptr || *pwszName == L'\0')
+        {
+            return &EmptyName;
+        }
+
+        std::lock_guard<std::mutex> lock(m_lock);
+        auto it = m_names.try_emplace(pwszName, 0).first;
+        ++it->second;
+        ++m_references;
+        return &(it->first);
+    }
+
+    // Release():
+    //
+    // Releases a reference to a name returned from Intern().  The name is removed from the pool (and the
+    // pointer is no longer valid) when its last reference is released.
+    //
+    void Release(_In_ std::wstring const *pName)
+    {
+        if (pName == &EmptyName)
+        {
+            return;
+        }
+
+        std::lock_guard<std::mutex> lock(m_lock);
+        auto it = m_names.find(*pName);
+        if (it != m_names.end() && &(it->first) == pName)
+        {
+            --m_references;
+            if (--it->second == 0)
+            {
+                m_names.erase(it);
+            }
+        }
+    }
+
+    // GetStatistics():
+    //
+    // Gets the number of distinct names in the pool, the number of references to them, the number of bytes
+    // of name storage held by the pool, and the number of bytes the same references would have held had each
+    // kept its own copy of the name.
+    //
+    void GetStatistics(_Out_ size_t *pNameCount,
+                       _Out_ size_t *pReferenceCount,
+                       _Out_ size_t *pPooledBytes,
+                       _Out_ size_t *pUnpooledBytes)
+    {
+        std::lock_guard<std::mutex> lock(m_lock);
+        size_t pooledBytes = 0;
+        size_t unpooledBytes = 0;
+        for (auto const& entry : m_names)
+        {
+            size_t nameBytes = (entry.first.size() + 1) * sizeof(wchar_t);
+            pooledBytes += nameBytes;
+            unpooledBytes += nameBytes * entry.second;
+        }
+
+        *pNameCount = m_names.size();
+        *pReferenceCount = m_references;
+        *pPooledBytes = pooledBytes;
+        *pUnpooledBytes = unpooledBytes;
+    }
+
+    static std::wstring const EmptyName;
+
+private:
+
+    std::mutex m_lock;
+    std::unordered_map<std::wstring, size_t> m_names;
+    size_t m_references = 0;
+};
+
 //*************************************************
 // Base Symbols:
 //
@@ -46,6 +143,15 @@ class BaseSymbol :
 {
 public:
 
+    ~BaseSymbol()
+    {
+        if (m_spNamePool != nullptr)
+        {
+            m_spNamePool->Release(m_pName);
+            m_spNamePool->Release(m_pQualifiedName);
+        }
+    }
+
     //*************************************************
     // ISvcSymbol:
     //
@@ -64,31 +170,13 @@ public:
     //
     // Gets the name of the symbol (e.g.: MyMethod)
     //
-    IFACEMETHOD(GetName)(_Out_ BSTR *pSymbolName)
-    {
-        *pSymbolName = nullptr;
-        if (!m_name.empty())
-        {
-            *pSymbolName = SysAllocString(m_name.c_str());
-            return (*pSymbolName == nullptr ? E_OUTOFMEMORY : S_OK);
-        }
-        return E_NOT_SET;
-    }
+    IFACEMETHOD(GetName)(_Out_ BSTR *pSymbolName);
 
     // GetQualifiedName():
     //
     // Gets the qualified name of the symbol (e.g.: MyNamespace::MyClass::MyMethod)
     //
-    IFACEMETHOD(GetQualifiedName)(_Out_ BSTR *pQualifiedName)
-    {
-        *pQualifiedName = nullptr;
-        if (!m_qualifiedName.empty())
-        {
-            *pQualifiedName = SysAllocString(m_qualifiedName.c_str());
-            return (*pQualifiedName == nullptr ? E_OUTOFMEMORY : S_OK);
-        }
-        return GetName(pQualifiedName);
-    }
+    IFACEMETHOD(GetQualifiedName)(_Out_ BSTR *pQualifiedName);
 
     // GetId():
     //
@@ -207,14 +295,7 @@ public:
             m_pSymbolSet = pSymbolSet;
             m_parentId = parentId;
             m_kind = kind;
-            if (pwszSymbolName != nullptr)
-            {
-                m_name = pwszSymbolName;
-            }
-            if (pwszQualifiedName != nullptr)
-            {
-                m_qualifiedName = pwszQualifiedName;
-            }
+            InitializeNames(pwszSymbolName, pwszQualifiedName);
             if (newSymbol)
             {
                 return InitializeNewSymbol(id);
@@ -234,10 +315,24 @@ public:
 
     // NotifyDependentChange():
     //
-    // Called when something this symbol is dependent upon changes (e.g.: layout, etc...).  Derived classes should
-    // override this method, provide a behavior, and then call the base class.
+    // Called when something about this symbol changes which it or symbols dependent upon it must account for
+    // (e.g.: a field was added and the type needs to be laid out again).  This symbol and every symbol which
+    // transitively depends upon it are updated through UpdateForDependentChange exactly once each and in
+    // dependency order.  If the owning symbol set has a batch open, the update is deferred until it commits.
     //
-    virtual HRESULT NotifyDependentChange();
+    HRESULT NotifyDependentChange();
+
+    // UpdateForDependentChange():
+    //
+    // Called to recompute anything about this symbol which is derived from this symbol's own contents or from the
+    // symbols it depends upon (e.g.: layout, size, etc...).  Derived classes should override this method and
+    // provide a behavior.  An override must *NOT* notify dependents itself.  NotifyDependentChange takes care of
+    // visiting them in the right order.
+    //
+    virtual HRESULT UpdateForDependentChange()
+    {
+        return S_OK;
+    }
 
     // IsGlobal():
     //
@@ -271,18 +366,7 @@ public:
     //
     // Adds a symbol as a child of this symbol.
     //
-    HRESULT AddChild(_In_ ULONG64 uniqueId)
-    {
-        //
-        // We cannot let a C++ exception escape.
-        //
-        auto fn = [&]()
-        {
-            m_children.push_back(uniqueId);
-            return NotifyDependentChange();
-        };
-        return ConvertException(fn);
-    }
+    HRESULT AddChild(_In_ ULONG64 uniqueId);
 
     // RemoveChild():
     //
@@ -337,10 +421,15 @@ public:
         //
         auto fn = [&]()
         {
-            auto it = m_dependentNotifySymbols.find(uniqueId);
-            if (it == m_dependentNotifySymbols.end())
+            if (m_spDependentNotifySymbols == nullptr)
+            {
+                m_spDependentNotifySymbols = std::make_unique<std::unordered_map<ULONG64, ULONG64>>();
+            }
+
+            auto it = m_spDependentNotifySymbols->find(uniqueId);
+            if (it == m_spDependentNotifySymbols->end())
             {
-                m_dependentNotifySymbols.insert( { uniqueId, 1 });
+                m_spDependentNotifySymbols->insert( { uniqueId, 1 });
             }
             else
             {
@@ -377,12 +466,17 @@ public:
         //
         auto fn = [&]()
         {
-            auto it = m_dependentNotifySymbols.find(uniqueId);
-            if (it != m_dependentNotifySymbols.end())
+            if (m_spDependentNotifySymbols == nullptr)
+            {
+                return S_OK;
+            }
+
+            auto it = m_spDependentNotifySymbols->find(uniqueId);
+            if (it != m_spDependentNotifySymbols->end())
             {
                 if (it->second == 1)
                 {
-                    m_dependentNotifySymbols.erase(it);
+                    m_spDependentNotifySymbols->erase(it);
                 }
                 else
                 {
@@ -402,21 +496,36 @@ public:
     //
 
     SymbolSet *InternalGetSymbolSet() const { return m_pSymbolSet; }
-    std::wstring const& InternalGetName() const { return m_name; }
+    std::unordered_map<ULONG64, ULONG64> const& InternalGetDependentNotifySymbols() const
+    {
+        return m_spDependentNotifySymbols == nullptr ? s_noDependentNotifySymbols : *m_spDependentNotifySymbols;
+    }
+    std::wstring const& InternalGetName() const { return *m_pName; }
     std::wstring const& InternalGetQualifiedName() const
     {
-        return m_qualifiedName.empty() ? m_name : m_qualifiedName;
+        return m_pQualifiedName->empty() ? *m_pName : *m_pQualifiedName;
     }
     SvcSymbolKind InternalGetKind() const { return m_kind; }
     ULONG64 InternalGetId() const { return m_id; }
     ULONG64 InternalGetParentId() const { return m_parentId; }
     std::vector<ULONG64> const& InternalGetChildren() { return m_children; }
-    bool InternalSetName(_In_opt_ PCWSTR pwszName)
+    bool InternalSetName(_In_opt_ PCWSTR pwszName);
+
+    // InternalGetChildrenByName():
+    //
+    // Gets the ids of the children of this symbol with a given name in the order they appear within the list of
+    // children.  Returns nullptr if there are none.  The returned list is only valid until the next change to
+    // the children of this symbol.
+    //
+    std::vector<ULONG64> const* InternalGetChildrenByName(_In_ std::wstring const& name) const
     {
-        return SUCCEEDED(ConvertException([&](){
-            m_name = pwszName;
-            return S_OK;
-        }));
+        if (m_spChildNameIndex == nullptr)
+        {
+            return nullptr;
+        }
+
+        auto it = m_spChildNameIndex->find(name);
+        return (it == m_spChildNameIndex->end() ? nullptr : &(it->second));
     }
 
 protected:
@@ -430,20 +539,33 @@ protected:
     // The kind of this symbol
     SvcSymbolKind m_kind;
 
-    // The names of this symbol
-    std::wstring m_name;
-    std::wstring m_qualifiedName;
+    // The names of this symbol.  These point into the name pool of the symbol set and are never null.  Each
+    // holds a reference on the pooled name which is released when the symbol is renamed or destroyed.  An empty
+    // qualified name means the qualified name is the same as the name.  A rename changes these (and releases the
+    // old name) with the symbol set held exclusive, so anything reading them from another thread must hold the
+    // symbol set lock.
+    std::shared_ptr<NamePool> m_spNamePool;
+    std::wstring const *m_pName = &NamePool::EmptyName;
+    std::wstring const *m_pQualifiedName = &NamePool::EmptyName;
 
     // Index of children of this symbol
     std::vector<ULONG64> m_children;
 
+    // Index of the children of this symbol by name (e.g.: the fields of a UDT).  Each list is in the same order
+    // as the children appear in m_children.  Unnamed children are not indexed.  This is only allocated once the
+    // symbol has a named child.  Most symbols never do.  Each key is a view of the pooled name of the children
+    // in its list (which hold a reference on it), so the index never copies a name.
+    using ChildNameIndex = std::unordered_map<std::wstring_view, std::vector<ULONG64>>;
+    std::unique_ptr<ChildNameIndex> m_spChildNameIndex;
+
     // Index of all symbols which are dependent upon this symbol.  If the layout of a type is modified,
     // everything which includes that type must be "laid out again".  This is the list of symbols which
-    // must receive that notification.
+    // must receive that notification.  This is only allocated once the symbol has a dependent.
     //
     // Note that this is a map from "unique id" -> "dependency count"
     //
-    std::unordered_map<ULONG64, ULONG64> m_dependentNotifySymbols;
+    std::unique_ptr<std::unordered_map<ULONG64, ULONG64>> m_spDependentNotifySymbols;
+    static std::unordered_map<ULONG64, ULONG64> const s_noDependentNotifySymbols;
 
     // Weak back pointer to our owning symbol set.
     SymbolSet *m_pSymbolSet;
@@ -456,6 +578,26 @@ private:
     // etc...
     //
     HRESULT InitializeNewSymbol(_In_ ULONG64 reservedId = 0);
+
+    // InitializeNames():
+    //
+    // Sets the names of this symbol from the name pool of the owning symbol set.  This may throw.
+    //
+    void InitializeNames(_In_opt_ PCWSTR pwszSymbolName, _In_opt_ PCWSTR pwszQualifiedName);
+
+    // UnindexChildName():
+    //
+    // Removes a child from the index of children by name.
+    //
+    void UnindexChildName(_In_ ULONG64 uniqueId);
+
+    // ReindexChildrenNamed():
+    //
+    // Rebuilds the index entry for children with the given name from the list of children.  This is only
+    // necessary when children with the same name are reordered or a child is renamed.  The name must be
+    // the pooled copy since a new entry is keyed by a view of it.  This may throw.
+    //
+    void ReindexChildrenNamed(_In_ std::wstring const& name);
 };
 
 // ChildEnumerator:
@@ -73,6 +73,20 @@ HRESULT BaseDataSymbol::BaseInitialize(_In_ SymbolSet *pSymbolSet,
         return E_INVALIDARG;
     }
 
+    //
+    // A field or base class places its type by value within the owning type.  The layout of the owning type
+    // needs the full layout of a UDT used this way and not just the size an importer gave its shell.
+    //
+    if (symKind == SvcSymbolField || symKind == SvcSymbolBaseClass)
+    {
+        IfFailedReturn(UdtTypeSymbol::EnsureMembersForLayout(pSymbolSet, symTypeId));
+    }
+
+    if (newSymbol)
+    {
+        IfFailedReturn(UdtTypeSymbol::EnsureMembersOf(pOwningSymbol));
+    }
+
     m_rangeCacheOffset = Uninitialized;
     m_rangeCacheSize = Uninitialized;
 
@@ -258,6 +272,11 @@ HRESULT BaseDataSymbol::BaseInitialize(_In_ SymbolSet *pSymbolSet,
         }
     }
 
+    if (newSymbol)
+    {
+        IfFailedReturn(UdtTypeSymbol::EnsureMembersOf(pOwningSymbol));
+    }
+
     IfFailedReturn(BaseSymbol::BaseInitialize(pSymbolSet, symKind, owningSymbolId, pwszName, pwszQualifiedName, newSymbol, id));
 
     m_symTypeId = symTypeId;
@@ -607,6 +626,11 @@ HRESULT BaseDataSymbol::InternalSetSymbolTypeId(_In_ ULONG64 symTypeId)
         return E_INVALIDARG;
     }
 
+    if (InternalGetKind() == SvcSymbolField || InternalGetKind() == SvcSymbolBaseClass)
+    {
+        IfFailedReturn(UdtTypeSymbol::EnsureMembersForLayout(InternalGetSymbolSet(), symTypeId));
+    }
+
     //
     // We need to remove certain chains of dependency and set up new ones.  At the end of the day,
     // this needs to be as if symTypeId was passed to our initializer.
@@ -635,7 +659,7 @@ HRESULT BaseDataSymbol::InternalSetSymbolTypeId(_In_ ULONG64 symTypeId)
     return hr;
 }
 
-HRESULT BaseDataSymbol::NotifyDependentChange()
+HRESULT BaseDataSymbol::UpdateForDependentChange()
 {
     HRESULT hr = S_OK;
 
@@ -670,7 +694,7 @@ HRESULT BaseDataSymbol::NotifyDependentChange()
         }
     }
 
-    return BaseSymbol::NotifyDependentChange();
+    return hr;
 }
 
 //*************************************************
@@ -842,6 +866,8 @@ HRESULT VariableSymbol::AddLiveRange(_In_ ULONG64 rangeOffset,
 {
     auto fn = [&]()
     {
+        SymbolSetExclusiveLock lock(InternalGetSymbolSet()->GetLock());
+
         if (!ValidateLiveRange(rangeOffset, rangeSize))
         {
             return E_INVALIDARG;
@@ -857,6 +883,7 @@ HRESULT VariableSymbol::AddLiveRange(_In_ ULONG64 rangeOffset,
 
         LiveRange * pRange = &(insResult.first->second);
         m_liveRangeList.push_back(pRange);
+        InvalidateLiveRangeIndex();
 
         // 
         // Send an advisory notification upwards that everyone should flush caches.  Do not consider
@@ -870,6 +897,17 @@ HRESULT VariableSymbol::AddLiveRange(_In_ ULONG64 rangeOffset,
     return ConvertException(fn);
 }
 
+HRESULT VariableSymbol::GetId(_Out_ ULONG64 *pId)
+{
+    if (!IsBoundToScope())
+    {
+        *pId = InternalGetId();
+        return S_OK;
+    }
+
+    return InternalGetSymbolSet()->GetScopeBindingId(InternalGetId(), GetBoundScope()->InternalGetModuleOffset(), pId);
+}
+
 HRESULT VariableSymbol::GetOffset(_Out_ ULONG64 * /*pSymbolOffset*/)
 {
     //
@@ -931,34 +969,46 @@ HRESULT VariableSymbol::GetLocation(_Out_ SvcSymbolLocation *pLocation)
     }
     else
     {
-        ULONG64 srelOffset = GetBoundScope()->InternalGetFunctionOffset();
-        FunctionSymbol *pFunction = GetBoundScope()->InternalGetFunction();
-
         //
-        // Sanity check that the scope we are bound to is within our parent function!
+        // The function's live range index is shared by every lookup and is thrown away by any change to a live
+        // range.  Hold the symbol set shared while using it.
         //
-        if (pFunction->InternalGetId() != InternalGetParentId())
+        auto fn = [&]()
         {
-            return E_UNEXPECTED;
-        }
+            SymbolSetSharedLock lock(InternalGetSymbolSet()->GetLock());
+
+            ULONG64 srelOffset = GetBoundScope()->InternalGetFunctionOffset();
+            FunctionSymbol *pFunction = GetBoundScope()->InternalGetFunction();
 
-        LiveRange const* pLiveRange = GetLiveRangeByOffset(srelOffset);
-        if (pLiveRange == nullptr)
-        {
             //
-            // It is not alive at this particular location.
+            // Sanity check that the scope we are bound to is within our parent function!
             //
-            pLocation->Kind = SvcSymbolLocationNone;
-            return S_OK;
-        }
+            if (pFunction->InternalGetId() != InternalGetParentId())
+            {
+                return E_UNEXPECTED;
+            }
 
-        *pLocation = pLiveRange->VariableLocation;
-        return S_OK;
+            LiveRange const* pLiveRange = pFunction->InternalFindVariableLiveRange(InternalGetId(), srelOffset);
+            if (pLiveRange == nullptr)
+            {
+                //
+                // It is not alive at this particular location.
+                //
+                pLocation->Kind = SvcSymbolLocationNone;
+                return S_OK;
+            }
+
+            *pLocation = pLiveRange->VariableLocation;
+            return S_OK;
+        };
+        return ConvertException(fn);
     }
 }
 
 bool VariableSymbol::InternalSetLiveRangeOffset(_In_ ULONG64 id, _In_ ULONG64 offset)
 {
+    SymbolSetExclusiveLock lock(InternalGetSymbolSet()->GetLock());
+
     LiveRange *pLiveRange = GetLiveRange(id);
     if (pLiveRange == nullptr ||
         !ValidateLiveRange(offset, pLiveRange->Size, id))
@@ -967,6 +1017,7 @@ bool VariableSymbol::InternalSetLiveRangeOffset(_In_ ULONG64 id, _In_ ULONG64 of
     }
 
     pLiveRange->Offset = offset;
+    InvalidateLiveRangeIndex();
 
     // 
     // Send an advisory notification upwards that everyone should flush caches.  Do not consider this
@@ -979,6 +1030,8 @@ bool VariableSymbol::InternalSetLiveRangeOffset(_In_ ULONG64 id, _In_ ULONG64 of
 
 bool VariableSymbol::InternalSetLiveRangeSize(_In_ ULONG64 id, _In_ ULONG64 size)
 {
+    SymbolSetExclusiveLock lock(InternalGetSymbolSet()->GetLock());
+
     LiveRange *pLiveRange = GetLiveRange(id);
     if (pLiveRange == nullptr ||
         !ValidateLiveRange(pLiveRange->Offset, size, id))
@@ -987,6 +1040,7 @@ bool VariableSymbol::InternalSetLiveRangeSize(_In_ ULONG64 id, _In_ ULONG64 size
     }
 
     pLiveRange->Size = size;
+    InvalidateLiveRangeIndex();
 
     // 
     // Send an advisory notification upwards that everyone should flush caches.  Do not consider this
@@ -999,6 +1053,8 @@ bool VariableSymbol::InternalSetLiveRangeSize(_In_ ULONG64 id, _In_ ULONG64 size
 
 bool VariableSymbol::InternalSetLiveRangeLocation(_In_ ULONG64 id, _In_ SvcSymbolLocation const& location)
 {
+    SymbolSetExclusiveLock lock(InternalGetSymbolSet()->GetLock());
+
     LiveRange *pLiveRange = GetLiveRange(id);
     if (pLiveRange == nullptr)
     {
@@ -1020,6 +1076,8 @@ bool VariableSymbol::InternalDeleteLiveRange(_In_ ULONG64 id)
 {
     auto fn = [&]()
     {
+        SymbolSetExclusiveLock lock(InternalGetSymbolSet()->GetLock());
+
         bool found = false;
 
         auto it = m_liveRanges.find(id);
@@ -1040,6 +1098,7 @@ bool VariableSymbol::InternalDeleteLiveRange(_In_ ULONG64 id)
         }
 
         m_liveRanges.erase(it);
+        InvalidateLiveRangeIndex();
         return S_OK;
     };
     if (FAILED(ConvertException(fn)))
@@ -1061,13 +1120,34 @@ void VariableSymbol::InternalDeleteAllLiveRanges()
 {
     auto fn = [&]()
     {
+        SymbolSetExclusiveLock lock(InternalGetSymbolSet()->GetLock());
+
         m_liveRangeList.clear();
         m_liveRanges.clear();
+        InvalidateLiveRangeIndex();
         return S_OK;
     };
     (void)ConvertException(fn);
 }
 
+void VariableSymbol::InvalidateLiveRangeIndex()
+{
+    //
+    // A variable bound to a scope carries a copy of the live ranges of the variable it was bound from.  Only the
+    // unbound variable feeds the function's index.
+    //
+    if (IsBoundToScope())
+    {
+        return;
+    }
+
+    BaseSymbol *pParent = InternalGetSymbolSet()->InternalGetSymbol(InternalGetParentId());
+    if (pParent != nullptr && pParent->InternalGetKind() == SvcSymbolFunction)
+    {
+        static_cast<FunctionSymbol *>(pParent)->InternalInvalidateLiveRangeIndex();
+    }
+}
+
 HRESULT VariableSymbol::MoveToBefore(_In_ ULONG64 position)
 {
     if (InternalGetKind() != SvcSymbolDataParameter)
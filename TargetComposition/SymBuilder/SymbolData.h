@@ -187,13 +187,13 @@ public:
     //
     virtual HRESULT Delete();
 
-    // NotifyDependentChange():
+    // UpdateForDependentChange():
     //
     // Called when something this symbol is dependent upon changes (e.g.: layout, etc...).  If our underlying
     // type changed, we need to refetch the size and subsequently pass a notification to the symbol set so that
     // it can update its mapping of symbol <-> offset.
     //
-    virtual HRESULT NotifyDependentChange();
+    virtual HRESULT UpdateForDependentChange();
 
     //*************************************************
     // Internal Accessors:
@@ -307,6 +307,13 @@ public:
     // ISvcSymbol:
     //
 
+    // GetId():
+    //
+    // Gets an identifier for the symbol which can be used to retrieve the same symbol again.  A variable bound
+    // to a scope has a scope binding ID so that it is retrieved bound to the same place.
+    //
+    IFACEMETHOD(GetId)(_Out_ ULONG64 *pId);
+
     // GetOffset():
     //
     // Gets the offset of the symbol (if said symbol has such).  Note that if the symbol has multiple
@@ -427,6 +434,13 @@ public:
 
 private:
 
+    // InvalidateLiveRangeIndex():
+    //
+    // Invalidates the live range index of the owning function after a live range has been added, moved,
+    // resized, or deleted.
+    //
+    void InvalidateLiveRangeIndex();
+
     ULONG64 m_curId;
     std::unordered_map<ULONG64, LiveRange> m_liveRanges;
     std::vector<LiveRange *> m_liveRangeList;
@@ -39,6 +39,7 @@ HRESULT FunctionSymbol::RuntimeClassInitialize(_In_ SymbolSet *pSymbolSet,
         HRESULT hr = S_OK;
 
         m_returnType = returnType;
+        m_liveRangeIndexValid = false;
 
         IfFailedReturn(BaseInitialize(pSymbolSet, SvcSymbolFunction, parentId, pwszName, pwszQualifiedName));
 
@@ -147,6 +148,129 @@ HRESULT FunctionSymbol::InternalSetReturnTypeId(_In_ ULONG64 returnTypeId)
     return hr;
 }
 
+void FunctionSymbol::BuildLiveRangeIndex()
+{
+    struct IndexedRange
+    {
+        ULONG64 Start;
+        ULONG64 End;
+        LiveRangeIndexEntry Entry;
+    };
+
+    m_liveRangeBoundaries.clear();
+    m_liveRangeSegments.clear();
+    m_liveRangeEntries.clear();
+
+    std::vector<IndexedRange> ranges;
+    for (ULONG64 childId : InternalGetChildren())
+    {
+        BaseSymbol *pChild = InternalGetSymbolSet()->InternalGetSymbol(childId);
+        if (pChild == nullptr ||
+            (pChild->InternalGetKind() != SvcSymbolDataParameter && pChild->InternalGetKind() != SvcSymbolDataLocal))
+        {
+            continue;
+        }
+
+        VariableSymbol *pVariable = static_cast<VariableSymbol *>(pChild);
+        for (VariableSymbol::LiveRange const *pLiveRange : pVariable->InternalGetLiveRanges())
+        {
+            if (pLiveRange->Size == 0)
+            {
+                continue;
+            }
+
+            ranges.push_back( { pLiveRange->Offset,
+                                pLiveRange->Offset + pLiveRange->Size,
+                                { childId, pLiveRange->UniqueId } } );
+            m_liveRangeBoundaries.push_back(pLiveRange->Offset);
+            m_liveRangeBoundaries.push_back(pLiveRange->Offset + pLiveRange->Size);
+        }
+    }
+
+    std::sort(m_liveRangeBoundaries.begin(), m_liveRangeBoundaries.end());
+    m_liveRangeBoundaries.erase(std::unique(m_liveRangeBoundaries.begin(), m_liveRangeBoundaries.end()),
+                                m_liveRangeBoundaries.end());
+
+    //
+    // Place each range in every segment it covers.  The ranges were gathered in child order and so each
+    // segment's entries are too.
+    //
+    size_t segmentCount = (m_liveRangeBoundaries.empty() ? 0 : m_liveRangeBoundaries.size() - 1);
+    std::vector<std::vector<LiveRangeIndexEntry>> segmentEntries(segmentCount);
+    for (auto&& range : ranges)
+    {
+        size_t firstSegment = std::lower_bound(m_liveRangeBoundaries.begin(), m_liveRangeBoundaries.end(), range.Start) -
+                              m_liveRangeBoundaries.begin();
+        size_t endSegment = std::lower_bound(m_liveRangeBoundaries.begin(), m_liveRangeBoundaries.end(), range.End) -
+                            m_liveRangeBoundaries.begin();
+
+        for (size_t segment = firstSegment; segment < endSegment; ++segment)
+        {
+            segmentEntries[segment].push_back(range.Entry);
+        }
+    }
+
+    m_liveRangeSegments.reserve(segmentCount + 1);
+    for (auto&& entries : segmentEntries)
+    {
+        m_liveRangeSegments.push_back(m_liveRangeEntries.size());
+        m_liveRangeEntries.insert(m_liveRangeEntries.end(), entries.begin(), entries.end());
+    }
+    m_liveRangeSegments.push_back(m_liveRangeEntries.size());
+
+    m_liveRangeIndexValid = true;
+}
+
+std::pair<FunctionSymbol::LiveRangeIndexEntry const *, FunctionSymbol::LiveRangeIndexEntry const *>
+FunctionSymbol::InternalFindLiveRanges(_In_ ULONG64 srelOffset)
+{
+    //
+    // Lookups holding the symbol set shared may get here at the same time.  Only one of them builds the index.
+    //
+    {
+        std::lock_guard<std::mutex> cacheLock(InternalGetSymbolSet()->GetCacheLock());
+        if (!m_liveRangeIndexValid)
+        {
+            BuildLiveRangeIndex();
+        }
+    }
+
+    //
+    // Find the segment whose start is the last boundary at or below the offset.  The final boundary is the end
+    // of the last segment and has no segment of its own.
+    //
+    auto it = std::upper_bound(m_liveRangeBoundaries.begin(), m_liveRangeBoundaries.end(), srelOffset);
+    if (it == m_liveRangeBoundaries.begin() || it == m_liveRangeBoundaries.end())
+    {
+        return { nullptr, nullptr };
+    }
+
+    size_t segment = (it - m_liveRangeBoundaries.begin()) - 1;
+    LiveRangeIndexEntry const *pEntries = m_liveRangeEntries.data();
+    return { pEntries + m_liveRangeSegments[segment], pEntries + m_liveRangeSegments[segment + 1] };
+}
+
+VariableSymbol::LiveRange const *FunctionSymbol::InternalFindVariableLiveRange(_In_ ULONG64 variableId,
+                                                                                _In_ ULONG64 srelOffset)
+{
+    auto entries = InternalFindLiveRanges(srelOffset);
+    for (LiveRangeIndexEntry const *pEntry = entries.first; pEntry != entries.second; ++pEntry)
+    {
+        if (pEntry->VariableId == variableId)
+        {
+            BaseSymbol *pSymbol = InternalGetSymbolSet()->InternalGetSymbol(variableId);
+            if (pSymbol == nullptr)
+            {
+                return nullptr;
+            }
+
+            return static_cast<VariableSymbol *>(pSymbol)->GetLiveRange(pEntry->RangeId);
+        }
+    }
+
+    return nullptr;
+}
+
 HRESULT FunctionSymbol::Delete()
 {
     for (auto&& range : m_addressRanges)
@@ -36,6 +36,16 @@ class FunctionSymbol :
 {
 public:
 
+    // LiveRangeIndexEntry:
+    //
+    // Identifies one live range of one variable of the function within the live range index.
+    //
+    struct LiveRangeIndexEntry
+    {
+        ULONG64 VariableId;
+        ULONG64 RangeId;
+    };
+
     //*************************************************
     // ISvcSymbol:
     //
@@ -85,17 +95,12 @@ public:
     // Internal APIs:
     //
 
-    virtual HRESULT NotifyDependentChange()
+    virtual HRESULT UpdateForDependentChange()
     {
         //
         // If one of the parameters changes, we need to recompute the function type.
         //
-        HRESULT hr = GetFunctionType(&m_functionType);
-        if (SUCCEEDED(hr))
-        {
-            hr = BaseSymbol::NotifyDependentChange();
-        }
-        return hr;
+        return GetFunctionType(&m_functionType);
     }
 
     HRESULT RuntimeClassInitialize(_In_ SymbolSet *pSymbolSet,
@@ -121,6 +126,33 @@ public:
     virtual ULONG64 InternalGetReturnTypeId() const { return m_returnType; }
     std::vector<std::pair<ULONG64, ULONG64>> const& InternalGetAddressRanges() const { return m_addressRanges; }
 
+    // InternalFindLiveRanges():
+    //
+    // Finds the live ranges of every parameter and local of the function which contain the given function
+    // relative offset.  The returned entries are in the order the variables are children of the function and
+    // remain valid until the next change to any live range of the function.  This is O(log n + k) in the
+    // number of live ranges once the index is built.  The caller must hold the symbol set (at least) shared
+    // for as long as it uses the entries.
+    //
+    std::pair<LiveRangeIndexEntry const *, LiveRangeIndexEntry const *> InternalFindLiveRanges(_In_ ULONG64 srelOffset);
+
+    // InternalFindVariableLiveRange():
+    //
+    // Finds the live range of the given parameter or local which contains the given function relative offset.
+    // Returns nullptr if the variable is not live there.
+    //
+    VariableSymbol::LiveRange const *InternalFindVariableLiveRange(_In_ ULONG64 variableId, _In_ ULONG64 srelOffset);
+
+    // InternalInvalidateLiveRangeIndex():
+    //
+    // Called whenever a live range of a parameter or local of the function is added, moved, resized, or
+    // deleted.  The index is rebuilt on the next query.
+    //
+    void InternalInvalidateLiveRangeIndex()
+    {
+        m_liveRangeIndexValid = false;
+    }
+
     //*************************************************
     // Internal  Setters:
     //
@@ -135,6 +167,12 @@ private:
     //
     HRESULT GetFunctionType(_Out_ ULONG64 *pFunctionTypeId);
 
+    // BuildLiveRangeIndex():
+    //
+    // Builds the live range index from the live ranges of every parameter and local.  This may throw.
+    //
+    void BuildLiveRangeIndex();
+
     // The set of address ranges associated with this function.  The first range is
     // considered the "primary" range including the entry point of the function.  Many
     // functions will have a single code range.  It is, however, possible that due to
@@ -148,6 +186,16 @@ private:
     ULONG64 m_functionType;
     ULONG64 m_returnType;
 
+    // The live range index.  The boundaries of every variable live range, sorted and unique, split the
+    // function into segments [m_liveRangeBoundaries[i], m_liveRangeBoundaries[i + 1]).  The live ranges
+    // covering segment i are m_liveRangeEntries[m_liveRangeSegments[i]] up to (but not including)
+    // m_liveRangeEntries[m_liveRangeSegments[i + 1]].
+    //
+    std::vector<ULONG64> m_liveRangeBoundaries;
+    std::vector<size_t> m_liveRangeSegments;
+    std::vector<LiveRangeIndexEntry> m_liveRangeEntries;
+    bool m_liveRangeIndexValid;
+
 };
 
 } // SymbolBuilder
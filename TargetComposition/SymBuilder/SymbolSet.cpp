@@ -32,34 +32,19 @@ namespace SymbolBuilder
 
 bool PublicList::FindNearestSymbols(_In_ ULONG64 address, _Out_ SymbolList const** pSymbolList)
 {
-    if (m_addresses.size() == 0)
-    {
-        return false;
-    }
-
-    auto it = std::lower_bound(m_addresses.begin(), m_addresses.end(), address,
-                               [&](_In_ const Address& symAddr, _In_ ULONG64 address)
-                               {
-                                   return symAddr.Addr < address;
-                               });
-
     //
-    // Remember that it points to the first element in the list where search_address <= list_address.
-    // If it happens to point to an element which is equal, we want this.  Otherwise, we need to step backwards
-    // one element because, in lacking an exact match, we want address below the search address which is
-    // CLOSEST to it!
+    // 'it' points to the first address which is above the search address.  The one before it is either an exact
+    // match or the address below the search address which is CLOSEST to it -- either of which is what we want.
     //
-    if (it == m_addresses.end() || it->Addr != address)
+    auto it = m_addresses.upper_bound(address);
+    if (it == m_addresses.begin())
     {
-        if (it == m_addresses.begin())
-        {
-            return false;
-        }
-
-        --it;
+        return false;
     }
 
-    *pSymbolList = &(it->Symbols);
+    --it;
+
+    *pSymbolList = &(it->second);
     return true;
 }
 
@@ -70,37 +55,7 @@ HRESULT PublicList::AddSymbol(_In_ ULONG64 address, _In_ ULONG64 symbol)
     //
     auto fn = [&]()
     {
-        auto it = std::lower_bound(m_addresses.begin(), m_addresses.end(), address,
-                                   [&](_In_ const Address& symAddr, _In_ ULONG64 address)
-                                   {
-                                       return symAddr.Addr < address;
-                                   });
-
-        //
-        // If there are no public symbols which are >= the new public address, the new one can just be put
-        // at the end of the list and we are done.
-        //
-        if (it == m_addresses.end())
-        {
-            m_addresses.push_back( { address, { symbol } } );
-            return S_OK;
-        }
-
-        //
-        // If the found element happens to be at the same address, there are *MULTIPLE* public symbols covering
-        // the same address and they go into a singular list.
-        //
-        if (it->Addr == address)
-        {
-            it->Symbols.push_back(symbol);
-            return S_OK;
-        }
-
-        //
-        // Otherwise, 'it' refers to the first element > address.  We need to insert the new public in the list
-        // immediately before 'it'.
-        //
-        m_addresses.insert(it, { address, { symbol } });
+        m_pendingSymbols.push_back( { address, symbol } );
         return S_OK;
     };
     return ConvertException(fn);
@@ -108,557 +63,1786 @@ HRESULT PublicList::AddSymbol(_In_ ULONG64 address, _In_ ULONG64 symbol)
 
 HRESULT PublicList::RemoveSymbol(_In_ ULONG64 address, _In_ ULONG64 symbol)
 {
+    HRESULT hr = S_OK;
+    IfFailedReturn(FlushPendingSymbols());
+
+    auto it = m_addresses.find(address);
+    if (it == m_addresses.end())
+    {
+        //
+        // We could not find this address.  It's not a failure per-se.  Just return S_FALSE to the caller
+        // to let them know nothing was actually removed!
+        //
+        return S_FALSE;
+    }
+
+    RemoveSymbolFromList(it->second, symbol);
+
     //
-    // We cannot let a C++ exception escape.
+    // If there are no public symbols matching this particular list any longer, we need to remove the entire
+    // address entry from the table.  To do otherwise would result in us missing the most appropriate symbol
+    // as we could find an address with an empty list!
     //
-    auto fn = [&]()
+    if (it->second.size() == 0)
     {
-        auto it = std::lower_bound(m_addresses.begin(), m_addresses.end(), address,
-                                   [&](_In_ const Address& symAddr, _In_ ULONG64 address)
-                                   {
-                                       return symAddr.Addr < address;
-                                   });
+        m_addresses.erase(it);
+    }
 
-        if (it == m_addresses.end() || it->Addr != address)
-        {
-            //
-            // We could not find this address.  It's not a failure per-se.  Just return S_FALSE to the caller
-            // to let them know nothing was actually removed!
-            //
-            return S_FALSE;
-        }
+    return hr;
+}
+
+HRESULT PublicList::FlushPendingSymbols()
+{
+    if (m_pendingSymbols.empty())
+    {
+        return S_OK;
+    }
 
-        RemoveSymbolFromList(it->Symbols, symbol);
+    size_t placed = 0;
 
+    //
+    // We cannot let a C++ exception escape.
+    //
+    auto fn = [&]()
+    {
         //
-        // If there are no public symbols matching this particular list any longer, we need to remove the entire
-        // address entry from the table.  To do otherwise would result in us missing the most appropriate symbol
-        // as we could find an address with an empty list!
+        // Sort the additions by address.  This must be a stable sort: multiple public symbols at the same address
+        // are kept in the order in which they were added.  Once sorted, each one is inserted with a hint of where
+        // the previous one went.  Loading into an empty index (or above everything already in it) is then linear
+        // after the sort.
         //
-        if (it->Symbols.size() == 0)
+        std::stable_sort(m_pendingSymbols.begin(), m_pendingSymbols.end(),
+                         [](_In_ PendingSymbol const& a, _In_ PendingSymbol const& b)
+                         {
+                             return a.Addr < b.Addr;
+                         });
+
+        auto itPrev = m_addresses.end();
+        for (; placed < m_pendingSymbols.size(); ++placed)
         {
-            m_addresses.erase(it);
+            PendingSymbol const& pending = m_pendingSymbols[placed];
+            if (itPrev == m_addresses.end() || itPrev->first != pending.Addr)
+            {
+                auto itHint = (itPrev == m_addresses.end() ? m_addresses.end() : std::next(itPrev));
+                itPrev = m_addresses.try_emplace(itHint, pending.Addr);
+            }
+
+            itPrev->second.push_back(pending.Symbol);
         }
 
         return S_OK;
     };
-    return ConvertException(fn);
+    HRESULT hr = ConvertException(fn);
+
+    m_pendingSymbols.erase(m_pendingSymbols.begin(), m_pendingSymbols.begin() + placed);
+    return hr;
 }
 
 bool SymbolRangeList::FindSymbols(_In_ ULONG64 address, _Out_ SymbolList const** pSymbolList)
 {
-    auto it = std::lower_bound(m_ranges.begin(), m_ranges.end(), address,
-                               [&](_In_ const AddressRange& rng, _In_ ULONG64 address)
-                               {
-                                   return rng.End < address;
-                               });
+    //
+    // Find the last range which starts at or below the address.
+    //
+    auto it = m_ranges.upper_bound(address);
+    if (it == m_ranges.begin())
+    {
+        return false;
+    }
+
+    --it;
+
+    //
+    // An address which is exactly at the end of a range has always resolved to that range in preference to an
+    // adjacent range which starts there (e.g.: the return address of a call at the very end of a function
+    // resolves to the function which made the call).  Keep that behavior.
+    //
+    if (it->first == address && it != m_ranges.begin())
+    {
+        auto itPrev = std::prev(it);
+        if (itPrev->second.End == address)
+        {
+            it = itPrev;
+        }
+    }
 
-    if (it == m_ranges.end() || it->Start > address)
+    if (it->second.End < address)
     {
         return false;
     }
 
-    *pSymbolList = &(it->Symbols);
+    *pSymbolList = &(it->second.Symbols);
     return true;
 }
 
 HRESULT SymbolRangeList::AddSymbol(_In_ ULONG64 start, _In_ ULONG64 end, _In_ ULONG64 symbol)
 {
+    if (start >= end)
+    {
+        return S_FALSE;
+    }
+
+    //
+    // We cannot let a C++ exception escape.
+    //
+    auto fn = [&]()
+    {
+        m_pendingRanges.push_back( { start, end, symbol } );
+        return S_OK;
+    };
+    return ConvertException(fn);
+}
+
+HRESULT SymbolRangeList::RemoveSymbol(_In_ ULONG64 start, _In_ ULONG64 end, _In_ ULONG64 symbol)
+{
+    HRESULT hr = S_OK;
+    IfFailedReturn(FlushPendingRanges());
+
     //
     // We cannot let a C++ exception escape.
     //
     auto fn = [&]()
     {
         //
-        // We must find the proper position within the address range to place the symbol in sorted
-        // order.  If there is no overlap, this is easy.  If there is overlap, we must split the ranges
-        // as appropriate.
+        // Split any range which straddles either end of [start, end) so that we can remove the symbol from
+        // exactly the ranges within it.
         //
-        auto it = std::lower_bound(m_ranges.begin(), m_ranges.end(), start,
-                                   [&](_In_ const AddressRange& rng, _In_ ULONG64 address)
-                                   {
-                                       return rng.End < address;
-                                   });
-
+        // This would be something like:
         //
-        // If there are no address ranges which begin above 'start', just append the range and be done.
-        // Likewise, if there is *AND* there is no overlap with any other known address range, just insert
-        // the new range before the one which is greater.
+        //     range:   [              )
+        //    remove:         [    )
         //
-        if (it == m_ranges.end())
-        {
-            m_ranges.push_back( { start, end, { symbol } } );
-            return S_OK;
-        }
+        // Where we now need:
+        //
+        //    range1:   [     )                 <-- has symbol
+        //    range2:         [    )            <-- does not have symbol
+        //    range3:              [   )        <-- has symbol
+        //
+        SplitRangeAt(start);
+        SplitRangeAt(end);
 
-        if (end <= it->Start)
+        bool found = false;
+        for (auto it = m_ranges.lower_bound(start); it != m_ranges.end() && it->first < end; ++it)
         {
-            m_ranges.insert(it, { start, end, { symbol } } );
-            return S_OK;
+            RemoveSymbolFromList(it->second.Symbols, symbol);
+            found = true;
         }
 
         //
-        // At this point, there is at least some overlap.  Walk forward, adding symbol to the ranges where
-        // appropriate and splitting where not.
+        // If we could not find this range, it's not a failure per-se.  Just return S_FALSE to the caller
+        // to let them know nothing was actually removed!
         //
-        size_t cur = it - m_ranges.begin();
-        while (start < end)
-        {
-            //
-            // If we have gotten to the point where there's nothing left and we still have range, append it.
-            //
-            if (cur >= m_ranges.size())
-            {
-                m_ranges.push_back( { start, end, { symbol } });
-                start = end;
-                break;
-            }
-
-            AddressRange& rng = m_ranges[cur];
-            
-            //
-            // If there is 100% overlap, just add the new symbol and be done.
-            //
-            if (start == rng.Start && end == rng.End)
-            {
-                rng.Symbols.push_back(symbol);
-                start = end;
-                break;
-            }
-
-            //
-            // If there is a part of the range before rng, insert it and continue on.
-            //
-            if (start < rng.Start)
-            {
-                ULONG64 curEnd = end;
-                if (curEnd > rng.Start)
-                {
-                    curEnd = rng.Start;
-                }
-
-                if (curEnd - start > 0)
-                {
-                    m_ranges.insert(m_ranges.begin() + cur, { start, curEnd, { symbol } });
-                    ++cur;
-                    start = curEnd;
-                    continue;
-                }
-            }
-
-            if (start >= rng.Start && start < rng.End)
-            {
-                //
-                // There is overlap.  Start is within the range.  End may be within the range *OR* it may be
-                // outside of the range.  We need to split the range.  There are three split points:
-                //
-                // 1: [rng.Start, start)
-                // 2: [start, end)
-                // 3: [end, rng.End)
-                //
-                // Note that if end goes outside the bounds of rng, there are only two:
-                //
-                // 1: [rng.Start, start)
-                // 2: [start, rng.End)
-                //
-                // But in the latter case, we will have to loop back up and continue with whatever was outside
-                // the bounds of rng.
-                //
-                if (start > rng.Start)
-                {
-                    auto itn = m_ranges.insert(m_ranges.begin() + cur, { rng.Start, start, rng.Symbols } );
-                    ++cur;
-                    AddressRange& existingRange = m_ranges[cur];
-                    existingRange.Start = start;
-                    continue;
-                }
-                else if (end >= rng.End)
-                {
-                    rng.Symbols.push_back(symbol);
-                    start = rng.End;
-                    ++cur;
-                    continue;
-                }
-                else
-                {
-                    //
-                    // We need to split again -- this is that #2 range in the first case above.  First, add
-                    // the new range for #3
-                    //
-                    auto itb = m_ranges.begin() + cur + 1;
-                    m_ranges.insert(itb, { end, rng.End, rng.Symbols });
-                    AddressRange& existingRange = m_ranges[cur];
-                    existingRange.End = end;
-                    existingRange.Symbols.push_back(symbol);
-                    start = end;
-                    break;
-                }
-            }
-            else
-            {
-                //
-                // It's not this range.  Move onto the next one.
-                //
-                ++cur;
-                continue;
-            }
-        }
-
-        return S_OK;
+        return (found ? S_OK : S_FALSE);
     };
     return ConvertException(fn);
 }
 
-HRESULT SymbolRangeList::RemoveSymbol(_In_ ULONG64 start, _In_ ULONG64 end, _In_ ULONG64 symbol)
+HRESULT SymbolRangeList::FlushPendingRanges()
 {
+    if (m_pendingRanges.empty())
+    {
+        return S_OK;
+    }
+
+    size_t placed = 0;
+
     //
     // We cannot let a C++ exception escape.
     //
     auto fn = [&]()
     {
         //
-        // Find where the first range associated with this symbol is and remove everything between
-        // [start, end)
-        //
-        auto it = std::lower_bound(m_ranges.begin(), m_ranges.end(), start,
-                                   [&](_In_ const AddressRange& rng, _In_ ULONG64 start)
-                                   {
-                                       return rng.End < start;
-                                   });
-
-        if (it == m_ranges.end() || it->Start > end)
-        {
-            //
-            // We could not find this range.  It's not a failure per-se.  Just return S_FALSE to the caller
-            // to let them know nothing was actually removed!
-            //
-            return S_FALSE;
-        }
-
+        // The common case for a large load (e.g.: an import of every function in a module) is a set of ranges
+        // which do not overlap each other or anything already in the index.  In that case, the order in which
+        // they were added makes no difference.  Sort them once and append each with a hint which makes the
+        // insertion constant time.
         //
-        // We need to keep walking and removing symbols or splitting ranges until we hit a range which is
-        // past the end of the sought half-open set [start, end)
+        // If anything overlaps, the order in which symbols were added determines the order of the symbol lists
+        // of split ranges.  Place them one at a time in the order they were added.
         //
-        size_t cur = it - m_ranges.begin();
-        while (cur < m_ranges.size() && end > m_ranges[cur].Start)
+        std::vector<PendingRange> sortedRanges(m_pendingRanges);
+        std::sort(sortedRanges.begin(), sortedRanges.end(),
+                  [](_In_ PendingRange const& a, _In_ PendingRange const& b)
+                  {
+                      return a.Start < b.Start;
+                  });
+
+        bool canAppend = true;
+        ULONG64 appendFrom = m_ranges.empty() ? 0 : std::prev(m_ranges.end())->second.End;
+        for (auto&& pending : sortedRanges)
         {
-            AddressRange& rng = m_ranges[cur];
-
-            //
-            // If the range is equivalent or a sub-range, just remove the symbol
-            //
-            if (start <= rng.Start && end >= rng.End)
+            if (pending.Start < appendFrom)
             {
-                RemoveSymbolFromList(rng.Symbols, symbol);
-                ++cur;
-                continue;
+                canAppend = false;
+                break;
             }
+            appendFrom = pending.End;
+        }
 
-            //
-            // If there is a sub-portion at the beginning of the range that we are *NOT* removing the
-            // symbol index from, we need to split.
-            //
-            // This would be something like:
-            //
-            //     range:   [              )
-            //    remove:         [        )
-            //
-            // Where we now need:
-            //
-            //    range1:   [     )                 <-- has symbol
-            //    range2:         [        )        <-- does not have symbol
-            //
-            if (start > rng.Start && start < rng.End)
+        if (canAppend)
+        {
+            m_pendingRanges.swap(sortedRanges);
+            for (; placed < m_pendingRanges.size(); ++placed)
             {
-                auto itb = m_ranges.begin() + cur + 1;
-                auto itn = m_ranges.insert(itb, { start, rng.End, rng.Symbols } );      // range2
-                RemoveSymbolFromList(itn->Symbols, symbol);
-
-                AddressRange& existingRange = m_ranges[cur];
-                existingRange.End = start;
-                ++cur;
-                continue;
+                PendingRange const& pending = m_pendingRanges[placed];
+                m_ranges.emplace_hint(m_ranges.end(), pending.Start, AddressRange { pending.End, { pending.Symbol } });
             }
-
-            //
-            // Now we need to check the other side of this (the above will fall into this after the split and continue)
-            //
-            // We may need a further split having something like:
-            //
-            //     range:   [              )
-            //    remove:   [        )
-            //
-            // Where we now need:
-            //
-            //    range1:   [        )              <-- does not have symbol
-            //    range2:            [     )        <-- has symbol
-            //
-            else if (end > rng.Start && end < rng.End)
+        }
+        else
+        {
+            for (; placed < m_pendingRanges.size(); ++placed)
             {
-                auto itb = m_ranges.begin() + cur + 1;
-                auto itn = m_ranges.insert(itb, { end, rng.End, rng.Symbols });      // range2
-
-                AddressRange& existingRange = m_ranges[cur];
-                existingRange.End = end;
-                RemoveSymbolFromList(existingRange.Symbols, symbol);
-                ++cur;
-                continue;
+                PendingRange const& pending = m_pendingRanges[placed];
+                InsertRange(pending.Start, pending.End, pending.Symbol);
             }
-
-            break;
         }
 
         return S_OK;
     };
-    return ConvertException(fn);
-}
-
-IDebugServiceManager* SymbolSet::GetServiceManager() const
-{
-    return m_pOwningProcess->GetServiceManager();
-}
+    HRESULT hr = ConvertException(fn);
 
-ISvcMachineArchitecture* SymbolSet::GetArchInfo() const
-{
-    return m_pOwningProcess->GetArchInfo();
+    m_pendingRanges.erase(m_pendingRanges.begin(), m_pendingRanges.begin() + placed);
+    return hr;
 }
 
-SymbolBuilderManager* SymbolSet::GetSymbolBuilderManager() const
+void SymbolRangeList::SplitRangeAt(_In_ ULONG64 address)
 {
-    return m_pOwningProcess->GetSymbolBuilderManager();
-}
+    auto it = m_ranges.upper_bound(address);
+    if (it == m_ranges.begin())
+    {
+        return;
+    }
 
-ISvcModule* SymbolSet::GetModule() const
-{
-    return m_spModule.Get();
+    --it;
+    if (it->first < address && address < it->second.End)
+    {
+        m_ranges.emplace_hint(std::next(it), address, AddressRange { it->second.End, it->second.Symbols });
+        it->second.End = address;
+    }
 }
 
-HRESULT SymbolSet::AddBasicCTypes()
+void SymbolRangeList::InsertRange(_In_ ULONG64 start, _In_ ULONG64 end, _In_ ULONG64 symbol)
 {
-    HRESULT hr = S_OK;
-
-    ComPtr<BasicTypeSymbol> spNew;
-    IfFailedReturn(MakeAndInitialize<BasicTypeSymbol>(&spNew, this, SvcSymbolIntrinsicVoid, 0, L"void"));
-    IfFailedReturn(MakeAndInitialize<BasicTypeSymbol>(&spNew, this, SvcSymbolIntrinsicBool, 1, L"bool"));
-    IfFailedReturn(MakeAndInitialize<BasicTypeSymbol>(&spNew, this, SvcSymbolIntrinsicChar, 1, L"char"));
-    IfFailedReturn(MakeAndInitialize<BasicTypeSymbol>(&spNew, this, SvcSymbolIntrinsicUInt, 1, L"unsigned char"));
-    IfFailedReturn(MakeAndInitialize<BasicTypeSymbol>(&spNew, this, SvcSymbolIntrinsicWChar, 2, L"wchar_t"));
-    IfFailedReturn(MakeAndInitialize<BasicTypeSymbol>(&spNew, this, SvcSymbolIntrinsicInt, 2, L"short"));
-    IfFailedReturn(MakeAndInitialize<BasicTypeSymbol>(&spNew, this, SvcSymbolIntrinsicUInt, 2, L"unsigned short"));
-    IfFailedReturn(MakeAndInitialize<BasicTypeSymbol>(&spNew, this, SvcSymbolIntrinsicInt, 4, L"int"));
-    IfFailedReturn(MakeAndInitialize<BasicTypeSymbol>(&spNew, this, SvcSymbolIntrinsicUInt, 4, L"unsigned int"));
-    IfFailedReturn(MakeAndInitialize<BasicTypeSymbol>(&spNew, this, SvcSymbolIntrinsicInt, 8, L"__int64"));
-    IfFailedReturn(MakeAndInitialize<BasicTypeSymbol>(&spNew, this, SvcSymbolIntrinsicUInt, 8, L"unsigned __int64"));
-    IfFailedReturn(MakeAndInitialize<BasicTypeSymbol>(&spNew, this, SvcSymbolIntrinsicLong, 4, L"long"));
-    IfFailedReturn(MakeAndInitialize<BasicTypeSymbol>(&spNew, this, SvcSymbolIntrinsicULong, 4, L"unsigned long"));
-    IfFailedReturn(MakeAndInitialize<BasicTypeSymbol>(&spNew, this, SvcSymbolIntrinsicFloat, 4, L"float"));
-    IfFailedReturn(MakeAndInitialize<BasicTypeSymbol>(&spNew, this, SvcSymbolIntrinsicFloat, 8, L"double"));
-
     //
-    // "Architecture" dependent types.
+    // Split any existing range which straddles either end of [start, end).  After this, the new range is
+    // covered exactly by some set of whole existing ranges and the gaps between them.  The symbol is added to
+    // each of the former and a new range holding only the symbol is created for each of the latter.
     //
-    IfFailedReturn(MakeAndInitialize<BasicTypeSymbol>(&spNew, this, SvcSymbolIntrinsicUInt, 
-                                                      static_cast<ULONG>(GetArchInfo()->GetBitness() / 8), L"size_t"));
-
-    return hr;
-}
-
-HRESULT SymbolSet::AddNewSymbol(_In_ BaseSymbol *pBaseSymbol, _Out_ ULONG64 *pUniqueId, _In_ ULONG64 reservedId)
-{
+    //     existing:   [      )      [          )
+    //          new:       [                )
     //
-    // We cannot let a C++ exception escape.
+    //       result:   [  )[  )[    )[      )[  )
+    //                  A   AN   N    AN      A
     //
-    auto fn = [&]()
+    SplitRangeAt(start);
+    SplitRangeAt(end);
+
+    ULONG64 cur = start;
+    auto it = m_ranges.lower_bound(start);
+    while (cur < end)
     {
-        ULONG64 uniqueId = (reservedId == 0 ? GetUniqueId() : reservedId);
-        if (uniqueId > std::numeric_limits<size_t>::max())
+        if (it == m_ranges.end() || it->first >= end)
         {
-            return E_FAIL;
+            m_ranges.emplace_hint(it, cur, AddressRange { end, { symbol } });
+            break;
         }
 
-        if (m_symbols.size() <= uniqueId + 1)
+        if (it->first > cur)
         {
-            m_symbols.resize(static_cast<size_t>(uniqueId + 1));
+            m_ranges.emplace_hint(it, cur, AddressRange { it->first, { symbol } });
+            cur = it->first;
         }
 
-        if (m_symbols[static_cast<size_t>(uniqueId)] != nullptr)
+        it->second.Symbols.push_back(symbol);
+        cur = it->second.End;
+        ++it;
+    }
+}
+
+//*************************************************
+// Name Trie:
+//
+
+void NameTrie::AddName(_In_ std::wstring const& name, _In_ ULONG64 symbol)
+{
+    Node *pNode = &m_root;
+    size_t pos = 0;
+    for(;;)
+    {
+        if (pos == name.size())
         {
-            return E_UNEXPECTED;
+            pNode->Symbols.push_back(symbol);
+            return;
         }
 
-        m_symbols[static_cast<size_t>(uniqueId)] = pBaseSymbol;
+        auto it = pNode->Children.find(name[pos]);
+        if (it == pNode->Children.end())
+        {
+            auto spNew = std::make_unique<Node>();
+            spNew->Label = name.substr(pos);
+            spNew->Symbols.push_back(symbol);
+            pNode->Children.emplace(name[pos], std::move(spNew));
+            return;
+        }
+
+        Node *pChild = it->second.get();
+        std::wstring const& label = pChild->Label;
+
+        size_t common = 1;
+        while (common < label.size() && pos + common < name.size() && label[common] == name[pos + common])
+        {
+            ++common;
+        }
+
+        //
+        // If the name diverges part way along the child's label, split the child at that point.  Everything
+        // which can throw is done before the trie is modified.
+        //
+        if (common < label.size())
+        {
+            auto spSplit = std::make_unique<Node>();
+            spSplit->Label = label.substr(0, common);
+            auto&& slot = spSplit->Children[label[common]];
+
+            slot = std::move(it->second);
+            slot->Label.erase(0, common);
+            pChild = spSplit.get();
+            it->second = std::move(spSplit);
+        }
+
+        pNode = pChild;
+        pos += common;
+    }
+}
+
+bool NameTrie::RemoveFromNode(_In_ Node *pNode,
+                              _In_ std::wstring const& name,
+                              _In_ size_t pos,
+                              _In_ ULONG64 symbol)
+{
+    if (pos == name.size())
+    {
+        auto it = std::find(pNode->Symbols.begin(), pNode->Symbols.end(), symbol);
+        if (it != pNode->Symbols.end())
+        {
+            pNode->Symbols.erase(it);
+        }
+    }
+    else
+    {
+        auto it = pNode->Children.find(name[pos]);
+        if (it == pNode->Children.end())
+        {
+            return false;
+        }
+
+        Node *pChild = it->second.get();
+        if (name.compare(pos, pChild->Label.size(), pChild->Label) != 0)
+        {
+            return false;
+        }
+
+        if (RemoveFromNode(pChild, name, pos + pChild->Label.size(), symbol))
+        {
+            pNode->Children.erase(it);
+        }
+        else if (pChild->Symbols.empty() && pChild->Children.size() == 1)
+        {
+            std::unique_ptr<Node>& spOnlyChild = pChild->Children.begin()->second;
+            std::wstring mergedLabel = pChild->Label + spOnlyChild->Label;
+
+            spOnlyChild->Label = std::move(mergedLabel);
+            std::unique_ptr<Node> spMerged = std::move(spOnlyChild);
+            it->second = std::move(spMerged);
+        }
+    }
+
+    return (pNode->Symbols.empty() && pNode->Children.empty());
+}
+
+void NameTrie::RemoveName(_In_ std::wstring const& name, _In_ ULONG64 symbol)
+{
+    //
+    // The root is never removed, even if it is left empty.
+    //
+    (void)RemoveFromNode(&m_root, name, 0, symbol);
+}
+
+NameTrie::Node const* NameTrie::FindNode(_In_ std::wstring const& prefix, _Out_ size_t *pLabelMatched) const
+{
+    Node const *pNode = &m_root;
+    size_t pos = 0;
+    size_t labelMatched = 0;
+
+    while (pos < prefix.size())
+    {
+        auto it = pNode->Children.find(prefix[pos]);
+        if (it == pNode->Children.end())
+        {
+            return nullptr;
+        }
+
+        Node const *pChild = it->second.get();
+        labelMatched = std::min(pChild->Label.size(), prefix.size() - pos);
+        if (prefix.compare(pos, labelMatched, pChild->Label, 0, labelMatched) != 0)
+        {
+            return nullptr;
+        }
+
+        pos += labelMatched;
+        pNode = pChild;
+    }
+
+    *pLabelMatched = labelMatched;
+    return pNode;
+}
+
+void NameTrie::CollectSubtree(_In_ Node const *pNode, _Inout_ SymbolList& symbols)
+{
+    symbols.insert(symbols.end(), pNode->Symbols.begin(), pNode->Symbols.end());
+    for (auto&& child : pNode->Children)
+    {
+        CollectSubtree(child.second.get(), symbols);
+    }
+}
+
+void NameTrie::CollectSubtreeNames(_In_ Node const *pNode,
+                                   _Inout_ std::wstring& name,
+                                   _In_ std::function<void(std::wstring const&, SymbolList const&)> const& fn)
+{
+    if (!pNode->Symbols.empty())
+    {
+        fn(name, pNode->Symbols);
+    }
+
+    for (auto&& child : pNode->Children)
+    {
+        size_t len = name.size();
+        name.append(child.second->Label);
+        CollectSubtreeNames(child.second.get(), name, fn);
+        name.resize(len);
+    }
+}
+
+void NameTrie::FindWithPrefix(_In_ std::wstring const& prefix, _Inout_ SymbolList& symbols) const
+{
+    size_t labelMatched;
+    Node const *pNode = FindNode(prefix, &labelMatched);
+    if (pNode != nullptr)
+    {
+        CollectSubtree(pNode, symbols);
+    }
+}
+
+void NameTrie::FindMatchingGlob(_In_ std::wstring const& pattern, _Inout_ SymbolList& symbols) const
+{
+    //
+    // Everything up to the first wildcard must match literally.  Start the walk at the node for that prefix.
+    //
+    size_t literalLength = pattern.find_first_of(L"*?");
+    if (literalLength == std::wstring::npos)
+    {
+        literalLength = pattern.size();
+    }
+
+    size_t labelMatched;
+    Node const *pStart = FindNode(pattern.substr(0, literalLength), &labelMatched);
+    if (pStart == nullptr)
+    {
+        return;
+    }
+
+    //
+    // From there, walk the trie one character at a time against the remainder of the pattern.  A position
+    // within the trie is a node and the number of characters of its label consumed.  A '*' can match any run
+    // of characters, so the same (position, pattern index) state can be reached many ways; each is only
+    // explored once.
+    //
+    struct State
+    {
+        Node const *pNode;
+        size_t LabelPos;
+        size_t PatternPos;
+    };
+
+    std::vector<State> pending { { pStart, labelMatched, literalLength } };
+    std::set<std::tuple<Node const *, size_t, size_t>> visited;
+
+    auto pushNext = [&](State const& cur, wchar_t match, bool anyChar, size_t nextPatternPos)
+    {
+        if (cur.LabelPos < cur.pNode->Label.size())
+        {
+            if (anyChar || cur.pNode->Label[cur.LabelPos] == match)
+            {
+                pending.push_back({ cur.pNode, cur.LabelPos + 1, nextPatternPos });
+            }
+        }
+        else if (anyChar)
+        {
+            for (auto&& child : cur.pNode->Children)
+            {
+                pending.push_back({ child.second.get(), 1, nextPatternPos });
+            }
+        }
+        else
+        {
+            auto it = cur.pNode->Children.find(match);
+            if (it != cur.pNode->Children.end())
+            {
+                pending.push_back({ it->second.get(), 1, nextPatternPos });
+            }
+        }
+    };
+
+    while (!pending.empty())
+    {
+        State cur = pending.back();
+        pending.pop_back();
+
+        if (!visited.insert(std::make_tuple(cur.pNode, cur.LabelPos, cur.PatternPos)).second)
+        {
+            continue;
+        }
+
+        if (cur.PatternPos == pattern.size())
+        {
+            if (cur.LabelPos == cur.pNode->Label.size())
+            {
+                symbols.insert(symbols.end(), cur.pNode->Symbols.begin(), cur.pNode->Symbols.end());
+            }
+            continue;
+        }
+
+        wchar_t c = pattern[cur.PatternPos];
+        if (c == L'*')
+        {
+            //
+            // A trailing '*' matches everything at or below this position.
+            //
+            if (cur.PatternPos + 1 == pattern.size())
+            {
+                CollectSubtree(cur.pNode, symbols);
+                continue;
+            }
+
+            pending.push_back({ cur.pNode, cur.LabelPos, cur.PatternPos + 1 });
+            pushNext(cur, c, true, cur.PatternPos);
+        }
+        else
+        {
+            pushNext(cur, c, c == L'?', cur.PatternPos + 1);
+        }
+    }
+}
+
+std::wstring NameTrie::LiteralRegexPrefix(_In_ std::wstring const& pattern)
+{
+    std::wstring prefix;
+
+    //
+    // With an alternation, there is no single prefix.
+    //
+    if (pattern.find(L'|') != std::wstring::npos)
+    {
+        return prefix;
+    }
+
+    size_t pos = 0;
+    if (pos < pattern.size() && pattern[pos] == L'^')
+    {
+        ++pos;
+    }
+
+    while (pos < pattern.size())
+    {
+        wchar_t literal;
+        size_t next;
+
+        wchar_t c = pattern[pos];
+        if (c == L'\\')
+        {
+            //
+            // An escaped punctuation character is a literal.  Anything else (\d, \w, ...) is a class.
+            //
+            if (pos + 1 >= pattern.size() || !iswpunct(pattern[pos + 1]))
+            {
+                break;
+            }
+            literal = pattern[pos + 1];
+            next = pos + 2;
+        }
+        else if (wcschr(L".[]{}()*+?^$", c) != nullptr)
+        {
+            break;
+        }
+        else
+        {
+            literal = c;
+            next = pos + 1;
+        }
+
+        //
+        // A quantified literal may not be present (or may be repeated).  Stop before it.
+        //
+        if (next < pattern.size() && wcschr(L"*+?{", pattern[next]) != nullptr)
+        {
+            break;
+        }
+
+        prefix.push_back(literal);
+        pos = next;
+    }
+
+    return prefix;
+}
+
+void NameTrie::FindMatchingRegex(_In_ std::wstring const& pattern, _Inout_ SymbolList& symbols) const
+{
+    std::wregex expression(pattern);
+    std::wstring prefix = LiteralRegexPrefix(pattern);
+
+    size_t labelMatched;
+    Node const *pNode = FindNode(prefix, &labelMatched);
+    if (pNode == nullptr)
+    {
+        return;
+    }
+
+    std::wstring name = prefix.substr(0, prefix.size() - labelMatched) + pNode->Label;
+    CollectSubtreeNames(pNode, name, [&](std::wstring const& candidate, SymbolList const& candidateSymbols)
+    {
+        if (std::regex_match(candidate, expression))
+        {
+            symbols.insert(symbols.end(), candidateSymbols.begin(), candidateSymbols.end());
+        }
+    });
+}
+
+bool NameTrie::GlobMatch(_In_ wchar_t const *pPattern, _In_ wchar_t const *pName)
+{
+    //
+    // On a mismatch, backtrack to the most recent '*' and let it consume one more character.
+    //
+    wchar_t const *pStarPattern = nullptr;
+    wchar_t const *pStarName = nullptr;
+
+    while (*pName != L'\0')
+    {
+        if (*pPattern == L'*')
+        {
+            pStarPattern = pPattern++;
+            pStarName = pName;
+        }
+        else if (*pPattern != L'\0' && (*pPattern == L'?' || *pPattern == *pName))
+        {
+            ++pPattern;
+            ++pName;
+        }
+        else if (pStarPattern != nullptr)
+        {
+            pPattern = pStarPattern + 1;
+            pName = ++pStarName;
+        }
+        else
+        {
+            return false;
+        }
+    }
+
+    while (*pPattern == L'*')
+    {
+        ++pPattern;
+    }
+
+    return (*pPattern == L'\0');
+}
+
+std::vector<SymbolSetLock::ThreadHold>& SymbolSetLock::GetThreadHolds()
+{
+    thread_local std::vector<ThreadHold> threadHolds;
+    return threadHolds;
+}
+
+SymbolSetLock::ThreadHold *SymbolSetLock::FindThreadHold(_In_ bool create)
+{
+    auto&& threadHolds = GetThreadHolds();
+    for (auto&& hold : threadHolds)
+    {
+        if (hold.Lock == this)
+        {
+            return &hold;
+        }
+    }
+
+    if (!create)
+    {
+        return nullptr;
+    }
+
+    threadHolds.push_back( { this, 0, 0 } );
+    return &(threadHolds.back());
+}
+
+void SymbolSetLock::ReleaseThreadHold()
+{
+    auto&& threadHolds = GetThreadHolds();
+    for (auto it = threadHolds.begin(); it != threadHolds.end(); ++it)
+    {
+        if (it->Lock == this)
+        {
+            threadHolds.erase(it);
+            break;
+        }
+    }
+}
+
+void SymbolSetLock::LockShared()
+{
+    ThreadHold *pHold = FindThreadHold(true);
+    if (pHold->SharedDepth == 0 && pHold->ExclusiveDepth == 0)
+    {
+        try
+        {
+            m_lock.lock_shared();
+        }
+        catch(...)
+        {
+            ReleaseThreadHold();
+            throw;
+        }
+    }
+
+    ++pHold->SharedDepth;
+}
+
+void SymbolSetLock::UnlockShared()
+{
+    ThreadHold *pHold = FindThreadHold(false);
+    if (pHold == nullptr || pHold->SharedDepth == 0)
+    {
+        return;
+    }
+
+    if (--pHold->SharedDepth == 0 && pHold->ExclusiveDepth == 0)
+    {
+        m_lock.unlock_shared();
+        ReleaseThreadHold();
+    }
+}
+
+void SymbolSetLock::LockExclusive()
+{
+    ThreadHold *pHold = FindThreadHold(true);
+    if (pHold->ExclusiveDepth == 0)
+    {
+        //
+        // A shared hold cannot be upgraded.  Whatever took the lock shared further up the stack must give it up
+        // before anything which changes the symbol set is called.
+        //
+        if (pHold->SharedDepth > 0)
+        {
+            throw std::logic_error("Internal error: symbol set lock upgraded from shared to exclusive");
+        }
+
+        try
+        {
+            m_lock.lock();
+        }
+        catch(...)
+        {
+            ReleaseThreadHold();
+            throw;
+        }
+    }
+
+    ++pHold->ExclusiveDepth;
+}
+
+void SymbolSetLock::UnlockExclusive()
+{
+    ThreadHold *pHold = FindThreadHold(false);
+    if (pHold == nullptr || pHold->ExclusiveDepth == 0)
+    {
+        return;
+    }
+
+    //
+    // The release handler runs while the lock is still held exclusive (and may take it again).
+    //
+    if (pHold->ExclusiveDepth == 1 && m_releasingExclusive)
+    {
+        m_releasingExclusive();
+        pHold = FindThreadHold(false);
+    }
+
+    if (--pHold->ExclusiveDepth == 0)
+    {
+        m_lock.unlock();
+        if (pHold->SharedDepth > 0)
+        {
+            m_lock.lock_shared();
+        }
+        else
+        {
+            ReleaseThreadHold();
+        }
+    }
+}
+
+bool SymbolSetLock::IsHeldExclusive()
+{
+    ThreadHold *pHold = FindThreadHold(false);
+    return (pHold != nullptr && pHold->ExclusiveDepth > 0);
+}
+
+IDebugServiceManager* SymbolSet::GetServiceManager() const
+{
+    return m_pOwningProcess->GetServiceManager();
+}
+
+ISvcMachineArchitecture* SymbolSet::GetArchInfo() const
+{
+    return m_pOwningProcess->GetArchInfo();
+}
+
+SymbolBuilderManager* SymbolSet::GetSymbolBuilderManager() const
+{
+    return m_pOwningProcess->GetSymbolBuilderManager();
+}
+
+ISvcModule* SymbolSet::GetModule() const
+{
+    return m_spModule.Get();
+}
+
+HRESULT SymbolSet::AddBasicCTypes()
+{
+    HRESULT hr = S_OK;
+
+    ComPtr<BasicTypeSymbol> spNew;
+    IfFailedReturn(MakeAndInitialize<BasicTypeSymbol>(&spNew, this, SvcSymbolIntrinsicVoid, 0, L"void"));
+    IfFailedReturn(MakeAndInitialize<BasicTypeSymbol>(&spNew, this, SvcSymbolIntrinsicBool, 1, L"bool"));
+    IfFailedReturn(MakeAndInitialize<BasicTypeSymbol>(&spNew, this, SvcSymbolIntrinsicChar, 1, L"char"));
+    IfFailedReturn(MakeAndInitialize<BasicTypeSymbol>(&spNew, this, SvcSymbolIntrinsicUInt, 1, L"unsigned char"));
+    IfFailedReturn(MakeAndInitialize<BasicTypeSymbol>(&spNew, this, SvcSymbolIntrinsicWChar, 2, L"wchar_t"));
+    IfFailedReturn(MakeAndInitialize<BasicTypeSymbol>(&spNew, this, SvcSymbolIntrinsicInt, 2, L"short"));
+    IfFailedReturn(MakeAndInitialize<BasicTypeSymbol>(&spNew, this, SvcSymbolIntrinsicUInt, 2, L"unsigned short"));
+    IfFailedReturn(MakeAndInitialize<BasicTypeSymbol>(&spNew, this, SvcSymbolIntrinsicInt, 4, L"int"));
+    IfFailedReturn(MakeAndInitialize<BasicTypeSymbol>(&spNew, this, SvcSymbolIntrinsicUInt, 4, L"unsigned int"));
+    IfFailedReturn(MakeAndInitialize<BasicTypeSymbol>(&spNew, this, SvcSymbolIntrinsicInt, 8, L"__int64"));
+    IfFailedReturn(MakeAndInitialize<BasicTypeSymbol>(&spNew, this, SvcSymbolIntrinsicUInt, 8, L"unsigned __int64"));
+    IfFailedReturn(MakeAndInitialize<BasicTypeSymbol>(&spNew, this, SvcSymbolIntrinsicLong, 4, L"long"));
+    IfFailedReturn(MakeAndInitialize<BasicTypeSymbol>(&spNew, this, SvcSymbolIntrinsicULong, 4, L"unsigned long"));
+    IfFailedReturn(MakeAndInitialize<BasicTypeSymbol>(&spNew, this, SvcSymbolIntrinsicFloat, 4, L"float"));
+    IfFailedReturn(MakeAndInitialize<BasicTypeSymbol>(&spNew, this, SvcSymbolIntrinsicFloat, 8, L"double"));
+
+    //
+    // "Architecture" dependent types.
+    //
+    IfFailedReturn(MakeAndInitialize<BasicTypeSymbol>(&spNew, this, SvcSymbolIntrinsicUInt, 
+                                                      static_cast<ULONG>(GetArchInfo()->GetBitness() / 8), L"size_t"));
+
+    return hr;
+}
+
+HRESULT SymbolSet::AddNewSymbol(_In_ BaseSymbol *pBaseSymbol, _Out_ ULONG64 *pUniqueId, _In_ ULONG64 reservedId)
+{
+    //
+    // We cannot let a C++ exception escape.
+    //
+    auto fn = [&]()
+    {
+        SymbolSetExclusiveLock lock(m_lock);
+
+        ULONG64 uniqueId = (reservedId == 0 ? GetUniqueId() : reservedId);
+        if (uniqueId > std::numeric_limits<size_t>::max())
+        {
+            return E_FAIL;
+        }
+
+        if (m_symbols.size() <= uniqueId + 1)
+        {
+            m_symbols.resize(static_cast<size_t>(uniqueId + 1));
+        }
+
+        if (m_symbols[static_cast<size_t>(uniqueId)] != nullptr)
+        {
+            return E_UNEXPECTED;
+        }
+
+        m_symbols[static_cast<size_t>(uniqueId)] = pBaseSymbol;
+
+        m_kindIndex[pBaseSymbol->InternalGetKind()].insert(uniqueId);
+        IndexSymbolName(pBaseSymbol);
+
+        if (pBaseSymbol->IsGlobal())
+        {
+            m_globalSymbols.push_back(uniqueId);
+            if (!pBaseSymbol->InternalGetQualifiedName().empty())
+            {
+                m_symbolNameMap.insert( { pBaseSymbol->InternalGetQualifiedName(), uniqueId });
+            }
+        }
+
+        *pUniqueId = uniqueId;
+
+        // 
+        // Send an advisory notification upwards that everyone should flush caches.  Do not consider this
+        // a failure to create the symbol if something goes wrong.  At worst, an explicit .reload will be
+        // required in the debugger.
+        //
+        (void)InvalidateExternalCaches();
+
+        return S_OK;
+    };
+    return ConvertException(fn);
+}
+
+void SymbolSet::IndexSymbolName(_In_ BaseSymbol *pSymbol)
+{
+    ULONG64 uniqueId = pSymbol->InternalGetId();
+
+    if (!pSymbol->InternalGetName().empty())
+    {
+        m_nameIndex[pSymbol->InternalGetName()].insert(uniqueId);
+    }
+
+    if (!pSymbol->InternalGetQualifiedName().empty())
+    {
+        m_qualifiedNameIndex[pSymbol->InternalGetQualifiedName()].insert(uniqueId);
+        m_qualifiedNameTrie.AddName(pSymbol->InternalGetQualifiedName(), uniqueId);
+    }
+}
+
+void SymbolSet::UnindexSymbolName(_In_ BaseSymbol *pSymbol)
+{
+    ULONG64 uniqueId = pSymbol->InternalGetId();
+
+    auto removeFrom = [uniqueId](std::unordered_map<std::wstring_view, std::set<ULONG64>>& index,
+                                 std::wstring const& name)
+    {
+        auto it = index.find(name);
+        if (it != index.end())
+        {
+            it->second.erase(uniqueId);
+            if (it->second.empty())
+            {
+                index.erase(it);
+            }
+        }
+    };
+
+    removeFrom(m_nameIndex, pSymbol->InternalGetName());
+    removeFrom(m_qualifiedNameIndex, pSymbol->InternalGetQualifiedName());
+
+    if (!pSymbol->InternalGetQualifiedName().empty())
+    {
+        m_qualifiedNameTrie.RemoveName(pSymbol->InternalGetQualifiedName(), uniqueId);
+    }
+}
+
+void SymbolSet::InternalFindSymbolsMatching(_In_ std::wstring const& pattern,
+                                            _In_ bool isRegex,
+                                            _Out_ std::vector<ULONG64> *pSymbols) const
+{
+    pSymbols->clear();
+
+    if (isRegex)
+    {
+        m_qualifiedNameTrie.FindMatchingRegex(pattern, *pSymbols);
+    }
+    else
+    {
+        m_qualifiedNameTrie.FindMatchingGlob(pattern, *pSymbols);
+    }
+
+    //
+    // A symbol may be reached along more than one path through the trie (e.g.: "*a*" against "aa").
+    //
+    std::sort(pSymbols->begin(), pSymbols->end());
+    pSymbols->erase(std::unique(pSymbols->begin(), pSymbols->end()), pSymbols->end());
+}
+
+void SymbolSet::GetImageSharingStatistics(_Out_ size_t *pSharingSets,
+                                          _Out_ size_t *pSymbolCount,
+                                          _Out_ size_t *pHeldSnapshotBytes)
+{
+    SymbolSetSharedLock lock(m_lock);
+
+    //
+    // Every symbol set sharing the image holds a reference to the shared state.  The manager only holds it
+    // weakly.
+    //
+    *pSharingSets = (m_spSharedImage == nullptr ? 0 : static_cast<size_t>(m_spSharedImage.use_count()));
+    *pSymbolCount = static_cast<size_t>(std::count_if(m_symbols.begin(), m_symbols.end(),
+                                                      [](ComPtr<ISvcSymbol> const& spSymbol)
+                                                      {
+                                                          return spSymbol != nullptr;
+                                                      }));
+    *pHeldSnapshotBytes = (m_spSnapshotReader == nullptr ? 0 : m_spSnapshotReader->GetHeldBufferSize());
+}
+
+HRESULT SymbolSet::DeleteExistingSymbol(_In_ ULONG64 uniqueId)
+{
+    //
+    // We cannot let a C++ exception escape.
+    //
+    auto fn = [&]()
+    {
+        SymbolSetExclusiveLock lock(m_lock);
+
+        //
+        // As we hand out 'uniqueId' based on position within a vector, it should always fit within the
+        // bounds of a size_t.  
+        //
+        if (uniqueId > std::numeric_limits<size_t>::max())
+        {
+            return E_INVALIDARG;
+        }
+
+        BaseSymbol *pSymbol = InternalGetSymbol(uniqueId);
+        if (pSymbol != nullptr)
+        {
+            if (pSymbol->IsGlobal())
+            {
+                for (auto itg = m_globalSymbols.begin(); itg != m_globalSymbols.end(); ++itg)
+                {
+                    if (*itg == uniqueId)
+                    {
+                        m_globalSymbols.erase(itg);
+                        break;
+                    }
+                }
+
+                if (!pSymbol->InternalGetQualifiedName().empty())
+                {
+                    auto itn = m_symbolNameMap.find(pSymbol->InternalGetQualifiedName());
+                    if (itn != m_symbolNameMap.end())
+                    {
+                        m_symbolNameMap.erase(itn);
+                    }
+                }
+            }
+
+            auto itk = m_kindIndex.find(pSymbol->InternalGetKind());
+            if (itk != m_kindIndex.end())
+            {
+                itk->second.erase(uniqueId);
+                if (itk->second.empty())
+                {
+                    m_kindIndex.erase(itk);
+                }
+            }
+            UnindexSymbolName(pSymbol);
+
+            if (pSymbol->InternalGetKind() == SvcSymbolFunction)
+            {
+                m_scopeCache.EraseRange( { uniqueId, 0 }, { uniqueId + 1, 0 } );
+            }
+            else if (pSymbol->InternalGetKind() == SvcSymbolType)
+            {
+                InvalidateTypeExpressionCaches();
+            }
+
+            m_symbols[static_cast<size_t>(uniqueId)] = nullptr;
+
+            //
+            // Send an advisory notification upwards that everyone should flush caches.  Do not consider this
+            // a failure to delete the symbol if something goes wrong.  At worst, an explicit .reload will be
+            // required by the debugger.
+            //
+            (void)InvalidateExternalCaches();
+        }
+
+        return S_OK;
+    };
+    return ConvertException(fn);
+}
+
+HRESULT SymbolSet::GetSymbolById(_In_ ULONG64 symbolId,
+                                 _COM_Outptr_ ISvcSymbol **ppSymbol)
+{
+    *ppSymbol = nullptr;
+
+    //
+    // We cannot let a C++ exception escape.
+    //
+    auto fn = [&]()
+    {
+        HRESULT hr = S_OK;
+        SymbolSetSharedLock lock(m_lock);
+
+        bool isScopeBoundVariable = (symbolId & ScopeBoundIdFlag) != 0;
+        std::pair<ULONG64, ULONG64> scopeBinding;
+        if (isScopeBoundVariable)
+        {
+            IfFailedReturn(FlushPendingAddresses());
+            std::lock_guard<std::mutex> cacheLock(m_cacheLock);
+
+            symbolId &= ~ScopeBoundIdFlag;
+            if (symbolId >= m_scopeBindings.size())
+            {
+                return E_INVALIDARG;
+            }
+
+            scopeBinding = m_scopeBindings[static_cast<size_t>(symbolId)];
+            symbolId = scopeBinding.first;
+        }
+
+        if (symbolId >= m_symbols.size())
+        {
+            return E_INVALIDARG;
+        }
+
+        ISvcSymbol *pSymbol = m_symbols[static_cast<size_t>(symbolId)].Get();
+        if (pSymbol == nullptr)
+        {
+            return E_INVALIDARG;
+        }
+
+        if (isScopeBoundVariable)
+        {
+            Microsoft::WRL::ComPtr<VariableSymbol> spBoundVariable;
+            IfFailedReturn(GetScopeBoundVariable(scopeBinding.first, scopeBinding.second, &spBoundVariable));
+
+            Microsoft::WRL::ComPtr<ISvcSymbol> spSymbol = spBoundVariable;
+            *ppSymbol = spSymbol.Detach();
+        }
+        else
+        {
+            Microsoft::WRL::ComPtr<ISvcSymbol> spSymbol = pSymbol;
+            *ppSymbol = spSymbol.Detach();
+        }
+        return hr;
+    };
+    return ConvertException(fn);
+}
+
+HRESULT SymbolSet::EnumerateAllSymbols(_COM_Outptr_ ISvcSymbolSetEnumerator **ppEnumerator)
+{
+    HRESULT hr = S_OK;
+    *ppEnumerator = nullptr;
+
+    ComPtr<GlobalEnumerator> spEnum;
+    IfFailedReturn(MakeAndInitialize<GlobalEnumerator>(&spEnum, this));
+
+    *ppEnumerator = spEnum.Detach();
+    return hr;
+}
+
+bool SymbolSet::DeferDependentChange(_In_ ULONG64 uniqueId)
+{
+    if (m_batchDepth == 0)
+    {
+        return false;
+    }
+
+    auto fn = [&]()
+    {
+        if (m_batchChangedSymbolSet.insert(uniqueId).second)
+        {
+            m_batchChangedSymbols.push_back(uniqueId);
+        }
+        return S_OK;
+    };
+
+    //
+    // If we cannot record the change, the caller performs it immediately.  That is slower but still correct.
+    //
+    return SUCCEEDED(ConvertException(fn));
+}
+
+HRESULT SymbolSet::CommitBatch()
+{
+    //
+    // We cannot let a C++ exception escape.
+    //
+    auto fn = [&]()
+    {
+        HRESULT hr = S_OK;
+        SymbolSetExclusiveLock lock(m_lock);
+
+        if (m_batchDepth == 0)
+        {
+            return E_UNEXPECTED;
+        }
+
+        if (--m_batchDepth > 0)
+        {
+            return hr;
+        }
+
+        //
+        // Take ownership of the batch state before doing any of the deferred work.  Notifications may well
+        // change other symbols and those changes must happen immediately now that the batch is closed.
+        //
+        std::vector<ULONG64> changedSymbols = std::move(m_batchChangedSymbols);
+        m_batchChangedSymbols.clear();
+        m_batchChangedSymbolSet.clear();
+
+        bool invalidationPending = m_batchInvalidationPending;
+        m_batchInvalidationPending = false;
+
+        //
+        // Update every changed symbol and everything dependent upon them in a single pass.  Symbols which were
+        // deleted within the batch no longer resolve and are skipped.
+        //
+        if (!changedSymbols.empty())
+        {
+            hr = PropagateDependentChanges(changedSymbols.data(), changedSymbols.size());
+        }
+
+        if (invalidationPending)
+        {
+            (void)InvalidateExternalCaches();
+        }
+
+        return hr;
+    };
+    return ConvertException(fn);
+}
+
+HRESULT SymbolSet::PropagateDependentChanges(_In_reads_(count) ULONG64 const *pChangedSymbols, _In_ size_t count)
+{
+    using DependentIterator = std::unordered_map<ULONG64, ULONG64>::const_iterator;
+
+    auto fn = [&]()
+    {
+        HRESULT hr = S_OK;
+
+        //
+        // Walk the dependency graph depth first from each changed symbol.  A symbol is appended to 'postOrder' only
+        // after everything dependent upon it has been.  The reverse of that is a topological order: a UDT comes
+        // after the types of all of its fields, an array after its element type, and so on.  The 'visited' set
+        // guarantees that a symbol reachable along many paths (e.g.: a struct embedded in many others) is only
+        // collected once and that a cycle in the graph cannot send us around forever.
+        //
+        // This is done with an explicit stack.  Dependency chains of types can be far deeper than we would want
+        // to recurse.
+        //
+        std::unordered_set<ULONG64> visited;
+        std::vector<ULONG64> postOrder;
+        std::vector<std::pair<BaseSymbol *, DependentIterator>> walkStack;
+
+        for (size_t i = 0; i < count; ++i)
+        {
+            ULONG64 changedId = pChangedSymbols[i];
+            BaseSymbol *pChangedSymbol = InternalGetSymbol(changedId);
+            if (pChangedSymbol == nullptr || !visited.insert(changedId).second)
+            {
+                continue;
+            }
+
+            walkStack.push_back({ pChangedSymbol, pChangedSymbol->InternalGetDependentNotifySymbols().begin() });
+            while (!walkStack.empty())
+            {
+                BaseSymbol *pSymbol = walkStack.back().first;
+                DependentIterator& itDependent = walkStack.back().second;
+
+                if (itDependent == pSymbol->InternalGetDependentNotifySymbols().end())
+                {
+                    postOrder.push_back(pSymbol->InternalGetId());
+                    walkStack.pop_back();
+                    continue;
+                }
+
+                ULONG64 dependentId = itDependent->first;
+                ++itDependent;
+
+                BaseSymbol *pDependentSymbol = InternalGetSymbol(dependentId);
+                if (pDependentSymbol != nullptr && visited.insert(dependentId).second)
+                {
+                    walkStack.push_back({ pDependentSymbol, pDependentSymbol->InternalGetDependentNotifySymbols().begin() });
+                }
+            }
+        }
+
+        //
+        // Now update each symbol exactly once in dependency order.
+        //
+        for (auto it = postOrder.rbegin(); it != postOrder.rend(); ++it)
+        {
+            BaseSymbol *pSymbol = InternalGetSymbol(*it);
+            if (pSymbol != nullptr)
+            {
+                HRESULT hrUpdate = pSymbol->UpdateForDependentChange();
+                if (SUCCEEDED(hr) && FAILED(hrUpdate))
+                {
+                    hr = hrUpdate;
+                }
+            }
+        }
+
+        return hr;
+    };
+    return ConvertException(fn);
+}
+
+HRESULT SymbolSet::GetScopeBoundVariable(_In_ ULONG64 variableId,
+                                         _In_ ULONG64 moduleOffset,
+                                         _COM_Outptr_ VariableSymbol **ppBoundVariable)
+{
+    auto fn = [&]()
+    {
+        HRESULT hr = S_OK;
+        *ppBoundVariable = nullptr;
+
+        std::pair<ULONG64, ULONG64> key { variableId, moduleOffset };
+        {
+            std::lock_guard<std::mutex> cacheLock(m_cacheLock);
+            ComPtr<VariableSymbol> *pCachedVariable = m_boundVariableCache.Find(key);
+            if (pCachedVariable != nullptr)
+            {
+                ComPtr<VariableSymbol> spBoundVariable = *pCachedVariable;
+                *ppBoundVariable = spBoundVariable.Detach();
+                return hr;
+            }
+        }
+
+        BaseSymbol *pSymbol = InternalGetSymbol(variableId);
+        if (pSymbol == nullptr ||
+            (pSymbol->InternalGetKind() != SvcSymbolDataParameter && pSymbol->InternalGetKind() != SvcSymbolDataLocal))
+        {
+            return E_INVALIDARG;
+        }
+
+        VariableSymbol *pVariable = static_cast<VariableSymbol *>(pSymbol);
+
+        ComPtr<ISvcSymbolSetScope> spScope;
+        IfFailedReturn(FindScopeByOffset(moduleOffset, &spScope));
 
-        if (pBaseSymbol->IsGlobal())
+        ComPtr<VariableSymbol> spBoundVariable;
+        IfFailedReturn(pVariable->BindToScope(static_cast<BaseScope *>(spScope.Get()), &spBoundVariable));
         {
-            m_globalSymbols.push_back(uniqueId);
-            if (!pBaseSymbol->InternalGetQualifiedName().empty())
+            std::lock_guard<std::mutex> cacheLock(m_cacheLock);
+            m_boundVariableCache.Insert(key, spBoundVariable);
+        }
+
+        *ppBoundVariable = spBoundVariable.Detach();
+        return hr;
+    };
+    return ConvertException(fn);
+}
+
+HRESULT SymbolSet::InvalidateExternalCaches()
+{
+    HRESULT hr = S_OK;
+
+    //
+    // Variables bound to a scope carry a copy of the variable's name, type, and live ranges.  Anything which
+    // calls for an invalidation may have changed those.
+    //
+    {
+        std::lock_guard<std::mutex> cacheLock(m_cacheLock);
+        m_boundVariableCache.Clear();
+    }
+    ++m_changeVersion;
+
+    //
+    // There are some circumstances where we *NEVER* want to send notifications upward.  If this is so, just
+    // ignore the invalidation.  It is either not needed or will happen later.
+    //
+    // If a batch is open, hold the invalidation.  A single one will be sent when the batch commits.
+    //
+    if (!m_cacheInvalidationDisabled && m_batchDepth > 0)
+    {
+        m_batchInvalidationPending = true;
+    }
+    else if (!m_cacheInvalidationDisabled)
+    {
+        IDebugServiceManager *pServiceManager = GetServiceManager();
+        if (pServiceManager == nullptr)
+        {
+            return E_UNEXPECTED;
+        }
+
+        ComPtr<SymbolCacheInvalidateArguments> spArgs;
+        IfFailedReturn(MakeAndInitialize<SymbolCacheInvalidateArguments>(&spArgs, m_spModule.Get(), this));
+
+        HRESULT hrEvent;
+        IfFailedReturn(pServiceManager->FireEventNotification(DEBUG_SVCEVENT_SYMBOLCACHEINVALIDATE, spArgs.Get(), &hrEvent));
+    }
+
+    //
+    // While we get a sink result if some handler decided to return a failure from their handling of the event, we
+    // are not going to propagate that upwards.  There's not really much we can do in this case.
+    //
+    return hr;
+}
+
+void SymbolSet::ImportForNameQuery(_In_ SvcSymbolKind searchKind, _In_opt_ PCWSTR pwszName)
+{
+    if (!HasImporter())
+    {
+        return;
+    }
+
+    //
+    // Failure to import should NOT trigger failure in the rest of the symbol builder!
+    //
+    (void)ConvertException([&](){
+        //
+        // Most queries are for something which has already been imported.  Check for that with the symbol set
+        // held shared so that such queries on different threads do not serialize on the exclusive lock.
+        //
+        {
+            SymbolSetSharedLock lock(m_lock);
+            if (m_spImporter->IsNameQueryImported(searchKind, pwszName))
             {
-                m_symbolNameMap.insert( { pBaseSymbol->InternalGetQualifiedName(), uniqueId });
+                return S_FALSE;
             }
         }
 
-        *pUniqueId = uniqueId;
+        SymbolSetForegroundImport foregroundImport(this);
+        SymbolSetExclusiveLock lock(m_lock);
+        return m_spImporter->ImportForNameQuery(searchKind, pwszName);
+    });
+}
 
-        // 
-        // Send an advisory notification upwards that everyone should flush caches.  Do not consider this
-        // a failure to create the symbol if something goes wrong.  At worst, an explicit .reload will be
-        // required in the debugger.
+void SymbolSet::ImportForOffsetQuery(_In_ SvcSymbolKind searchKind, _In_ ULONG64 moduleOffset)
+{
+    if (!HasImporter())
+    {
+        return;
+    }
+
+    //
+    // Failure to import should NOT trigger failure in the rest of the symbol builder!
+    //
+    (void)ConvertException([&](){
         //
-        (void)InvalidateExternalCaches();
+        // As with a name query, check whether there is anything to import without taking the symbol set
+        // exclusive first.
+        //
+        {
+            SymbolSetSharedLock lock(m_lock);
+            if (m_spImporter->IsOffsetQueryImported(searchKind, moduleOffset))
+            {
+                return S_FALSE;
+            }
+        }
 
-        return S_OK;
-    };
-    return ConvertException(fn);
+        SymbolSetForegroundImport foregroundImport(this);
+        SymbolSetExclusiveLock lock(m_lock);
+        return m_spImporter->ImportForOffsetQuery(searchKind, moduleOffset);
+    });
 }
 
-HRESULT SymbolSet::DeleteExistingSymbol(_In_ ULONG64 uniqueId)
+HRESULT SymbolSet::FlushPendingAddresses()
 {
+    HRESULT hr = S_OK;
+
     //
-    // We cannot let a C++ exception escape.
+    // Only a writer may change the indices.  A reader holding the symbol set shared never has anything to place:
+    // the writer which buffered the additions placed them before it gave up its exclusive hold.
     //
-    auto fn = [&]()
+    if (!m_lock.IsHeldExclusive())
     {
-        //
-        // As we hand out 'uniqueId' based on position within a vector, it should always fit within the
-        // bounds of a size_t.  
-        //
-        if (uniqueId > std::numeric_limits<size_t>::max())
+        return hr;
+    }
+
+    IfFailedReturn(m_symbolRanges.FlushPendingRanges());
+    IfFailedReturn(m_publicAddresses.FlushPendingSymbols());
+    return hr;
+}
+
+HRESULT TypeExpression::Parse(_In_ std::wstring const& typeName, _Out_ TypeExpression *pExpression)
+{
+    pExpression->BaseName.clear();
+    pExpression->Declarators.clear();
+
+    //
+    // Declarators are peeled off the end of the name one at a time.  Whatever remains is the name of the base
+    // type.
+    //
+    size_t end = typeName.size();
+    auto skipSpace = [&]()
+    {
+        while (end > 0 && iswspace(typeName[end - 1])) { --end; }
+    };
+
+    skipSpace();
+    for(;;)
+    {
+        if (end == 0)
         {
             return E_INVALIDARG;
         }
 
-        BaseSymbol *pSymbol = InternalGetSymbol(uniqueId);
-        if (pSymbol != nullptr)
+        Declarator declarator { };
+        wchar_t c = typeName[end - 1];
+
+        if (c == L'*' || c == L'&' || c == L'^')
         {
-            if (pSymbol->IsGlobal())
+            --end;
+            declarator.Kind = SvcSymbolTypePointer;
+            declarator.PointerKind = SvcSymbolPointerStandard;
+            if (c == L'&')
             {
-                for (auto itg = m_globalSymbols.begin(); itg != m_globalSymbols.end(); ++itg)
+                if (end > 1 && typeName[end - 1] == L'&')
                 {
-                    if (*itg == uniqueId)
-                    {
-                        m_globalSymbols.erase(itg);
-                        break;
-                    }
+                    --end;
+                    declarator.PointerKind = SvcSymbolPointerRValueReference;
                 }
-
-                if (!pSymbol->InternalGetQualifiedName().empty())
+                else
                 {
-                    auto itn = m_symbolNameMap.find(pSymbol->InternalGetQualifiedName());
-                    if (itn != m_symbolNameMap.end())
-                    {
-                        m_symbolNameMap.erase(itn);
-                    }
+                    declarator.PointerKind = SvcSymbolPointerReference;
                 }
             }
+            else if (c == L'^')
+            {
+                declarator.PointerKind = SvcSymbolPointerCXHat;
+            }
+        }
+        else if (c == L']')
+        {
+            size_t close = end - 1;
+            size_t open = typeName.rfind(L'[', close);
+            if (open == std::wstring::npos)
+            {
+                return E_INVALIDARG;
+            }
 
-            m_symbols[static_cast<size_t>(uniqueId)] = nullptr;
+            ULONG64 dim = 0;
+            for (size_t i = open + 1; i < close; ++i)
+            {
+                if (typeName[i] >= L'0' && typeName[i] <= L'9')
+                {
+                    dim = (dim * 10) + (typeName[i] - L'0');
+                }
+                else
+                {
+                    return E_INVALIDARG;
+                }
+            }
 
-            //
-            // Send an advisory notification upwards that everyone should flush caches.  Do not consider this
-            // a failure to delete the symbol if something goes wrong.  At worst, an explicit .reload will be
-            // required by the debugger.
-            //
-            (void)InvalidateExternalCaches();
+            end = open;
+            declarator.Kind = SvcSymbolTypeArray;
+            declarator.ArrayDim = dim;
+        }
+        else
+        {
+            break;
         }
 
-        return S_OK;
-    };
-    return ConvertException(fn);
+        pExpression->Declarators.push_back(declarator);
+        skipSpace();
+    }
+
+    pExpression->BaseName.assign(typeName, 0, end);
+    std::reverse(pExpression->Declarators.begin(), pExpression->Declarators.end());
+    return S_OK;
 }
 
-HRESULT SymbolSet::GetSymbolById(_In_ ULONG64 symbolId,
-                                 _COM_Outptr_ ISvcSymbol **ppSymbol)
+void TypeExpression::AppendDeclarator(_Inout_ std::wstring& typeName, _In_ Declarator const& declarator)
 {
-    HRESULT hr = S_OK;
-
-    bool isScopeBoundVariable = (symbolId & ScopeBoundIdFlag) != 0;
-    std::pair<ULONG64, ULONG64> scopeBinding;
-    if (isScopeBoundVariable)
+    if (declarator.Kind == SvcSymbolTypePointer)
     {
-        symbolId &= ~ScopeBoundIdFlag;
-        if (symbolId >= m_scopeBindings.size())
-        {
-            return E_INVALIDARG;
-        }
-
-        scopeBinding = m_scopeBindings[static_cast<size_t>(symbolId)];
-        symbolId = scopeBinding.first;
+        PointerTypeSymbol::AppendPtrChar(typeName, declarator.PointerKind);
+    }
+    else
+    {
+        wchar_t arBuf[64];
+        swprintf_s(arBuf, ARRAYSIZE(arBuf), L"[%I64d]", declarator.ArrayDim);
+        typeName += arBuf;
     }
+}
 
-    *ppSymbol = nullptr;
-    if (symbolId >= m_symbols.size())
+std::wstring TypeExpression::GetNormalizedName() const
+{
+    std::wstring normalizedName = BaseName;
+    for (auto&& declarator : Declarators)
     {
-        return E_INVALIDARG;
+        AppendDeclarator(normalizedName, declarator);
     }
+    return normalizedName;
+}
 
-    ISvcSymbol *pSymbol = m_symbols[static_cast<size_t>(symbolId)].Get();
-    if (pSymbol == nullptr)
+HRESULT SymbolSet::GetTypeForLookup(_In_ ULONG64 typeId, 
+                                    _Out_ ULONG64 *pTypeId, 
+                                    _Outptr_opt_ BaseTypeSymbol **ppTypeSymbol)
+{
+    BaseSymbol *pSymbol = InternalGetSymbol(typeId);
+    if (pSymbol == nullptr || pSymbol->InternalGetKind() != SvcSymbolType)
     {
         return E_INVALIDARG;
     }
 
-    if (isScopeBoundVariable)
+    *pTypeId = typeId;
+
+    if (ppTypeSymbol != nullptr)
     {
-        VariableSymbol *pVariable = static_cast<VariableSymbol *>(pSymbol);
+        *ppTypeSymbol = static_cast<BaseTypeSymbol *>(pSymbol);
+    }
+
+    return S_OK;
+}
 
-        Microsoft::WRL::ComPtr<ISvcSymbolSetScope> spScope;
-        IfFailedReturn(FindScopeByOffset(scopeBinding.second, &spScope));
+ULONG64 SymbolSet::FindMemoizedTypeExpression(_In_ std::wstring const& expression)
+{
+    std::lock_guard<std::mutex> cacheLock(m_cacheLock);
+    auto it = m_typeExpressionCache.find(expression);
+    return (it == m_typeExpressionCache.end() ? 0 : it->second);
+}
 
-        BaseScope *pScope = static_cast<BaseScope *>(spScope.Get());
+void SymbolSet::MemoizeTypeExpression(_In_ std::wstring const& expression, _In_ ULONG64 typeId)
+{
+    std::lock_guard<std::mutex> cacheLock(m_cacheLock);
+    m_typeExpressionCache[expression] = typeId;
+}
 
-        Microsoft::WRL::ComPtr<VariableSymbol> spBoundVariable;
-        IfFailedReturn(pVariable->BindToScope(pScope, &spBoundVariable));
+void SymbolSet::InvalidateTypeExpressionCaches()
+{
+    std::lock_guard<std::mutex> cacheLock(m_cacheLock);
+    m_typeExpressionCache.clear();
+    m_derivedTypeCache.clear();
+}
 
-        Microsoft::WRL::ComPtr<ISvcSymbol> spSymbol = spBoundVariable;
-        *ppSymbol = spSymbol.Detach();
+void SymbolSet::RecordDerivedType(_In_ ULONG64 baseTypeId,
+                                  _In_ TypeExpression::Declarator const& declarator,
+                                  _In_ ULONG64 derivedTypeId)
+{
+    std::lock_guard<std::mutex> cacheLock(m_cacheLock);
+    m_derivedTypeCache[GetDerivedTypeKey(baseTypeId, declarator)] = derivedTypeId;
+}
+
+ULONG64 SymbolSet::FindDerivedType(_In_ ULONG64 baseTypeId,
+                                   _In_ TypeExpression::Declarator const& declarator,
+                                   _In_ std::wstring const& derivedName)
+{
+    {
+        auto key = GetDerivedTypeKey(baseTypeId, declarator);
+        std::lock_guard<std::mutex> cacheLock(m_cacheLock);
+        auto it = m_derivedTypeCache.find(key);
+        if (it != m_derivedTypeCache.end())
+        {
+            return it->second;
+        }
     }
-    else
+
+    //
+    // The type may have been created before the cache saw it (e.g.: explicitly or by an import).  Such a type
+    // goes by the same name a demand created one would.  It only counts if it really is the derived type asked
+    // for.
+    //
+    ULONG64 derivedId = InternalGetSymbolIdByName(derivedName);
+    BaseSymbol *pSymbol = InternalGetSymbol(derivedId);
+    if (pSymbol == nullptr || pSymbol->InternalGetKind() != SvcSymbolType)
     {
-        Microsoft::WRL::ComPtr<ISvcSymbol> spSymbol = pSymbol;
-        *ppSymbol = spSymbol.Detach();
+        return 0;
     }
-    return S_OK;
-}
 
-HRESULT SymbolSet::EnumerateAllSymbols(_COM_Outptr_ ISvcSymbolSetEnumerator **ppEnumerator)
-{
-    HRESULT hr = S_OK;
-    *ppEnumerator = nullptr;
+    BaseTypeSymbol *pType = static_cast<BaseTypeSymbol *>(pSymbol);
+    if (pType->InternalGetTypeKind() != declarator.Kind)
+    {
+        return 0;
+    }
 
-    ComPtr<GlobalEnumerator> spEnum;
-    IfFailedReturn(MakeAndInitialize<GlobalEnumerator>(&spEnum, this));
+    if (declarator.Kind == SvcSymbolTypePointer)
+    {
+        PointerTypeSymbol *pPointerType = static_cast<PointerTypeSymbol *>(pType);
+        if (pPointerType->InternalGetPointerToTypeId() != baseTypeId ||
+            pPointerType->InternalGetPointerKind() != declarator.PointerKind)
+        {
+            return 0;
+        }
+    }
+    else
+    {
+        ArrayTypeSymbol *pArrayType = static_cast<ArrayTypeSymbol *>(pType);
+        if (pArrayType->InternalGetArrayOfTypeId() != baseTypeId ||
+            pArrayType->InternalGetArraySize() != declarator.ArrayDim)
+        {
+            return 0;
+        }
+    }
 
-    *ppEnumerator = spEnum.Detach();
-    return hr;
+    RecordDerivedType(baseTypeId, declarator, derivedId);
+    return derivedId;
 }
 
-HRESULT SymbolSet::InvalidateExternalCaches()
+HRESULT SymbolSet::ResolveTypeExpression(_In_ TypeExpression const& expression, _Out_ ULONG64 *pTypeId)
 {
     HRESULT hr = S_OK;
+    *pTypeId = 0;
 
-    //
-    // There are some circumstances where we *NEVER* want to send notifications upward.  If this is so, just
-    // ignore the invalidation.  It is either not needed or will happen later.
-    //
-    if (!m_cacheInvalidationDisabled)
+    ULONG64 typeId = FindMemoizedTypeExpression(expression.BaseName);
+    if (typeId == 0)
     {
-        IDebugServiceManager *pServiceManager = GetServiceManager();
-        if (pServiceManager == nullptr)
+        ImportForNameQuery(SvcSymbolType, expression.BaseName.c_str());
+        typeId = InternalGetSymbolIdByName(expression.BaseName);
+    }
+
+    BaseSymbol *pSymbol = InternalGetSymbol(typeId);
+    if (pSymbol == nullptr || pSymbol->InternalGetKind() != SvcSymbolType)
+    {
+        return E_INVALIDARG;
+    }
+
+    for (auto&& declarator : expression.Declarators)
+    {
+        BaseTypeSymbol *pBaseType = static_cast<BaseTypeSymbol *>(InternalGetSymbol(typeId));
+
+        if (declarator.Kind == SvcSymbolTypePointer)
         {
-            return E_UNEXPECTED;
+            if (!m_demandCreatePointerTypes)
+            {
+                return E_FAIL;
+            }
+
+            //
+            // Declarators apply left to right, so "int [5] *" would otherwise be "pointer-to-array(5)-of-int"
+            // rather than the C++ int (*)[5].  Rather than have a real type name parser, reject such pointed-to
+            // types.
+            //
+            switch(pBaseType->InternalGetTypeKind())
+            {
+                case SvcSymbolTypeFunction:
+                case SvcSymbolTypeArray:
+                    return E_INVALIDARG;
+
+                default:
+                    break;
+            }
+        }
+        else if (!m_demandCreateArrayTypes)
+        {
+            return E_FAIL;
         }
 
-        ComPtr<SymbolCacheInvalidateArguments> spArgs;
-        IfFailedReturn(MakeAndInitialize<SymbolCacheInvalidateArguments>(&spArgs, m_spModule.Get(), this));
+        std::wstring derivedName = pBaseType->InternalGetQualifiedName();
+        TypeExpression::AppendDeclarator(derivedName, declarator);
+
+        ULONG64 derivedId = FindDerivedType(typeId, declarator, derivedName);
+        if (derivedId == 0)
+        {
+            if (declarator.Kind == SvcSymbolTypePointer)
+            {
+                ComPtr<PointerTypeSymbol> spPointerType;
+                IfFailedReturn(MakeAndInitialize<PointerTypeSymbol>(&spPointerType, 
+                                                                    this, 
+                                                                    typeId, 
+                                                                    declarator.PointerKind));
+                derivedId = spPointerType->InternalGetId();
+            }
+            else
+            {
+                ComPtr<ArrayTypeSymbol> spArrayType;
+                IfFailedReturn(MakeAndInitialize<ArrayTypeSymbol>(&spArrayType, this, typeId, declarator.ArrayDim));
+                derivedId = spArrayType->InternalGetId();
+            }
+
+            //
+            // NOTE: The id is safe to be used past the ComPtr destruction above because creation of the symbol
+            //       will add it to our internal management lists...  and nothing could possibly have deleted
+            //       it before returning from this method!
+            //
+            RecordDerivedType(typeId, declarator, derivedId);
+        }
 
-        HRESULT hrEvent;
-        IfFailedReturn(pServiceManager->FireEventNotification(DEBUG_SVCEVENT_SYMBOLCACHEINVALIDATE, spArgs.Get(), &hrEvent));
+        typeId = derivedId;
     }
 
-    //
-    // While we get a sink result if some handler decided to return a failure from their handling of the event, we
-    // are not going to propagate that upwards.  There's not really much we can do in this case.
-    //
+    *pTypeId = typeId;
     return hr;
 }
 
@@ -674,213 +1858,64 @@ HRESULT SymbolSet::FindTypeByName(_In_ std::wstring const& typeName,
         *ppTypeSymbol = nullptr;
     }
 
-    //
-    // If we have an underlying importer, give it a shot at pulling in symbols that are relevant for
-    // the name in question.  It may immediately turn around and say "I've already done this" but
-    // such is the price for an on demand import like this.
-    //
-    if (HasImporter() && allowAutoCreations)
-    {
-        //
-        // Failure to import should NOT trigger failure in the rest of the symbol builder!
-        //
-        (void)m_spImporter->ImportForNameQuery(SvcSymbolType, typeName.c_str());
-    }
-
     //
     // We cannot let a C++ exception escape.
     //
     auto fn = [&]()
     {
-        ULONG64 symId = InternalGetSymbolIdByName(typeName);
-        BaseSymbol *pSymbol = nullptr;
-        if (symId != 0)
-        {
-            pSymbol = InternalGetSymbol(symId);
-            if (pSymbol == nullptr || pSymbol->InternalGetKind() != SvcSymbolType)
-            {
-                return E_INVALIDARG;
-            }
-
-            *pTypeId = symId;
-
-            if (ppTypeSymbol != nullptr)
-            {
-                *ppTypeSymbol = static_cast<BaseTypeSymbol *>(pSymbol);
-            }
-
-            return hr;
-        }
-        else if (!allowAutoCreations)
+        if (!allowAutoCreations)
         {
-            return E_INVALIDARG;
+            SymbolSetSharedLock lock(m_lock);
+            return GetTypeForLookup(InternalGetSymbolIdByName(typeName), pTypeId, ppTypeSymbol);
         }
 
         //
-        // Is this a pointer type or something similar which we will allow "on demand" creation of according
-        // to standard C like semantics.
+        // Anything asked for before resolves the same way until a type is deleted or renamed.  There is no need
+        // to go back to the importer or parse it again.
         //
-        wchar_t const *pStart = typeName.c_str();
-        wchar_t const *pc = (pStart + wcslen(pStart) - 1);
-
-        switch(*pc)
         {
-            case L'*':
-            case L'&':
-            case L'^':
+            SymbolSetSharedLock lock(m_lock);
+            ULONG64 memoizedId = FindMemoizedTypeExpression(typeName);
+            if (memoizedId != 0)
             {
-                if (!m_demandCreatePointerTypes)
-                {
-                    return E_FAIL;
-                }
-
-                SvcSymbolPointerKind pointerKind = SvcSymbolPointerStandard;
-                if (*pc == L'&')
-                {
-                    if (*(pc - 1) == L'&' && (pc - 1) != pStart)
-                    {
-                        --pc;
-                        pointerKind = SvcSymbolPointerRValueReference;
-                    }
-                    else
-                    {
-                        pointerKind = SvcSymbolPointerReference;
-                    }
-                }
-                else if (*pc == L'^')
-                {
-                    pointerKind = SvcSymbolPointerCXHat;
-                }
-
-                wchar_t const *pPrior = (pc - 1);
-                while (pPrior > pStart && iswspace(*pPrior)) { --pPrior; }
-
-                if (pPrior == pStart)
-                {
-                    return E_INVALIDARG;
-                }
-
-                std::wstring baseName(pStart, pPrior - pStart + 1);
-
-                //
-                // NOTE: This is *NOT* a C++ "type name" parser.  We simply recurse to the base type.
-                //       This does mean that you can ask for "void **" and get it.  It also means that
-                //       without further intervention, you would be able to ask for "int [5] *" to get 
-                //       "pointer-to-array(5)-of-int" rather than asking for int (*)[5].
-                //
-                //       In order to avoid this nonsense without further complexity of a real type name
-                //       parser, we reject certain "pointed-to" types.
-                //
-
-                ULONG64 pointedToId = 0;
-                BaseTypeSymbol *pPointedToType = nullptr;
-                IfFailedReturn(FindTypeByName(baseName, &pointedToId, &pPointedToType, true));
-
-                switch(pPointedToType->InternalGetTypeKind())
-                {
-                    case SvcSymbolTypeFunction:
-                    case SvcSymbolTypeArray:
-                        //
-                        // In order to have gotten this, we saw something like "int [5] *" which is not valid
-                        // C-ish syntax.
-                        //
-                        return E_INVALIDARG;
-
-                    default:
-                        break;
-                }
-
-                ComPtr<PointerTypeSymbol> spPointerType;
-                IfFailedReturn(MakeAndInitialize<PointerTypeSymbol>(&spPointerType, this, pointedToId, pointerKind));
-
-                symId = spPointerType->InternalGetId();
-
-                //
-                // NOTE: This is safe to be held past the ComPtr destruction above because creation of the symbol
-                //       will add it to our internal management lists...  and nothing could possibly have deleted
-                //       it before returning from this method!
-                //
-                pSymbol = spPointerType.Get();
-
-                break;
+                return GetTypeForLookup(memoizedId, pTypeId, ppTypeSymbol);
             }
+        }
 
-            case L']':
-            {
-                if (!m_demandCreateArrayTypes)
-                {
-                    return E_FAIL;
-                }
-
-                wchar_t const *pb = pc - 1;
-                while (pb > pStart && *pb != L'[')
-                {
-                    --pb;
-                }
-
-                if (pb == pStart)
-                {
-                    return E_INVALIDARG;
-                }
-
-                ULONG64 dim = 0;
-                wchar_t const *pDig = pb + 1;
-                while (*pDig != L']')
-                {
-                    if (*pDig >= L'0' && *pDig <= L'9')
-                    {
-                        dim = (dim * 10) + (*pDig - L'0');
-                    }
-                    else
-                    {
-                        return E_INVALIDARG;
-                    }
-                    ++pDig;
-                }
-
-                pb--;
-                while (pb > pStart && iswspace(*pb)) { --pb; }
-
-                if (pb == pStart)
-                {
-                    return E_INVALIDARG;
-                }
-
-                std::wstring baseName(pStart, pb - pStart + 1);
-
-                ULONG64 arrayOfId = 0;
-                IfFailedReturn(FindTypeByName(baseName, &arrayOfId, nullptr));
-
-                ComPtr<ArrayTypeSymbol> spArrayType;
-                IfFailedReturn(MakeAndInitialize<ArrayTypeSymbol>(&spArrayType, this, arrayOfId, dim));
-
-                symId = spArrayType->InternalGetId();
-
-                //
-                // NOTE: This is safe to be held past the ComPtr destruction above because creation of the symbol
-                //       will add it to our internal management lists...  and nothing could possibly have deleted
-                //       it before returning from this method!
-                //
-                pSymbol = spArrayType.Get();
-                break;
-            }
+        //
+        // If we have an underlying importer, give it a shot at pulling in symbols that are relevant for
+        // the name in question.  It may immediately turn around and say "I've already done this" but
+        // such is the price for an on demand import like this.
+        //
+        ImportForNameQuery(SvcSymbolType, typeName.c_str());
 
-            default:
-                break;
-        }
+        //
+        // Resolving the name may create types.  Hold the symbol set exclusive from here on.
+        //
+        SymbolSetExclusiveLock lock(m_lock);
 
+        ULONG64 symId = InternalGetSymbolIdByName(typeName);
         if (symId == 0)
         {
-            return E_INVALIDARG;
-        }
-
-        *pTypeId = symId;
+            //
+            // Is this a pointer type or something similar which we will allow "on demand" creation of according
+            // to standard C like semantics.  Different spellings of the same thing (e.g.: "Foo*" and "Foo *")
+            // share the one derived type.
+            //
+            TypeExpression expression;
+            IfFailedReturn(TypeExpression::Parse(typeName, &expression));
 
-        if (ppTypeSymbol != nullptr)
-        {
-            *ppTypeSymbol = static_cast<BaseTypeSymbol *>(pSymbol);
+            std::wstring normalizedName = expression.GetNormalizedName();
+            symId = FindMemoizedTypeExpression(normalizedName);
+            if (symId == 0)
+            {
+                IfFailedReturn(ResolveTypeExpression(expression, &symId));
+                MemoizeTypeExpression(normalizedName, symId);
+            }
         }
 
+        IfFailedReturn(GetTypeForLookup(symId, pTypeId, ppTypeSymbol));
+        MemoizeTypeExpression(typeName, symId);
         return hr;
     };
     return ConvertException(fn);
@@ -895,19 +1930,15 @@ HRESULT SymbolSet::FindSymbolByName(_In_ PCWSTR symbolName, _COM_Outptr_ ISvcSym
     // the name in question.  It may immediately turn around and say "I've already done this" but
     // such is the price for an on demand import like this.
     //
-    if (HasImporter())
-    {
-        //
-        // Failure to import should NOT trigger failure in the rest of the symbol builder!
-        //
-        (void)m_spImporter->ImportForNameQuery(SvcSymbol, symbolName);
-    }
+    ImportForNameQuery(SvcSymbol, symbolName);
 
     //
     // We cannot let a C++ exception escape.
     //
     auto fn = [&]()
     {
+        SymbolSetSharedLock lock(m_lock);
+
         std::wstring name = symbolName;
         auto it = m_symbolNameMap.find(name);
         if (it == m_symbolNameMap.end())
@@ -933,7 +1964,6 @@ HRESULT SymbolSet::FindSymbolByOffset(_In_ ULONG64 moduleOffset,
                                       _COM_Outptr_ ISvcSymbol **ppSymbol,
                                       _Out_ ULONG64 *pSymbolOffset)
 {
-    HRESULT hr = S_OK;
     *ppSymbol = nullptr;
 
     //
@@ -941,49 +1971,54 @@ HRESULT SymbolSet::FindSymbolByOffset(_In_ ULONG64 moduleOffset,
     // the address in question.  It may immediately turn around and say "I've already done this" but
     // such is the price for an on demand import like this.
     //
-    if (HasImporter())
+    ImportForOffsetQuery(SvcSymbol, moduleOffset);
+
+    //
+    // We cannot let a C++ exception escape.
+    //
+    auto fn = [&]()
     {
-        //
-        // Failure to import should NOT trigger failure in the rest of the symbol builder!
-        //
-        (void)m_spImporter->ImportForOffsetQuery(SvcSymbol, moduleOffset);
-    }
+        HRESULT hr = S_OK;
+        SymbolSetSharedLock lock(m_lock);
+        IfFailedReturn(FlushPendingAddresses());
 
-    BaseSymbol *pSymbol = nullptr;
+        BaseSymbol *pSymbol = nullptr;
 
-    SymbolRangeList::SymbolList const* pSymbols;
-    if (!m_symbolRanges.FindSymbols(moduleOffset, &pSymbols) || pSymbols->size() == 0)
-    {
-        //
-        // Is there a public symbol which happens to be "closest" to this address...?
-        //
-        PublicList::SymbolList const* pPublics;
-        if (!m_publicAddresses.FindNearestSymbols(moduleOffset, &pPublics) || pPublics->size() == 0)
+        SymbolRangeList::SymbolList const* pSymbols;
+        if (!m_symbolRanges.FindSymbols(moduleOffset, &pSymbols) || pSymbols->size() == 0)
         {
-            return E_BOUNDS;
-        }
+            //
+            // Is there a public symbol which happens to be "closest" to this address...?
+            //
+            PublicList::SymbolList const* pPublics;
+            if (!m_publicAddresses.FindNearestSymbols(moduleOffset, &pPublics) || pPublics->size() == 0)
+            {
+                return E_BOUNDS;
+            }
 
-        pSymbol = InternalGetSymbol((*pPublics)[0]);
-    }
-    else
-    {
-        pSymbol = InternalGetSymbol((*pSymbols)[0]);
-    }
+            pSymbol = InternalGetSymbol((*pPublics)[0]);
+        }
+        else
+        {
+            pSymbol = InternalGetSymbol((*pSymbols)[0]);
+        }
 
 
-    ULONG64 symbolOffset;
-    IfFailedReturn(pSymbol->GetOffset(&symbolOffset));
+        ULONG64 symbolOffset;
+        IfFailedReturn(pSymbol->GetOffset(&symbolOffset));
 
-    if (exactMatchOnly && symbolOffset != moduleOffset)
-    {
-        return E_BOUNDS;
-    }
+        if (exactMatchOnly && symbolOffset != moduleOffset)
+        {
+            return E_BOUNDS;
+        }
 
-    ComPtr<ISvcSymbol> spSymbol = pSymbol;
+        ComPtr<ISvcSymbol> spSymbol = pSymbol;
 
-    *pSymbolOffset = (moduleOffset - symbolOffset);
-    *ppSymbol = spSymbol.Detach();
-    return S_OK;
+        *pSymbolOffset = (moduleOffset - symbolOffset);
+        *ppSymbol = spSymbol.Detach();
+        return S_OK;
+    };
+    return ConvertException(fn);
 }
 
 HRESULT SymbolSet::GetGlobalScope(_COM_Outptr_ ISvcSymbolSetScope **ppScope)
@@ -1001,90 +2036,130 @@ HRESULT SymbolSet::GetGlobalScope(_COM_Outptr_ ISvcSymbolSetScope **ppScope)
 HRESULT SymbolSet::FindScopeByOffset(_In_ ULONG64 moduleOffset,
                                      _COM_Outptr_ ISvcSymbolSetScope **ppScope)
 {
-    HRESULT hr = S_OK;
     *ppScope = nullptr;
 
-    SymbolRangeList::SymbolList const* pSymbols;
-    if (!m_symbolRanges.FindSymbols(moduleOffset, &pSymbols) || pSymbols->size() == 0)
+    //
+    // We cannot let a C++ exception escape.
+    //
+    auto fn = [&]()
     {
-        return E_BOUNDS;
-    }
+        HRESULT hr = S_OK;
+        SymbolSetSharedLock lock(m_lock);
+        IfFailedReturn(FlushPendingAddresses());
 
-    for (size_t i = 0; i < pSymbols->size(); ++i)
-    {
-        BaseSymbol *pSymbol = InternalGetSymbol((*pSymbols)[i]);
-        if (pSymbol->InternalGetKind() == SvcSymbolFunction)
+        SymbolRangeList::SymbolList const* pSymbols;
+        if (!m_symbolRanges.FindSymbols(moduleOffset, &pSymbols) || pSymbols->size() == 0)
+        {
+            return E_BOUNDS;
+        }
+
+        for (size_t i = 0; i < pSymbols->size(); ++i)
         {
-            FunctionSymbol *pFunction = static_cast<FunctionSymbol *>(pSymbol);
+            BaseSymbol *pSymbol = InternalGetSymbol((*pSymbols)[i]);
+            if (pSymbol->InternalGetKind() == SvcSymbolFunction)
+            {
+                FunctionSymbol *pFunction = static_cast<FunctionSymbol *>(pSymbol);
+
+                ULONG64 functionOffset;
+                IfFailedReturn(pFunction->GetOffset(&functionOffset));
 
-            ULONG64 functionOffset;
-            IfFailedReturn(pFunction->GetOffset(&functionOffset));
+                ULONG64 srelOffset = moduleOffset - functionOffset;
 
-            ULONG64 srelOffset = moduleOffset - functionOffset;
+                //
+                // A scope is immutable (what is live where is asked of the function each time) and so one scope
+                // serves every query at the same place in the same function.
+                //
+                std::pair<ULONG64, ULONG64> key { pFunction->InternalGetId(), srelOffset };
+                {
+                    std::lock_guard<std::mutex> cacheLock(m_cacheLock);
+                    ComPtr<ISvcSymbolSetScope> *pCachedScope = m_scopeCache.Find(key);
+                    if (pCachedScope != nullptr)
+                    {
+                        ComPtr<ISvcSymbolSetScope> spScope = *pCachedScope;
+                        *ppScope = spScope.Detach();
+                        return hr;
+                    }
+                }
 
-            ComPtr<Scope> spScope;
-            IfFailedReturn(MakeAndInitialize<Scope>(&spScope, this, pFunction, srelOffset));
+                ComPtr<Scope> spScope;
+                IfFailedReturn(MakeAndInitialize<Scope>(&spScope, this, pFunction, srelOffset, true));
+                {
+                    std::lock_guard<std::mutex> cacheLock(m_cacheLock);
+                    m_scopeCache.Insert(key, spScope);
+                }
 
-            *ppScope = spScope.Detach();
-            return S_OK;
+                *ppScope = spScope.Detach();
+                return hr;
+            }
         }
-    }
 
-    return E_FAIL;
+        return E_FAIL;
+    };
+    return ConvertException(fn);
 }
 
 HRESULT SymbolSet::FindScopeFrame(_In_ ISvcProcess *pProcess,
                                   _In_ ISvcRegisterContext *pRegisterContext,
                                   _COM_Outptr_ ISvcSymbolSetScopeFrame **ppScopeFrame)
 {
-    HRESULT hr = S_OK;
     *ppScopeFrame = nullptr;
 
     //
-    // We must find the scope from @pc.  We must fetch the register and convert it back to a
-    // module relative offset that everything else here is based upon.
+    // We cannot let a C++ exception escape.
     //
-    ULONG64 pc;
-    IfFailedReturn(pRegisterContext->GetAbstractRegisterValue64(SvcAbstractRegisterInstructionPointer,
-                                                                &pc));
+    auto fn = [&]()
+    {
+        HRESULT hr = S_OK;
+        SymbolSetSharedLock lock(m_lock);
+        IfFailedReturn(FlushPendingAddresses());
 
-    ULONG64 moduleBase;
-    IfFailedReturn(m_spModule->GetBaseAddress(&moduleBase));
+        //
+        // We must find the scope from @pc.  We must fetch the register and convert it back to a
+        // module relative offset that everything else here is based upon.
+        //
+        ULONG64 pc;
+        IfFailedReturn(pRegisterContext->GetAbstractRegisterValue64(SvcAbstractRegisterInstructionPointer,
+                                                                    &pc));
 
-    ULONG64 modRelPc = pc - moduleBase;
+        ULONG64 moduleBase;
+        IfFailedReturn(m_spModule->GetBaseAddress(&moduleBase));
 
-    SymbolRangeList::SymbolList const* pSymbols;
-    if (!m_symbolRanges.FindSymbols(modRelPc, &pSymbols) || pSymbols->size() == 0)
-    {
-        return E_BOUNDS;
-    }
+        ULONG64 modRelPc = pc - moduleBase;
 
-    for (size_t i = 0; i < pSymbols->size(); ++i)
-    {
-        BaseSymbol *pSymbol = InternalGetSymbol((*pSymbols)[i]);
-        if (pSymbol->InternalGetKind() == SvcSymbolFunction)
+        SymbolRangeList::SymbolList const* pSymbols;
+        if (!m_symbolRanges.FindSymbols(modRelPc, &pSymbols) || pSymbols->size() == 0)
+        {
+            return E_BOUNDS;
+        }
+
+        for (size_t i = 0; i < pSymbols->size(); ++i)
         {
-            FunctionSymbol *pFunction = static_cast<FunctionSymbol *>(pSymbol);
+            BaseSymbol *pSymbol = InternalGetSymbol((*pSymbols)[i]);
+            if (pSymbol->InternalGetKind() == SvcSymbolFunction)
+            {
+                FunctionSymbol *pFunction = static_cast<FunctionSymbol *>(pSymbol);
 
-            ULONG64 functionOffset;
-            IfFailedReturn(pFunction->GetOffset(&functionOffset));
+                ULONG64 functionOffset;
+                IfFailedReturn(pFunction->GetOffset(&functionOffset));
 
-            ULONG64 srelOffset = modRelPc - functionOffset;
+                ULONG64 srelOffset = modRelPc - functionOffset;
 
-            ComPtr<ScopeFrame> spScopeFrame;
-            IfFailedReturn(MakeAndInitialize<ScopeFrame>(&spScopeFrame, 
-                                                         this, 
-                                                         pFunction, 
-                                                         srelOffset,
-                                                         pProcess,
-                                                         pRegisterContext));
+                ComPtr<ScopeFrame> spScopeFrame;
+                IfFailedReturn(MakeAndInitialize<ScopeFrame>(&spScopeFrame, 
+                                                             this, 
+                                                             pFunction, 
+                                                             srelOffset,
+                                                             pProcess,
+                                                             pRegisterContext));
 
-            *ppScopeFrame = spScopeFrame.Detach();
-            return S_OK;
+                *ppScopeFrame = spScopeFrame.Detach();
+                return S_OK;
+            }
         }
-    }
 
-    return E_FAIL;
+        return E_FAIL;
+    };
+    return ConvertException(fn);
 }
 
 //*************************************************
@@ -1093,54 +2168,77 @@ HRESULT SymbolSet::FindScopeFrame(_In_ ISvcProcess *pProcess,
 
 HRESULT ScopeEnumerator::GetNext(_COM_Outptr_ ISvcSymbol **ppSymbol)
 {
-    HRESULT hr = S_OK;
     *ppSymbol = nullptr;
 
-    BaseScope *pScope = static_cast<BaseScope *>(m_spScope.Get());
+    //
+    // We cannot let a C++ exception escape.
+    //
+    auto fn = [&]()
+    {
+        HRESULT hr = S_OK;
+        SymbolSetSharedLock lock(InternalGetSymbolSet()->GetLock());
+        IfFailedReturn(InternalGetSymbolSet()->FlushPendingAddresses());
 
-    FunctionSymbol *pFunction = pScope->InternalGetFunction();
-    auto&& functionChildren = pFunction->InternalGetChildren();
+        BaseScope *pScope = static_cast<BaseScope *>(m_spScope.Get());
 
-    for(;;)
-    {
-        if (m_pos >= functionChildren.size())
+        FunctionSymbol *pFunction = pScope->InternalGetFunction();
+        auto&& functionChildren = pFunction->InternalGetChildren();
+
+        for(;;)
         {
-            break;
-        }
+            if (m_pos >= functionChildren.size())
+            {
+                break;
+            }
 
-        ULONG64 childId = functionChildren[m_pos];
-        ++m_pos;
+            ULONG64 childId = functionChildren[m_pos];
+            ++m_pos;
 
-        BaseSymbol *pChildSymbol = InternalGetSymbolSet()->InternalGetSymbol(childId);
-        if (pChildSymbol == nullptr || !SymbolMatchesSearchCriteria(pChildSymbol))
-        {
-            continue;
-        }
+            BaseSymbol *pChildSymbol = InternalGetSymbolSet()->InternalGetSymbol(childId);
+            if (pChildSymbol == nullptr || !SymbolMatchesSearchCriteria(pChildSymbol))
+            {
+                continue;
+            }
 
-        //
-        // If the symbol is a variable, we need to bind it to the scope so that its
-        // location fetch can return useful information.
-        //
-        if (pChildSymbol->InternalGetKind() == SvcSymbolDataParameter ||
-            pChildSymbol->InternalGetKind() == SvcSymbolDataLocal)
-        {
-            VariableSymbol *pChildVariable = static_cast<VariableSymbol *>(pChildSymbol);
+            //
+            // If the symbol is a variable, we need to bind it to the scope so that its
+            // location fetch can return useful information.
+            //
+            if (pChildSymbol->InternalGetKind() == SvcSymbolDataParameter ||
+                pChildSymbol->InternalGetKind() == SvcSymbolDataLocal)
+            {
+                VariableSymbol *pChildVariable = static_cast<VariableSymbol *>(pChildSymbol);
 
-            ComPtr<VariableSymbol> spBoundVariable;
-            IfFailedReturn(pChildVariable->BindToScope(pScope, &spBoundVariable));
+                //
+                // A binding to a scope without a frame is the same as any other binding of the variable at the same
+                // place and may be shared.
+                //
+                ComPtr<VariableSymbol> spBoundVariable;
+                if (pScope->InternalGetScopeFrameContext() == nullptr)
+                {
+                    IfFailedReturn(InternalGetSymbolSet()->GetScopeBoundVariable(childId,
+                                                                                 pScope->InternalGetModuleOffset(),
+                                                                                 &spBoundVariable));
+                }
+                else
+                {
+                    IfFailedReturn(pChildVariable->BindToScope(pScope, &spBoundVariable));
+                }
 
-            *ppSymbol = spBoundVariable.Detach();
-            return S_OK;
-        }
-        else
-        {
-            ComPtr<ISvcSymbol> spSymbol = pChildSymbol;
-            *ppSymbol = spSymbol.Detach();
-            return S_OK;
+                *ppSymbol = spBoundVariable.Detach();
+                return S_OK;
+            }
+            else
+            {
+                ComPtr<ISvcSymbol> spSymbol = pChildSymbol;
+                *ppSymbol = spSymbol.Detach();
+                return S_OK;
+            }
         }
-    }
 
-    return E_BOUNDS;
+        return E_BOUNDS;
+    };
+    return ConvertException(fn);
 }
 
 //*************************************************
@@ -1160,13 +2258,7 @@ HRESULT GlobalScope::EnumerateChildren(_In_ SvcSymbolKind kind,
     // the name in question.  It may immediately turn around and say "I've already done this" but
     // such is the price for an on demand import like this.
     //
-    if (m_spSymbolSet->HasImporter())
-    {
-        //
-        // Failure to import should NOT trigger failure in the rest of the symbol builder!
-        //
-        (void)m_spSymbolSet->GetImporter()->ImportForNameQuery(kind, pwszName);
-    }
+    m_spSymbolSet->ImportForNameQuery(kind, pwszName);
 
     Microsoft::WRL::ComPtr<GlobalEnumerator> spEnum;
     IfFailedReturn(Microsoft::WRL::MakeAndInitialize<GlobalEnumerator>(&spEnum,
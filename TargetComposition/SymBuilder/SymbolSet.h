@@ -26,6 +26,7 @@ namespace SymbolBuilder
 {
 
 class SymbolBuilderManager;
+struct SharedImageSymbols;              // Forward declaration from SymManager.h
 
 //*************************************************
 // Overall Symbol Set:
@@ -33,7 +34,7 @@ class SymbolBuilderManager;
 
 // PublicList:
 //
-// Provides a list of addresses in sorted order which can be binary searched for the "nearest" symbol(s) to
+// Provides an index of addresses in sorted order which can be searched for the "nearest" symbol(s) to
 // a given address.
 //
 class PublicList
@@ -53,13 +54,15 @@ public:
     // FindNearestSymbols():
     //
     // Find the list of symbols which are closest to a given address.  If such can be found, true is returned and
-    // an output pointer to the list of symbol ids is passed in 'pSymbolList'
+    // an output pointer to the list of symbol ids is passed in 'pSymbolList'.  Buffered additions are not
+    // searched.  This does not change the list and may be called by many readers at once.
     //
     bool FindNearestSymbols(_In_ ULONG64 address, _Out_ SymbolList const** pSymbolList);
 
     // AddSymbol():
     //
-    // Adds a public symbol to the list.
+    // Adds a public symbol to the list.  The addition is buffered and placed in the index (along with any
+    // other buffered additions) in a single sorted pass the next time the list is flushed or a symbol is removed.
     //
     HRESULT AddSymbol(_In_ ULONG64 address, _In_ ULONG64 symbol);
 
@@ -69,12 +72,24 @@ public:
     //
     HRESULT RemoveSymbol(_In_ ULONG64 address, _In_ ULONG64 symbol);
 
+    // HasPendingSymbols():
+    //
+    // Indicates whether there are buffered additions which have not yet been placed in the index.
+    //
+    bool HasPendingSymbols() const { return !m_pendingSymbols.empty(); }
+
+    // FlushPendingSymbols():
+    //
+    // Places every buffered addition into the index.
+    //
+    HRESULT FlushPendingSymbols();
+
 private:
-    
-    struct Address
+
+    struct PendingSymbol
     {
         ULONG64 Addr;
-        SymbolList Symbols;
+        ULONG64 Symbol;
     };
 
     // RemoveSymbolFromList():
@@ -93,14 +108,19 @@ private:
         }
     }
 
-    std::vector<Address> m_addresses;
+    // The index of address -> the public symbols at that address (in the order they were added).  This is
+    // a balanced tree so that insertion, removal, and nearest lookup are all logarithmic.
+    std::map<ULONG64, SymbolList> m_addresses;
+
+    // Additions which have not yet been placed in the index.
+    std::vector<PendingSymbol> m_pendingSymbols;
 
 };
 
 // SymbolRangeList:
 //
-// Provides a list of address ranges in sorted order which can be binary searched for a given symbol or set
-// of symbols.
+// Provides an index of address ranges in sorted order which can be searched for the symbol or set of symbols
+// covering a given address.
 //
 class SymbolRangeList
 {
@@ -120,14 +140,16 @@ public:
     // FindSymbols():
     //
     // Find the list of symbols which overlap a given address.  If such can be found, true is returned and
-    // an output pointer to the list of symbol ids is passed in 'pSymbolList'
+    // an output pointer to the list of symbol ids is passed in 'pSymbolList'.  Buffered additions are not
+    // searched.  This does not change the list and may be called by many readers at once.
     //
     bool FindSymbols(_In_ ULONG64 address, _Out_ SymbolList const** pSymbolList);
 
     // AddSymbol():
     //
     // Adds a symbol to the range list.  The symbol's address range is given by the half-open set 
-    // [start, end).  
+    // [start, end).  The addition is buffered and placed in the index (along with any other buffered additions)
+    // the next time the list is flushed or a symbol is removed.  An empty range is ignored.
     //
     HRESULT AddSymbol(_In_ ULONG64 start, _In_ ULONG64 end, _In_ ULONG64 symbol);
 
@@ -137,15 +159,51 @@ public:
     //
     HRESULT RemoveSymbol(_In_ ULONG64 start, _In_ ULONG64 end, _In_ ULONG64 symbol);
 
+    // HasPendingRanges():
+    //
+    // Indicates whether there are buffered additions which have not yet been placed in the index.
+    //
+    bool HasPendingRanges() const { return !m_pendingRanges.empty(); }
+
+    // FlushPendingRanges():
+    //
+    // Places every buffered addition into the index.
+    //
+    HRESULT FlushPendingRanges();
+
 private:
-    
+
+    //
+    // The index holds disjoint [start, end) ranges keyed by their start address.  Where symbols overlap, their
+    // ranges are split so that each indexed range has the full list of symbols covering it.
+    //
     struct AddressRange
     {
-        ULONG64 Start;
         ULONG64 End;
         SymbolList Symbols;
     };
 
+    struct PendingRange
+    {
+        ULONG64 Start;
+        ULONG64 End;
+        ULONG64 Symbol;
+    };
+
+    // InsertRange():
+    //
+    // Places a single symbol range into the index, splitting any existing ranges it partially overlaps.  This
+    // may throw.
+    //
+    void InsertRange(_In_ ULONG64 start, _In_ ULONG64 end, _In_ ULONG64 symbol);
+
+    // SplitRangeAt():
+    //
+    // If 'address' falls strictly within an indexed range, splits that range in two at 'address'.  Both halves
+    // keep the full symbol list.  This may throw.
+    //
+    void SplitRangeAt(_In_ ULONG64 address);
+
     // RemoveSymbolFromList():
     //
     // Removes a symbol from the given list.
@@ -162,10 +220,421 @@ private:
         }
     }
 
-    std::vector<AddressRange> m_ranges;
+    // The index of start address -> range.  This is a balanced tree so that insertion, removal, and lookup of
+    // the range covering an address are logarithmic (plus the number of ranges an added symbol overlaps).
+    std::map<ULONG64, AddressRange> m_ranges;
+
+    // Additions which have not yet been placed in the index.
+    std::vector<PendingRange> m_pendingRanges;
 
 };
 
+// NameTrie:
+//
+// Provides an index of names (as a compressed prefix trie) which can be searched for every symbol whose name
+// starts with a given prefix or matches a glob or regular expression.  The cost of a search is proportional to
+// the length of the pattern's literal portions and the number of matches rather than the number of names.
+//
+class NameTrie
+{
+public:
+
+    using SymbolList = std::vector<ULONG64>;
+
+    // AddName():
+    //
+    // Adds a symbol to the trie under a given name.  This may throw.
+    //
+    void AddName(_In_ std::wstring const& name, _In_ ULONG64 symbol);
+
+    // RemoveName():
+    //
+    // Removes a symbol from the trie under a given name.
+    //
+    void RemoveName(_In_ std::wstring const& name, _In_ ULONG64 symbol);
+
+    // FindWithPrefix():
+    //
+    // Appends every symbol whose name starts with 'prefix' to 'symbols'.  This may throw.
+    //
+    void FindWithPrefix(_In_ std::wstring const& prefix, _Inout_ SymbolList& symbols) const;
+
+    // FindMatchingGlob():
+    //
+    // Appends every symbol whose name matches the glob 'pattern' to 'symbols'.  A '*' in the pattern matches
+    // any run of characters and a '?' matches any single character.  This may throw.
+    //
+    void FindMatchingGlob(_In_ std::wstring const& pattern, _Inout_ SymbolList& symbols) const;
+
+    // FindMatchingRegex():
+    //
+    // Appends every symbol whose whole name matches the regular expression 'pattern' to 'symbols'.  Only the
+    // names under the literal prefix of the expression (if any) are tested.  This may throw (including a
+    // std::regex_error for an invalid expression).
+    //
+    void FindMatchingRegex(_In_ std::wstring const& pattern, _Inout_ SymbolList& symbols) const;
+
+    // IsGlobPattern():
+    //
+    // Indicates whether a name contains glob wildcard characters.
+    //
+    static bool IsGlobPattern(_In_ std::wstring const& name)
+    {
+        return name.find_first_of(L"*?") != std::wstring::npos;
+    }
+
+    // GlobMatch():
+    //
+    // Indicates whether a single name matches the glob 'pattern'.
+    //
+    static bool GlobMatch(_In_ wchar_t const *pPattern, _In_ wchar_t const *pName);
+
+private:
+
+    struct Node
+    {
+        // The characters on the edge leading into this node from its parent.
+        std::wstring Label;
+
+        // Child nodes keyed by the first character of their label.
+        std::map<wchar_t, std::unique_ptr<Node>> Children;
+
+        // The symbols whose name ends at this node.
+        SymbolList Symbols;
+    };
+
+    // FindNode():
+    //
+    // Finds the node at which the prefix 'prefix' ends.  As labels are compressed, 'prefix' may end part way
+    // along the label of the returned node.  Returns nullptr if no name starts with 'prefix'.  The number of characters of the returned node's label which are part of 'prefix' is returned in
+    // 'pLabelMatched'.
+    //
+    Node const* FindNode(_In_ std::wstring const& prefix, _Out_ size_t *pLabelMatched) const;
+
+    // CollectSubtree():
+    //
+    // Appends every symbol at or below 'pNode' to 'symbols'.
+    //
+    static void CollectSubtree(_In_ Node const *pNode, _Inout_ SymbolList& symbols);
+
+    // CollectSubtreeNames():
+    //
+    // Calls 'fn' with the name and symbols of every node at or below 'pNode' which has symbols.  'name' holds the
+    // name up to and including the label of 'pNode'.
+    //
+    static void CollectSubtreeNames(_In_ Node const *pNode,
+                                    _Inout_ std::wstring& name,
+                                    _In_ std::function<void(std::wstring const&, SymbolList const&)> const& fn);
+
+    // RemoveFromNode():
+    //
+    // Removes a symbol under the name whose remainder (after the label of 'pNode') starts at 'pos'.  Nodes
+    // left with a single child and no symbols are merged with that child.  Returns true if 'pNode' is left
+    // empty and should be removed by its parent.  This may throw.
+    //
+    static bool RemoveFromNode(_In_ Node *pNode,
+                               _In_ std::wstring const& name,
+                               _In_ size_t pos,
+                               _In_ ULONG64 symbol);
+
+    // LiteralRegexPrefix():
+    //
+    // Returns the literal prefix which every string matching the regular expression 'pattern' must start
+    // with.  This is conservative and may be shorter than the true prefix (or empty).
+    //
+    static std::wstring LiteralRegexPrefix(_In_ std::wstring const& pattern);
+
+    // The root of the trie.  It always has an empty label.
+    Node m_root;
+};
+
+// LruCache:
+//
+// A cache of at most a fixed number of values by key.  Once full, adding a value evicts the least recently
+// found or added one.  This may throw.
+//
+template<typename TKey, typename TValue>
+class LruCache
+{
+public:
+
+    LruCache(_In_ size_t capacity) :
+        m_capacity(capacity)
+    {
+    }
+
+    // Find():
+    //
+    // Finds the value for a key and makes it the most recently used.  Returns nullptr if the key is not
+    // in the cache.
+    //
+    TValue *Find(_In_ TKey const& key)
+    {
+        auto it = m_index.find(key);
+        if (it == m_index.end())
+        {
+            return nullptr;
+        }
+
+        m_entries.splice(m_entries.begin(), m_entries, it->second);
+        return &(it->second->second);
+    }
+
+    // Insert():
+    //
+    // Adds (or replaces) the value for a key as the most recently used, evicting the least recently used
+    // value if the cache is full.
+    //
+    void Insert(_In_ TKey const& key, _In_ TValue value)
+    {
+        Erase(key);
+
+        m_entries.emplace_front(key, std::move(value));
+        try
+        {
+            m_index.insert( { key, m_entries.begin() } );
+        }
+        catch(...)
+        {
+            m_entries.pop_front();
+            throw;
+        }
+
+        if (m_entries.size() > m_capacity)
+        {
+            m_index.erase(m_entries.back().first);
+            m_entries.pop_back();
+        }
+    }
+
+    // Erase():
+    //
+    // Removes the value for a key if present.
+    //
+    void Erase(_In_ TKey const& key)
+    {
+        auto it = m_index.find(key);
+        if (it != m_index.end())
+        {
+            m_entries.erase(it->second);
+            m_index.erase(it);
+        }
+    }
+
+    // EraseRange():
+    //
+    // Removes the values for every key in [lowKey, highKey).
+    //
+    void EraseRange(_In_ TKey const& lowKey, _In_ TKey const& highKey)
+    {
+        auto itEnd = m_index.lower_bound(highKey);
+        for (auto it = m_index.lower_bound(lowKey); it != itEnd; )
+        {
+            m_entries.erase(it->second);
+            it = m_index.erase(it);
+        }
+    }
+
+    // Clear():
+    //
+    // Removes every value.
+    //
+    void Clear()
+    {
+        m_index.clear();
+        m_entries.clear();
+    }
+
+    size_t Size() const { return m_entries.size(); }
+
+private:
+
+    using EntryList = std::list<std::pair<TKey, TValue>>;
+
+    size_t m_capacity;
+    EntryList m_entries;                                        // Most recently used first
+    std::map<TKey, typename EntryList::iterator> m_index;
+};
+
+// SymbolSetLock:
+//
+// A reader / writer lock over a symbol set.  Lookups hold the lock shared and may run concurrently on any number
+// of threads.  Anything which changes the set (including an on demand import) holds the lock exclusive.
+//
+// Both kinds of hold are reentrant on a thread.  A thread holding the lock exclusive may take it shared; that
+// is a no-op.  A thread holding the lock only shared may *NOT* take it exclusive.  Doing so would have to give
+// up the shared hold (two readers upgrading in place wait on each other forever) and anything the outer reader
+// had found could change underneath it.  Such an upgrade is an internal error and LockExclusive throws.
+//
+// Just before the last exclusive hold on a thread is released, the owner's release handler (if any) is called
+// with the lock still held exclusive.
+//
+class SymbolSetLock
+{
+public:
+
+    SymbolSetLock(_In_ std::function<void()> releasingExclusive = nullptr) :
+        m_releasingExclusive(std::move(releasingExclusive))
+    {
+    }
+
+    SymbolSetLock(SymbolSetLock const&) = delete;
+    SymbolSetLock& operator=(SymbolSetLock const&) = delete;
+
+    // LockShared() / UnlockShared():
+    //
+    // Takes / releases a shared hold on the lock for the calling thread.  LockShared may throw.
+    //
+    void LockShared();
+    void UnlockShared();
+
+    // LockExclusive() / UnlockExclusive():
+    //
+    // Takes / releases an exclusive hold on the lock for the calling thread.  LockExclusive may throw.
+    //
+    void LockExclusive();
+    void UnlockExclusive();
+
+    // IsHeldExclusive():
+    //
+    // Indicates whether the calling thread holds the lock exclusive.
+    //
+    bool IsHeldExclusive();
+
+private:
+
+    // ThreadHold:
+    //
+    // The holds which a thread has on a single lock.
+    //
+    struct ThreadHold
+    {
+        SymbolSetLock const *Lock;
+        ULONG SharedDepth;
+        ULONG ExclusiveDepth;
+    };
+
+    // GetThreadHolds():
+    //
+    // Gets the holds which the calling thread has on any lock.  Only locks which are actually held are in the
+    // list and a thread rarely holds more than one, so this is searched linearly.
+    //
+    static std::vector<ThreadHold>& GetThreadHolds();
+
+    // FindThreadHold():
+    //
+    // Finds the calling thread's hold on this lock.  If 'create' is true, an empty hold is added if there is
+    // none (which may throw); otherwise, nullptr is returned if there is none.
+    //
+    ThreadHold *FindThreadHold(_In_ bool create);
+
+    // ReleaseThreadHold():
+    //
+    // Removes the calling thread's (now empty) hold on this lock.
+    //
+    void ReleaseThreadHold();
+
+    std::shared_mutex m_lock;
+    std::function<void()> m_releasingExclusive;
+};
+
+// SymbolSetSharedLock:
+//
+// Holds a symbol set lock shared for the lifetime of the object.  This may throw.
+//
+class SymbolSetSharedLock
+{
+public:
+
+    SymbolSetSharedLock(_In_ SymbolSetLock& lock) :
+        m_lock(lock)
+    {
+        m_lock.LockShared();
+    }
+
+    ~SymbolSetSharedLock()
+    {
+        m_lock.UnlockShared();
+    }
+
+    SymbolSetSharedLock(SymbolSetSharedLock const&) = delete;
+    SymbolSetSharedLock& operator=(SymbolSetSharedLock const&) = delete;
+
+private:
+
+    SymbolSetLock& m_lock;
+};
+
+// SymbolSetExclusiveLock:
+//
+// Holds a symbol set lock exclusive for the lifetime of the object.  This may throw.
+//
+class SymbolSetExclusiveLock
+{
+public:
+
+    SymbolSetExclusiveLock(_In_ SymbolSetLock& lock) :
+        m_lock(lock)
+    {
+        m_lock.LockExclusive();
+    }
+
+    ~SymbolSetExclusiveLock()
+    {
+        m_lock.UnlockExclusive();
+    }
+
+    SymbolSetExclusiveLock(SymbolSetExclusiveLock const&) = delete;
+    SymbolSetExclusiveLock& operator=(SymbolSetExclusiveLock const&) = delete;
+
+private:
+
+    SymbolSetLock& m_lock;
+};
+
+// TypeExpression:
+//
+// A type name split into the name of a base type and the pointer, reference, and array declarators applied to
+// it in order (e.g.: "Foo *[16]" is "Foo" followed by a pointer and then an array of 16).  Declarators are only
+// recognized at the end of the name.  Anything before them (e.g.: template arguments) is part of the base name.
+//
+// NOTE: This is *NOT* a C++ type name parser.  Declarators always apply left to right.  "int [5] *" is a pointer
+//       to an array (and is rejected when resolved) rather than C's "int (*)[5]".
+//
+struct TypeExpression
+{
+    struct Declarator
+    {
+        SvcSymbolTypeKind Kind;                 // SvcSymbolTypePointer or SvcSymbolTypeArray
+        SvcSymbolPointerKind PointerKind;       // The kind of pointer (if a pointer)
+        ULONG64 ArrayDim;                       // The number of elements (if an array)
+    };
+
+    // Parse():
+    //
+    // Parses a type name.  E_INVALIDARG is returned if the name is empty or a declarator is malformed.  This
+    // may throw.
+    //
+    static HRESULT Parse(_In_ std::wstring const& typeName, _Out_ TypeExpression *pExpression);
+
+    // AppendDeclarator():
+    //
+    // Appends a declarator to a type name in the same form as the name given to a derived type created for it
+    // (e.g.: " *" or "[16]").  This may throw.
+    //
+    static void AppendDeclarator(_Inout_ std::wstring& typeName, _In_ Declarator const& declarator);
+
+    // GetNormalizedName():
+    //
+    // Gets the name of the type in a single canonical form.  For a type which has been demand created, this is
+    // its qualified name.  This may throw.
+    //
+    std::wstring GetNormalizedName() const;
+
+    std::wstring BaseName;
+    std::vector<Declarator> Declarators;
+};
+
 // SymbolSet:
 //
 // Our representation for our "in memory constructed" symbols for a given module within a given 
@@ -188,11 +657,22 @@ public:
     //
     static constexpr ULONG64 ScopeBoundIdFlag = (1ull << 63);
 
+    // The number of scopes and scope bound variables kept for reuse.
+    static constexpr size_t ScopeCacheSize = 1024;
+    static constexpr size_t BoundVariableCacheSize = 4096;
+
     SymbolSet() :
         m_nextId(0),
+        m_scopeCache(ScopeCacheSize),
+        m_boundVariableCache(BoundVariableCacheSize),
+        m_lock([this](){ (void)FlushPendingAddresses(); }),
         m_demandCreatePointerTypes(true),
         m_demandCreateArrayTypes(true),
-        m_cacheInvalidationDisabled(false)
+        m_cacheInvalidationDisabled(false),
+        m_foregroundImports(0),
+        m_batchDepth(0),
+        m_batchInvalidationPending(false),
+        m_changeVersion(0)
     {
     }
 
@@ -318,17 +798,24 @@ public:
 
     // RuntimeClassInitialize():
     //
-    // Initialize a new symbol set.
+    // Initialize a new symbol set.  If a name pool is given, the names of the symbols in the set are interned in
+    // it (e.g.: to share them with the symbol sets for the same image in other processes).
     //
     HRESULT RuntimeClassInitialize(_In_ ISvcModule *pModule, 
                                    _In_ SymbolBuilderProcess *pOwningProcess,
-                                   _In_ bool addBasicCTypes = true)
+                                   _In_ bool addBasicCTypes = true,
+                                   _In_opt_ std::shared_ptr<NamePool> const& spNamePool = nullptr)
     {
         HRESULT hr = S_OK;
 
         m_spModule = pModule;
         m_pOwningProcess = pOwningProcess;
 
+        IfFailedReturn(ConvertException([&](){
+            m_spNamePool = (spNamePool != nullptr ? spNamePool : std::make_shared<NamePool>());
+            return S_OK;
+        }));
+
         if (addBasicCTypes)
         {
             hr = AddBasicCTypes();
@@ -356,6 +843,19 @@ public:
     //
     HRESULT DeleteExistingSymbol(_In_ ULONG64 uniqueId);
 
+    // IndexSymbolName():
+    //
+    // Adds a symbol to the name indices under its current base and qualified names.  This may throw.
+    //
+    void IndexSymbolName(_In_ BaseSymbol *pSymbol);
+
+    // UnindexSymbolName():
+    //
+    // Removes a symbol from the name indices under its current base and qualified names.  This is called
+    // before a symbol is renamed or deleted.  This may throw.
+    //
+    void UnindexSymbolName(_In_ BaseSymbol *pSymbol);
+
     // InvalidateExternalCaches():
     //
     // Fires an event notification to any listeners indicating that their caching of symbols from this
@@ -374,9 +874,37 @@ public:
                            _COM_Outptr_opt_ BaseTypeSymbol **ppTypeSymbol,
                            _In_ bool allowAutoCreations = true);
 
+    // InvalidateTypeExpressionCaches():
+    //
+    // Forgets every type expression resolved by FindTypeByName and every derived type it found or created.  This
+    // is required whenever a type is deleted or renamed.  Nothing else changes how an expression resolves.
+    //
+    void InvalidateTypeExpressionCaches();
+
+    // ImportForNameQuery() / ImportForOffsetQuery():
+    //
+    // If we have an underlying importer, gives it a shot at pulling in symbols that are relevant for a lookup of
+    // the given name or address.  Whether there is anything left to import is first checked with the symbol set
+    // held shared.  Only an actual import holds it exclusive.  Failure to import should NOT trigger failure of the
+    // lookup and so nothing is returned.
+    //
+    void ImportForNameQuery(_In_ SvcSymbolKind searchKind, _In_opt_ PCWSTR pwszName);
+    void ImportForOffsetQuery(_In_ SvcSymbolKind searchKind, _In_ ULONG64 moduleOffset);
+
+    // FlushPendingAddresses():
+    //
+    // If the calling thread holds the symbol set exclusive, places any buffered symbol ranges and public
+    // addresses in their indices.  This happens whenever the last exclusive hold on the symbol set is given up
+    // (and so at the end of every change and batch).  A lookup by address calls this before it searches those
+    // indices so that a lookup made in the middle of a change sees what that change added.  A reader which only
+    // holds the symbol set shared has nothing to place and this does nothing.
+    //
+    HRESULT FlushPendingAddresses();
+
     // GetScopeBindingId():
     //
-    // Gets a new ID for a scope binding.
+    // Gets the ID for a scope binding.  Every binding of the same variable at the same module offset gets the
+    // same ID.
     //
     HRESULT GetScopeBindingId(_In_ ULONG64 variableId,
                               _In_ ULONG64 moduleOffset,
@@ -384,12 +912,38 @@ public:
     {
         auto fn = [&]()
         {
-            m_scopeBindings.push_back( std::pair<ULONG64, ULONG64> { variableId, moduleOffset } );
-            *pId = ScopeBoundIdFlag | (m_scopeBindings.size() - 1);
+            std::lock_guard<std::mutex> cacheLock(m_cacheLock);
+
+            std::pair<ULONG64, ULONG64> scopeBinding { variableId, moduleOffset };
+            auto it = m_scopeBindingIds.find(scopeBinding);
+            if (it == m_scopeBindingIds.end())
+            {
+                m_scopeBindings.push_back(scopeBinding);
+                try
+                {
+                    it = m_scopeBindingIds.insert( { scopeBinding, m_scopeBindings.size() - 1 } ).first;
+                }
+                catch(...)
+                {
+                    m_scopeBindings.pop_back();
+                    throw;
+                }
+            }
+
+            *pId = ScopeBoundIdFlag | it->second;
             return S_OK;
         };
         return ConvertException(fn);
     }
+
+    // GetScopeBoundVariable():
+    //
+    // Gets a variable bound to the scope at a given module offset.  Bindings are kept (up to a limit) and
+    // reused until the next change to the symbol set.
+    //
+    HRESULT GetScopeBoundVariable(_In_ ULONG64 variableId,
+                                  _In_ ULONG64 moduleOffset,
+                                  _COM_Outptr_ VariableSymbol **ppBoundVariable);
 	
     // SetImporter():
     //
@@ -398,7 +952,37 @@ public:
     void SetImporter(_In_ std::unique_ptr<SymbolImporter>&& importer)
     {
         m_spImporter = std::move(importer);
-    }	
+
+        //
+        // If the symbol set started as a copy of another, the new importer must not import what the copy already
+        // has.  An importer which cannot take the state is still used; it just imports some things again.
+        //
+        if (m_spImporter != nullptr && m_spSeedImportState != nullptr)
+        {
+            (void)m_spImporter->SetImportState(*m_spSeedImportState);
+        }
+        m_spSeedImportState.reset();
+    }
+
+    // SetSeedImportState():
+    //
+    // Sets what the importer of another symbol set had imported into the symbols this one was copied from.  This
+    // is given to the importer of this symbol set when it is set.
+    //
+    void SetSeedImportState(_In_ std::unique_ptr<ImportState>&& spImportState)
+    {
+        m_spSeedImportState = std::move(spImportState);
+    }
+
+    // SetSnapshotReader():
+    //
+    // Sets the reader of the snapshot this symbol set was loaded from.  The members of the UDTs loaded from the
+    // snapshot are created by the reader when they are first needed.
+    //
+    void SetSnapshotReader(_In_ std::unique_ptr<SymbolSnapshotReader>&& spReader)
+    {
+        m_spSnapshotReader = std::move(spReader);
+    }
 
     // SetCacheInvalidationDisable():
     //
@@ -409,6 +993,74 @@ public:
         m_cacheInvalidationDisabled = disable;
     }
 
+    // IsCacheInvalidationDisabled():
+    //
+    // Indicates whether cache invalidation notifications are currently disabled.
+    //
+    bool IsCacheInvalidationDisabled() const { return m_cacheInvalidationDisabled; }
+
+    // BeginForegroundImport() / EndForegroundImport():
+    //
+    // Brackets an import on behalf of a query.  These are called before taking the symbol set lock.  While any
+    // is outstanding, a background import gives up the symbol set at its next opportunity and waits.
+    //
+    void BeginForegroundImport() { ++m_foregroundImports; }
+    void EndForegroundImport() { --m_foregroundImports; }
+
+    // HasForegroundImports():
+    //
+    // Indicates whether any query is waiting to import into (or is importing into) the symbol set.
+    //
+    bool HasForegroundImports() const { return m_foregroundImports > 0; }
+
+    // BeginBatch():
+    //
+    // Opens a batch on the symbol set.  While a batch is open, layouts and dependent change notifications are
+    // only recorded against the symbols they would apply to and cache invalidations are held.  Batches may
+    // nest.  Nothing is performed until the outermost batch is committed.  Note that the size and layout of
+    // a symbol which was changed within an open batch are not up to date until the batch commits.  This may
+    // throw.
+    //
+    void BeginBatch()
+    {
+        SymbolSetExclusiveLock lock(m_lock);
+        ++m_batchDepth;
+    }
+
+    // CommitBatch():
+    //
+    // Closes a batch opened by BeginBatch.  If this closes the outermost batch, every symbol which was changed
+    // within the batch is sent a single dependent change notification and, if any invalidation was held,
+    // a single cache invalidation is sent upwards.
+    //
+    HRESULT CommitBatch();
+
+    // IsBatchOpen():
+    //
+    // Indicates whether there is an open batch on the symbol set.
+    //
+    bool IsBatchOpen() const
+    {
+        return m_batchDepth > 0;
+    }
+
+    // DeferDependentChange():
+    //
+    // If a batch is open, records that the given symbol needs a dependent change notification when the batch
+    // commits and returns true.  If no batch is open (or the symbol cannot be recorded), false is returned and
+    // the caller must perform the change immediately.
+    //
+    bool DeferDependentChange(_In_ ULONG64 uniqueId);
+
+    // PropagateDependentChanges():
+    //
+    // Updates each of the given changed symbols and every symbol which transitively depends upon any of them.  Each
+    // symbol is updated exactly once, after all of the symbols it depends upon, regardless of how many paths through
+    // the dependency graph lead to it.  A failure to update one symbol does not prevent the others from being
+    // updated; the first failure is returned.
+    //
+    HRESULT PropagateDependentChanges(_In_reads_(count) ULONG64 const *pChangedSymbols, _In_ size_t count);
+
     //*************************************************
     // Internal Accessors:
     //
@@ -449,7 +1101,10 @@ public:
     //
     HRESULT InternalAddSymbolRange(_In_ ULONG64 start, _In_ ULONG64 end, _In_ ULONG64 symbol)
     {
-        return m_symbolRanges.AddSymbol(start, end, symbol);
+        return ConvertException([&](){
+            SymbolSetExclusiveLock lock(m_lock);
+            return m_symbolRanges.AddSymbol(start, end, symbol);
+        });
     }
 
     // InternalRemoveSymbolRange():
@@ -458,7 +1113,10 @@ public:
     //
     HRESULT InternalRemoveSymbolRange(_In_ ULONG64 start, _In_ ULONG64 end, _In_ ULONG64 symbol)
     {
-        return m_symbolRanges.RemoveSymbol(start, end, symbol);
+        return ConvertException([&](){
+            SymbolSetExclusiveLock lock(m_lock);
+            return m_symbolRanges.RemoveSymbol(start, end, symbol);
+        });
     }
 
     // InternalAddPublicSymbol():
@@ -467,7 +1125,10 @@ public:
     //
     HRESULT InternalAddPublicSymbol(_In_ ULONG64 address, _In_ ULONG64 symbol)
     {
-        return m_publicAddresses.AddSymbol(address, symbol);
+        return ConvertException([&](){
+            SymbolSetExclusiveLock lock(m_lock);
+            return m_publicAddresses.AddSymbol(address, symbol);
+        });
     }
 
     // InternalRemovePublicSymbol():
@@ -476,23 +1137,119 @@ public:
     //
     HRESULT InternalRemovePublicSymbol(_In_ ULONG64 address, _In_ ULONG64 symbol)
     {
-        return m_publicAddresses.RemoveSymbol(address, symbol);
+        return ConvertException([&](){
+            SymbolSetExclusiveLock lock(m_lock);
+            return m_publicAddresses.RemoveSymbol(address, symbol);
+        });
     }
 
     std::vector<Microsoft::WRL::ComPtr<ISvcSymbol>> const& InternalGetSymbols() { return m_symbols; }
     std::vector<ULONG64> const& InternalGetGlobalSymbols() const { return m_globalSymbols; }
+
+    // InternalGetSymbolsByKind():
+    //
+    // Gets the ids of every symbol of the given kind (global or not) in id order.  Returns nullptr if
+    // there are none.
+    //
+    std::set<ULONG64> const* InternalGetSymbolsByKind(_In_ SvcSymbolKind kind) const
+    {
+        auto it = m_kindIndex.find(kind);
+        return (it == m_kindIndex.end() ? nullptr : &(it->second));
+    }
+
+    // InternalGetSymbolsByName():
+    //
+    // Gets the ids of every symbol (global or not) with the given base name or qualified name in id order.
+    // Returns nullptr if there are none.
+    //
+    std::set<ULONG64> const* InternalGetSymbolsByName(_In_ std::wstring const& name, _In_ bool qualified) const
+    {
+        auto&& index = (qualified ? m_qualifiedNameIndex : m_nameIndex);
+        auto it = index.find(name);
+        return (it == index.end() ? nullptr : &(it->second));
+    }
+
+    // InternalFindSymbolsMatching():
+    //
+    // Finds every symbol (global or not) whose qualified name matches a glob pattern (or a regular expression
+    // if 'isRegex' is true).  The ids are returned in id order.  This may throw.
+    //
+    void InternalFindSymbolsMatching(_In_ std::wstring const& pattern,
+                                     _In_ bool isRegex,
+                                     _Out_ std::vector<ULONG64> *pSymbols) const;
     IDebugServiceManager* GetServiceManager() const;
     ISvcMachineArchitecture* GetArchInfo() const;
     SymbolBuilderManager* GetSymbolBuilderManager() const;
     ISvcModule* GetModule() const;
     SymbolBuilderProcess* GetOwningProcess() const { return m_pOwningProcess; }
 
+    // GetNamePool():
+    //
+    // Gets the pool of interned names shared by every symbol in this set.
+    //
+    std::shared_ptr<NamePool> const& GetNamePool() const { return m_spNamePool; }
+
+    // GetImageIdentity() / SetSharedImage():
+    //
+    // Gets / sets the identity of the module image (name, timestamp, and size) which this symbol set describes
+    // and what it shares with the symbol sets for the same image in other processes.  The identity is empty if
+    // this symbol set does not share its image.  The shared state is kept alive by the symbol sets which share
+    // it.  This may throw.
+    //
+    std::wstring const& GetImageIdentity() const { return m_imageIdentity; }
+    void SetSharedImage(_In_ std::wstring const& imageIdentity,
+                        _In_ std::shared_ptr<SharedImageSymbols> const& spSharedImage)
+    {
+        m_imageIdentity = imageIdentity;
+        m_spSharedImage = spSharedImage;
+    }
+
+    // GetImageSharingStatistics():
+    //
+    // Gets what this symbol set shares with the symbol sets for the same image in other processes and what it
+    // holds privately: the number of symbol sets sharing the image (zero if this one does not share it), the
+    // number of symbols this set holds its own copy of, and the bytes of the in memory snapshot it still holds
+    // for UDT members which have yet to be created.
+    //
+    void GetImageSharingStatistics(_Out_ size_t *pSharingSets,
+                                   _Out_ size_t *pSymbolCount,
+                                   _Out_ size_t *pHeldSnapshotBytes);
+
+    // GetChangeVersion():
+    //
+    // Gets a number which changes every time something in the symbol set changes.
+    //
+    ULONG64 GetChangeVersion() const { return m_changeVersion; }
+
+    // GetLock():
+    //
+    // Gets the reader / writer lock over the symbol set.  Lookups through the symbol set's interfaces and
+    // enumerators hold it shared.  Anything which changes the symbol set holds it exclusive.
+    //
+    SymbolSetLock& GetLock() const { return m_lock; }
+
+    // GetCacheLock():
+    //
+    // Gets the lock over what lookups fill in while holding the symbol set shared: the scope, scope bound
+    // variable, and type expression caches, scope binding IDs, and the live range indices of functions.  Nothing
+    // which takes the symbol set lock may be called while holding this.
+    //
+    std::mutex& GetCacheLock() const { return m_cacheLock; }
+
     // HasImporter/GetImporter():
     //
     // Indicates whether or not we have an underlying symbol importer / gets it.
     //
     bool HasImporter() const { return m_spImporter.get() != nullptr; }
     SymbolImporter *GetImporter() const { return m_spImporter.get(); }
+
+    // HasSnapshotReader/GetSnapshotReader():
+    //
+    // Indicates whether or not members are still to be created from the snapshot this set was loaded from / gets
+    // the reader of it.
+    //
+    bool HasSnapshotReader() const { return m_spSnapshotReader.get() != nullptr; }
+    SymbolSnapshotReader *GetSnapshotReader() const { return m_spSnapshotReader.get(); }
     ULONG64 ReserveUniqueId() { return GetUniqueId(); }
 
 private:
@@ -502,6 +1259,59 @@ private:
         return ++m_nextId;
     }
 
+    // GetTypeForLookup():
+    //
+    // Returns the type with the given id as the result of a lookup by name.  E_INVALIDARG is returned if there is
+    // no such type.
+    //
+    HRESULT GetTypeForLookup(_In_ ULONG64 typeId, _Out_ ULONG64 *pTypeId, _Outptr_opt_ BaseTypeSymbol **ppTypeSymbol);
+
+    // FindMemoizedTypeExpression() / MemoizeTypeExpression():
+    //
+    // Finds / records the id of the type a type expression resolved to.  Find returns 0 if the expression has not
+    // been resolved since the cache was last invalidated.  Memoize may throw.
+    //
+    ULONG64 FindMemoizedTypeExpression(_In_ std::wstring const& expression);
+    void MemoizeTypeExpression(_In_ std::wstring const& expression, _In_ ULONG64 typeId);
+
+    // FindDerivedType():
+    //
+    // Finds a derived type (pointer or array) of a given type which has already been created, whether recorded
+    // or by its name.  Returns 0 if there is none.  This may throw.
+    //
+    ULONG64 FindDerivedType(_In_ ULONG64 baseTypeId,
+                            _In_ TypeExpression::Declarator const& declarator,
+                            _In_ std::wstring const& derivedName);
+
+    // GetDerivedTypeKey():
+    //
+    // Gets the key of a derived type (pointer or array) of a given type in the derived type cache.
+    //
+    static std::tuple<ULONG64, SvcSymbolTypeKind, ULONG64> GetDerivedTypeKey(
+        _In_ ULONG64 baseTypeId,
+        _In_ TypeExpression::Declarator const& declarator)
+    {
+        ULONG64 kindKey = (declarator.Kind == SvcSymbolTypePointer ? static_cast<ULONG64>(declarator.PointerKind)
+                                                                    : declarator.ArrayDim);
+        return std::make_tuple(baseTypeId, declarator.Kind, kindKey);
+    }
+
+    // RecordDerivedType():
+    //
+    // Records a derived type (pointer or array) of a given type so that FindDerivedType will find it without
+    // going by name.  This may throw.
+    //
+    void RecordDerivedType(_In_ ULONG64 baseTypeId,
+                           _In_ TypeExpression::Declarator const& declarator,
+                           _In_ ULONG64 derivedTypeId);
+
+    // ResolveTypeExpression():
+    //
+    // Finds the type for a parsed type expression, creating any pointer and array types needed along the way
+    // if the symbol set allows it.  The symbol set must be held exclusive.  This may throw.
+    //
+    HRESULT ResolveTypeExpression(_In_ TypeExpression const& expression, _Out_ ULONG64 *pTypeId);
+
     // The next "unique id" that we will hand out when a new symbol is constructed
     ULONG64 m_nextId;
 
@@ -511,12 +1321,33 @@ private:
     // The master index of "global" symbols
     std::vector<ULONG64> m_globalSymbols;
 
-    // Scope bindings: pair< variable id, moduleOffset > 
+    // Scope bindings: pair< variable id, moduleOffset > and the index of each in m_scopeBindings
     std::vector<std::pair<ULONG64, ULONG64>> m_scopeBindings;
+    std::map<std::pair<ULONG64, ULONG64>, size_t> m_scopeBindingIds;
+
+    // The most recently used scopes keyed by pair< function id, function relative offset >
+    LruCache<std::pair<ULONG64, ULONG64>, Microsoft::WRL::ComPtr<ISvcSymbolSetScope>> m_scopeCache;
+
+    // The most recently used scope bound variables keyed by pair< variable id, moduleOffset >.  As these copy
+    // information from the variable they are bound from, they are dropped on any change to the symbol set.
+    LruCache<std::pair<ULONG64, ULONG64>, Microsoft::WRL::ComPtr<VariableSymbol>> m_boundVariableCache;
 
     // The master index of names -> global symbol IDs
     std::unordered_map<std::wstring, ULONG64> m_symbolNameMap;
 
+    // Secondary indices of all symbols (global or not) by kind, base name, and qualified name.  These
+    // allow a filtered enumeration to avoid walking every symbol in the set.  The name keys are views of the
+    // pooled names of the symbols in each entry (which hold a reference on them) rather than copies.
+    std::unordered_map<SvcSymbolKind, std::set<ULONG64>> m_kindIndex;
+    std::unordered_map<std::wstring_view, std::set<ULONG64>> m_nameIndex;
+    std::unordered_map<std::wstring_view, std::set<ULONG64>> m_qualifiedNameIndex;
+
+    // A prefix trie over the qualified names of all symbols for wildcard and regular expression searches.
+    NameTrie m_qualifiedNameTrie;
+
+    // The interned names of all symbols in the set.
+    std::shared_ptr<NamePool> m_spNamePool;
+
     // The module for which we are the symbols
     Microsoft::WRL::ComPtr<ISvcModule> m_spModule;
 
@@ -533,15 +1364,121 @@ private:
     // to it. 
     std::unique_ptr<SymbolImporter> m_spImporter;
 
+    // What the importer of the symbols this set was copied from had imported (until the importer is set).
+    std::unique_ptr<ImportState> m_spSeedImportState;
+
+    // The reader of the snapshot this set was loaded from while the members of any UDT are still in it.
+    std::unique_ptr<SymbolSnapshotReader> m_spSnapshotReader;
+
     // An indication of whether cache invalidation is disabled or not.
     bool m_cacheInvalidationDisabled;
 
+    // The number of imports on behalf of queries which are outstanding.
+    std::atomic<ULONG> m_foregroundImports;
+
+    // Batch state: the nesting depth of open batches, the symbols which need a dependent change notification
+    // on commit (in the order they were first changed), and whether a cache invalidation is being held.
+    ULONG m_batchDepth;
+    std::vector<ULONG64> m_batchChangedSymbols;
+    std::unordered_set<ULONG64> m_batchChangedSymbolSet;
+    bool m_batchInvalidationPending;
+
+    // The identity of the module image which this symbol set describes, what it shares with other symbol sets for
+    // the same image, and the count of changes to it.
+    std::wstring m_imageIdentity;
+    std::shared_ptr<SharedImageSymbols> m_spSharedImage;
+    ULONG64 m_changeVersion;
+
+    // Type expressions (as given and normalized) resolved by FindTypeByName and the derived types of each type keyed
+    // by tuple< base type id, pointer or array, pointer kind or array dimension >.  Both are only invalidated when
+    // a type is deleted or renamed.
+    std::unordered_map<std::wstring, ULONG64> m_typeExpressionCache;
+    std::map<std::tuple<ULONG64, SvcSymbolTypeKind, ULONG64>, ULONG64> m_derivedTypeCache;
+
+    // The reader / writer lock over the symbol set and the lock over caches filled in by lookups.
+    mutable SymbolSetLock m_lock;
+    mutable std::mutex m_cacheLock;
+
     // Configuration options:
     bool m_demandCreatePointerTypes;
     bool m_demandCreateArrayTypes;
     
 };
 
+// SymbolSetBatch:
+//
+// Holds a batch open on a symbol set for the lifetime of the object.  A caller which cares about the result of the
+// commit should call Commit explicitly; otherwise the batch is committed on destruction.  That includes unwinding
+// from an exception: the changes made before the error are committed (laid out and invalidated), not rolled back.
+//
+class SymbolSetBatch
+{
+public:
+
+    SymbolSetBatch(_In_ SymbolSet *pSymbolSet) :
+        m_pSymbolSet(pSymbolSet),
+        m_open(true)
+    {
+        m_pSymbolSet->BeginBatch();
+    }
+
+    ~SymbolSetBatch()
+    {
+        (void)Commit();
+    }
+
+    SymbolSetBatch(SymbolSetBatch const&) = delete;
+    SymbolSetBatch& operator=(SymbolSetBatch const&) = delete;
+
+    // Commit():
+    //
+    // Commits the batch.  This may only be done once.  Subsequent calls return S_FALSE.
+    //
+    HRESULT Commit()
+    {
+        if (!m_open)
+        {
+            return S_FALSE;
+        }
+
+        m_open = false;
+        return m_pSymbolSet->CommitBatch();
+    }
+
+private:
+
+    SymbolSet *m_pSymbolSet;
+    bool m_open;
+};
+
+// SymbolSetForegroundImport:
+//
+// Marks an import on behalf of a query for the lifetime of the object.  This must be constructed before taking
+// the symbol set lock.
+//
+class SymbolSetForegroundImport
+{
+public:
+
+    SymbolSetForegroundImport(_In_ SymbolSet *pSymbolSet) :
+        m_pSymbolSet(pSymbolSet)
+    {
+        m_pSymbolSet->BeginForegroundImport();
+    }
+
+    ~SymbolSetForegroundImport()
+    {
+        m_pSymbolSet->EndForegroundImport();
+    }
+
+    SymbolSetForegroundImport(SymbolSetForegroundImport const&) = delete;
+    SymbolSetForegroundImport& operator=(SymbolSetForegroundImport const&) = delete;
+
+private:
+
+    SymbolSet *m_pSymbolSet;
+};
+
 // BaseSymbolEnumerator:
 //
 // A base class for symbol enumeration which provides certain helpers.
@@ -594,6 +1531,7 @@ protected:
     {
         m_spSymbolSet = pSymbolSet;
         m_searchKind = SvcSymbol;
+        m_searchIsPattern = false;
         m_pSearchInfo = nullptr;
         return Reset();
     }
@@ -623,11 +1561,28 @@ protected:
                 m_pSearchInfo = reinterpret_cast<SvcSymbolSearchInfo *>(m_searchData.get());
                 memcpy(m_pSearchInfo, pSearchInfo, dataSize);
             }
+
+            //
+            // A name with wildcards is a pattern unless there is a symbol with exactly that name (e.g.:
+            // "operator*").
+            //
+            m_searchIsPattern = NameTrie::IsGlobPattern(m_searchName) &&
+                                pSymbolSet->InternalGetSymbolsByName(m_searchName, IsQualifiedNameSearch()) == nullptr;
+
             return Reset();
         };
         return ConvertException(fn);
     }
 
+    // IsQualifiedNameSearch():
+    //
+    // Indicates whether a name search is against qualified names rather than base names.
+    //
+    bool IsQualifiedNameSearch() const
+    {
+        return (m_pSearchInfo != nullptr && (m_pSearchInfo->SearchOptions & SvcSymbolSearchQualifiedName) != 0);
+    }
+
     // SymbolMatchesSearchCriteria():
     //
     // Checks whether a given symbol from the scope matches other search criteria (name, kind,
@@ -643,12 +1598,17 @@ protected:
         if (!m_searchName.empty())
         {
             wchar_t const *pMatchName = 
-                (m_pSearchInfo != nullptr && (m_pSearchInfo->SearchOptions & 
-                                              SvcSymbolSearchQualifiedName) != 0) ?
+                IsQualifiedNameSearch() ?
                     pSymbol->InternalGetQualifiedName().c_str() :
                     pSymbol->InternalGetName().c_str();
 
-            if (!pMatchName || wcscmp(pMatchName, m_searchName.c_str()) != 0)
+            if (!pMatchName)
+            {
+                return false;
+            }
+
+            if (m_searchIsPattern ? !NameTrie::GlobMatch(m_searchName.c_str(), pMatchName) :
+                                    wcscmp(pMatchName, m_searchName.c_str()) != 0)
             {
                 return false;
             }
@@ -677,6 +1637,7 @@ protected:
 
     SvcSymbolKind m_searchKind;
     std::wstring m_searchName;
+    bool m_searchIsPattern;
     SvcSymbolSearchInfo *m_pSearchInfo;
     std::unique_ptr<unsigned char[]> m_searchData;
 };
@@ -701,9 +1662,113 @@ public:
     //
     // Gets the next symbol from the enumerator.
     //
+    IFACEMETHOD(Reset)()
+    {
+        m_patternMatches.reset();
+        return BaseSymbolEnumerator::Reset();
+    }
+
     IFACEMETHOD(GetNext)(_COM_Outptr_ ISvcSymbol **ppSymbol)
     {
         *ppSymbol = nullptr;
+        return ConvertException([&](){
+            SymbolSetSharedLock lock(m_spSymbolSet->GetLock());
+            return InternalGetNext(ppSymbol);
+        });
+    }
+
+    //*************************************************
+    // Internal APIs:
+    //
+
+    HRESULT RuntimeClassInitialize(_In_ SymbolSet *pSymbolSet)
+    {
+        return BaseInitialize(pSymbolSet);
+    }
+
+    HRESULT RuntimeClassInitialize(_In_ SymbolSet *pSymbolSet,
+                                   _In_ SvcSymbolKind symKind,
+                                   _In_opt_ PCWSTR pwszName,
+                                   _In_opt_ SvcSymbolSearchInfo *pSearchInfo)
+    {
+        return BaseInitialize(pSymbolSet, symKind, pwszName, pSearchInfo);
+    }
+
+private:
+
+    // InternalGetNext():
+    //
+    // Gets the next symbol from the enumerator.  The symbol set must be held shared.
+    //
+    HRESULT InternalGetNext(_COM_Outptr_ ISvcSymbol **ppSymbol)
+    {
+        //
+        // If there is a name or kind filter, walk the matching index rather than every symbol in the set.
+        // The candidates are looked up again on each call (and resumed by id) so that symbols added or deleted
+        // in between calls behave just as they would with a walk of the master list.
+        //
+        // The exception is a wildcard search of qualified names.  That is answered once from the name trie
+        // and then walked.  Base names are not in the trie; such a search walks every symbol.
+        //
+        std::set<ULONG64> const *pCandidates = nullptr;
+        bool useIndex = false;
+        if (m_searchIsPattern)
+        {
+            if (IsQualifiedNameSearch())
+            {
+                auto fn = [&]()
+                {
+                    if (!m_patternMatches.has_value())
+                    {
+                        std::vector<ULONG64> matches;
+                        m_spSymbolSet->InternalFindSymbolsMatching(m_searchName, false, &matches);
+                        m_patternMatches.emplace(matches.begin(), matches.end());
+                    }
+                    return S_OK;
+                };
+
+                HRESULT hr = ConvertException(fn);
+                if (FAILED(hr))
+                {
+                    return hr;
+                }
+
+                pCandidates = &(m_patternMatches.value());
+                useIndex = true;
+            }
+        }
+        else if (!m_searchName.empty())
+        {
+            pCandidates = m_spSymbolSet->InternalGetSymbolsByName(m_searchName, IsQualifiedNameSearch());
+            useIndex = true;
+        }
+        else if (m_searchKind != SvcSymbol)
+        {
+            pCandidates = m_spSymbolSet->InternalGetSymbolsByKind(m_searchKind);
+            useIndex = true;
+        }
+
+        if (useIndex)
+        {
+            if (pCandidates == nullptr)
+            {
+                return E_BOUNDS;
+            }
+
+            for (auto it = pCandidates->lower_bound(m_pos); it != pCandidates->end(); ++it)
+            {
+                m_pos = static_cast<size_t>(*it) + 1;
+                BaseSymbol *pBaseSymbol = m_spSymbolSet->InternalGetSymbol(*it);
+                if (pBaseSymbol != nullptr && SymbolMatchesSearchCriteria(pBaseSymbol))
+                {
+                    Microsoft::WRL::ComPtr<ISvcSymbol> spSymbol = pBaseSymbol;
+                    *ppSymbol = spSymbol.Detach();
+                    return S_OK;
+                }
+            }
+
+            return E_BOUNDS;
+        }
 
         //
         // NOTE: There may be gaps in our id <-> symbol mapping because of deleted symbols or other
@@ -731,22 +1796,9 @@ public:
         return E_BOUNDS;
     }
 
-    //*************************************************
-    // Internal APIs:
-    //
-
-    HRESULT RuntimeClassInitialize(_In_ SymbolSet *pSymbolSet)
-    {
-        return BaseInitialize(pSymbolSet);
-    }
-
-    HRESULT RuntimeClassInitialize(_In_ SymbolSet *pSymbolSet,
-                                   _In_ SvcSymbolKind symKind,
-                                   _In_opt_ PCWSTR pwszName,
-                                   _In_opt_ SvcSymbolSearchInfo *pSearchInfo)
-    {
-        return BaseInitialize(pSymbolSet, symKind, pwszName, pSearchInfo);
-    }
+    // The symbols matching a wildcard search of qualified names (in id order).  This is filled in on the first
+    // call to GetNext after a reset.
+    std::optional<std::set<ULONG64>> m_patternMatches;
 };
 
 // GlobalScope:
@@ -874,9 +1926,10 @@ public:
     // Internal APIs:
     //
 
-    SymbolSet *InternalGetSymbolSet() const { return m_spSymbolSet.Get(); }
+    SymbolSet *InternalGetSymbolSet() const { return m_pSymbolSet; }
     FunctionSymbol *InternalGetFunction() const { return m_spFunction.Get(); }
     ULONG64 InternalGetFunctionOffset() const { return m_srelOffset; }
+    ULONG64 InternalGetModuleOffset() const { return m_spFunction->InternalGetAddressRanges()[0].first + m_srelOffset; }
     ISvcProcess *InternalGetScopeFrameProcess() const { return m_spFrameProcess.Get(); }
     ISvcRegisterContext *InternalGetScopeFrameContext() const { return m_spFrameContext.Get(); }
 
@@ -890,11 +1943,16 @@ protected:
                            _In_ FunctionSymbol *pFunction,
                            _In_ ULONG64 srelOffset,
                            _In_opt_ ISvcProcess *pFrameProcess = nullptr,
-                           _In_opt_ ISvcRegisterContext *pFrameContext = nullptr)
+                           _In_opt_ ISvcRegisterContext *pFrameContext = nullptr,
+                           _In_ bool cachedBySymbolSet = false)
     {
         HRESULT hr = S_OK;
 
-        m_spSymbolSet = pSymbolSet;
+        m_pSymbolSet = pSymbolSet;
+        if (!cachedBySymbolSet)
+        {
+            m_spSymbolSet = pSymbolSet;
+        }
         m_spFunction = pFunction;
         m_srelOffset = srelOffset;
         m_spFrameProcess = pFrameProcess;
@@ -907,7 +1965,9 @@ protected:
         return hr;
     }
 
-    // Our owning symbol set
+    // Our owning symbol set.  A scope held in the symbol set's scope cache does not hold a reference to the
+    // symbol set (it would be a cycle) and, like the symbols, relies on the symbol set outliving it.
+    SymbolSet *m_pSymbolSet;
     Microsoft::WRL::ComPtr<SymbolSet> m_spSymbolSet;
 
     // The function for which we are a scope.
@@ -940,9 +2000,10 @@ public:
 
     HRESULT RuntimeClassInitialize(_In_ SymbolSet *pSymbolSet,
                                    _In_ FunctionSymbol *pFunction,
-                                   _In_ ULONG64 srelOffset)
+                                   _In_ ULONG64 srelOffset,
+                                   _In_ bool cachedBySymbolSet = false)
     {
-        return BaseInitialize(pSymbolSet, pFunction, srelOffset);
+        return BaseInitialize(pSymbolSet, pFunction, srelOffset, nullptr, nullptr, cachedBySymbolSet);
     }
 };
 
@@ -0,0 +1,1350 @@
+//**************************************************************************
+//
+// SymbolSnapshot.cpp
+//
+// The implementation for saving a symbol set to (and loading a symbol set from) a binary
+// snapshot file.
+//
+//**************************************************************************
+//
+// Copyright (c) Microsoft Corporation.  All rights reserved.
+//
+//**************************************************************************
+
+#include "SymBuilder.h"
+
+using namespace Microsoft::WRL;
+
+namespace Debugger
+{
+namespace TargetComposition
+{
+namespace Services
+{
+namespace SymbolBuilder
+{
+
+struct HandleDeleter
+{
+    void operator()(_In_ HANDLE h)
+    {
+        CloseHandle(h);
+    }
+};
+
+typedef std::unique_ptr<void, HandleDeleter> handle_ptr;
+
+//
+// Extra data is written in 8 byte units.  A live range must not need padding to be read back in place.
+//
+static_assert(sizeof(SnapshotLiveRange) % sizeof(ULONG64) == 0, "unexpected live range padding");
+
+//*************************************************
+// Image Identity:
+//
+
+HRESULT GetSnapshotImageIdentity(_In_ ISvcModule *pModule,
+                                 _Out_ std::wstring *pImageName,
+                                 _Out_ ULONG *pTimeStamp,
+                                 _Out_ ULONG64 *pImageSize)
+{
+    HRESULT hr = S_OK;
+    *pTimeStamp = 0;
+    *pImageSize = 0;
+
+    ComPtr<ISvcModuleWithTimestampAndChecksum> spModuleTimestamp;
+    if (SUCCEEDED(pModule->QueryInterface(IID_PPV_ARGS(&spModuleTimestamp))))
+    {
+        IfFailedReturn(spModuleTimestamp->GetTimeDateStamp(pTimeStamp));
+    }
+
+    IfFailedReturn(pModule->GetSize(pImageSize));
+
+    BSTR moduleName;
+    IfFailedReturn(pModule->GetName(&moduleName));
+    bstr_ptr spModuleName(moduleName);
+
+    return ConvertException([&](){
+        *pImageName = moduleName;
+        return S_OK;
+    });
+}
+
+//*************************************************
+// Snapshot Writer:
+//
+
+HRESULT SymbolSnapshotWriter::BuildSnapshot(_Out_ SnapshotHeader *pHeader, _Out_opt_ ImportState *pImportState)
+{
+    auto fn = [&]()
+    {
+        HRESULT hr = S_OK;
+
+        //
+        // Importing deferred members below changes the symbol set.  Hold it exclusive for the whole build so that
+        // the snapshot is of a single consistent state.
+        //
+        SymbolSetExclusiveLock lock(m_pSymbolSet->GetLock());
+
+        //
+        // The string table always starts with the empty string so that an offset of zero means "no name".
+        //
+        m_strings.push_back(L'\0');
+        m_stringOffsets.insert( { std::wstring(), 0 } );
+
+        //
+        // A snapshot must not depend upon the importer which created the symbol set.  Import the members of
+        // every UDT whose members were deferred.  Doing so may import further such UDTs, so repeat until there
+        // are none left.
+        //
+        for (bool imported = true; imported; )
+        {
+            imported = false;
+
+            std::set<ULONG64> const *pTypes = m_pSymbolSet->InternalGetSymbolsByKind(SvcSymbolType);
+            std::vector<ULONG64> types;
+            if (pTypes != nullptr)
+            {
+                types.assign(pTypes->begin(), pTypes->end());
+            }
+
+            for (ULONG64 typeId : types)
+            {
+                BaseSymbol *pSymbol = m_pSymbolSet->InternalGetSymbol(typeId);
+                SvcSymbolTypeKind typeKind;
+                if (pSymbol != nullptr &&
+                    SUCCEEDED(static_cast<BaseTypeSymbol *>(pSymbol)->GetTypeKind(&typeKind)) &&
+                    typeKind == SvcSymbolTypeUDT &&
+                    static_cast<UdtTypeSymbol *>(pSymbol)->InternalHasDeferredMembers())
+                {
+                    IfFailedReturn(static_cast<UdtTypeSymbol *>(pSymbol)->EnsureMembers());
+                    imported = true;
+                }
+            }
+        }
+
+        //
+        // Every symbol is found through the kind index.  Walk them in id order so that the snapshot of an unchanged
+        // symbol set is always the same.
+        //
+        SvcSymbolKind kinds[] = { SvcSymbolType, SvcSymbolField, SvcSymbolBaseClass, SvcSymbolData,
+                                  SvcSymbolFunction, SvcSymbolDataParameter, SvcSymbolDataLocal, SvcSymbolPublic };
+
+        std::vector<ULONG64> symbols;
+        for (SvcSymbolKind kind : kinds)
+        {
+            std::set<ULONG64> const *pSymbols = m_pSymbolSet->InternalGetSymbolsByKind(kind);
+            if (pSymbols != nullptr)
+            {
+                symbols.insert(symbols.end(), pSymbols->begin(), pSymbols->end());
+            }
+        }
+        std::sort(symbols.begin(), symbols.end());
+
+        for (ULONG64 symbolId : symbols)
+        {
+            BaseSymbol *pSymbol = m_pSymbolSet->InternalGetSymbol(symbolId);
+            if (pSymbol == nullptr)
+            {
+                return E_UNEXPECTED;
+            }
+
+            //
+            // Function types are created for (and by) every function.  Only keep those which something else
+            // refers to.
+            //
+            if (pSymbol->InternalGetKind() == SvcSymbolType)
+            {
+                SvcSymbolTypeKind typeKind;
+                IfFailedReturn(static_cast<BaseTypeSymbol *>(pSymbol)->GetTypeKind(&typeKind));
+                if (typeKind == SvcSymbolTypeFunction)
+                {
+                    continue;
+                }
+            }
+
+            IfFailedReturn(AddSymbol(symbolId));
+        }
+
+        IfFailedReturn(FillFunctionTypes());
+
+        if (pImportState != nullptr)
+        {
+            IfFailedReturn(SaveImportState(pImportState));
+        }
+
+        //
+        // Record which module image the symbols are for.  A symbol set whose module cannot tell us that is saved
+        // without an image name, and its snapshot will only load where a mismatch is explicitly allowed.
+        //
+        std::wstring imageName;
+        ULONG imageTimeStamp = 0;
+        ULONG64 imageSize = 0;
+        ISvcModule *pModule = m_pSymbolSet->GetModule();
+        if (pModule == nullptr || FAILED(GetSnapshotImageIdentity(pModule, &imageName, &imageTimeStamp, &imageSize)))
+        {
+            imageName.clear();
+            imageTimeStamp = 0;
+            imageSize = 0;
+        }
+        ULONG64 imageNameOffset = AddString(imageName);
+
+        *pHeader = { };
+        pHeader->Signature = SnapshotSignature;
+        pHeader->Version = SnapshotVersion;
+        pHeader->RecordSize = sizeof(SnapshotRecord);
+        pHeader->LocationSize = sizeof(SvcSymbolLocation);
+        pHeader->RecordCount = m_records.size();
+        pHeader->RecordsOffset = sizeof(SnapshotHeader);
+        pHeader->ExtraOffset = pHeader->RecordsOffset + m_records.size() * sizeof(SnapshotRecord);
+        pHeader->ExtraSize = m_extra.size() * sizeof(ULONG64);
+        pHeader->StringsOffset = pHeader->ExtraOffset + pHeader->ExtraSize;
+        pHeader->StringsSize = m_strings.size() * sizeof(wchar_t);
+        pHeader->ImageName = imageNameOffset;
+        pHeader->ImageSize = imageSize;
+        pHeader->ImageTimeStamp = imageTimeStamp;
+
+        return hr;
+    };
+    return ConvertException(fn);
+}
+
+HRESULT SymbolSnapshotWriter::WriteToFile(_In_z_ PCWSTR pwszFileName)
+{
+    auto fn = [&]()
+    {
+        HRESULT hr = S_OK;
+
+        SnapshotHeader header;
+        IfFailedReturn(BuildSnapshot(&header));
+
+        handle_ptr spFile;
+        HANDLE hFile = CreateFileW(pwszFileName,
+                                   GENERIC_WRITE,
+                                   0,
+                                   nullptr,
+                                   CREATE_ALWAYS,
+                                   FILE_ATTRIBUTE_NORMAL,
+                                   nullptr);
+        if (hFile == INVALID_HANDLE_VALUE)
+        {
+            return HRESULT_FROM_WIN32(GetLastError());
+        }
+        spFile.reset(hFile);
+
+        auto writeFile = [&](_In_reads_bytes_(size) void const *pData, _In_ size_t size)
+        {
+            BYTE const *pCur = reinterpret_cast<BYTE const *>(pData);
+            while (size > 0)
+            {
+                DWORD chunk = static_cast<DWORD>(std::min(size, static_cast<size_t>(0x40000000)));
+                DWORD written;
+                if (!WriteFile(spFile.get(), pCur, chunk, &written, nullptr))
+                {
+                    return HRESULT_FROM_WIN32(GetLastError());
+                }
+                pCur += written;
+                size -= written;
+            }
+            return S_OK;
+        };
+
+        IfFailedReturn(writeFile(&header, sizeof(header)));
+        IfFailedReturn(writeFile(m_records.data(), m_records.size() * sizeof(SnapshotRecord)));
+        IfFailedReturn(writeFile(m_extra.data(), m_extra.size() * sizeof(ULONG64)));
+        IfFailedReturn(writeFile(m_strings.data(), m_strings.size() * sizeof(wchar_t)));
+
+        return hr;
+    };
+    return ConvertException(fn);
+}
+
+HRESULT SymbolSnapshotWriter::WriteToBuffer(_Out_ std::vector<BYTE> *pBuffer, _Out_opt_ ImportState *pImportState)
+{
+    auto fn = [&]()
+    {
+        HRESULT hr = S_OK;
+        pBuffer->clear();
+
+        SnapshotHeader header;
+        IfFailedReturn(BuildSnapshot(&header, pImportState));
+
+        auto appendBuffer = [&](_In_reads_bytes_(size) void const *pData, _In_ size_t size)
+        {
+            BYTE const *pBytes = reinterpret_cast<BYTE const *>(pData);
+            pBuffer->insert(pBuffer->end(), pBytes, pBytes + size);
+        };
+
+        pBuffer->reserve(static_cast<size_t>(header.StringsOffset + header.StringsSize));
+        appendBuffer(&header, sizeof(header));
+        appendBuffer(m_records.data(), m_records.size() * sizeof(SnapshotRecord));
+        appendBuffer(m_extra.data(), m_extra.size() * sizeof(ULONG64));
+        appendBuffer(m_strings.data(), m_strings.size() * sizeof(wchar_t));
+
+        return hr;
+    };
+    return ConvertException(fn);
+}
+
+HRESULT SymbolSnapshotWriter::SaveImportState(_Out_ ImportState *pImportState)
+{
+    HRESULT hr = S_OK;
+    *pImportState = ImportState();
+
+    ImportState state;
+    if (!m_pSymbolSet->HasImporter() || FAILED(m_pSymbolSet->GetImporter()->GetImportState(&state)))
+    {
+        return S_OK;
+    }
+
+    pImportState->FullGlobalImport = state.FullGlobalImport;
+    pImportState->NameQueries = std::move(state.NameQueries);
+    pImportState->AddressQueries = std::move(state.AddressQueries);
+
+    //
+    // Anything imported which did not make it into the snapshot (e.g.: function types which only a function
+    // refers to, or symbols which have since been deleted) is simply left out.  The importer of the copy
+    // imports it again if it is needed.
+    //
+    for (auto&& kvp : state.ImportedSymbols)
+    {
+        auto it = m_symbolRecords.find(kvp.second);
+        if (it != m_symbolRecords.end() && it->second != RecordInProgress)
+        {
+            pImportState->ImportedSymbols.insert( { kvp.first, it->second } );
+        }
+    }
+
+    for (auto&& kvp : state.DeferredUdts)
+    {
+        auto it = m_symbolRecords.find(kvp.first);
+        if (it != m_symbolRecords.end() && it->second != RecordInProgress)
+        {
+            pImportState->DeferredUdts.insert( { it->second, kvp.second } );
+        }
+    }
+
+    return hr;
+}
+
+HRESULT SymbolSnapshotWriter::AddSymbol(_In_ ULONG64 symbolId)
+{
+    HRESULT hr = S_OK;
+
+    auto it = m_symbolRecords.find(symbolId);
+    if (it != m_symbolRecords.end())
+    {
+        return (it->second == RecordInProgress ? HRESULT_FROM_WIN32(ERROR_CIRCULAR_DEPENDENCY) : S_OK);
+    }
+
+    BaseSymbol *pSymbol = m_pSymbolSet->InternalGetSymbol(symbolId);
+    if (pSymbol == nullptr)
+    {
+        //
+        // Something refers to a symbol which has been deleted.  There is no way to describe that in a snapshot.
+        //
+        return E_INVALIDARG;
+    }
+
+    //
+    // A child is always written as part of its parent so that the order of children is kept.
+    //
+    ULONG64 parentId = pSymbol->InternalGetParentId();
+    if (parentId != 0 && m_symbolRecords.find(parentId) == m_symbolRecords.end())
+    {
+        IfFailedReturn(AddSymbol(parentId));
+        if (m_symbolRecords.find(symbolId) != m_symbolRecords.end())
+        {
+            return S_OK;
+        }
+    }
+
+    m_symbolRecords[symbolId] = RecordInProgress;
+
+    SnapshotRecord record = { };
+    IfFailedReturn(AddReference(parentId, &record.Parent));
+    record.Name = AddString(pSymbol->InternalGetName());
+    record.QualifiedName = AddString(pSymbol->InternalGetQualifiedName());
+    IfFailedReturn(FillRecord(pSymbol, &record));
+
+    m_records.push_back(record);
+    ULONG64 recordNumber = m_records.size();
+    m_symbolRecords[symbolId] = recordNumber;
+
+    if (record.Kind == SnapshotRecordFunctionType)
+    {
+        m_functionTypes.push_back( { recordNumber, symbolId } );
+    }
+
+    //
+    // Add everything the children depend upon before the children themselves.  Otherwise, a type which is a
+    // child of this symbol and used by an earlier child would be written in the middle of the children and the
+    // reloaded children would be in a different order.
+    //
+    std::vector<ULONG64> children = pSymbol->InternalGetChildren();
+    for (ULONG64 childId : children)
+    {
+        BaseSymbol *pChild = m_pSymbolSet->InternalGetSymbol(childId);
+        if (pChild == nullptr)
+        {
+            return E_UNEXPECTED;
+        }
+
+        if (pChild->InternalGetKind() != SvcSymbolType)
+        {
+            ULONG64 typeRecord;
+            IfFailedReturn(AddReference(static_cast<BaseDataSymbol *>(pChild)->InternalGetSymbolTypeId(), &typeRecord));
+        }
+    }
+
+    for (ULONG64 childId : children)
+    {
+        IfFailedReturn(AddSymbol(childId));
+    }
+
+    return hr;
+}
+
+HRESULT SymbolSnapshotWriter::AddReference(_In_ ULONG64 symbolId, _Out_ ULONG64 *pRecord)
+{
+    HRESULT hr = S_OK;
+    *pRecord = 0;
+
+    if (symbolId == 0)
+    {
+        return S_OK;
+    }
+
+    IfFailedReturn(AddSymbol(symbolId));
+
+    ULONG64 record = m_symbolRecords[symbolId];
+    if (record == RecordInProgress)
+    {
+        return HRESULT_FROM_WIN32(ERROR_CIRCULAR_DEPENDENCY);
+    }
+
+    *pRecord = record;
+    return hr;
+}
+
+HRESULT SymbolSnapshotWriter::FillRecord(_In_ BaseSymbol *pSymbol, _Inout_ SnapshotRecord *pRecord)
+{
+    HRESULT hr = S_OK;
+
+    switch(pSymbol->InternalGetKind())
+    {
+        case SvcSymbolType:
+        {
+            BaseTypeSymbol *pTypeSymbol = static_cast<BaseTypeSymbol *>(pSymbol);
+
+            //
+            // Function types do not fill in their type kind.  Ask through the interface.
+            //
+            SvcSymbolTypeKind typeKind;
+            IfFailedReturn(pTypeSymbol->GetTypeKind(&typeKind));
+
+            switch(typeKind)
+            {
+                case SvcSymbolTypeIntrinsic:
+                {
+                    BasicTypeSymbol *pBasicType = static_cast<BasicTypeSymbol *>(pTypeSymbol);
+                    pRecord->Kind = SnapshotRecordBasicType;
+                    pRecord->SubKind = pBasicType->InternalGetIntrinsicKind();
+                    pRecord->Values[0] = pBasicType->InternalGetTypeSize();
+                    break;
+                }
+
+                case SvcSymbolTypeUDT:
+                    //
+                    // The size lets the UDT be created (and used by anything which only needs its size) before
+                    // its members are.
+                    //
+                    pRecord->Kind = SnapshotRecordUdt;
+                    pRecord->Values[0] = pTypeSymbol->InternalGetTypeSize();
+                    break;
+
+                case SvcSymbolTypePointer:
+                {
+                    PointerTypeSymbol *pPointerType = static_cast<PointerTypeSymbol *>(pTypeSymbol);
+                    pRecord->Kind = SnapshotRecordPointer;
+                    pRecord->SubKind = pPointerType->InternalGetPointerKind();
+                    IfFailedReturn(AddReference(pPointerType->InternalGetPointerToTypeId(), &pRecord->Type));
+                    break;
+                }
+
+                case SvcSymbolTypeArray:
+                {
+                    ArrayTypeSymbol *pArrayType = static_cast<ArrayTypeSymbol *>(pTypeSymbol);
+                    pRecord->Kind = SnapshotRecordArray;
+                    pRecord->Values[0] = pArrayType->InternalGetArraySize();
+                    IfFailedReturn(AddReference(pArrayType->InternalGetArrayOfTypeId(), &pRecord->Type));
+                    break;
+                }
+
+                case SvcSymbolTypeTypedef:
+                {
+                    TypedefTypeSymbol *pTypedefType = static_cast<TypedefTypeSymbol *>(pTypeSymbol);
+                    pRecord->Kind = SnapshotRecordTypedef;
+                    IfFailedReturn(AddReference(pTypedefType->InternalGetTypedefOfTypeId(), &pRecord->Type));
+                    break;
+                }
+
+                case SvcSymbolTypeEnum:
+                {
+                    EnumTypeSymbol *pEnumType = static_cast<EnumTypeSymbol *>(pTypeSymbol);
+                    pRecord->Kind = SnapshotRecordEnum;
+                    IfFailedReturn(AddReference(pEnumType->InternalGetEnumBasicTypeId(), &pRecord->Type));
+                    break;
+                }
+
+                case SvcSymbolTypeFunction:
+                    //
+                    // The return and parameter types are filled in by FillFunctionTypes.  They are not dependencies
+                    // of the record.
+                    //
+                    pRecord->Kind = SnapshotRecordFunctionType;
+                    break;
+
+                default:
+                    return E_NOTIMPL;
+            }
+            break;
+        }
+
+        case SvcSymbolField:
+        {
+            UdtPositionalSymbol *pField = static_cast<UdtPositionalSymbol *>(pSymbol);
+            IfFailedReturn(AddReference(pField->InternalGetSymbolTypeId(), &pRecord->Type));
+
+            if (pField->InternalIsConstantValue())
+            {
+                pRecord->Kind = SnapshotRecordConstantField;
+                if (pField->InternalIsIncreasingConstant())
+                {
+                    pRecord->SubKind = VT_EMPTY;
+                }
+                else
+                {
+                    VARIANT const& value = pField->InternalGetSymbolValue();
+                    pRecord->SubKind = value.vt;
+                    pRecord->Values[0] = value.ullVal;
+                }
+            }
+            else
+            {
+                pRecord->Kind = SnapshotRecordField;
+                pRecord->Values[0] = pField->InternalGetSymbolOffset();
+                pRecord->Values[1] = pField->InternalGetBitFieldLength();
+                pRecord->Values[2] = pField->InternalGetBitFieldPosition();
+            }
+            break;
+        }
+
+        case SvcSymbolBaseClass:
+        {
+            BaseClassSymbol *pBaseClass = static_cast<BaseClassSymbol *>(pSymbol);
+            pRecord->Kind = SnapshotRecordBaseClass;
+            pRecord->Values[0] = pBaseClass->InternalGetSymbolOffset();
+            IfFailedReturn(AddReference(pBaseClass->InternalGetSymbolTypeId(), &pRecord->Type));
+            break;
+        }
+
+        case SvcSymbolData:
+        {
+            GlobalDataSymbol *pGlobalData = static_cast<GlobalDataSymbol *>(pSymbol);
+            pRecord->Kind = SnapshotRecordGlobalData;
+            pRecord->Values[0] = pGlobalData->InternalGetSymbolOffset();
+            IfFailedReturn(AddReference(pGlobalData->InternalGetSymbolTypeId(), &pRecord->Type));
+            break;
+        }
+
+        case SvcSymbolFunction:
+        {
+            FunctionSymbol *pFunction = static_cast<FunctionSymbol *>(pSymbol);
+            auto&& addressRanges = pFunction->InternalGetAddressRanges();
+            if (addressRanges.empty())
+            {
+                return E_UNEXPECTED;
+            }
+
+            pRecord->Kind = SnapshotRecordFunction;
+            pRecord->Values[0] = addressRanges[0].first;
+            pRecord->Values[1] = addressRanges[0].second;
+            IfFailedReturn(AddReference(pFunction->InternalGetReturnTypeId(), &pRecord->Type));
+            break;
+        }
+
+        case SvcSymbolDataParameter:
+        case SvcSymbolDataLocal:
+        {
+            VariableSymbol *pVariable = static_cast<VariableSymbol *>(pSymbol);
+            pRecord->Kind = SnapshotRecordVariable;
+            pRecord->SubKind = pVariable->InternalGetKind();
+            IfFailedReturn(AddReference(pVariable->InternalGetSymbolTypeId(), &pRecord->Type));
+
+            auto&& liveRanges = pVariable->InternalGetLiveRanges();
+            pRecord->ExtraOffset = m_extra.size() * sizeof(ULONG64);
+            pRecord->ExtraCount = liveRanges.size();
+            for (VariableSymbol::LiveRange const *pLiveRange : liveRanges)
+            {
+                SnapshotLiveRange liveRange = { };
+                liveRange.Offset = pLiveRange->Offset;
+                liveRange.Size = pLiveRange->Size;
+                liveRange.Location = pLiveRange->VariableLocation;
+                AddExtra(&liveRange, sizeof(liveRange));
+            }
+            break;
+        }
+
+        case SvcSymbolPublic:
+        {
+            PublicSymbol *pPublic = static_cast<PublicSymbol *>(pSymbol);
+            pRecord->Kind = SnapshotRecordPublic;
+            pRecord->Values[0] = pPublic->InternalGetOffset();
+            break;
+        }
+
+        default:
+            return E_NOTIMPL;
+    }
+
+    return hr;
+}
+
+HRESULT SymbolSnapshotWriter::FillFunctionTypes()
+{
+    HRESULT hr = S_OK;
+
+    //
+    // Filling in a function type may add further records (including other function types).  Do not hold an
+    // iterator across that.
+    //
+    for (size_t i = 0; i < m_functionTypes.size(); ++i)
+    {
+        ULONG64 recordNumber = m_functionTypes[i].first;
+        FunctionTypeSymbol *pFunctionType =
+            static_cast<FunctionTypeSymbol *>(m_pSymbolSet->InternalGetSymbol(m_functionTypes[i].second));
+
+        ULONG64 returnTypeRecord;
+        IfFailedReturn(AddReference(pFunctionType->InternalGetReturnTypeId(), &returnTypeRecord));
+
+        std::vector<ULONG64> parameterTypeRecords;
+        for (ULONG64 parameterTypeId : pFunctionType->InternalGetParameterTypes())
+        {
+            ULONG64 parameterTypeRecord;
+            IfFailedReturn(AddReference(parameterTypeId, &parameterTypeRecord));
+            parameterTypeRecords.push_back(parameterTypeRecord);
+        }
+
+        SnapshotRecord& record = m_records[static_cast<size_t>(recordNumber - 1)];
+        record.Type = returnTypeRecord;
+        record.ExtraOffset = AddExtra(parameterTypeRecords.data(), parameterTypeRecords.size() * sizeof(ULONG64));
+        record.ExtraCount = parameterTypeRecords.size();
+    }
+
+    return hr;
+}
+
+ULONG64 SymbolSnapshotWriter::AddString(_In_ std::wstring const& str)
+{
+    auto it = m_stringOffsets.find(str);
+    if (it != m_stringOffsets.end())
+    {
+        return it->second;
+    }
+
+    ULONG64 offset = m_strings.size() * sizeof(wchar_t);
+    m_strings.insert(m_strings.end(), str.begin(), str.end());
+    m_strings.push_back(L'\0');
+    m_stringOffsets.insert( { str, offset } );
+    return offset;
+}
+
+ULONG64 SymbolSnapshotWriter::AddExtra(_In_reads_bytes_(size) void const *pData, _In_ size_t size)
+{
+    ULONG64 offset = m_extra.size() * sizeof(ULONG64);
+    size_t start = m_extra.size();
+    m_extra.resize(start + (size + sizeof(ULONG64) - 1) / sizeof(ULONG64));
+    if (size > 0)
+    {
+        memcpy(&m_extra[start], pData, size);
+    }
+    return offset;
+}
+
+//*************************************************
+// Snapshot Reader:
+//
+
+HRESULT SymbolSnapshotReader::ReadFromFile(_In_z_ PCWSTR pwszFileName)
+{
+    auto fn = [&]()
+    {
+        HRESULT hr = S_OK;
+
+        handle_ptr spFile;
+        HANDLE hFile = CreateFileW(pwszFileName,
+                                   GENERIC_READ,
+                                   FILE_SHARE_READ,
+                                   nullptr,
+                                   OPEN_EXISTING,
+                                   FILE_ATTRIBUTE_NORMAL,
+                                   nullptr);
+        if (hFile == INVALID_HANDLE_VALUE)
+        {
+            return HRESULT_FROM_WIN32(GetLastError());
+        }
+        spFile.reset(hFile);
+
+        LARGE_INTEGER fileSize;
+        if (!GetFileSizeEx(spFile.get(), &fileSize))
+        {
+            return HRESULT_FROM_WIN32(GetLastError());
+        }
+
+        if (static_cast<ULONG64>(fileSize.QuadPart) < sizeof(SnapshotHeader) ||
+            static_cast<ULONG64>(fileSize.QuadPart) > std::numeric_limits<size_t>::max())
+        {
+            return E_INVALIDARG;
+        }
+
+        handle_ptr spMapping;
+        HANDLE hMapping = CreateFileMappingW(spFile.get(), nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (hMapping == nullptr)
+        {
+            return HRESULT_FROM_WIN32(GetLastError());
+        }
+        spMapping.reset(hMapping);
+
+        mappedview_ptr spView(MapViewOfFile(spMapping.get(), FILE_MAP_READ, 0, 0, 0));
+        if (spView == nullptr)
+        {
+            return HRESULT_FROM_WIN32(GetLastError());
+        }
+
+        //
+        // Members created while the snapshot is being loaded (e.g.: because an array of a UDT needs its layout)
+        // must not release the snapshot even if they happen to be the last ones deferred at the time.
+        //
+        m_loading = true;
+        hr = LoadSnapshot(reinterpret_cast<BYTE const *>(spView.get()), fileSize.QuadPart);
+        m_loading = false;
+        IfFailedReturn(hr);
+
+        //
+        // The mapping handle and file can be closed.  The view stays valid until it is unmapped.
+        //
+        if (HasDeferredMembers())
+        {
+            m_spView = std::move(spView);
+        }
+        return hr;
+    };
+    return ConvertException(fn);
+}
+
+HRESULT SymbolSnapshotReader::ReadFromBuffer(_In_ std::shared_ptr<std::vector<BYTE> const> const& spBuffer)
+{
+    if (spBuffer == nullptr || spBuffer->size() < sizeof(SnapshotHeader))
+    {
+        return E_INVALIDARG;
+    }
+
+    return ConvertException([&](){
+        HRESULT hr = S_OK;
+
+        m_loading = true;
+        hr = LoadSnapshot(spBuffer->data(), spBuffer->size());
+        m_loading = false;
+        IfFailedReturn(hr);
+
+        if (HasDeferredMembers())
+        {
+            m_spBuffer = spBuffer;
+        }
+        return hr;
+    });
+}
+
+HRESULT SymbolSnapshotReader::LoadSnapshot(_In_reads_bytes_(viewSize) BYTE const *pView, _In_ ULONG64 viewSize)
+{
+    HRESULT hr = S_OK;
+
+    SnapshotHeader const *pHeader = reinterpret_cast<SnapshotHeader const *>(pView);
+    if (pHeader->Signature != SnapshotSignature ||
+        pHeader->Version != SnapshotVersion ||
+        pHeader->RecordSize != sizeof(SnapshotRecord) ||
+        pHeader->LocationSize != sizeof(SvcSymbolLocation))
+    {
+        return E_INVALIDARG;
+    }
+
+    //
+    // Every region must be within the file and suitably aligned.  The string table must end in a null terminator
+    // so that any string within it is terminated.
+    //
+    auto validRegion = [viewSize](_In_ ULONG64 offset, _In_ ULONG64 size, _In_ ULONG64 alignment)
+    {
+        return (offset % alignment == 0 && offset <= viewSize && size <= viewSize - offset);
+    };
+
+    if (pHeader->RecordCount > viewSize / sizeof(SnapshotRecord) ||
+        !validRegion(pHeader->RecordsOffset, pHeader->RecordCount * sizeof(SnapshotRecord), sizeof(ULONG64)) ||
+        !validRegion(pHeader->ExtraOffset, pHeader->ExtraSize, sizeof(ULONG64)) ||
+        !validRegion(pHeader->StringsOffset, pHeader->StringsSize, sizeof(wchar_t)) ||
+        pHeader->StringsSize < sizeof(wchar_t) ||
+        pHeader->StringsSize % sizeof(wchar_t) != 0)
+    {
+        return E_INVALIDARG;
+    }
+
+    SnapshotRecord const *pRecords = reinterpret_cast<SnapshotRecord const *>(pView + pHeader->RecordsOffset);
+    m_pExtra = pView + pHeader->ExtraOffset;
+    m_extraSize = pHeader->ExtraSize;
+    m_pStrings = reinterpret_cast<wchar_t const *>(pView + pHeader->StringsOffset);
+    m_stringsSize = pHeader->StringsSize;
+
+    if (m_pStrings[m_stringsSize / sizeof(wchar_t) - 1] != L'\0')
+    {
+        return E_INVALIDARG;
+    }
+
+    if (!m_allowImageMismatch)
+    {
+        IfFailedReturn(CheckImageIdentity(pHeader));
+    }
+
+    m_pRecords = pRecords;
+    m_recordIds.reserve(static_cast<size_t>(pHeader->RecordCount));
+
+    //
+    // Load everything within a single batch so that each type is laid out once after all of its fields exist and
+    // so that caches are invalidated once.
+    //
+    SymbolSetBatch batch(m_pSymbolSet);
+
+    for (ULONG64 i = 0; i < pHeader->RecordCount; ++i)
+    {
+        ULONG64 symbolId;
+        IfFailedReturn(LoadOrDeferRecord(i + 1, &symbolId));
+        m_recordIds.push_back(symbolId);
+    }
+
+    //
+    // Now that every record has a symbol, fill in the function types.
+    //
+    for (ULONG64 i = 0; i < pHeader->RecordCount; ++i)
+    {
+        SnapshotRecord const& record = pRecords[i];
+        if (record.Kind != SnapshotRecordFunctionType)
+        {
+            continue;
+        }
+
+        FunctionTypeSymbol *pFunctionType =
+            static_cast<FunctionTypeSymbol *>(m_pSymbolSet->InternalGetSymbol(m_recordIds[static_cast<size_t>(i)]));
+
+        BYTE const *pExtra;
+        IfFailedReturn(GetExtra(record, sizeof(ULONG64), &pExtra));
+
+        //
+        // A function type may refer to a record which follows it.  Every record has been through LoadOrDeferRecord
+        // by now, so GetSymbolId checks against all records and not just those preceding it.
+        //
+        std::vector<ULONG64> parameterTypes;
+        for (ULONG64 p = 0; p < record.ExtraCount; ++p)
+        {
+            ULONG64 parameterTypeRecord;
+            memcpy(&parameterTypeRecord, pExtra + p * sizeof(ULONG64), sizeof(ULONG64));
+
+            ULONG64 parameterTypeId;
+            if (parameterTypeRecord == 0)
+            {
+                return E_INVALIDARG;
+            }
+            IfFailedReturn(GetSymbolId(parameterTypeRecord, &parameterTypeId));
+            parameterTypes.push_back(parameterTypeId);
+        }
+
+        ULONG64 returnTypeId;
+        IfFailedReturn(GetSymbolId(record.Type, &returnTypeId));
+
+        pFunctionType->InternalSetReturnType(returnTypeId);
+        IfFailedReturn(pFunctionType->InternalSetParameterTypes(parameterTypes.size(),
+                                                                parameterTypes.empty() ? nullptr : parameterTypes.data()));
+    }
+
+    IfFailedReturn(batch.Commit());
+
+    //
+    // Nothing is needed from the snapshot after this unless there are members still to create.
+    //
+    if (!HasDeferredMembers())
+    {
+        m_pRecords = nullptr;
+        m_pExtra = nullptr;
+        m_extraSize = 0;
+        m_pStrings = nullptr;
+        m_stringsSize = 0;
+    }
+    return hr;
+}
+
+HRESULT SymbolSnapshotReader::CheckImageIdentity(_In_ SnapshotHeader const *pHeader) const
+{
+    HRESULT hr = S_OK;
+
+    PCWSTR pwszImageName;
+    IfFailedReturn(GetString(pHeader->ImageName, false, &pwszImageName));
+
+    std::wstring imageName;
+    ULONG imageTimeStamp;
+    ULONG64 imageSize;
+    ISvcModule *pModule = m_pSymbolSet->GetModule();
+    if (pModule == nullptr || FAILED(GetSnapshotImageIdentity(pModule, &imageName, &imageTimeStamp, &imageSize)))
+    {
+        return HRESULT_FROM_WIN32(ERROR_REVISION_MISMATCH);
+    }
+
+    //
+    // The symbols of one build of a module are meaningless for any other: the offsets of functions, globals, and
+    // publics would all be wrong.
+    //
+    if (*pwszImageName == L'\0' ||
+        _wcsicmp(pwszImageName, imageName.c_str()) != 0 ||
+        pHeader->ImageTimeStamp != imageTimeStamp ||
+        pHeader->ImageSize != imageSize)
+    {
+        return HRESULT_FROM_WIN32(ERROR_REVISION_MISMATCH);
+    }
+
+    return hr;
+}
+
+HRESULT SymbolSnapshotReader::LoadOrDeferRecord(_In_ ULONG64 recordNumber, _Out_ ULONG64 *pSymbolId)
+{
+    HRESULT hr = S_OK;
+    *pSymbolId = 0;
+
+    SnapshotRecord const& record = m_pRecords[static_cast<size_t>(recordNumber - 1)];
+    if (record.Parent != 0 && record.Parent < recordNumber)
+    {
+        auto it = m_deferredMembers.find(m_recordIds[static_cast<size_t>(record.Parent - 1)]);
+        if (it != m_deferredMembers.end())
+        {
+            if (record.Kind == SnapshotRecordField ||
+                record.Kind == SnapshotRecordConstantField ||
+                record.Kind == SnapshotRecordBaseClass)
+            {
+                it->second.push_back(recordNumber);
+                return S_OK;
+            }
+
+            //
+            // Anything else which is a child of the UDT (e.g.: a nested type) must follow the members which
+            // precede it.  Create those now.  The members which follow it are then created as they come.
+            //
+            IfFailedReturn(UdtTypeSymbol::EnsureMembersOf(m_pSymbolSet->InternalGetSymbol(it->first)));
+        }
+    }
+
+    return LoadRecord(recordNumber, pSymbolId);
+}
+
+HRESULT SymbolSnapshotReader::LoadMembers(_In_ ULONG64 udtId)
+{
+    auto it = m_deferredMembers.find(udtId);
+    if (it == m_deferredMembers.end())
+    {
+        return S_FALSE;
+    }
+
+    std::vector<ULONG64> memberRecords = std::move(it->second);
+    m_deferredMembers.erase(it);
+
+    //
+    // The UDT may have been deleted since it was loaded.
+    //
+    HRESULT hr = S_FALSE;
+    if (m_pSymbolSet->InternalGetSymbol(udtId) != nullptr)
+    {
+        //
+        // As with an importer filling in deferred members, this may happen at type query time and we *CANNOT*
+        // send a cache invalidation.  Filling in the members of a type which already exists is not a change anyone
+        // else needs to know about.  The members are added in a batch so that the UDT is laid out once.
+        //
+        bool cacheInvalidationDisabled = m_pSymbolSet->IsCacheInvalidationDisabled();
+        m_pSymbolSet->SetCacheInvalidationDisable(true);
+
+        hr = ConvertException([&](){
+            HRESULT hr = S_OK;
+            SymbolSetBatch batch(m_pSymbolSet);
+            for (ULONG64 recordNumber : memberRecords)
+            {
+                ULONG64 symbolId;
+                IfFailedReturn(LoadRecord(recordNumber, &symbolId));
+                m_recordIds[static_cast<size_t>(recordNumber - 1)] = symbolId;
+            }
+            IfFailedReturn(batch.Commit());
+            return hr;
+        });
+
+        m_pSymbolSet->SetCacheInvalidationDisable(cacheInvalidationDisabled);
+    }
+
+    if (!m_loading && !HasDeferredMembers())
+    {
+        ReleaseSnapshot();
+    }
+    return hr;
+}
+
+void SymbolSnapshotReader::ReleaseSnapshot()
+{
+    m_pRecords = nullptr;
+    m_pExtra = nullptr;
+    m_extraSize = 0;
+    m_pStrings = nullptr;
+    m_stringsSize = 0;
+    m_spView.reset();
+    m_spBuffer.reset();
+    std::vector<ULONG64>().swap(m_recordIds);
+}
+
+HRESULT SymbolSnapshotReader::LoadRecord(_In_ ULONG64 recordNumber, _Out_ ULONG64 *pSymbolId)
+{
+    HRESULT hr = S_OK;
+    *pSymbolId = 0;
+
+    SnapshotRecord const& record = m_pRecords[static_cast<size_t>(recordNumber - 1)];
+
+    //
+    // Records may only refer to records which precede them.  Deferred members are created after every record has
+    // been loaded, so this cannot be left to GetSymbolId.
+    //
+    if (record.Parent >= recordNumber || (record.Kind != SnapshotRecordFunctionType && record.Type >= recordNumber))
+    {
+        return E_INVALIDARG;
+    }
+
+    ULONG64 parentId;
+    IfFailedReturn(GetSymbolId(record.Parent, &parentId));
+
+    PCWSTR pwszName;
+    PCWSTR pwszQualifiedName;
+    IfFailedReturn(GetString(record.Name, false, &pwszName));
+    IfFailedReturn(GetString(record.QualifiedName, true, &pwszQualifiedName));
+
+    ULONG64 typeId = 0;
+    if (record.Kind != SnapshotRecordFunctionType)
+    {
+        IfFailedReturn(GetSymbolId(record.Type, &typeId));
+    }
+
+    switch(record.Kind)
+    {
+        case SnapshotRecordBasicType:
+        {
+            if (record.Values[0] > std::numeric_limits<ULONG>::max())
+            {
+                return E_INVALIDARG;
+            }
+
+            ComPtr<BasicTypeSymbol> spBasicType;
+            IfFailedReturn(MakeAndInitialize<BasicTypeSymbol>(&spBasicType,
+                                                              m_pSymbolSet,
+                                                              static_cast<SvcSymbolIntrinsicKind>(record.SubKind),
+                                                              static_cast<ULONG>(record.Values[0]),
+                                                              pwszName));
+            *pSymbolId = spBasicType->InternalGetId();
+            break;
+        }
+
+        case SnapshotRecordUdt:
+        {
+            ComPtr<UdtTypeSymbol> spUdtType;
+            IfFailedReturn(MakeAndInitialize<UdtTypeSymbol>(&spUdtType, m_pSymbolSet, parentId, pwszName, pwszQualifiedName));
+
+            //
+            // The members are created by LoadMembers when something first needs them.  Until then, the UDT has the
+            // size it was saved with.
+            //
+            m_deferredMembers.insert( { spUdtType->InternalGetId(), std::vector<ULONG64>() } );
+            spUdtType->InternalDeferMembers(record.Values[0]);
+
+            *pSymbolId = spUdtType->InternalGetId();
+            break;
+        }
+
+        case SnapshotRecordPointer:
+        {
+            ComPtr<PointerTypeSymbol> spPointerType;
+            IfFailedReturn(MakeAndInitialize<PointerTypeSymbol>(&spPointerType,
+                                                                m_pSymbolSet,
+                                                                typeId,
+                                                                static_cast<SvcSymbolPointerKind>(record.SubKind)));
+            *pSymbolId = spPointerType->InternalGetId();
+            break;
+        }
+
+        case SnapshotRecordArray:
+        {
+            ComPtr<ArrayTypeSymbol> spArrayType;
+            IfFailedReturn(MakeAndInitialize<ArrayTypeSymbol>(&spArrayType, m_pSymbolSet, typeId, record.Values[0]));
+            *pSymbolId = spArrayType->InternalGetId();
+            break;
+        }
+
+        case SnapshotRecordTypedef:
+        {
+            ComPtr<TypedefTypeSymbol> spTypedefType;
+            IfFailedReturn(MakeAndInitialize<TypedefTypeSymbol>(&spTypedefType,
+                                                                m_pSymbolSet,
+                                                                typeId,
+                                                                parentId,
+                                                                pwszName,
+                                                                pwszQualifiedName));
+            *pSymbolId = spTypedefType->InternalGetId();
+            break;
+        }
+
+        case SnapshotRecordEnum:
+        {
+            ComPtr<EnumTypeSymbol> spEnumType;
+            IfFailedReturn(MakeAndInitialize<EnumTypeSymbol>(&spEnumType,
+                                                             m_pSymbolSet,
+                                                             typeId,
+                                                             parentId,
+                                                             pwszName,
+                                                             pwszQualifiedName));
+            *pSymbolId = spEnumType->InternalGetId();
+            break;
+        }
+
+        case SnapshotRecordFunctionType:
+        {
+            ComPtr<FunctionTypeSymbol> spFunctionType;
+            IfFailedReturn(MakeAndInitialize<FunctionTypeSymbol>(&spFunctionType, m_pSymbolSet));
+            *pSymbolId = spFunctionType->InternalGetId();
+            break;
+        }
+
+        case SnapshotRecordField:
+        {
+            ComPtr<FieldSymbol> spField;
+            IfFailedReturn(MakeAndInitialize<FieldSymbol>(&spField,
+                                                          m_pSymbolSet,
+                                                          parentId,
+                                                          record.Values[0],
+                                                          typeId,
+                                                          pwszName,
+                                                          record.Values[1],
+                                                          record.Values[2]));
+            *pSymbolId = spField->InternalGetId();
+            break;
+        }
+
+        case SnapshotRecordConstantField:
+        {
+            //
+            // The field only accepts simple numeric variants (or VT_EMPTY for an automatically increasing
+            // enumerant).  No VariantClear is needed.
+            //
+            VARIANT value;
+            value.vt = static_cast<VARTYPE>(record.SubKind);
+            value.ullVal = record.Values[0];
+
+            ComPtr<FieldSymbol> spField;
+            IfFailedReturn(MakeAndInitialize<FieldSymbol>(&spField, m_pSymbolSet, parentId, typeId, &value, pwszName));
+            *pSymbolId = spField->InternalGetId();
+            break;
+        }
+
+        case SnapshotRecordBaseClass:
+        {
+            ComPtr<BaseClassSymbol> spBaseClass;
+            IfFailedReturn(MakeAndInitialize<BaseClassSymbol>(&spBaseClass, m_pSymbolSet, parentId, record.Values[0], typeId));
+            *pSymbolId = spBaseClass->InternalGetId();
+            break;
+        }
+
+        case SnapshotRecordGlobalData:
+        {
+            ComPtr<GlobalDataSymbol> spGlobalData;
+            IfFailedReturn(MakeAndInitialize<GlobalDataSymbol>(&spGlobalData,
+                                                               m_pSymbolSet,
+                                                               parentId,
+                                                               record.Values[0],
+                                                               typeId,
+                                                               pwszName,
+                                                               pwszQualifiedName));
+            *pSymbolId = spGlobalData->InternalGetId();
+            break;
+        }
+
+        case SnapshotRecordFunction:
+        {
+            ComPtr<FunctionSymbol> spFunction;
+            IfFailedReturn(MakeAndInitialize<FunctionSymbol>(&spFunction,
+                                                             m_pSymbolSet,
+                                                             parentId,
+                                                             typeId,
+                                                             record.Values[0],
+                                                             record.Values[1],
+                                                             pwszName,
+                                                             pwszQualifiedName));
+            *pSymbolId = spFunction->InternalGetId();
+            break;
+        }
+
+        case SnapshotRecordVariable:
+        {
+            SvcSymbolKind variableKind = static_cast<SvcSymbolKind>(record.SubKind);
+            if (variableKind != SvcSymbolDataParameter && variableKind != SvcSymbolDataLocal)
+            {
+                return E_INVALIDARG;
+            }
+
+            ComPtr<VariableSymbol> spVariable;
+            IfFailedReturn(MakeAndInitialize<VariableSymbol>(&spVariable,
+                                                             m_pSymbolSet,
+                                                             variableKind,
+                                                             parentId,
+                                                             typeId,
+                                                             pwszName));
+
+            BYTE const *pExtra;
+            IfFailedReturn(GetExtra(record, sizeof(SnapshotLiveRange), &pExtra));
+
+            for (ULONG64 r = 0; r < record.ExtraCount; ++r)
+            {
+                SnapshotLiveRange liveRange;
+                memcpy(&liveRange, pExtra + r * sizeof(SnapshotLiveRange), sizeof(SnapshotLiveRange));
+
+                ULONG64 liveRangeId;
+                IfFailedReturn(spVariable->AddLiveRange(liveRange.Offset, liveRange.Size, liveRange.Location, &liveRangeId));
+            }
+
+            *pSymbolId = spVariable->InternalGetId();
+            break;
+        }
+
+        case SnapshotRecordPublic:
+        {
+            ComPtr<PublicSymbol> spPublic;
+            IfFailedReturn(MakeAndInitialize<PublicSymbol>(&spPublic, m_pSymbolSet, record.Values[0], pwszName, pwszQualifiedName));
+            *pSymbolId = spPublic->InternalGetId();
+            break;
+        }
+
+        default:
+            return E_INVALIDARG;
+    }
+
+    return hr;
+}
+
+HRESULT SymbolSnapshotReader::LoadImportState(_Inout_ ImportState *pImportState) const
+{
+    auto fn = [&]()
+    {
+        std::unordered_map<ULONG, ULONG64> importedSymbols;
+        for (auto&& kvp : pImportState->ImportedSymbols)
+        {
+            //
+            // A member of a UDT has not been created yet.  It is not imported on its own but only along with its
+            // UDT, so it can be left out.
+            //
+            if (kvp.second != 0 && kvp.second <= m_recordIds.size() &&
+                m_recordIds[static_cast<size_t>(kvp.second - 1)] == 0)
+            {
+                continue;
+            }
+
+            ULONG64 symbolId;
+            if (kvp.second == 0 || FAILED(GetSymbolId(kvp.second, &symbolId)))
+            {
+                return E_INVALIDARG;
+            }
+            importedSymbols.insert( { kvp.first, symbolId } );
+        }
+
+        std::unordered_map<ULONG64, ULONG> deferredUdts;
+        for (auto&& kvp : pImportState->DeferredUdts)
+        {
+            ULONG64 symbolId;
+            if (kvp.first == 0 || FAILED(GetSymbolId(kvp.first, &symbolId)))
+            {
+                return E_INVALIDARG;
+            }
+            deferredUdts.insert( { symbolId, kvp.second } );
+        }
+
+        pImportState->ImportedSymbols = std::move(importedSymbols);
+        pImportState->DeferredUdts = std::move(deferredUdts);
+        return S_OK;
+    };
+    return ConvertException(fn);
+}
+
+HRESULT SymbolSnapshotReader::GetSymbolId(_In_ ULONG64 record, _Out_ ULONG64 *pSymbolId) const
+{
+    *pSymbolId = 0;
+
+    if (record == 0)
+    {
+        return S_OK;
+    }
+
+    //
+    // Records may only refer to records which have already been loaded.  Nothing may refer to a member of a UDT
+    // which has not been created yet.
+    //
+    if (record > m_recordIds.size() || m_recordIds[static_cast<size_t>(record - 1)] == 0)
+    {
+        return E_INVALIDARG;
+    }
+
+    *pSymbolId = m_recordIds[static_cast<size_t>(record - 1)];
+    return S_OK;
+}
+
+HRESULT SymbolSnapshotReader::GetString(_In_ ULONG64 offset, _In_ bool allowNull, _Out_ PCWSTR *ppwsz) const
+{
+    *ppwsz = nullptr;
+
+    if (offset % sizeof(wchar_t) != 0 || offset >= m_stringsSize)
+    {
+        return E_INVALIDARG;
+    }
+
+    PCWSTR pwsz = m_pStrings + offset / sizeof(wchar_t);
+    if (allowNull && *pwsz == L'\0')
+    {
+        return S_OK;
+    }
+
+    *ppwsz = pwsz;
+    return S_OK;
+}
+
+HRESULT SymbolSnapshotReader::GetExtra(_In_ SnapshotRecord const& record,
+                                       _In_ size_t elementSize,
+                                       _Outptr_result_maybenull_ BYTE const **ppExtra) const
+{
+    *ppExtra = nullptr;
+
+    if (record.ExtraOffset > m_extraSize ||
+        record.ExtraCount > (m_extraSize - record.ExtraOffset) / elementSize)
+    {
+        return E_INVALIDARG;
+    }
+
+    *ppExtra = m_pExtra + record.ExtraOffset;
+    return S_OK;
+}
+
+} // SymbolBuilder
+} // Services
+} // TargetComposition
+} // Debugger
@@ -0,0 +1,424 @@
+//**************************************************************************
+//
+// SymbolSnapshot.h
+//
+// The header for saving a symbol set to (and loading a symbol set from) a binary snapshot
+// file.  A snapshot allows a symbol set which was built by script or imported from another
+// source to be reloaded in a later debugger session without rebuilding it from scratch.
+//
+// The snapshot format is:
+//
+//     SnapshotHeader
+//     SnapshotRecord[RecordCount]         (fixed size; one per saved symbol)
+//     Extra data                          (variable length data referenced from records)
+//     String table                        (null terminated UTF-16 strings)
+//
+// Records are written in dependency order: every record only refers (by 1-based record number) to
+// records which precede it.  The one exception is function types, whose return and parameter types
+// are filled in once all records have been loaded.  This allows a snapshot to be loaded in a single
+// pass directly out of a read only mapped view of the file.
+//
+// The members (fields and base classes) of UDTs are not created when a snapshot is loaded.  Each UDT is
+// created with the size it was saved with and its members are deferred in the same way as an importer
+// defers them (see UdtTypeSymbol::InternalDeferMembers).  They are created from the still mapped snapshot
+// the first time something needs them.
+//
+// A snapshot records the identity (name, time date stamp, and size) of the module image whose symbols it
+// holds and is not loaded for any other image unless the caller explicitly allows it.
+//
+//**************************************************************************
+//
+// Copyright (c) Microsoft Corporation.  All rights reserved.
+//
+//**************************************************************************
+
+#ifndef __SYMBOLSNAPSHOT_H__
+#define __SYMBOLSNAPSHOT_H__
+
+namespace Debugger
+{
+namespace TargetComposition
+{
+namespace Services
+{
+namespace SymbolBuilder
+{
+
+//
+// Forward Declarations:
+//
+class SymbolSet;
+
+//*************************************************
+// Snapshot Format:
+//
+
+// SnapshotSignature / SnapshotVersion:
+//
+// Identifies a symbol builder snapshot file and the version of its format.  Any change to the layout of
+// the structures below must change the version.
+//
+constexpr ULONG SnapshotSignature = 0x53534253;     // 'SBSS'
+constexpr ULONG SnapshotVersion = 2;
+
+// SnapshotRecordKind:
+//
+// Identifies the kind of symbol which a snapshot record describes.
+//
+enum SnapshotRecordKind : ULONG
+{
+    SnapshotRecordBasicType = 1,            // SubKind: intrinsic kind, Values[0]: size
+    SnapshotRecordUdt,                      // Values[0]: size
+    SnapshotRecordPointer,                  // SubKind: pointer kind, Type: pointee
+    SnapshotRecordArray,                    // Type: array of, Values[0]: dimension
+    SnapshotRecordTypedef,                  // Type: typedef of
+    SnapshotRecordEnum,                     // Type: basic type
+    SnapshotRecordFunctionType,             // Type: return type, Extra: ULONG64 parameter type records
+    SnapshotRecordField,                    // Type, Values[0]: offset, Values[1]: bit length, Values[2]: bit position
+    SnapshotRecordConstantField,            // Type (optional), SubKind: VARTYPE, Values[0]: value
+    SnapshotRecordBaseClass,                // Type, Values[0]: offset
+    SnapshotRecordGlobalData,               // Type, Values[0]: offset
+    SnapshotRecordFunction,                 // Type: return type, Values[0]: code offset, Values[1]: code size
+    SnapshotRecordVariable,                 // SubKind: symbol kind, Type, Extra: SnapshotLiveRange
+    SnapshotRecordPublic                    // Values[0]: offset
+};
+
+// SnapshotHeader:
+//
+// The header at the start of every snapshot file.  All offsets are byte offsets from the start of the file.
+//
+struct SnapshotHeader
+{
+    ULONG Signature;                        // SnapshotSignature
+    ULONG Version;                          // SnapshotVersion
+    ULONG RecordSize;                       // sizeof(SnapshotRecord)
+    ULONG LocationSize;                     // sizeof(SvcSymbolLocation)
+    ULONG64 RecordCount;
+    ULONG64 RecordsOffset;
+    ULONG64 ExtraOffset;
+    ULONG64 ExtraSize;
+    ULONG64 StringsOffset;
+    ULONG64 StringsSize;
+    ULONG64 ImageName;                      // String table offset of the module name (zero if unknown)
+    ULONG64 ImageSize;                      // Size of the module image
+    ULONG ImageTimeStamp;                   // Time date stamp of the module image (zero if it has none)
+    ULONG Reserved;
+};
+
+// SnapshotRecord:
+//
+// The description of a single saved symbol.  References to other symbols are 1-based record numbers where
+// zero means "none".  Names are byte offsets into the string table where zero is the empty string.  The extra
+// data for a record is ExtraCount elements starting at byte offset ExtraOffset into the extra data.
+//
+struct SnapshotRecord
+{
+    ULONG Kind;
+    ULONG SubKind;
+    ULONG64 Parent;
+    ULONG64 Type;
+    ULONG64 Name;
+    ULONG64 QualifiedName;
+    ULONG64 Values[3];
+    ULONG64 ExtraOffset;
+    ULONG64 ExtraCount;
+};
+
+// SnapshotLiveRange:
+//
+// The extra data for a variable: one per live range.
+//
+struct SnapshotLiveRange
+{
+    ULONG64 Offset;
+    ULONG64 Size;
+    SvcSymbolLocation Location;
+};
+
+// MappedViewDeleter / mappedview_ptr:
+//
+// Unmaps a mapped view of a snapshot file.
+//
+struct MappedViewDeleter
+{
+    void operator()(_In_ void const *pView)
+    {
+        UnmapViewOfFile(pView);
+    }
+};
+
+typedef std::unique_ptr<void const, MappedViewDeleter> mappedview_ptr;
+
+// GetSnapshotImageIdentity():
+//
+// Gets the name, time date stamp, and size of a module image as recorded in a snapshot.  A module without a
+// time date stamp (e.g.: an ELF image) is identified by its name and size alone.
+//
+HRESULT GetSnapshotImageIdentity(_In_ ISvcModule *pModule,
+                                 _Out_ std::wstring *pImageName,
+                                 _Out_ ULONG *pTimeStamp,
+                                 _Out_ ULONG64 *pImageSize);
+
+//*************************************************
+// Snapshot Writer:
+//
+
+// SymbolSnapshotWriter:
+//
+// Writes the contents of a symbol set to a snapshot file.
+//
+class SymbolSnapshotWriter
+{
+public:
+
+    SymbolSnapshotWriter(_In_ SymbolSet *pSymbolSet) :
+        m_pSymbolSet(pSymbolSet)
+    {
+    }
+
+    // WriteToFile():
+    //
+    // Writes a snapshot of every symbol in the symbol set to the given file (replacing it if it exists).  Function
+    // types are only written if something other than a function refers to them.  A function recreates its own
+    // function type when it is loaded.
+    //
+    HRESULT WriteToFile(_In_z_ PCWSTR pwszFileName);
+
+    // WriteToBuffer():
+    //
+    // Writes a snapshot of every symbol in the symbol set to memory in the same form as WriteToFile.  If
+    // 'pImportState' is given, it receives what the importer of the symbol set (if any) has imported as of the
+    // snapshot with each symbol given by its record number rather than its id.  Anything the importer imported
+    // which is not in the snapshot is left out.
+    //
+    HRESULT WriteToBuffer(_Out_ std::vector<BYTE> *pBuffer, _Out_opt_ ImportState *pImportState = nullptr);
+
+private:
+
+    // BuildSnapshot():
+    //
+    // Builds the records, extra data, and string table for every symbol in the symbol set and fills in the
+    // header which describes them.  If 'pImportState' is given, the import state is taken as of the same state
+    // of the symbol set.
+    //
+    HRESULT BuildSnapshot(_Out_ SnapshotHeader *pHeader, _Out_opt_ ImportState *pImportState = nullptr);
+
+    // SaveImportState():
+    //
+    // Gets the import state of the symbol set with each symbol given by its record number.
+    //
+    HRESULT SaveImportState(_Out_ ImportState *pImportState);
+
+    // AddSymbol():
+    //
+    // Adds a record for the given symbol (and, before it, records for anything it depends upon) if one has
+    // not already been added.  The children of the symbol are added immediately after it in the order they
+    // appear in the symbol.
+    //
+    HRESULT AddSymbol(_In_ ULONG64 symbolId);
+
+    // AddReference():
+    //
+    // Adds a record for a symbol which is referenced by another and returns its record number.  A symbol id of zero
+    // is returned as a record number of zero.
+    //
+    HRESULT AddReference(_In_ ULONG64 symbolId, _Out_ ULONG64 *pRecord);
+
+    // FillRecord():
+    //
+    // Fills in the kind specific portion of a record for the given symbol.
+    //
+    HRESULT FillRecord(_In_ BaseSymbol *pSymbol, _Inout_ SnapshotRecord *pRecord);
+
+    // FillFunctionTypes():
+    //
+    // Fills in the return and parameter types of every function type record once all other records exist.
+    //
+    HRESULT FillFunctionTypes();
+
+    // AddString():
+    //
+    // Adds a string to the string table (if it is not already there) and returns its byte offset.
+    //
+    ULONG64 AddString(_In_ std::wstring const& str);
+
+    // AddExtra():
+    //
+    // Appends data to the extra data (padded to 8 bytes) and returns its byte offset.
+    //
+    ULONG64 AddExtra(_In_reads_bytes_(size) void const *pData, _In_ size_t size);
+
+    // Value of m_symbolRecords for a symbol whose record is being built.
+    static constexpr ULONG64 RecordInProgress = static_cast<ULONG64>(-1ll);
+
+    SymbolSet *m_pSymbolSet;
+
+    // Map of symbol id -> record number
+    std::unordered_map<ULONG64, ULONG64> m_symbolRecords;
+
+    // The function type records: pair< record number, symbol id >
+    std::vector<std::pair<ULONG64, ULONG64>> m_functionTypes;
+
+    std::vector<SnapshotRecord> m_records;
+    std::vector<ULONG64> m_extra;
+    std::vector<wchar_t> m_strings;
+    std::unordered_map<std::wstring, ULONG64> m_stringOffsets;
+};
+
+//*************************************************
+// Snapshot Reader:
+//
+
+// SymbolSnapshotReader:
+//
+// Loads the contents of a snapshot file into a symbol set.  While the members of any UDT have yet to be created,
+// the reader keeps the snapshot mapped (or referenced) and must be owned by the symbol set (see
+// SymbolSet::SetSnapshotReader).
+//
+class SymbolSnapshotReader
+{
+public:
+
+    // SymbolSnapshotReader():
+    //
+    // Constructs a reader for the given symbol set.  Unless 'allowImageMismatch' is true, a snapshot is only
+    // loaded if it was saved for the same module image as the symbol set is for.
+    //
+    SymbolSnapshotReader(_In_ SymbolSet *pSymbolSet, _In_ bool allowImageMismatch = false) :
+        m_pSymbolSet(pSymbolSet),
+        m_allowImageMismatch(allowImageMismatch),
+        m_loading(false)
+    {
+    }
+
+    // ReadFromFile():
+    //
+    // Maps the given snapshot file and creates a symbol for every record within it other than the members of
+    // UDTs.  The symbol set should be empty (created without the basic C types): the basic types are part of
+    // the snapshot.  All layout and cache invalidation is deferred until the whole snapshot has been loaded.
+    //
+    HRESULT ReadFromFile(_In_z_ PCWSTR pwszFileName);
+
+    // ReadFromBuffer():
+    //
+    // Creates a symbol for every record of a snapshot held in memory (as written by WriteToBuffer) other than
+    // the members of UDTs.  The buffer is referenced until those have been created.  The same requirements on
+    // the symbol set apply as for ReadFromFile.
+    //
+    HRESULT ReadFromBuffer(_In_ std::shared_ptr<std::vector<BYTE> const> const& spBuffer);
+
+    // LoadMembers():
+    //
+    // Creates the members of a UDT which were left in the snapshot when it was loaded.  This must be called with
+    // the symbol set held exclusive (see UdtTypeSymbol::EnsureMembers).  If the UDT was not loaded from this
+    // snapshot or its members have already been created, this returns S_FALSE and does nothing.  Once the members
+    // of every UDT have been created, the snapshot is released.
+    //
+    HRESULT LoadMembers(_In_ ULONG64 udtId);
+
+    // HasDeferredMembers():
+    //
+    // Indicates whether the members of any UDT have yet to be created from the snapshot.
+    //
+    bool HasDeferredMembers() const { return !m_deferredMembers.empty(); }
+
+    // GetHeldBufferSize():
+    //
+    // Gets the size of the in memory snapshot (see ReadFromBuffer) held until the deferred members are created.
+    // The buffer is shared with every other reader of it.  A snapshot file is not counted.
+    //
+    size_t GetHeldBufferSize() const { return (m_spBuffer == nullptr ? 0 : m_spBuffer->size()); }
+
+    // LoadImportState():
+    //
+    // Converts an import state saved along with the snapshot by WriteToBuffer (which gives each symbol by its
+    // record number) to one which gives the symbols created for those records.  This must be called after the
+    // snapshot has been read.
+    //
+    HRESULT LoadImportState(_Inout_ ImportState *pImportState) const;
+
+private:
+
+    // LoadSnapshot():
+    //
+    // Validates a mapped snapshot and creates a symbol for every record within it other than the members of
+    // UDTs.
+    //
+    HRESULT LoadSnapshot(_In_reads_bytes_(viewSize) BYTE const *pView, _In_ ULONG64 viewSize);
+
+    // CheckImageIdentity():
+    //
+    // Checks that a snapshot was saved for the module image which the symbol set is for.
+    //
+    HRESULT CheckImageIdentity(_In_ SnapshotHeader const *pHeader) const;
+
+    // LoadOrDeferRecord():
+    //
+    // Creates the symbol for a single record as the snapshot is loaded or, if it is a member of a UDT whose
+    // members are deferred, remembers it for LoadMembers.  A deferred record has a symbol id of zero.
+    //
+    HRESULT LoadOrDeferRecord(_In_ ULONG64 recordNumber, _Out_ ULONG64 *pSymbolId);
+
+    // LoadRecord():
+    //
+    // Creates the symbol for a single record and returns its id.
+    //
+    HRESULT LoadRecord(_In_ ULONG64 recordNumber, _Out_ ULONG64 *pSymbolId);
+
+    // ReleaseSnapshot():
+    //
+    // Releases the snapshot (and everything kept to create deferred members from it).
+    //
+    void ReleaseSnapshot();
+
+    // GetSymbolId():
+    //
+    // Gets the id of the symbol which was created for a given record number.  The record must have already
+    // been loaded.
+    //
+    HRESULT GetSymbolId(_In_ ULONG64 record, _Out_ ULONG64 *pSymbolId) const;
+
+    // GetString():
+    //
+    // Gets a string from the string table of the mapped snapshot.  An empty string is returned as nullptr if
+    // 'allowNull' is true.
+    //
+    HRESULT GetString(_In_ ULONG64 offset, _In_ bool allowNull, _Out_ PCWSTR *ppwsz) const;
+
+    // GetExtra():
+    //
+    // Gets a pointer to the extra data for a record as 'count' elements of 'elementSize' bytes.
+    //
+    HRESULT GetExtra(_In_ SnapshotRecord const& record,
+                     _In_ size_t elementSize,
+                     _Outptr_result_maybenull_ BYTE const **ppExtra) const;
+
+    SymbolSet *m_pSymbolSet;
+    bool m_allowImageMismatch;
+    bool m_loading;
+
+    // What keeps the snapshot regions valid after ReadFromFile / ReadFromBuffer returns (while members are
+    // deferred)
+    mappedview_ptr m_spView;
+    std::shared_ptr<std::vector<BYTE> const> m_spBuffer;
+
+    // The snapshot regions
+    SnapshotRecord const *m_pRecords = nullptr;
+    BYTE const *m_pExtra = nullptr;
+    ULONG64 m_extraSize = 0;
+    wchar_t const *m_pStrings = nullptr;
+    ULONG64 m_stringsSize = 0;
+
+    // Map of record number - 1 -> symbol id (zero for a deferred member)
+    std::vector<ULONG64> m_recordIds;
+
+    // Map of UDT id -> the record numbers of its members which have yet to be created (in order)
+    std::unordered_map<ULONG64, std::vector<ULONG64>> m_deferredMembers;
+};
+
+} // SymbolBuilder
+} // Services
+} // TargetComposition
+} // Debugger
+
+#endif // __SYMBOLSNAPSHOT_H__
@@ -81,8 +81,100 @@ HRESULT UdtPositionalSymbol::MoveToBefore(_In_ ULONG64 position)
 // UDT Symbols:
 //
 
+HRESULT UdtTypeSymbol::EnsureMembers()
+{
+    if (!m_membersDeferred)
+    {
+        return S_OK;
+    }
+
+    //
+    // The import changes the symbol set and must hold it exclusive.  Another thread may have imported the
+    // members while this one waited for the lock.
+    //
+    auto fn = [&]()
+    {
+        SymbolSet *pSymbolSet = InternalGetSymbolSet();
+        SymbolSetForegroundImport foregroundImport(pSymbolSet);
+        SymbolSetExclusiveLock lock(pSymbolSet->GetLock());
+        if (!m_membersDeferred)
+        {
+            return S_OK;
+        }
+
+        //
+        // Clear the deferral before importing anything.  The import adds the members as children of this UDT
+        // and may well come back through here (e.g.: for a member which points back to this UDT).  If the import
+        // fails, we do not keep retrying it on every access.
+        //
+        m_membersDeferred = false;
+
+        //
+        // A UDT loaded from a snapshot has its members created from the snapshot.  Anything else was deferred by
+        // the importer.
+        //
+        if (pSymbolSet->HasSnapshotReader())
+        {
+            HRESULT hrSnapshot = pSymbolSet->GetSnapshotReader()->LoadMembers(InternalGetId());
+            if (hrSnapshot != S_FALSE)
+            {
+                return hrSnapshot;
+            }
+        }
+
+        if (!pSymbolSet->HasImporter())
+        {
+            return E_UNEXPECTED;
+        }
+
+        return pSymbolSet->GetImporter()->ImportMembers(InternalGetId());
+    };
+    return ConvertException(fn);
+}
+
+HRESULT UdtTypeSymbol::EnsureMembersForLayout(_In_ SymbolSet *pSymbolSet, _In_ ULONG64 typeId)
+{
+    BaseSymbol *pSymbol = pSymbolSet->InternalGetSymbol(typeId);
+    while (pSymbol != nullptr && pSymbol->InternalGetKind() == SvcSymbolType)
+    {
+        BaseTypeSymbol *pType = static_cast<BaseTypeSymbol *>(pSymbol);
+
+        SvcSymbolTypeKind typeKind;
+        IfFailedReturn(pType->GetTypeKind(&typeKind));
+
+        switch(typeKind)
+        {
+            case SvcSymbolTypeTypedef:
+                pSymbol = pSymbolSet->InternalGetSymbol(
+                    static_cast<TypedefTypeSymbol *>(pType)->InternalGetTypedefOfTypeId()
+                    );
+                break;
+
+            case SvcSymbolTypeUDT:
+                return EnsureMembersOf(pType);
+
+            default:
+                //
+                // Anything else either does not depend upon the layout of a UDT or (as with an array) already
+                // ensured the members of its element type when it was created.
+                //
+                return S_OK;
+        }
+    }
+
+    return S_OK;
+}
+
 HRESULT UdtTypeSymbol::LayoutType()
 {
+    //
+    // A shell has no members to lay out.  Its size came from the importer which created it.
+    //
+    if (m_membersDeferred)
+    {
+        return S_OK;
+    }
+
     ULONG64 curOffset = 0;
     ULONG64 typeSize = 0;
     ULONG64 curBitFieldPosition = 0;
@@ -392,6 +484,11 @@ HRESULT ArrayTypeSymbol::RuntimeClassInitialize(_In_ SymbolSet *pSymbolSet,
             return E_INVALIDARG;
         }
 
+        //
+        // The alignment of the array is that of its element type.  Make sure that is known.
+        //
+        IfFailedReturn(UdtTypeSymbol::EnsureMembersForLayout(pSymbolSet, arrayOfId));
+
         BaseTypeSymbol *pArrayOfType = static_cast<BaseTypeSymbol *>(pArrayOfSymbol);
         ULONG64 arrayOfTypeSize = pArrayOfType->InternalGetTypeSize();
         ULONG64 arrayOfTypeAlign = pArrayOfType->InternalGetTypeAlignment();
@@ -440,7 +537,7 @@ HRESULT ArrayTypeSymbol::RuntimeClassInitialize(_In_ SymbolSet *pSymbolSet,
     return ConvertException(fn);
 }
 
-HRESULT ArrayTypeSymbol::NotifyDependentChange()
+HRESULT ArrayTypeSymbol::UpdateForDependentChange()
 {
     BaseSymbol *pArrayOfSymbol = InternalGetSymbolSet()->InternalGetSymbol(m_arrayOfTypeId);
     if (pArrayOfSymbol == nullptr || pArrayOfSymbol->InternalGetKind() != SvcSymbolType)
@@ -454,7 +551,7 @@ HRESULT ArrayTypeSymbol::NotifyDependentChange()
     m_typeAlignment = pArrayOfType->InternalGetTypeAlignment();
     m_typeSize = (m_baseTypeSize * m_arrayDim);
 
-    return BaseSymbol::NotifyDependentChange();
+    return S_OK;
 }
 
 HRESULT ArrayTypeSymbol::Delete()
@@ -521,9 +618,49 @@ HRESULT TypedefTypeSymbol::RuntimeClassInitialize(_In_ SymbolSet *pSymbolSet,
 
     m_typeSize = pTypedefOfType->InternalGetTypeSize();
     m_typeAlignment = pTypedefOfType->InternalGetTypeAlignment();
+
+    //
+    // Add a dependency notification between the type we are a typedef of and us.  If the layout of the underlying
+    // type changes, our size and alignment change with it.
+    //
+    IfFailedReturn(pTypedefOfType->AddDependentNotify(InternalGetId()));
+
     return hr;
 }
 
+HRESULT TypedefTypeSymbol::UpdateForDependentChange()
+{
+    BaseSymbol *pTypedefOfSymbol = InternalGetSymbolSet()->InternalGetSymbol(m_typedefOfTypeId);
+    if (pTypedefOfSymbol == nullptr || pTypedefOfSymbol->InternalGetKind() != SvcSymbolType)
+    {
+        return E_INVALIDARG;
+    }
+
+    BaseTypeSymbol *pTypedefOfType = static_cast<BaseTypeSymbol *>(pTypedefOfSymbol);
+
+    m_typeSize = pTypedefOfType->InternalGetTypeSize();
+    m_typeAlignment = pTypedefOfType->InternalGetTypeAlignment();
+
+    return S_OK;
+}
+
+HRESULT TypedefTypeSymbol::Delete()
+{
+    HRESULT hr = S_OK;
+
+    BaseSymbol *pTypedefOfType = InternalGetSymbolSet()->InternalGetSymbol(m_typedefOfTypeId);
+    if (pTypedefOfType != nullptr)
+    {
+        //
+        // Remove a dependency notification between the type we are a typedef of and us.  We are going away and
+        // no longer need the notification.
+        //
+        IfFailedReturn(pTypedefOfType->RemoveDependentNotify(InternalGetId()));
+    }
+
+    return BaseSymbol::Delete();
+}
+
 //*************************************************
 // Enum Symbols:
 //
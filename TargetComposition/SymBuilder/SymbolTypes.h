@@ -323,18 +323,32 @@ class UdtTypeSymbol :
 {
 public:
 
+    //*************************************************
+    // ISvcSymbol:
+    //
+
+    // EnumerateChildren():
+    //
+    // Enumerates all children of the UDT.  If the members of the UDT were deferred by an importer, they are
+    // imported first.
+    //
+    IFACEMETHOD(EnumerateChildren)(_In_ SvcSymbolKind kind,
+                                   _In_opt_z_ PCWSTR pwszName,
+                                   _In_opt_ SvcSymbolSearchInfo *pSearchInfo,
+                                   _COM_Outptr_ ISvcSymbolSetEnumerator **ppChildEnum)
+    {
+        *ppChildEnum = nullptr;
+        IfFailedReturn(EnsureMembers());
+        return BaseSymbol::EnumerateChildren(kind, pwszName, pSearchInfo, ppChildEnum);
+    }
+
     //*************************************************
     // Internal APIs:
     //
 
-    virtual HRESULT NotifyDependentChange()
+    virtual HRESULT UpdateForDependentChange()
     {
-        HRESULT hr = LayoutType();
-        if (SUCCEEDED(hr))
-        {
-            hr = BaseSymbol::NotifyDependentChange();
-        }
-        return hr;
+        return LayoutType();
     }
 
     HRESULT RuntimeClassInitialize(_In_ SymbolSet *pSymbolSet,
@@ -342,18 +356,75 @@ public:
                                    _In_ PCWSTR pwszName,
                                    _In_opt_ PCWSTR pwszQualifiedName)
     {
+        m_membersDeferred = false;
         return BaseInitialize(pSymbolSet, SvcSymbolType, SvcSymbolTypeUDT, parentId, pwszName, pwszQualifiedName);
     }
 
     // LayoutType():
     //
     // Performs a type layout.  This computes everything necessary about a type from its field layout including
-    // the offsets of fields, the size of the type, and any alignment padding necessary.
+    // the offsets of fields, the size of the type, and any alignment padding necessary.  A UDT whose members
+    // are deferred keeps the size it was given by its importer.
     //
     HRESULT LayoutType();
 
+    // InternalDeferMembers():
+    //
+    // Called by an importer (or a snapshot reader) which has created this UDT as a shell (name and size only).
+    // The members are imported through the symbol set's importer (or created from the snapshot) the first time
+    // something needs them.
+    //
+    void InternalDeferMembers(_In_ ULONG64 typeSize)
+    {
+        m_membersDeferred = true;
+        m_typeSize = typeSize;
+    }
+
+    // EnsureMembers():
+    //
+    // If the members of this UDT are deferred, imports them now.  This must be called before anything walks the
+    // children of the UDT or depends upon its layout (as opposed to just its size).
+    //
+    HRESULT EnsureMembers();
+
+    // EnsureMembersForLayout():
+    //
+    // Called when the type with the given id is about to be laid out by value within some other type (e.g.: as
+    // the type of a field or base class).  If that type is (or is a typedef of) a UDT with deferred members, the
+    // members are imported so that its alignment is known.
+    //
+    static HRESULT EnsureMembersForLayout(_In_ SymbolSet *pSymbolSet, _In_ ULONG64 typeId);
+
+    // EnsureMembersOf():
+    //
+    // If the given symbol is a UDT with deferred members, imports them.  Anything which adds a child to a
+    // symbol calls this first so that the imported members always precede anything added later.
+    //
+    static HRESULT EnsureMembersOf(_In_opt_ BaseSymbol *pSymbol)
+    {
+        SvcSymbolTypeKind typeKind;
+        if (pSymbol == nullptr || pSymbol->InternalGetKind() != SvcSymbolType ||
+            FAILED(static_cast<BaseTypeSymbol *>(pSymbol)->GetTypeKind(&typeKind)) ||
+            typeKind != SvcSymbolTypeUDT)
+        {
+            return S_OK;
+        }
+
+        return static_cast<UdtTypeSymbol *>(pSymbol)->EnsureMembers();
+    }
+
+    //*************************************************
+    // Internal Accessors():
+    //
+
+    bool InternalHasDeferredMembers() const { return m_membersDeferred; }
+
 private:
 
+    // Indicates that an importer has not yet imported the members of this UDT.  This is only changed with the
+    // symbol set held exclusive but EnsureMembers checks it before taking any lock.
+    std::atomic<bool> m_membersDeferred;
+
 };
 
 // PointerTypeSymbol:
@@ -442,6 +513,7 @@ public:
     //
     
     ULONG64 InternalGetPointerToTypeId() const { return m_pointerToId; }
+    SvcSymbolPointerKind InternalGetPointerKind() const { return m_pointerKind; }
 
 private:
 
@@ -518,12 +590,12 @@ public:
                                    _In_ ULONG64 arrayOfId,
                                    _In_ ULONG64 arrayDim);
 
-    // NotifyDependentChange():
+    // UpdateForDependentChange():
     //
     // Called if the layout of the underlying type of the array changes, this allows us to recompute the layout
     // of the array itself.
     //
-    virtual HRESULT NotifyDependentChange();
+    virtual HRESULT UpdateForDependentChange();
 
     // Delete():
     //
@@ -584,6 +656,19 @@ public:
                                    _In_ PCWSTR pwszName,
                                    _In_opt_ PCWSTR pwszQualifiedName);
 
+    // UpdateForDependentChange():
+    //
+    // Called if the layout of the type we are a typedef of changes, this allows us to pick up its new size and
+    // alignment.
+    //
+    virtual HRESULT UpdateForDependentChange();
+
+    // Delete():
+    //
+    // Called when this symbol is deleted.
+    //
+    virtual HRESULT Delete();
+
     //*************************************************
     // Internal Accessors():
     //
@@ -647,14 +732,9 @@ public:
     // Internal APIs:
     //
 
-    virtual HRESULT NotifyDependentChange()
+    virtual HRESULT UpdateForDependentChange()
     {
-        HRESULT hr = LayoutEnum();
-        if (SUCCEEDED(hr))
-        {
-            hr = BaseSymbol::NotifyDependentChange();
-        }
-        return hr;
+        return LayoutEnum();
     }
     
     HRESULT RuntimeClassInitialize(_In_ SymbolSet *pSymbolSet,
@@ -1041,6 +1121,13 @@ public:
     HRESULT InternalSetParameterTypes(_In_ ULONG64 paramCount,
                                       _In_reads_(paramCount) ULONG64 *pParamTypes);
 
+    //*************************************************
+    // Internal Accessors():
+    //
+
+    ULONG64 InternalGetReturnTypeId() const { return m_returnType; }
+    std::vector<ULONG64> const& InternalGetParameterTypes() const { return m_paramTypes; }
+
 private:
 
     ULONG64 m_returnType;
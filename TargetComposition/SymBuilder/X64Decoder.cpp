@@ -0,0 +1,902 @@
+//**************************************************************************
+//
+// X64Decoder.cpp
+//
+// The implementation of the small table driven x64 decoder used by the range builder.
+//
+//**************************************************************************
+//
+// Copyright (c) Microsoft Corporation.  All rights reserved.
+//
+//**************************************************************************
+
+//
+// The decoder is built on its own by the X64DecoderTests project and so includes only what it needs rather
+// than SymBuilder.h.
+//
+#include <algorithm>
+#include <iterator>
+#include <utility>
+#include "X64Decoder.h"
+
+namespace Debugger
+{
+namespace TargetComposition
+{
+namespace Services
+{
+namespace SymbolBuilder
+{
+
+namespace
+{
+
+//*************************************************
+// Opcode Tables:
+//
+
+// OperandSpec:
+//
+// How an operand is encoded (following the operand notation of the architecture manuals).
+//
+enum class OperandSpec : unsigned char
+{
+    None,
+    Eb,                 // ModRM r/m: byte
+    Ew,                 // ModRM r/m: word
+    Ed,                 // ModRM r/m: dword
+    Ev,                 // ModRM r/m: operand sized
+    Gb,                 // ModRM reg: byte
+    Gv,                 // ModRM reg: operand sized
+    M,                  // ModRM r/m: memory only
+    Ib,                 // imm8
+    Iw,                 // imm16
+    Iz,                 // imm16/imm32 (sign extended to 64 bits)
+    Iv,                 // imm16/imm32/imm64
+    Jb,                 // rel8
+    Jz,                 // rel32
+    Zb,                 // register in the low bits of the opcode: byte
+    Zv,                 // register in the low bits of the opcode: operand sized
+    AL,                 // al
+    RAX,                // al/ax/eax/rax by operand size
+    CL                  // cl
+};
+
+enum OperandAccess : unsigned char
+{
+    Read = 0x1,
+    Write = 0x2,
+    ReadWrite = 0x3
+};
+
+struct OperandEntry
+{
+    OperandSpec Spec;
+    unsigned char Access;
+};
+
+// OpcodeEntry:
+//
+// Describes an opcode (or a ModRM.reg selected member of an opcode group).
+//
+struct OpcodeEntry
+{
+    bool Valid;
+    NativeInstructionKind Kind;
+    bool IsCall;
+    bool Default64;                 // The operand size defaults to 64 bits (push, pop, near call)
+    bool HideOperands;              // Operands are decoded for length only and are not reported (nop, prefetch)
+    bool AllowRep;                  // An F3 prefix is permitted (rep ret, pause, endbr64)
+    int Group;                      // If not -1, the ModRM.reg field selects the entry from this group
+    OperandEntry Operands[3];
+};
+
+constexpr int NoGroup = -1;
+
+enum OpcodeGroup
+{
+    Group1_Eb_Ib,                   // 80
+    Group1_Ev_Iz,                   // 81
+    Group1_Ev_Ib,                   // 83
+    Group1A_Ev,                     // 8F
+    Group2_Eb_Ib,                   // C0
+    Group2_Ev_Ib,                   // C1
+    Group2_Eb_1,                    // D0
+    Group2_Ev_1,                    // D1
+    Group2_Eb_CL,                   // D2
+    Group2_Ev_CL,                   // D3
+    Group11_Eb_Ib,                  // C6
+    Group11_Ev_Iz,                  // C7
+    Group3_Eb,                      // F6
+    Group3_Ev,                      // F7
+    Group4_Eb,                      // FE
+    Group5_Ev,                      // FF
+    Group8_Ev_Ib,                   // 0F BA
+    GroupHintNop,                   // 0F 1F
+    GroupPrefetch,                  // 0F 18
+    GroupCount
+};
+
+// OpcodeTables:
+//
+// The one byte and two byte (0F) opcode maps and the opcode group tables.
+//
+struct OpcodeTables
+{
+    OpcodeEntry OneByte[256];
+    OpcodeEntry TwoByte[256];
+    OpcodeEntry Groups[GroupCount][8];
+    OpcodeEntry Popcnt;             // F3 0F B8
+};
+
+OpcodeEntry MakeEntry(NativeInstructionKind kind,
+                      OperandEntry op0 = { OperandSpec::None, 0 },
+                      OperandEntry op1 = { OperandSpec::None, 0 },
+                      OperandEntry op2 = { OperandSpec::None, 0 })
+{
+    OpcodeEntry entry = { };
+    entry.Valid = true;
+    entry.Kind = kind;
+    entry.Group = NoGroup;
+    entry.Operands[0] = op0;
+    entry.Operands[1] = op1;
+    entry.Operands[2] = op2;
+    return entry;
+}
+
+OpcodeEntry MakeGroup(int group)
+{
+    OpcodeEntry entry = { };
+    entry.Valid = true;
+    entry.Group = group;
+    return entry;
+}
+
+OpcodeTables BuildOpcodeTables()
+{
+    using K = NativeInstructionKind;
+    using S = OperandSpec;
+
+    OpcodeTables t = { };
+
+    //
+    // 00-3F: The eight classic ALU operations in their six forms each.  Only 'cmp' leaves its first
+    // operand untouched.
+    //
+    static K const aluKinds[8] = { K::Add, K::Other, K::Other, K::Other, K::Other, K::Sub, K::Other, K::Other };
+    for (int op = 0; op < 8; ++op)
+    {
+        unsigned char dst = (op == 7) ? Read : ReadWrite;
+        int base = op * 8;
+        t.OneByte[base + 0] = MakeEntry(aluKinds[op], { S::Eb, dst }, { S::Gb, Read });
+        t.OneByte[base + 1] = MakeEntry(aluKinds[op], { S::Ev, dst }, { S::Gv, Read });
+        t.OneByte[base + 2] = MakeEntry(aluKinds[op], { S::Gb, dst }, { S::Eb, Read });
+        t.OneByte[base + 3] = MakeEntry(aluKinds[op], { S::Gv, dst }, { S::Ev, Read });
+        t.OneByte[base + 4] = MakeEntry(aluKinds[op], { S::AL, dst }, { S::Ib, Read });
+        t.OneByte[base + 5] = MakeEntry(aluKinds[op], { S::RAX, dst }, { S::Iz, Read });
+
+        t.Groups[Group1_Eb_Ib][op] = MakeEntry(aluKinds[op], { S::Eb, dst }, { S::Ib, Read });
+        t.Groups[Group1_Ev_Iz][op] = MakeEntry(aluKinds[op], { S::Ev, dst }, { S::Iz, Read });
+        t.Groups[Group1_Ev_Ib][op] = MakeEntry(aluKinds[op], { S::Ev, dst }, { S::Ib, Read });
+    }
+
+    for (int r = 0; r < 8; ++r)
+    {
+        t.OneByte[0x50 + r] = MakeEntry(K::Push, { S::Zv, Read });
+        t.OneByte[0x50 + r].Default64 = true;
+        t.OneByte[0x58 + r] = MakeEntry(K::Pop, { S::Zv, Write });
+        t.OneByte[0x58 + r].Default64 = true;
+    }
+
+    t.OneByte[0x63] = MakeEntry(K::Other, { S::Gv, Write }, { S::Ed, Read });                    // movsxd
+    t.OneByte[0x68] = MakeEntry(K::Push, { S::Iz, Read });
+    t.OneByte[0x68].Default64 = true;
+    t.OneByte[0x69] = MakeEntry(K::Other, { S::Gv, Write }, { S::Ev, Read }, { S::Iz, Read });    // imul
+    t.OneByte[0x6A] = MakeEntry(K::Push, { S::Ib, Read });
+    t.OneByte[0x6A].Default64 = true;
+    t.OneByte[0x6B] = MakeEntry(K::Other, { S::Gv, Write }, { S::Ev, Read }, { S::Ib, Read });    // imul
+
+    for (int cc = 0; cc < 16; ++cc)
+    {
+        t.OneByte[0x70 + cc] = MakeEntry(K::ConditionalJump, { S::Jb, Read });
+    }
+
+    t.OneByte[0x80] = MakeGroup(Group1_Eb_Ib);
+    t.OneByte[0x81] = MakeGroup(Group1_Ev_Iz);
+    t.OneByte[0x83] = MakeGroup(Group1_Ev_Ib);
+    t.OneByte[0x84] = MakeEntry(K::Other, { S::Eb, Read }, { S::Gb, Read });                     // test
+    t.OneByte[0x85] = MakeEntry(K::Other, { S::Ev, Read }, { S::Gv, Read });                     // test
+    t.OneByte[0x86] = MakeEntry(K::Other, { S::Eb, ReadWrite }, { S::Gb, ReadWrite });           // xchg
+    t.OneByte[0x87] = MakeEntry(K::Other, { S::Ev, ReadWrite }, { S::Gv, ReadWrite });           // xchg
+    t.OneByte[0x88] = MakeEntry(K::Mov, { S::Eb, Write }, { S::Gb, Read });
+    t.OneByte[0x89] = MakeEntry(K::Mov, { S::Ev, Write }, { S::Gv, Read });
+    t.OneByte[0x8A] = MakeEntry(K::Mov, { S::Gb, Write }, { S::Eb, Read });
+    t.OneByte[0x8B] = MakeEntry(K::Mov, { S::Gv, Write }, { S::Ev, Read });
+    t.OneByte[0x8D] = MakeEntry(K::Lea, { S::Gv, Write }, { S::M, Read });
+    t.OneByte[0x8F] = MakeGroup(Group1A_Ev);
+    t.Groups[Group1A_Ev][0] = MakeEntry(K::Pop, { S::Ev, Write });
+    t.Groups[Group1A_Ev][0].Default64 = true;
+
+    t.OneByte[0x90] = MakeEntry(K::Other);                                                          // nop / pause
+    t.OneByte[0x90].AllowRep = true;
+    for (int r = 1; r < 8; ++r)
+    {
+        t.OneByte[0x90 + r] = MakeEntry(K::Other, { S::Zv, ReadWrite }, { S::RAX, ReadWrite });   // xchg
+    }
+    t.OneByte[0x98] = MakeEntry(K::Other);                                                          // cbw/cwde/cdqe
+    t.OneByte[0x99] = MakeEntry(K::Other);                                                          // cwd/cdq/cqo
+    t.OneByte[0xA8] = MakeEntry(K::Other, { S::AL, Read }, { S::Ib, Read });                       // test
+    t.OneByte[0xA9] = MakeEntry(K::Other, { S::RAX, Read }, { S::Iz, Read });                      // test
+
+    for (int r = 0; r < 8; ++r)
+    {
+        t.OneByte[0xB0 + r] = MakeEntry(K::Mov, { S::Zb, Write }, { S::Ib, Read });
+        t.OneByte[0xB8 + r] = MakeEntry(K::Mov, { S::Zv, Write }, { S::Iv, Read });
+    }
+
+    t.OneByte[0xC0] = MakeGroup(Group2_Eb_Ib);
+    t.OneByte[0xC1] = MakeGroup(Group2_Ev_Ib);
+    t.OneByte[0xD0] = MakeGroup(Group2_Eb_1);
+    t.OneByte[0xD1] = MakeGroup(Group2_Ev_1);
+    t.OneByte[0xD2] = MakeGroup(Group2_Eb_CL);
+    t.OneByte[0xD3] = MakeGroup(Group2_Ev_CL);
+    for (int op = 0; op < 8; ++op)
+    {
+        t.Groups[Group2_Eb_Ib][op] = MakeEntry(K::Other, { S::Eb, ReadWrite }, { S::Ib, Read });
+        t.Groups[Group2_Ev_Ib][op] = MakeEntry(K::Other, { S::Ev, ReadWrite }, { S::Ib, Read });
+        t.Groups[Group2_Eb_1][op] = MakeEntry(K::Other, { S::Eb, ReadWrite });
+        t.Groups[Group2_Ev_1][op] = MakeEntry(K::Other, { S::Ev, ReadWrite });
+        t.Groups[Group2_Eb_CL][op] = MakeEntry(K::Other, { S::Eb, ReadWrite }, { S::CL, Read });
+        t.Groups[Group2_Ev_CL][op] = MakeEntry(K::Other, { S::Ev, ReadWrite }, { S::CL, Read });
+    }
+
+    t.OneByte[0xC2] = MakeEntry(K::Return, { S::Iw, Read });
+    t.OneByte[0xC3] = MakeEntry(K::Return);
+    t.OneByte[0xC3].AllowRep = true;
+    t.OneByte[0xC6] = MakeGroup(Group11_Eb_Ib);
+    t.OneByte[0xC7] = MakeGroup(Group11_Ev_Iz);
+    t.Groups[Group11_Eb_Ib][0] = MakeEntry(K::Mov, { S::Eb, Write }, { S::Ib, Read });
+    t.Groups[Group11_Ev_Iz][0] = MakeEntry(K::Mov, { S::Ev, Write }, { S::Iz, Read });
+    t.OneByte[0xCC] = MakeEntry(K::Trap);                                                           // int3
+    t.OneByte[0xCD] = MakeEntry(K::Trap, { S::Ib, Read });                                         // int n (__fastfail)
+
+    t.OneByte[0xE8] = MakeEntry(K::Call, { S::Jz, Read });
+    t.OneByte[0xE8].IsCall = true;
+    t.OneByte[0xE9] = MakeEntry(K::Jump, { S::Jz, Read });
+    t.OneByte[0xEB] = MakeEntry(K::Jump, { S::Jb, Read });
+
+    t.OneByte[0xF6] = MakeGroup(Group3_Eb);
+    t.OneByte[0xF7] = MakeGroup(Group3_Ev);
+    t.Groups[Group3_Eb][0] = t.Groups[Group3_Eb][1] = MakeEntry(K::Other, { S::Eb, Read }, { S::Ib, Read });
+    t.Groups[Group3_Ev][0] = t.Groups[Group3_Ev][1] = MakeEntry(K::Other, { S::Ev, Read }, { S::Iz, Read });
+    for (int op = 2; op < 8; ++op)
+    {
+        unsigned char access = (op < 4) ? ReadWrite : Read;                                         // not/neg vs. mul/div
+        t.Groups[Group3_Eb][op] = MakeEntry(K::Other, { S::Eb, access });
+        t.Groups[Group3_Ev][op] = MakeEntry(K::Other, { S::Ev, access });
+    }
+
+    t.OneByte[0xFE] = MakeGroup(Group4_Eb);
+    t.Groups[Group4_Eb][0] = t.Groups[Group4_Eb][1] = MakeEntry(K::Other, { S::Eb, ReadWrite });   // inc/dec
+    t.OneByte[0xFF] = MakeGroup(Group5_Ev);
+    t.Groups[Group5_Ev][0] = t.Groups[Group5_Ev][1] = MakeEntry(K::Other, { S::Ev, ReadWrite });   // inc/dec
+    t.Groups[Group5_Ev][2] = MakeEntry(K::Call, { S::Ev, Read });                                  // indirect call
+    t.Groups[Group5_Ev][2].IsCall = true;
+    t.Groups[Group5_Ev][2].Default64 = true;
+    t.Groups[Group5_Ev][6] = MakeEntry(K::Push, { S::Ev, Read });
+    t.Groups[Group5_Ev][6].Default64 = true;
+
+    //
+    // Two byte (0F) opcodes:
+    //
+    t.TwoByte[0x0B] = MakeEntry(K::Trap);                                                           // ud2
+    t.TwoByte[0x18] = MakeGroup(GroupPrefetch);
+    t.TwoByte[0x1E] = MakeEntry(K::Other, { S::Ev, Read });                                        // hint nop / endbr64
+    t.TwoByte[0x1E].HideOperands = true;
+    t.TwoByte[0x1E].AllowRep = true;
+    t.TwoByte[0x1F] = MakeGroup(GroupHintNop);
+    for (int op = 0; op < 8; ++op)
+    {
+        t.Groups[GroupHintNop][op] = MakeEntry(K::Other, { S::Ev, Read });
+        t.Groups[GroupHintNop][op].HideOperands = true;
+    }
+    for (int op = 0; op < 4; ++op)
+    {
+        t.Groups[GroupPrefetch][op] = MakeEntry(K::Other, { S::M, Read });
+        t.Groups[GroupPrefetch][op].HideOperands = true;
+    }
+
+    for (int cc = 0; cc < 16; ++cc)
+    {
+        t.TwoByte[0x40 + cc] = MakeEntry(K::Other, { S::Gv, ReadWrite }, { S::Ev, Read });        // cmovcc
+        t.TwoByte[0x80 + cc] = MakeEntry(K::ConditionalJump, { S::Jz, Read });
+        t.TwoByte[0x90 + cc] = MakeEntry(K::Other, { S::Eb, Write });                              // setcc
+    }
+
+    t.TwoByte[0xA3] = MakeEntry(K::Other, { S::Ev, Read }, { S::Gv, Read });                       // bt
+    t.TwoByte[0xAB] = MakeEntry(K::Other, { S::Ev, ReadWrite }, { S::Gv, Read });                  // bts
+    t.TwoByte[0xAF] = MakeEntry(K::Other, { S::Gv, ReadWrite }, { S::Ev, Read });                  // imul
+    t.TwoByte[0xB0] = MakeEntry(K::Other, { S::Eb, ReadWrite }, { S::Gb, Read });                  // cmpxchg
+    t.TwoByte[0xB1] = MakeEntry(K::Other, { S::Ev, ReadWrite }, { S::Gv, Read });                  // cmpxchg
+    t.TwoByte[0xB3] = MakeEntry(K::Other, { S::Ev, ReadWrite }, { S::Gv, Read });                  // btr
+    t.TwoByte[0xB6] = MakeEntry(K::Other, { S::Gv, Write }, { S::Eb, Read });                      // movzx
+    t.TwoByte[0xB7] = MakeEntry(K::Other, { S::Gv, Write }, { S::Ew, Read });                      // movzx
+    t.TwoByte[0xBA] = MakeGroup(Group8_Ev_Ib);
+    t.Groups[Group8_Ev_Ib][4] = MakeEntry(K::Other, { S::Ev, Read }, { S::Ib, Read });             // bt
+    for (int op = 5; op < 8; ++op)
+    {
+        t.Groups[Group8_Ev_Ib][op] = MakeEntry(K::Other, { S::Ev, ReadWrite }, { S::Ib, Read });   // bts/btr/btc
+    }
+    t.TwoByte[0xBB] = MakeEntry(K::Other, { S::Ev, ReadWrite }, { S::Gv, Read });                  // btc
+    t.TwoByte[0xBC] = MakeEntry(K::Other, { S::Gv, Write }, { S::Ev, Read });                      // bsf / tzcnt
+    t.TwoByte[0xBC].AllowRep = true;
+    t.TwoByte[0xBD] = MakeEntry(K::Other, { S::Gv, Write }, { S::Ev, Read });                      // bsr / lzcnt
+    t.TwoByte[0xBD].AllowRep = true;
+    t.TwoByte[0xBE] = MakeEntry(K::Other, { S::Gv, Write }, { S::Eb, Read });                      // movsx
+    t.TwoByte[0xBF] = MakeEntry(K::Other, { S::Gv, Write }, { S::Ew, Read });                      // movsx
+    t.TwoByte[0xC0] = MakeEntry(K::Other, { S::Eb, ReadWrite }, { S::Gb, ReadWrite });             // xadd
+    t.TwoByte[0xC1] = MakeEntry(K::Other, { S::Ev, ReadWrite }, { S::Gv, ReadWrite });             // xadd
+    for (int r = 0; r < 8; ++r)
+    {
+        t.TwoByte[0xC8 + r] = MakeEntry(K::Other, { S::Zv, ReadWrite });                          // bswap
+    }
+
+    t.Popcnt = MakeEntry(K::Other, { S::Gv, Write }, { S::Ev, Read });
+    t.Popcnt.AllowRep = true;
+
+    return t;
+}
+
+OpcodeTables const& GetOpcodeTables()
+{
+    static OpcodeTables const tables = BuildOpcodeTables();
+    return tables;
+}
+
+//*************************************************
+// Registers:
+//
+// The decoder numbers registers as: 0-15 (64-bit), 16-31 (32-bit), 32-47 (16-bit), 48-63 (8-bit low),
+// 64-67 (ah, ch, dh, bh), 68 (rip).
+//
+
+constexpr uint32_t RegisterClassSize = 16;
+constexpr uint32_t HighByteBase = 64;
+constexpr uint32_t RipRegister = 68;
+
+wchar_t const *const RegisterNames[X64Decoder::RegisterCount] =
+{
+    L"rax", L"rcx", L"rdx", L"rbx", L"rsp", L"rbp", L"rsi", L"rdi",
+    L"r8", L"r9", L"r10", L"r11", L"r12", L"r13", L"r14", L"r15",
+    L"eax", L"ecx", L"edx", L"ebx", L"esp", L"ebp", L"esi", L"edi",
+    L"r8d", L"r9d", L"r10d", L"r11d", L"r12d", L"r13d", L"r14d", L"r15d",
+    L"ax", L"cx", L"dx", L"bx", L"sp", L"bp", L"si", L"di",
+    L"r8w", L"r9w", L"r10w", L"r11w", L"r12w", L"r13w", L"r14w", L"r15w",
+    L"al", L"cl", L"dl", L"bl", L"spl", L"bpl", L"sil", L"dil",
+    L"r8b", L"r9b", L"r10b", L"r11b", L"r12b", L"r13b", L"r14b", L"r15b",
+    L"ah", L"ch", L"dh", L"bh",
+    L"rip"
+};
+
+uint32_t GeneralRegister(uint32_t index, uint32_t sizeInBytes, bool hasRex)
+{
+    switch(sizeInBytes)
+    {
+        case 8:
+            return index;
+        case 4:
+            return RegisterClassSize + index;
+        case 2:
+            return 2 * RegisterClassSize + index;
+        default:
+            //
+            // Without a REX prefix, byte registers 4-7 are the legacy high byte registers.
+            //
+            if (!hasRex && index >= 4 && index < 8)
+            {
+                return HighByteBase + (index - 4);
+            }
+            return 3 * RegisterClassSize + index;
+    }
+}
+
+//*************************************************
+// Instruction Decoding:
+//
+
+// ByteReader:
+//
+// Bounds checked reading of the instruction bytes.
+//
+class ByteReader
+{
+public:
+
+    ByteReader(unsigned char const *pBytes, size_t byteCount) :
+        m_pBytes(pBytes),
+        m_byteCount(byteCount),
+        m_pos(0)
+    {
+    }
+
+    bool Peek(unsigned char *pValue) const
+    {
+        if (m_pos >= m_byteCount)
+        {
+            return false;
+        }
+        *pValue = m_pBytes[m_pos];
+        return true;
+    }
+
+    // ReadSigned():
+    //
+    // Reads a little endian value of 'size' bytes and sign extends it.
+    //
+    bool ReadSigned(size_t size, int64_t *pValue)
+    {
+        uint64_t value;
+        if (!ReadUnsigned(size, &value))
+        {
+            return false;
+        }
+
+        if (size < 8)
+        {
+            uint64_t signBit = 1ull << (size * 8 - 1);
+            value = (value ^ signBit) - signBit;
+        }
+        *pValue = static_cast<int64_t>(value);
+        return true;
+    }
+
+    bool ReadUnsigned(size_t size, uint64_t *pValue)
+    {
+        if (m_byteCount - m_pos < size)
+        {
+            return false;
+        }
+
+        uint64_t value = 0;
+        for (size_t i = 0; i < size; ++i)
+        {
+            value |= static_cast<uint64_t>(m_pBytes[m_pos + i]) << (i * 8);
+        }
+        m_pos += size;
+        *pValue = value;
+        return true;
+    }
+
+    size_t Position() const { return m_pos; }
+
+private:
+
+    unsigned char const *m_pBytes;
+    size_t m_byteCount;
+    size_t m_pos;
+};
+
+void ClearOperand(NativeOperand *pOperand)
+{
+    pOperand->Flags = 0;
+    for (size_t r = 0; r < std::size(pOperand->Regs); ++r)
+    {
+        pOperand->Regs[r] = X64Decoder::NoRegister;
+    }
+    pOperand->ScalingFactor = 1;
+    pOperand->ConstantValue = 0;
+}
+
+} // anonymous namespace
+
+wchar_t const *X64Decoder::GetRegisterName(uint32_t reg)
+{
+    return (reg < RegisterCount) ? RegisterNames[reg] : nullptr;
+}
+
+bool X64Decoder::Decode(unsigned char const *pBytes,
+                        size_t byteCount,
+                        uint64_t address,
+                        NativeInstruction *pInstruction)
+{
+    //
+    // No instruction is ever longer than 15 bytes.
+    //
+    constexpr size_t MaximumInstructionLength = 15;
+    ByteReader reader(pBytes, (std::min)(byteCount, MaximumInstructionLength));
+
+    pInstruction->Address = address;
+    pInstruction->Length = 0;
+    pInstruction->Kind = NativeInstructionKind::Other;
+    pInstruction->IsCall = false;
+    pInstruction->BranchTarget = 0;
+    pInstruction->NumOperands = 0;
+
+    //
+    // Legacy prefixes followed by an optional REX prefix.
+    //
+    bool operandSize16 = false;
+    bool rep = false;
+    unsigned char rex = 0;
+    unsigned char b;
+    uint64_t skipped;
+    for(;;)
+    {
+        if (!reader.Peek(&b))
+        {
+            return false;
+        }
+
+        bool isPrefix = true;
+        switch(b)
+        {
+            case 0x66:
+                operandSize16 = true;
+                break;
+            case 0xF2:
+                return false;               // No F2 prefixed instruction is in our subset
+            case 0xF3:
+                rep = true;
+                break;
+            case 0xF0:                      // lock
+            case 0x2E: case 0x3E:           // segment overrides / branch hints
+            case 0x26: case 0x36:
+            case 0x64: case 0x65:
+                break;
+            case 0x67:
+                return false;               // 32-bit addressing is not in our subset
+            default:
+                isPrefix = false;
+                break;
+        }
+
+        if (!isPrefix)
+        {
+            break;
+        }
+        (void)reader.ReadUnsigned(1, &skipped);
+    }
+
+    if ((b & 0xF0) == 0x40)
+    {
+        rex = b;
+        (void)reader.ReadUnsigned(1, &skipped);
+    }
+
+    bool rexW = (rex & 0x08) != 0;
+    bool rexR = (rex & 0x04) != 0;
+    bool rexX = (rex & 0x02) != 0;
+    bool rexB = (rex & 0x01) != 0;
+
+    OpcodeTables const& tables = GetOpcodeTables();
+
+    uint64_t opcode;
+    if (!reader.ReadUnsigned(1, &opcode))
+    {
+        return false;
+    }
+
+    bool twoByte = false;
+    if (opcode == 0x0F)
+    {
+        twoByte = true;
+        if (!reader.ReadUnsigned(1, &opcode))
+        {
+            return false;
+        }
+    }
+
+    OpcodeEntry const *pEntry;
+    if (twoByte && rep && opcode == 0xB8)
+    {
+        pEntry = &tables.Popcnt;
+    }
+    else
+    {
+        pEntry = twoByte ? &tables.TwoByte[opcode] : &tables.OneByte[opcode];
+    }
+
+    //
+    // xchg r8, rax (41 90) is not a nop.
+    //
+    if (!twoByte && opcode == 0x90 && rexB)
+    {
+        pEntry = &tables.OneByte[0x91];
+    }
+
+    if (!pEntry->Valid)
+    {
+        return false;
+    }
+
+    //
+    // Do we need a ModRM byte...?  Every group does as does any r/m or reg operand.
+    //
+    bool needsModRM = (pEntry->Group != NoGroup);
+    for (auto&& op : pEntry->Operands)
+    {
+        switch(op.Spec)
+        {
+            case OperandSpec::Eb: case OperandSpec::Ew: case OperandSpec::Ed: case OperandSpec::Ev:
+            case OperandSpec::Gb: case OperandSpec::Gv: case OperandSpec::M:
+                needsModRM = true;
+                break;
+            default:
+                break;
+        }
+    }
+
+    uint32_t mod = 0;
+    uint32_t regField = 0;
+    uint32_t rmField = 0;
+    NativeOperand rmOperand;
+    ClearOperand(&rmOperand);
+
+    if (needsModRM)
+    {
+        uint64_t modrm;
+        if (!reader.ReadUnsigned(1, &modrm))
+        {
+            return false;
+        }
+
+        mod = static_cast<uint32_t>(modrm >> 6);
+        regField = static_cast<uint32_t>((modrm >> 3) & 7);
+        rmField = static_cast<uint32_t>(modrm & 7);
+
+        if (pEntry->Group != NoGroup)
+        {
+            pEntry = &tables.Groups[pEntry->Group][regField];
+            if (!pEntry->Valid)
+            {
+                return false;
+            }
+        }
+
+        if (mod != 3)
+        {
+            //
+            // Memory operand: [base + index * scale + displacement]
+            //
+            uint32_t base = X64Decoder::NoRegister;
+            uint32_t index = X64Decoder::NoRegister;
+            uint32_t scale = 1;
+            size_t dispSize = (mod == 1) ? 1 : ((mod == 2) ? 4 : 0);
+
+            if (rmField == 4)
+            {
+                uint64_t sib;
+                if (!reader.ReadUnsigned(1, &sib))
+                {
+                    return false;
+                }
+
+                uint32_t sibIndex = static_cast<uint32_t>((sib >> 3) & 7) | (rexX ? 8 : 0);
+                uint32_t sibBase = static_cast<uint32_t>(sib & 7);
+                if (sibIndex != 4)
+                {
+                    index = sibIndex;
+                    scale = 1u << (sib >> 6);
+                }
+
+                if (sibBase == 5 && mod == 0)
+                {
+                    dispSize = 4;
+                }
+                else
+                {
+                    base = sibBase | (rexB ? 8 : 0);
+                }
+            }
+            else if (rmField == 5 && mod == 0)
+            {
+                base = RipRegister;
+                dispSize = 4;
+            }
+            else
+            {
+                base = rmField | (rexB ? 8 : 0);
+            }
+
+            int64_t disp = 0;
+            if (dispSize != 0 && !reader.ReadSigned(dispSize, &disp))
+            {
+                return false;
+            }
+
+            rmOperand.Flags = NativeOperandMemory;
+            size_t regNum = 0;
+            if (base != X64Decoder::NoRegister)
+            {
+                rmOperand.Regs[regNum++] = base;
+            }
+            if (index != X64Decoder::NoRegister)
+            {
+                rmOperand.Regs[regNum++] = index;
+                if (scale != 1)
+                {
+                    //
+                    // The scaled register is always the first.
+                    //
+                    std::swap(rmOperand.Regs[0], rmOperand.Regs[regNum - 1]);
+                    rmOperand.ScalingFactor = scale;
+                }
+            }
+            if (disp != 0 || regNum == 0)
+            {
+                rmOperand.Flags |= NativeOperandImmediate;
+                rmOperand.ConstantValue = disp;
+            }
+        }
+    }
+
+    if (rep && !pEntry->AllowRep)
+    {
+        return false;
+    }
+
+    uint32_t operandSize = pEntry->Default64 ? (operandSize16 ? 2 : 8) : (rexW ? 8 : (operandSize16 ? 2 : 4));
+
+    //
+    // Build the operands in order.  Immediates follow the ModRM/SIB/displacement bytes in operand order.
+    //
+    NativeOperand operands[3];
+    size_t numOperands = 0;
+    bool isRelative[3] = { };
+
+    for (auto&& op : pEntry->Operands)
+    {
+        if (op.Spec == OperandSpec::None)
+        {
+            break;
+        }
+
+        NativeOperand& operand = operands[numOperands];
+        ClearOperand(&operand);
+
+        uint32_t accessFlags = ((op.Access & Read) ? NativeOperandInput : 0) |
+                            ((op.Access & Write) ? NativeOperandOutput : 0);
+
+        size_t immSize = 0;
+        switch(op.Spec)
+        {
+            case OperandSpec::Eb:
+            case OperandSpec::Ew:
+            case OperandSpec::Ed:
+            case OperandSpec::Ev:
+            case OperandSpec::M:
+            {
+                if (mod == 3)
+                {
+                    if (op.Spec == OperandSpec::M)
+                    {
+                        return false;
+                    }
+
+                    uint32_t size = (op.Spec == OperandSpec::Eb) ? 1 :
+                                 (op.Spec == OperandSpec::Ew) ? 2 :
+                                 (op.Spec == OperandSpec::Ed) ? 4 : operandSize;
+                    operand.Flags = NativeOperandRegister;
+                    operand.Regs[0] = GeneralRegister(rmField | (rexB ? 8 : 0), size, rex != 0);
+                }
+                else
+                {
+                    operand = rmOperand;
+                }
+                break;
+            }
+
+            case OperandSpec::Gb:
+            case OperandSpec::Gv:
+                operand.Flags = NativeOperandRegister;
+                operand.Regs[0] = GeneralRegister(regField | (rexR ? 8 : 0),
+                                                  (op.Spec == OperandSpec::Gb) ? 1 : operandSize,
+                                                  rex != 0);
+                break;
+
+            case OperandSpec::Zb:
+            case OperandSpec::Zv:
+                operand.Flags = NativeOperandRegister;
+                operand.Regs[0] = GeneralRegister(static_cast<uint32_t>(opcode & 7) | (rexB ? 8 : 0),
+                                                  (op.Spec == OperandSpec::Zb) ? 1 : operandSize,
+                                                  rex != 0);
+                break;
+
+            case OperandSpec::AL:
+                operand.Flags = NativeOperandRegister;
+                operand.Regs[0] = GeneralRegister(0, 1, rex != 0);
+                break;
+
+            case OperandSpec::RAX:
+                operand.Flags = NativeOperandRegister;
+                operand.Regs[0] = GeneralRegister(0, operandSize, rex != 0);
+                break;
+
+            case OperandSpec::CL:
+                operand.Flags = NativeOperandRegister;
+                operand.Regs[0] = GeneralRegister(1, 1, rex != 0);
+                break;
+
+            case OperandSpec::Ib:
+                immSize = 1;
+                break;
+
+            case OperandSpec::Iw:
+                immSize = 2;
+                break;
+
+            case OperandSpec::Iz:
+                immSize = (operandSize == 2) ? 2 : 4;
+                break;
+
+            case OperandSpec::Iv:
+                immSize = operandSize;
+                break;
+
+            case OperandSpec::Jb:
+                immSize = 1;
+                isRelative[numOperands] = true;
+                break;
+
+            case OperandSpec::Jz:
+                if (operandSize16)
+                {
+                    return false;
+                }
+                immSize = 4;
+                isRelative[numOperands] = true;
+                break;
+
+            default:
+                return false;
+        }
+
+        if (immSize != 0)
+        {
+            int64_t imm;
+            if (!reader.ReadSigned(immSize, &imm))
+            {
+                return false;
+            }
+            operand.Flags = NativeOperandImmediate;
+            operand.ConstantValue = imm;
+            accessFlags = NativeOperandInput;
+        }
+
+        operand.Flags |= accessFlags;
+        ++numOperands;
+    }
+
+    pInstruction->Length = reader.Position();
+    pInstruction->Kind = pEntry->Kind;
+    pInstruction->IsCall = pEntry->IsCall;
+
+    //
+    // Relative branch operands are reported (as the data model disassembler does) as the absolute target.
+    //
+    for (size_t i = 0; i < numOperands; ++i)
+    {
+        if (isRelative[i])
+        {
+            uint64_t target = address + pInstruction->Length + static_cast<uint64_t>(operands[i].ConstantValue);
+            operands[i].ConstantValue = static_cast<int64_t>(target);
+            pInstruction->BranchTarget = target;
+        }
+    }
+
+    if (!pEntry->HideOperands)
+    {
+        for (size_t i = 0; i < numOperands; ++i)
+        {
+            pInstruction->Operands[i] = operands[i];
+        }
+        pInstruction->NumOperands = numOperands;
+    }
+
+    return true;
+}
+
+} // SymbolBuilder
+} // Services
+} // TargetComposition
+} // Debugger
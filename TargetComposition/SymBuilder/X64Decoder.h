@@ -0,0 +1,134 @@
+//**************************************************************************
+//
+// X64Decoder.h
+//
+// A small table driven decoder for the subset of x64 instructions which the range builder
+// needs to understand in order to walk a function: the general purpose integer instructions
+// and every control transfer.  Anything outside that subset is reported as undecodable and
+// the caller is expected to fall back to the data model disassembler.
+//
+// This has no dependency on the debugger, the data model, or the symbol builder's symbols.  It uses only
+// standard C++ (no Windows headers or SAL annotations) so that it builds and is tested with any compiler.
+//
+//**************************************************************************
+//
+// Copyright (c) Microsoft Corporation.  All rights reserved.
+//
+//**************************************************************************
+
+#ifndef __X64DECODER_H__
+#define __X64DECODER_H__
+
+#include <cstddef>
+#include <cstdint>
+
+namespace Debugger
+{
+namespace TargetComposition
+{
+namespace Services
+{
+namespace SymbolBuilder
+{
+
+// NativeInstructionKind:
+//
+// The classification of a decoded instruction.
+//
+enum class NativeInstructionKind
+{
+    Other,
+    Mov,
+    Push,
+    Pop,
+    Add,
+    Sub,
+    Lea,
+    Call,
+    Jump,                       // Unconditional direct jump
+    ConditionalJump,            // Conditional direct jump
+    Return,
+    Trap                        // Does not continue (int3, ud2, int 29h)
+};
+
+// NativeOperandFlags:
+//
+// Flags describing a decoded operand.  These have the same values as the range builder's own
+// operand flags.
+//
+enum NativeOperandFlags
+{
+    NativeOperandInput = 0x00000001,
+    NativeOperandOutput = 0x00000002,
+    NativeOperandRegister = 0x00000004,
+    NativeOperandMemory = 0x00000008,
+    NativeOperandImmediate = 0x00000010,
+};
+
+// NativeOperand:
+//
+// A decoded operand.  Registers are given in the decoder's own register numbering (see
+// X64Decoder::GetRegisterName).  For a memory operand with a scaled index, the index is the first
+// register and 'ScalingFactor' applies to it.  Immediates (including displacements and the targets of
+// direct branches) are in 'ConstantValue'.
+//
+struct NativeOperand
+{
+    uint32_t Flags;
+    uint32_t Regs[3];
+    uint32_t ScalingFactor;
+    int64_t ConstantValue;
+};
+
+// NativeInstruction:
+//
+// A decoded instruction.
+//
+struct NativeInstruction
+{
+    uint64_t Address;
+    uint64_t Length;
+    NativeInstructionKind Kind;
+    bool IsCall;
+    uint64_t BranchTarget;               // The target of a direct Call, Jump, or ConditionalJump
+    size_t NumOperands;
+    NativeOperand Operands[4];
+};
+
+// X64Decoder:
+//
+// Decodes x64 instructions.
+//
+class X64Decoder
+{
+public:
+
+    // A constant defining no register
+    static constexpr uint32_t NoRegister = static_cast<uint32_t>(-1);
+
+    // The number of registers in the decoder's register numbering.
+    static constexpr uint32_t RegisterCount = 16 * 4 + 4 + 1;
+
+    // Decode():
+    //
+    // Decodes the instruction at the start of 'pBytes' (which is at 'address' in the target).  This returns
+    // false if the bytes are not an instruction in the decoder's subset or are truncated.
+    //
+    static bool Decode(unsigned char const *pBytes,
+                       size_t byteCount,
+                       uint64_t address,
+                       NativeInstruction *pInstruction);
+
+    // GetRegisterName():
+    //
+    // Gets the name of a register in the decoder's numbering (e.g.: "rax", "r8d", "ah", "rip").
+    //
+    static wchar_t const *GetRegisterName(uint32_t reg);
+};
+
+} // SymbolBuilder
+} // Services
+} // TargetComposition
+} // Debugger
+
+#endif // __X64DECODER_H__
@@ -0,0 +1,346 @@
+//**************************************************************************
+//
+// X64DecoderTests.cpp
+//
+// Table driven tests for the x64 decoder used by the range builder.  Each test gives the bytes of an
+// instruction and the expected decoding of them.  These run as a plain console application without the
+// debugger.  Once the tests pass, the decoder is timed over the decodable test instructions.
+//
+// Usage: X64DecoderTests [benchmarkIterations]
+//
+//**************************************************************************
+//
+// Copyright (c) Microsoft Corporation.  All rights reserved.
+//
+//**************************************************************************
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cwchar>
+#include <iterator>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "../X64Decoder.h"
+
+using namespace Debugger::TargetComposition::Services::SymbolBuilder;
+
+// DecoderTest:
+//
+// A single test of the decoder.  'Expected' is the text produced by FormatInstruction for the decoded
+// instruction or nullptr if the bytes must not decode.  'Length' is the expected length of the instruction.
+//
+struct DecoderTest
+{
+    wchar_t const *Description;
+    std::vector<unsigned char> Bytes;
+    wchar_t const *Expected;
+    uint64_t Length;
+};
+
+// The address at which every test instruction is decoded.
+constexpr uint64_t TestAddress = 0x1000;
+
+DecoderTest const DecoderTests[] =
+{
+    //
+    // Plain register and immediate forms:
+    //
+    { L"ret", { 0xC3 }, L"Return", 1 },
+    { L"rep ret", { 0xF3, 0xC3 }, L"Return", 2 },
+    { L"ret imm16", { 0xC2, 0x08, 0x00 }, L"Return 0x8:r", 3 },
+    { L"int3", { 0xCC }, L"Trap", 1 },
+    { L"ud2", { 0x0F, 0x0B }, L"Trap", 2 },
+    { L"push r15", { 0x41, 0x57 }, L"Push r15:r", 2 },
+    { L"pop rbx", { 0x5B }, L"Pop rbx:w", 1 },
+    { L"mov al, dh (no REX)", { 0x88, 0xF0 }, L"Mov al:w, dh:r", 2 },
+    { L"mov al, sil (REX)", { 0x40, 0x88, 0xF0 }, L"Mov al:w, sil:r", 3 },
+    { L"mov r8, imm64", { 0x49, 0xB8, 0x88, 0x77, 0x66, 0x55, 0x44, 0x33, 0x22, 0x11 },
+      L"Mov r8:w, 0x1122334455667788:r", 10 },
+    { L"mov ecx, imm32", { 0xB9, 0xFF, 0xFF, 0xFF, 0xFF }, L"Mov ecx:w, -0x1:r", 5 },
+    { L"xchg r8d, eax (REX.B 90 is not nop)", { 0x41, 0x90 }, L"Other r8d:rw, eax:rw", 2 },
+    { L"nop", { 0x90 }, L"Other", 1 },
+    { L"popcnt rax, rcx", { 0xF3, 0x48, 0x0F, 0xB8, 0xC1 }, L"Other rax:w, rcx:r", 5 },
+    { L"movzx eax, byte [rcx]", { 0x0F, 0xB6, 0x01 }, L"Other eax:w, [rcx]:r", 3 },
+
+    //
+    // ModRM memory forms, SIB, and rip relative addressing:
+    //
+    { L"mov [rsp+8], rbx", { 0x48, 0x89, 0x5C, 0x24, 0x08 }, L"Mov [rsp+0x8]:w, rbx:r", 5 },
+    { L"mov eax, [rsp]", { 0x8B, 0x04, 0x24 }, L"Mov eax:w, [rsp]:r", 3 },
+    { L"mov rax, [rbp-8]", { 0x48, 0x8B, 0x45, 0xF8 }, L"Mov rax:w, [rbp-0x8]:r", 4 },
+    { L"mov [rax], cx", { 0x66, 0x89, 0x08 }, L"Mov [rax]:w, cx:r", 3 },
+    { L"mov r8, [rip+0x10]", { 0x4C, 0x8B, 0x05, 0x10, 0x00, 0x00, 0x00 }, L"Mov r8:w, [rip+0x10]:r", 7 },
+    { L"lea rax, [rax+rcx*8]", { 0x48, 0x8D, 0x04, 0xC8 }, L"Lea rax:w, [rcx*8+rax]:r", 4 },
+    { L"mov eax, [r8*4+0x2010] (SIB without base)", { 0x42, 0x8B, 0x04, 0x85, 0x10, 0x20, 0x00, 0x00 },
+      L"Mov eax:w, [r8*4+0x2010]:r", 8 },
+    { L"mov rax, [r13+r12] (REX.X index 4 is r12)", { 0x4B, 0x8B, 0x44, 0x25, 0x00 },
+      L"Mov rax:w, [r13+r12]:r", 5 },
+    { L"mov rax, [r12] (REX.B base 4 needs a SIB)", { 0x49, 0x8B, 0x04, 0x24 }, L"Mov rax:w, [r12]:r", 4 },
+    { L"mov rax, [r13] (REX.B base 5 needs a displacement)", { 0x49, 0x8B, 0x45, 0x00 }, L"Mov rax:w, [r13]:r", 4 },
+    { L"mov r9d, [r10+r11*2+0x100]", { 0x47, 0x8B, 0x8C, 0x5A, 0x00, 0x01, 0x00, 0x00 },
+      L"Mov r9d:w, [r11*2+r10+0x100]:r", 8 },
+
+    //
+    // Opcode groups (the ModRM reg field selects the operation):
+    //
+    { L"sub rsp, 0x28 (group 1)", { 0x48, 0x83, 0xEC, 0x28 }, L"Sub rsp:rw, 0x28:r", 4 },
+    { L"add rsp, 0x1000 (group 1)", { 0x48, 0x81, 0xC4, 0x00, 0x10, 0x00, 0x00 }, L"Add rsp:rw, 0x1000:r", 7 },
+    { L"cmp byte [rsp+0x10], 0 (group 1)", { 0x80, 0x7C, 0x24, 0x10, 0x00 }, L"Other [rsp+0x10]:r, 0x0:r", 5 },
+    { L"pop [rax] (group 1A)", { 0x8F, 0x00 }, L"Pop [rax]:w", 2 },
+    { L"shl rax, 4 (group 2)", { 0x48, 0xC1, 0xE0, 0x04 }, L"Other rax:rw, 0x4:r", 4 },
+    { L"sar edx, cl (group 2)", { 0xD3, 0xFA }, L"Other edx:rw, cl:r", 2 },
+    { L"mov dword [rsp+0x20], 1 (group 11)", { 0xC7, 0x44, 0x24, 0x20, 0x01, 0x00, 0x00, 0x00 },
+      L"Mov [rsp+0x20]:w, 0x1:r", 8 },
+    { L"test cl, 1 (group 3)", { 0xF6, 0xC1, 0x01 }, L"Other cl:r, 0x1:r", 3 },
+    { L"neg eax (group 3)", { 0xF7, 0xD8 }, L"Other eax:rw", 2 },
+    { L"inc byte [rdi] (group 4)", { 0xFE, 0x07 }, L"Other [rdi]:rw", 2 },
+    { L"call r11 (group 5)", { 0x41, 0xFF, 0xD3 }, L"Call r11:r", 3 },
+    { L"call [rip+0x100] (group 5)", { 0xFF, 0x15, 0x00, 0x01, 0x00, 0x00 }, L"Call [rip+0x100]:r", 6 },
+    { L"push [rbx+8] (group 5)", { 0xFF, 0x73, 0x08 }, L"Push [rbx+0x8]:r", 3 },
+    { L"bt rax, 3 (group 8)", { 0x48, 0x0F, 0xBA, 0xE0, 0x03 }, L"Other rax:r, 0x3:r", 5 },
+    { L"nop dword [rax+rax] (hint nop group)", { 0x0F, 0x1F, 0x44, 0x00, 0x00 }, L"Other", 5 },
+    { L"prefetcht0 [rcx] (prefetch group)", { 0x0F, 0x18, 0x09 }, L"Other", 3 },
+
+    //
+    // Direct branches are reported with their absolute target:
+    //
+    { L"call rel32", { 0xE8, 0xFB, 0x0F, 0x00, 0x00 }, L"Call 0x2000:r", 5 },
+    { L"jmp rel8", { 0xEB, 0xFE }, L"Jump 0x1000:r", 2 },
+    { L"jz rel8 backwards", { 0x74, 0xF0 }, L"ConditionalJump 0xff2:r", 2 },
+    { L"jnz rel32", { 0x0F, 0x85, 0x00, 0x01, 0x00, 0x00 }, L"ConditionalJump 0x1106:r", 6 },
+
+    //
+    // Bytes outside the decoder's subset or truncated:
+    //
+    { L"movsd (F2 prefix)", { 0xF2, 0x0F, 0x10, 0xC1 }, nullptr, 0 },
+    { L"32-bit addressing (67 prefix)", { 0x67, 0x8B, 0x00 }, nullptr, 0 },
+    { L"syscall", { 0x0F, 0x05 }, nullptr, 0 },
+    { L"lea with a register operand", { 0x48, 0x8D, 0xC0 }, nullptr, 0 },
+    { L"undefined group 5 member", { 0xFF, 0xF8 }, nullptr, 0 },
+    { L"rep before an instruction which does not allow it", { 0xF3, 0x8B, 0xC1 }, nullptr, 0 },
+    { L"jmp rel16 (66 prefix)", { 0x66, 0xE9, 0x00, 0x00 }, nullptr, 0 },
+    { L"truncated ModRM", { 0x48, 0x8B }, nullptr, 0 },
+    { L"truncated SIB", { 0x8B, 0x04 }, nullptr, 0 },
+    { L"truncated displacement", { 0x8B, 0x80, 0x00, 0x01 }, nullptr, 0 },
+    { L"truncated immediate", { 0xB8, 0x01, 0x00 }, nullptr, 0 },
+    { L"empty", { }, nullptr, 0 },
+};
+
+// FormatConstant():
+//
+// Formats a constant as signed hex (e.g.: 0x10, -0x8).
+//
+std::wstring FormatConstant(int64_t value)
+{
+    std::wostringstream str;
+    if (value < 0)
+    {
+        str << L"-0x" << std::hex << (0 - static_cast<uint64_t>(value));
+    }
+    else
+    {
+        str << L"0x" << std::hex << static_cast<uint64_t>(value);
+    }
+    return str.str();
+}
+
+// FormatInstruction():
+//
+// Formats a decoded instruction as its kind followed by its operands.  Each operand is followed by its access
+// (r, w, or rw).  A memory operand is given as [scaled-index*scale+base+displacement].
+//
+std::wstring FormatInstruction(NativeInstruction const& instr)
+{
+    static wchar_t const *const kindNames[] =
+    {
+        L"Other", L"Mov", L"Push", L"Pop", L"Add", L"Sub", L"Lea", L"Call", L"Jump", L"ConditionalJump", L"Return",
+        L"Trap"
+    };
+
+    std::wstring text = kindNames[static_cast<size_t>(instr.Kind)];
+    for (size_t i = 0; i < instr.NumOperands; ++i)
+    {
+        NativeOperand const& operand = instr.Operands[i];
+        text += (i == 0) ? L" " : L", ";
+
+        if (operand.Flags & NativeOperandMemory)
+        {
+            text += L"[";
+            bool first = true;
+            for (size_t r = 0; r < std::size(operand.Regs); ++r)
+            {
+                if (operand.Regs[r] == X64Decoder::NoRegister)
+                {
+                    continue;
+                }
+
+                if (!first)
+                {
+                    text += L"+";
+                }
+                text += X64Decoder::GetRegisterName(operand.Regs[r]);
+                if (first && operand.ScalingFactor != 1)
+                {
+                    text += L"*" + std::to_wstring(operand.ScalingFactor);
+                }
+                first = false;
+            }
+
+            if (operand.Flags & NativeOperandImmediate)
+            {
+                std::wstring disp = FormatConstant(operand.ConstantValue);
+                text += (first || disp[0] == L'-') ? disp : L"+" + disp;
+            }
+            text += L"]";
+        }
+        else if (operand.Flags & NativeOperandRegister)
+        {
+            text += X64Decoder::GetRegisterName(operand.Regs[0]);
+        }
+        else if (operand.Flags & NativeOperandImmediate)
+        {
+            text += FormatConstant(operand.ConstantValue);
+        }
+
+        text += L":";
+        if (operand.Flags & NativeOperandInput)
+        {
+            text += L"r";
+        }
+        if (operand.Flags & NativeOperandOutput)
+        {
+            text += L"w";
+        }
+    }
+    return text;
+}
+
+// RunTest():
+//
+// Runs a single test and reports any failure.  Returns whether the test passed.
+//
+bool RunTest(DecoderTest const& test)
+{
+    //
+    // Decode from a buffer holding exactly the test bytes so that a read past them is a truncation rather than
+    // a read of whatever follows.
+    //
+    NativeInstruction instr;
+    bool decoded = X64Decoder::Decode(test.Bytes.data(), test.Bytes.size(), TestAddress, &instr);
+
+    if (test.Expected == nullptr)
+    {
+        if (decoded)
+        {
+            wprintf(L"FAILED: %ls: unexpectedly decoded as '%ls'\n", test.Description, FormatInstruction(instr).c_str());
+            return false;
+        }
+        return true;
+    }
+
+    if (!decoded)
+    {
+        wprintf(L"FAILED: %ls: unable to decode\n", test.Description);
+        return false;
+    }
+
+    std::wstring text = FormatInstruction(instr);
+    if (text != test.Expected || instr.Length != test.Length || instr.Address != TestAddress)
+    {
+        wprintf(L"FAILED: %ls: decoded as '%ls' (length %llu); expected '%ls' (length %llu)\n",
+                test.Description, text.c_str(), static_cast<unsigned long long>(instr.Length), test.Expected,
+                static_cast<unsigned long long>(test.Length));
+        return false;
+    }
+
+    //
+    // Direct branches must also report their target and calls must be flagged as such.
+    //
+    bool isDirectBranch = (instr.Kind == NativeInstructionKind::Jump ||
+                           instr.Kind == NativeInstructionKind::ConditionalJump ||
+                           (instr.Kind == NativeInstructionKind::Call &&
+                            (instr.Operands[0].Flags & NativeOperandImmediate) &&
+                            !(instr.Operands[0].Flags & NativeOperandMemory)));
+    uint64_t expectedTarget = isDirectBranch ? static_cast<uint64_t>(instr.Operands[0].ConstantValue) : 0;
+    if (instr.BranchTarget != expectedTarget ||
+        instr.IsCall != (instr.Kind == NativeInstructionKind::Call))
+    {
+        wprintf(L"FAILED: %ls: unexpected branch target 0x%llx or call flag\n", test.Description,
+                static_cast<unsigned long long>(instr.BranchTarget));
+        return false;
+    }
+
+    return true;
+}
+
+// RunBenchmark():
+//
+// Decodes the instructions of every test which must decode, back to back in one buffer, 'iterations' times
+// and reports the time taken per instruction.  Returns whether every instruction decoded.
+//
+bool RunBenchmark(size_t iterations)
+{
+    std::vector<unsigned char> code;
+    size_t instructionCount = 0;
+    for (auto&& test : DecoderTests)
+    {
+        if (test.Expected != nullptr)
+        {
+            code.insert(code.end(), test.Bytes.begin(), test.Bytes.end());
+            ++instructionCount;
+        }
+    }
+
+    //
+    // The sum of the lengths keeps the decoding from being optimized away.
+    //
+    uint64_t totalLength = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < iterations; ++i)
+    {
+        size_t pos = 0;
+        while (pos < code.size())
+        {
+            NativeInstruction instr;
+            if (!X64Decoder::Decode(code.data() + pos, code.size() - pos, TestAddress + pos, &instr))
+            {
+                wprintf(L"FAILED: benchmark: unable to decode at offset 0x%zx\n", pos);
+                return false;
+            }
+            pos += static_cast<size_t>(instr.Length);
+            totalLength += instr.Length;
+        }
+    }
+    auto end = std::chrono::steady_clock::now();
+
+    double elapsedNs = std::chrono::duration<double, std::nano>(end - start).count();
+    wprintf(L"Decoded %zu instructions %zu times (%llu bytes) in %.3f ms: %.2f ns per instruction\n",
+            instructionCount, iterations, static_cast<unsigned long long>(totalLength), elapsedNs / 1000000.0,
+            elapsedNs / static_cast<double>(instructionCount * iterations));
+    return true;
+}
+
+int main(int argc, char *argv[])
+{
+    size_t iterations = (argc > 1) ? static_cast<size_t>(strtoull(argv[1], nullptr, 0)) : 100000;
+
+    size_t failed = 0;
+    for (auto&& test : DecoderTests)
+    {
+        if (!RunTest(test))
+        {
+            ++failed;
+        }
+    }
+
+    wprintf(L"%zu of %zu decoder tests passed\n", std::size(DecoderTests) - failed, std::size(DecoderTests));
+    if (failed != 0)
+    {
+        return 1;
+    }
+
+    return (iterations == 0 || RunBenchmark(iterations)) ? 0 : 1;
+}